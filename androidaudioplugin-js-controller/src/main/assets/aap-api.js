@@ -5,8 +5,8 @@
 // NOT a stable API. Always drive automation through aap.* instead.
 //
 // This mirrors uapmd-app's uapmd-api.js in spirit, but the vocabulary is the AAP host API only
-// (no sequencer/timeline concepts). Offline rendering (aap.render.*) is intentionally absent for
-// now and will be added on top of this surface later.
+// (no sequencer/timeline concepts). Offline rendering is per instance (renderOffline()); there is
+// no timeline-level aap.render.* yet.
 
 // Wraps a created plugin instance id with the per-instance operations.
 class PluginInstance {
@@ -18,6 +18,17 @@ class PluginInstance {
     prepare(frameCount, sampleRate) { __aap_instance_prepare(this.instanceId, frameCount, sampleRate); return this; }
     activate() { __aap_instance_activate(this.instanceId); return this; }
     process(frameCount) { __aap_instance_process(this.instanceId, frameCount); return this; }
+    // Renders totalFrames in native code, block by block (the block size is the prepared frameCount).
+    // options: { events: [{ frame, words }], input: { seed, amplitude } } (no input means silence).
+    // Returns { frames, blocks, droppedEvents, elapsedMs, realtimeFactor, perBlockUs, outputs }, where
+    // outputs are the getAudioOutputStats() items accumulated over the whole render.
+    renderOffline(totalFrames, options) {
+        const opts = options || {};
+        const events = (opts.events || []).map((e) => ({ frame: Number(e.frame), ump: umpWordsToHex(e.words) }));
+        const input = opts.input || {};
+        return __aap_instance_render_offline(this.instanceId, totalFrames, events,
+            input.seed || 0, input.amplitude || 0);
+    }
     deactivate() { __aap_instance_deactivate(this.instanceId); return this; }
     destroy() { __aap_instance_destroy(this.instanceId); }
     fillAudioInputs(seed, amplitude) { __aap_instance_fill_audio_inputs(this.instanceId, seed, amplitude); return this; }
@@ -28,6 +39,17 @@ class PluginInstance {
         return this;
     }
     getAudioOutputStats() { return __aap_instance_get_audio_output_stats(this.instanceId); }
+    // Process tracing. options: { histograms, events } (booleans); no options disables it.
+    // dumpProcessTraceEvents() returns a Chrome JSON trace string, loadable in Perfetto UI.
+    setProcessTrace(options) {
+        const opts = options || {};
+        __aap_instance_set_process_trace_flags(this.instanceId,
+            (opts.histograms ? ProcessTraceFlags.HISTOGRAMS : 0) | (opts.events ? ProcessTraceFlags.EVENTS : 0));
+        return this;
+    }
+    resetProcessTraceHistograms() { __aap_instance_reset_process_trace_histograms(this.instanceId); return this; }
+    dumpProcessTraceHistograms() { return __aap_instance_dump_process_trace_histograms(this.instanceId); }
+    dumpProcessTraceEvents() { return __aap_instance_dump_process_trace_events(this.instanceId); }
     addEventUmpInput(words) { __aap_instance_add_event_ump_input_hex(this.instanceId, umpWordsToHex(words)); return this; }
     sleepMs(milliseconds) { __aap_sleep_ms(milliseconds); return this; }
 
@@ -52,6 +74,9 @@ class PluginInstance {
     destroyGui(guiInstanceId) { __aap_instance_destroy_gui(this.instanceId, guiInstanceId); return this; }
 }
 
+// aap::ProcessTraceFlags
+const ProcessTraceFlags = { HISTOGRAMS: 1, EVENTS: 2 };
+
 function umpWordsToHex(words) {
     if (!Array.isArray(words))
         throw new Error("addEventUmpInput() expects an array of 32-bit UMP words");
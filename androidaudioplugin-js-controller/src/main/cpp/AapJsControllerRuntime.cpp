@@ -90,6 +90,61 @@ std::vector<uint8_t> hexDecode(const std::string& in) {
     return out;
 }
 
+// The synthetic audio input of __aap_instance_fill_audio_inputs and __aap_instance_render_offline.
+// `port` is the absolute port index, so that both produce the same signal for the same port.
+void fillSyntheticAudioInput(float* data, int32_t frames, int64_t seed, int64_t position, int32_t port, double amplitude) {
+    for (int32_t i = 0; i < frames; ++i) {
+        auto phase = static_cast<double>((seed + position + i + port * 31) % 97) / 97.0;
+        data[i] = static_cast<float>((std::sin(phase * 6.283185307179586) * 0.7 +
+                                      std::sin(phase * 18.84955592153876) * 0.3) * amplitude);
+    }
+}
+
+// Statistics of an audio output, with an FNV-1a hash of the quantized samples, accumulated over
+// one or more blocks.
+struct AudioOutputStats {
+    int64_t samples{0};
+    double sum{0}, sumAbs{0}, sumSq{0}, maxAbs{0};
+    uint32_t hash{2166136261u};
+
+    void add(const float* data, int32_t frames) {
+        for (int32_t i = 0; data && i < frames; ++i) {
+            auto v = static_cast<double>(data[i]);
+            auto av = std::abs(v);
+            sum += v;
+            sumAbs += av;
+            sumSq += v * v;
+            maxAbs = std::max(maxAbs, av);
+            int32_t q = static_cast<int32_t>(std::max(-1.0, std::min(1.0, v)) * 2147483647.0);
+            hash ^= static_cast<uint32_t>(q);
+            hash *= 16777619u;
+        }
+        samples += data ? frames : 0;
+    }
+
+    choc::value::Value toObject() const {
+        auto obj = choc::value::createObject("");
+        obj.setMember("samples", samples);
+        obj.setMember("sum", sum);
+        obj.setMember("sumAbs", sumAbs);
+        obj.setMember("rms", samples > 0 ? std::sqrt(sumSq / samples) : 0.0);
+        obj.setMember("maxAbs", maxAbs);
+        obj.setMember("hash", static_cast<int64_t>(hash));
+        return obj;
+    }
+};
+
+// The absolute indices of the audio ports of `instance` in `direction`, in port order.
+std::vector<int32_t> getAudioPorts(aap::PluginInstance* instance, int32_t direction) {
+    std::vector<int32_t> ports;
+    for (int32_t p = 0, n = instance->getNumPorts(); p < n; ++p) {
+        auto* port = instance->getPort(p);
+        if (port && port->getContentType() == AAP_CONTENT_TYPE_AUDIO && port->getPortDirection() == direction)
+            ports.push_back(p);
+    }
+    return ports;
+}
+
 } // namespace
 
 AapJsControllerRuntime& AapJsControllerRuntime::global() {
@@ -255,11 +310,70 @@ void AapJsControllerRuntime::registerBindings() {
     ctx.registerFunction("__aap_instance_process", [this](choc::javascript::ArgumentList args) -> Value {
         auto instance = requireClient()->getInstanceById((int32_t) args.get<int64_t>(0));
         auto frameCount = (int32_t) args.get<int64_t>(1);
-        // 1s timeout; this is a single non-realtime block (the offline renderer comes later).
+        // 1s timeout; this is a single non-realtime block (use __aap_instance_render_offline for long renders).
         instance->process(frameCount, 1000000000L);
         return {};
     });
 
+    // Runs the whole render loop natively (PluginInstance::renderOffline()), instead of crossing the
+    // JS/native boundary for every block. Arguments: instanceId, totalFrames, events ([{frame, ump}]
+    // where ump is hex, sorted by frame), seed and amplitude of the synthetic input (amplitude 0 means
+    // silence). Returns the render statistics and the audio output stats over the whole render.
+    ctx.registerFunction("__aap_instance_render_offline", [this](choc::javascript::ArgumentList args) -> Value {
+        auto instance = requireClient()->getInstanceById((int32_t) args.get<int64_t>(0));
+        auto totalFrames = args.get<int64_t>(1);
+        auto seed = args.get<int64_t>(3);
+        auto amplitude = args.get<double>(4);
+
+        std::vector<std::vector<uint8_t>> eventBytes;
+        std::vector<aap::OfflineRenderEvent> events;
+        if (auto* eventList = args[2]; eventList && eventList->isArray()) {
+            eventBytes.reserve(eventList->size());
+            for (uint32_t i = 0; i < eventList->size(); i++) {
+                auto element = (*eventList)[i];
+                eventBytes.emplace_back(hexDecode(std::string(element["ump"].getString())));
+                events.push_back({element["frame"].getWithDefault<int64_t>(0),
+                                  eventBytes.back().data(), static_cast<int32_t>(eventBytes.back().size())});
+            }
+            std::stable_sort(events.begin(), events.end(), [](auto& a, auto& b) { return a.frame < b.frame; });
+        }
+
+        std::vector<AudioOutputStats> outputStats;
+        // renderOffline() counts only the audio ports; the generator takes the absolute port index.
+        auto audioInputs = getAudioPorts(instance, AAP_PORT_DIRECTION_INPUT);
+
+        aap::OfflineRenderRequest request{};
+        request.total_frames = totalFrames;
+        request.events = events.data();
+        request.num_events = static_cast<int32_t>(events.size());
+        if (amplitude != 0.0)
+            request.input_source = [seed, amplitude, &audioInputs](int64_t position, int32_t audioPort, float* data, int32_t frames) {
+                fillSyntheticAudioInput(data, frames, seed, position, audioInputs[audioPort], amplitude);
+            };
+        request.output_sink = [&outputStats](int64_t, int32_t audioPort, const float* data, int32_t frames) {
+            if ((size_t) audioPort >= outputStats.size())
+                outputStats.resize(audioPort + 1);
+            outputStats[audioPort].add(data, frames);
+        };
+
+        auto result = instance->renderOffline(request);
+
+        auto obj = createObject("");
+        obj.setMember("frames", result.frames_rendered);
+        obj.setMember("blocks", static_cast<int64_t>(result.num_blocks));
+        obj.setMember("droppedEvents", static_cast<int64_t>(result.num_dropped_events));
+        obj.setMember("elapsedMs", result.elapsed_nanoseconds / 1000000.0);
+        auto sampleRate = instance->getSampleRate();
+        obj.setMember("realtimeFactor", result.elapsed_nanoseconds > 0 && sampleRate > 0 ?
+                      (double) result.frames_rendered / sampleRate * 1e9 / result.elapsed_nanoseconds : 0.0);
+        obj.setMember("perBlockUs", result.num_blocks > 0 ? result.elapsed_nanoseconds / 1000.0 / result.num_blocks : 0.0);
+        auto outputs = createEmptyArray();
+        for (auto& stats : outputStats)
+            outputs.addArrayElement(stats.toObject());
+        obj.setMember("outputs", outputs);
+        return obj;
+    });
+
     ctx.registerFunction("__aap_instance_fill_audio_inputs", [this](choc::javascript::ArgumentList args) -> Value {
         auto instance = requireClient()->getInstanceById((int32_t) args.get<int64_t>(0));
         auto seed = (int32_t) args.get<int64_t>(1);
@@ -268,20 +382,12 @@ void AapJsControllerRuntime::registerBindings() {
         if (!buffer)
             return {};
         auto frames = buffer->num_frames(buffer);
-        for (int32_t p = 0, n = instance->getNumPorts(); p < n; ++p) {
-            auto* port = instance->getPort(p);
-            if (!port || port->getContentType() != AAP_CONTENT_TYPE_AUDIO ||
-                port->getPortDirection() != AAP_PORT_DIRECTION_INPUT)
-                continue;
+        for (auto p : getAudioPorts(instance, AAP_PORT_DIRECTION_INPUT)) {
             auto* data = static_cast<float*>(buffer->get_buffer(buffer, p));
             if (!data)
                 continue;
             auto samples = std::min<int32_t>(frames, buffer->get_buffer_size(buffer, p) / sizeof(float));
-            for (int32_t i = 0; i < samples; ++i) {
-                auto phase = static_cast<double>((seed + i + p * 31) % 97) / 97.0;
-                data[i] = static_cast<float>((std::sin(phase * 6.283185307179586) * 0.7 +
-                                              std::sin(phase * 18.84955592153876) * 0.3) * amplitude);
-            }
+            fillSyntheticAudioInput(data, samples, seed, 0, p, amplitude);
         }
         return {};
     });
@@ -297,20 +403,8 @@ void AapJsControllerRuntime::registerBindings() {
         if (!sourceBuffer || !destinationBuffer)
             return {};
 
-        std::vector<int32_t> sourcePorts;
-        std::vector<int32_t> destinationPorts;
-        for (int32_t p = 0, n = source->getNumPorts(); p < n; ++p) {
-            auto* port = source->getPort(p);
-            if (port && port->getContentType() == AAP_CONTENT_TYPE_AUDIO &&
-                port->getPortDirection() == AAP_PORT_DIRECTION_OUTPUT)
-                sourcePorts.push_back(p);
-        }
-        for (int32_t p = 0, n = destination->getNumPorts(); p < n; ++p) {
-            auto* port = destination->getPort(p);
-            if (port && port->getContentType() == AAP_CONTENT_TYPE_AUDIO &&
-                port->getPortDirection() == AAP_PORT_DIRECTION_INPUT)
-                destinationPorts.push_back(p);
-        }
+        auto sourcePorts = getAudioPorts(source, AAP_PORT_DIRECTION_OUTPUT);
+        auto destinationPorts = getAudioPorts(destination, AAP_PORT_DIRECTION_INPUT);
 
         const auto portCount = std::min(sourcePorts.size(), destinationPorts.size());
         for (size_t i = 0; i < portCount; ++i) {
@@ -335,39 +429,41 @@ void AapJsControllerRuntime::registerBindings() {
         auto arr = createEmptyArray();
         if (!buffer)
             return arr;
-        for (int32_t p = 0, n = instance->getNumPorts(); p < n; ++p) {
-            auto* port = instance->getPort(p);
-            if (!port || port->getContentType() != AAP_CONTENT_TYPE_AUDIO ||
-                port->getPortDirection() != AAP_PORT_DIRECTION_OUTPUT)
-                continue;
+        for (auto p : getAudioPorts(instance, AAP_PORT_DIRECTION_OUTPUT)) {
             auto* data = static_cast<float*>(buffer->get_buffer(buffer, p));
             auto samples = data ? std::min<int32_t>(buffer->num_frames(buffer), buffer->get_buffer_size(buffer, p) / sizeof(float)) : 0;
-            double sum = 0.0, sumAbs = 0.0, sumSq = 0.0, maxAbs = 0.0;
-            uint32_t hash = 2166136261u;
-            for (int32_t i = 0; i < samples; ++i) {
-                auto v = static_cast<double>(data[i]);
-                auto av = std::abs(v);
-                sum += v;
-                sumAbs += av;
-                sumSq += v * v;
-                maxAbs = std::max(maxAbs, av);
-                int32_t q = static_cast<int32_t>(std::max(-1.0, std::min(1.0, v)) * 2147483647.0);
-                hash ^= static_cast<uint32_t>(q);
-                hash *= 16777619u;
-            }
-            auto obj = createObject("");
+            AudioOutputStats stats;
+            stats.add(data, samples);
+            auto obj = stats.toObject();
             obj.setMember("port", static_cast<int64_t>(p));
-            obj.setMember("samples", static_cast<int64_t>(samples));
-            obj.setMember("sum", sum);
-            obj.setMember("sumAbs", sumAbs);
-            obj.setMember("rms", samples > 0 ? std::sqrt(sumSq / samples) : 0.0);
-            obj.setMember("maxAbs", maxAbs);
-            obj.setMember("hash", static_cast<int64_t>(hash));
             arr.addArrayElement(obj);
         }
         return arr;
     });
 
+    // process() tracing of the client instance (see aap::ProcessTrace). The flags are
+    // aap::ProcessTraceFlags; 0 disables the recording.
+    ctx.registerFunction("__aap_instance_set_process_trace_flags", [this](choc::javascript::ArgumentList args) -> Value {
+        auto instance = requireClient()->getInstanceById((int32_t) args.get<int64_t>(0));
+        instance->getProcessTrace().setFlags((uint32_t) args.get<int64_t>(1));
+        return {};
+    });
+
+    ctx.registerFunction("__aap_instance_reset_process_trace_histograms", [this](choc::javascript::ArgumentList args) -> Value {
+        requireClient()->getInstanceById((int32_t) args.get<int64_t>(0))->getProcessTrace().resetHistograms();
+        return {};
+    });
+
+    ctx.registerFunction("__aap_instance_dump_process_trace_histograms", [this](choc::javascript::ArgumentList args) -> Value {
+        auto instance = requireClient()->getInstanceById((int32_t) args.get<int64_t>(0));
+        return Value(instance->getProcessTrace().dumpHistograms());
+    });
+
+    ctx.registerFunction("__aap_instance_dump_process_trace_events", [this](choc::javascript::ArgumentList args) -> Value {
+        auto instance = requireClient()->getInstanceById((int32_t) args.get<int64_t>(0));
+        return Value(instance->getProcessTrace().dumpEventsAsJson());
+    });
+
     ctx.registerFunction("__aap_instance_add_event_ump_input_hex", [this](choc::javascript::ArgumentList args) -> Value {
         auto instance = requireClient()->getInstanceById((int32_t) args.get<int64_t>(0));
         auto bytes = hexDecode(args.get<std::string>(1));
@@ -74,7 +74,8 @@ size_t aap::AAPMidiEventTranslator::runThroughMidi2UmpForMidiMapping(uint8_t* by
         }
         if (presetIndex >= 0) {
             if (instance->getInstanceState() == aap::PluginInstantiationState::PLUGIN_INSTANTIATION_STATE_ACTIVE) {
-                auto aapxsInstance = instance->getAAPXSDispatcher().getPluginAAPXSByUri(AAP_PRESETS_EXTENSION_URI);
+                constexpr auto presetsUriHash = aap::xs::UridMapping::hashUri(AAP_PRESETS_EXTENSION_URI);
+                auto aapxsInstance = instance->getAAPXSDispatcher().getPluginAAPXSByUri(AAP_PRESETS_EXTENSION_URI, presetsUriHash);
                 auto size = aap_midi2_generate_aapxs_sysex8(
                         (uint32_t *) (translation_buffer + translatedIndex),
                         (midi_buffer_size - translatedIndex) / 4,
@@ -1,4 +1,6 @@
 #include "AudioBuffer.h"
+#include <algorithm>
+#include "aap/ext/midi.h"
 #include "aap/unstable/utility.h"
 
 aap::AudioBuffer::AudioBuffer(int32_t numChannels, int32_t framesPerCallback, int32_t midiBufferSize) {
@@ -8,6 +10,7 @@ aap::AudioBuffer::AudioBuffer(int32_t numChannels, int32_t framesPerCallback, in
     if (midiBufferSize <= 0)
         AAP_ASSERT_FALSE; // note: should not reach here
     audio.clear();
+    deferred_channels.resize(numChannels, nullptr);
     midi_capacity = midiBufferSize;
     midi_in = midiBufferSize > 0 ? calloc(1, midiBufferSize) : nullptr;
     midi_out = midiBufferSize > 0 ? calloc(1, midiBufferSize) : nullptr;
@@ -30,6 +33,48 @@ aap_buffer_t aap::AudioBuffer::asAAPBuffer() {
     return ret;
 }
 
+void aap::AudioBuffer::clearDirtyRegions(int32_t numFrames, int32_t framesToBeOverwritten) {
+    auto from = std::max(0, framesToBeOverwritten);
+    if (from < dirty_frames)
+        for (uint32_t ch = 0; ch < audio.getNumChannels(); ch++)
+            memset(audio.getChannel(ch).data.data + from, 0, (dirty_frames - from) * sizeof(float));
+    dirty_frames = std::min(std::max(numFrames, 0), (int32_t) audio.getNumFrames());
+    discardDeferredAudio();
+
+    for (auto midi : {midi_in, midi_out}) {
+        if (!midi)
+            continue;
+        auto size = std::min((int64_t) sizeof(AAPMidiBufferHeader) + ((AAPMidiBufferHeader*) midi)->length,
+                             (int64_t) midi_capacity);
+        memset(midi, 0, (size_t) size);
+    }
+}
+
+void aap::AudioBuffer::deferAudioChannel(int32_t channel, const float* data, int32_t numFrames) {
+    if (!deferred_channels[channel])
+        num_deferred_channels++;
+    deferred_channels[channel] = data;
+    deferred_frames = std::min(numFrames, (int32_t) audio.getNumFrames());
+}
+
+void aap::AudioBuffer::copyDeferredAudio() {
+    for (uint32_t ch = 0; ch < deferred_channels.size(); ch++) {
+        if (!deferred_channels[ch])
+            continue;
+        memcpy(audio.getChannel(ch).data.data, deferred_channels[ch], deferred_frames * sizeof(float));
+        deferred_channels[ch] = nullptr;
+    }
+    dirty_frames = std::max(dirty_frames, deferred_frames);
+    num_deferred_channels = 0;
+}
+
+void aap::AudioBuffer::discardDeferredAudio() {
+    if (num_deferred_channels == 0)
+        return;
+    std::fill(deferred_channels.begin(), deferred_channels.end(), nullptr);
+    num_deferred_channels = 0;
+}
+
 int32_t aap::AudioBuffer::aapBufferGetNumFrames(aap_buffer_t *b) {
     return ((AudioBuffer*) b->impl)->audio.getNumFrames();
 }
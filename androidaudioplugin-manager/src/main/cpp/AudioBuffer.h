@@ -6,6 +6,7 @@
 #include <choc/audio/choc_SampleBuffers.h>
 #include <choc/containers/choc_SingleReaderSingleWriterFIFO.h>
 #include <aap/android-audio-plugin.h>
+#include <vector>
 
 namespace aap {
 
@@ -15,6 +16,17 @@ namespace aap {
         static int32_t aapBufferGetBufferSize(aap_buffer_t *, int32_t);
         static int32_t aapBufferGetNumPorts(aap_buffer_t *);
 
+        // frames of `audio` that may have been written since the last `clearDirtyRegions()`.
+        // Everything after them is always zero.
+        int32_t dirty_frames{0};
+
+        // Audio channels that still live in another buffer (typically the aap_buffer_t of the
+        // plugin that produced them), or nullptr if they are in `audio`. See `deferAudioChannel()`.
+        std::vector<const float*> deferred_channels{};
+        int32_t num_deferred_channels{0};
+        int32_t deferred_frames{0};
+        bool deferral_allowed{false};
+
     public:
         choc::buffer::ChannelArrayBuffer<float> audio;
         void *midi_in;
@@ -26,6 +38,57 @@ namespace aap {
         ~AudioBuffer();
 
         aap_buffer_t asAAPBuffer();
+
+        /**
+         * Clears what the previous cycle may have written, instead of the whole buffer:
+         * `audio` up to the frame count of the previous cycle, and the MIDI buffers up to their
+         * AAPMidiBufferHeader length (bytes beyond the header length are not cleared).
+         *
+         * `numFrames` is the frame count of the next cycle. If the caller is going to overwrite
+         * `framesToBeOverwritten` frames of all the channels anyway, they are not cleared.
+         */
+        void clearDirtyRegions(int32_t numFrames, int32_t framesToBeOverwritten = 0);
+
+        /**
+         * Audio graphs set it when the only consumer of this buffer can read deferred audio
+         * channels (by `getAudioChannelData()`), so that a producer does not have to copy its
+         * outputs into `audio` only to get them copied out again.
+         */
+        void setAudioDeferralAllowed(bool allowed) { deferral_allowed = allowed; }
+        bool isAudioDeferralAllowed() { return deferral_allowed; }
+
+        /**
+         * Lets `channel` refer to `data` (which has to stay valid until the consumer reads it)
+         * instead of copying it into `audio`. Only valid while `isAudioDeferralAllowed()`.
+         */
+        void deferAudioChannel(int32_t channel, const float* data, int32_t numFrames);
+
+        // Returns the data of `channel`, wherever it currently is.
+        const float* getAudioChannelData(int32_t channel) {
+            return num_deferred_channels > 0 && deferred_channels[channel] ?
+                   deferred_channels[channel] : audio.getChannel(channel).data.data;
+        }
+
+        // Returns `audio` of `channel` for overwriting it, which cancels its deferral if any.
+        float* getAudioChannelForWrite(int32_t channel) {
+            if (num_deferred_channels > 0 && deferred_channels[channel]) {
+                deferred_channels[channel] = nullptr;
+                num_deferred_channels--;
+            }
+            return audio.getChannel(channel).data.data;
+        }
+
+        // Copies the deferred audio channels into `audio`. No-op if there is none.
+        void resolveDeferredAudio() {
+            if (num_deferred_channels > 0)
+                copyDeferredAudio();
+        }
+
+        // Forgets the deferred audio channels, for when `audio` is going to be overwritten anyway.
+        void discardDeferredAudio();
+
+    private:
+        void copyDeferredAudio();
     };
 
 }
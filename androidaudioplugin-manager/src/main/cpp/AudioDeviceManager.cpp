@@ -12,6 +12,13 @@ aap::AudioDeviceManager* aap::AudioDeviceManager::getInstance() {
 
 #else
 
-// implement desktop version?
+#include "VirtualAudioDeviceManager.h"
+
+// There is no audio device backend on desktop (yet); the virtual devices render headless.
+aap::VirtualAudioDeviceManager audioDeviceManager{};
+
+aap::AudioDeviceManager* aap::AudioDeviceManager::getInstance() {
+    return &audioDeviceManager;
+}
 
 #endif
@@ -0,0 +1,580 @@
+#include "AudioGraph.h"
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <aap/ext/midi.h>
+#include <aap/unstable/logging.h>
+#if ANDROID
+#include <android/trace.h>
+#endif
+
+#define LOG_TAG "AAP.AudioGraph.Basic"
+
+#define AAP_AUDIO_GRAPH_MAX_DEFAULT_WORKERS 3
+
+namespace {
+    // Workers park on the cycle generation between cycles. The futex is process-local.
+    void waitForChange(std::atomic<uint32_t>* word, uint32_t expected) {
+#if defined(__linux__)
+        syscall(SYS_futex, (uint32_t*) word, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+        const auto delay = timespec{0, 50000}; // 50 microseconds
+        clock_nanosleep(CLOCK_REALTIME, 0, &delay, nullptr);
+#endif
+    }
+
+    void wakeAll(std::atomic<uint32_t>* word) {
+#if defined(__linux__)
+        syscall(SYS_futex, (uint32_t*) word, FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+#endif
+    }
+
+    void copyMidi(void* dst, const void* src, int32_t capacity) {
+        auto mbh = (const AAPMidiBufferHeader*) src;
+        auto size = std::min((int32_t) (sizeof(AAPMidiBufferHeader) + mbh->length), capacity);
+        memcpy(dst, src, size);
+    }
+
+    // message type 0 (utility), status 0x20
+    bool isJRTimestamp(uint32_t word0) { return (word0 & 0xF0F00000) == 0x00200000; }
+
+    // UMP packet size in 32-bit words, by the message type (the top 4 bits of the first word).
+    uint32_t umpWords(uint32_t word0) {
+        static constexpr uint8_t sizes[16] {1, 1, 1, 2, 2, 4, 1, 1, 2, 2, 2, 3, 3, 4, 4, 4};
+        return sizes[word0 >> 28];
+    }
+
+    // Walks a UMP sequence packet by packet, keeping track of the JR Timestamp time.
+    struct UmpCursor {
+        const uint32_t* words;
+        uint32_t num_words;
+        uint32_t position{0};
+        int64_t ticks{0};
+
+        // skips the JR Timestamps in front of the next packet. Returns false at the end.
+        bool advance() {
+            while (position < num_words && isJRTimestamp(words[position]))
+                ticks += words[position++] & 0xFFFF;
+            return position < num_words;
+        }
+        uint32_t packetWords() { return std::min(umpWords(words[position]), num_words - position); }
+    };
+
+    // Merges the UMPs in `src` into `dst` in the order of their JR Timestamps (packets at the
+    // same time keep `dst` first). `scratch` must hold `capacity` bytes. What does not fit is dropped.
+    void mergeMidi(void* dst, const void* src, int32_t capacity, uint8_t* scratch) {
+        auto dstHeader = (AAPMidiBufferHeader*) dst;
+        auto srcHeader = (const AAPMidiBufferHeader*) src;
+        if (srcHeader->length == 0)
+            return;
+        if (dstHeader->length == 0) {
+            copyMidi(dst, src, capacity);
+            return;
+        }
+        // in 32-bit words
+        auto available = (uint32_t) ((capacity - (int32_t) sizeof(AAPMidiBufferHeader)) / (int32_t) sizeof(uint32_t));
+        auto dstWords = std::min(dstHeader->length / (uint32_t) sizeof(uint32_t), available);
+        memcpy(scratch, dstHeader + 1, dstWords * sizeof(uint32_t));
+        UmpCursor a{(const uint32_t*) scratch, dstWords};
+        UmpCursor b{(const uint32_t*) (srcHeader + 1), srcHeader->length / (uint32_t) sizeof(uint32_t)};
+        auto out = (uint32_t*) (dstHeader + 1);
+        uint32_t length = 0;
+        int64_t ticks = 0;
+        bool hasA = a.advance(), hasB = b.advance();
+        while (hasA || hasB) {
+            auto& c = hasA && (!hasB || a.ticks <= b.ticks) ? a : b;
+            auto size = c.packetWords();
+            auto numTimestamps = c.ticks > ticks ? (uint32_t) ((c.ticks - ticks - 1) / 31250 + 1) : 0;
+            if (length + numTimestamps + size > available)
+                break;
+            for (; ticks < c.ticks; ticks += std::min<int64_t>(c.ticks - ticks, 31250))
+                out[length++] = cmidi2_ump_jr_timestamp_direct((uint32_t) std::min<int64_t>(c.ticks - ticks, 31250));
+            memcpy(out + length, c.words + c.position, size * sizeof(uint32_t));
+            length += size;
+            c.position += size;
+            hasA = a.advance();
+            hasB = b.advance();
+        }
+        dstHeader->length = length * sizeof(uint32_t);
+    }
+
+    void copyBuffer(aap::AudioBuffer* dst, aap::AudioBuffer* src, int32_t numFrames) {
+        dst->discardDeferredAudio();
+        auto numChannels = std::min(dst->audio.getNumChannels(), src->audio.getNumChannels());
+        auto frames = std::min((int32_t) std::min(dst->audio.getNumFrames(), src->audio.getNumFrames()), numFrames);
+        for (uint32_t ch = 0; ch < numChannels; ch++)
+            memcpy(dst->audio.getChannel(ch).data.data, src->audio.getChannel(ch).data.data, frames * sizeof(float));
+        auto capacity = std::min(dst->midi_capacity, src->midi_capacity);
+        copyMidi(dst->midi_in, src->midi_in, capacity);
+        copyMidi(dst->midi_out, src->midi_out, capacity);
+    }
+
+    // Unites the sorted set `src` into `dst`.
+    void unite(std::vector<int32_t>& dst, const std::vector<int32_t>& src) {
+        std::vector<int32_t> result{};
+        std::set_union(dst.begin(), dst.end(), src.begin(), src.end(), std::back_inserter(result));
+        dst = std::move(result);
+    }
+}
+
+// How the outputs of some nodes are mixed into one buffer: audio is summed, and a MIDI sequence
+// is merged unless an earlier source brought every part of it already (see rebuildSchedule()).
+struct aap::BasicAudioGraph::MixPlan {
+    std::vector<AudioBuffer*> views{};
+    std::vector<bool> merge_midi_in{};
+    std::vector<bool> merge_midi_out{};
+    // for mergeMidi(); empty if there is only one source.
+    std::vector<uint8_t> midi_scratch{};
+};
+
+namespace {
+    // Mixes `plan.views[index]` into `dst`, which already contains the earlier sources.
+    void mixBuffer(aap::AudioBuffer* dst, aap::BasicAudioGraph::MixPlan& plan, size_t index, int32_t numFrames) {
+        auto src = plan.views[index];
+        auto numChannels = std::min(dst->audio.getNumChannels(), src->audio.getNumChannels());
+        auto frames = std::min((int32_t) std::min(dst->audio.getNumFrames(), src->audio.getNumFrames()), numFrames);
+        for (uint32_t ch = 0; ch < numChannels; ch++) {
+            auto d = dst->audio.getChannel(ch).data.data;
+            auto s = src->audio.getChannel(ch).data.data;
+            for (int32_t i = 0; i < frames; i++)
+                d[i] += s[i];
+        }
+        auto capacity = std::min(std::min(dst->midi_capacity, src->midi_capacity), (int32_t) plan.midi_scratch.size());
+        if (plan.merge_midi_in[index])
+            mergeMidi(dst->midi_in, src->midi_in, capacity, plan.midi_scratch.data());
+        if (plan.merge_midi_out[index])
+            mergeMidi(dst->midi_out, src->midi_out, capacity, plan.midi_scratch.data());
+    }
+
+    // Makes the calling worker thread follow the scheduling of the audio thread. Returns false if
+    // the audio thread is realtime and the worker could not get the same scheduling.
+    bool followAudioThreadScheduling(int32_t policy, int32_t priority) {
+        sched_param param{};
+        if (policy != SCHED_FIFO && policy != SCHED_RR) {
+            // the audio thread does not preempt the workers either.
+            pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+            return true;
+        }
+        param.sched_priority = priority;
+        auto error = pthread_setschedparam(pthread_self(), policy, &param);
+        if (error == 0)
+            return true;
+        aap::a_log_f(AAP_LOG_LEVEL_WARN, LOG_TAG,
+                     "A worker thread could not get the realtime scheduling of the audio thread (error %d). It does not take part in the processing.",
+                     error);
+        return false;
+    }
+}
+
+// Immutable topology (sorted) plus the per-cycle state that the audio thread resets every cycle.
+struct aap::BasicAudioGraph::Schedule {
+    struct Entry {
+        AudioGraphNode* node;
+        // null if it is aliased.
+        std::unique_ptr<AudioBuffer> buffer;
+        // the buffer it processes: either `buffer` or the one of its only input.
+        AudioBuffer* view{nullptr};
+        bool aliased{false};
+        // whether the node may leave deferred audio channels in `view` for the next node.
+        bool defer_output{false};
+        bool writes_midi_output{false};
+        std::vector<int32_t> inputs{};
+        std::vector<int32_t> outputs{};
+    };
+    std::vector<Entry> entries{};
+    std::vector<int32_t> roots{};
+    std::vector<int32_t> sinks{};
+
+    // per-cycle state
+    std::unique_ptr<std::atomic<int32_t>[]> pending{};
+    // ready queue. Every node gets ready exactly once per cycle, so it never wraps around.
+    // Each slot holds (entry index + 1), 0 until it is published.
+    std::unique_ptr<std::atomic<int32_t>[]> ready{};
+    std::atomic<int32_t> ready_head{0};
+    std::atomic<int32_t> ready_tail{0};
+    std::atomic<int32_t> completed{0};
+    AudioBuffer* graph_buffer{nullptr};
+    int32_t num_frames{0};
+    // how the inputs of each entry, and the sinks, are mixed.
+    std::vector<MixPlan> input_mixes{};
+    MixPlan sink_mix{};
+
+    int32_t size() { return (int32_t) entries.size(); }
+
+    void push(int32_t index) {
+        auto at = ready_tail.fetch_add(1, std::memory_order_acq_rel);
+        ready[at].store(index + 1, std::memory_order_release);
+    }
+};
+
+aap::BasicAudioGraph::BasicAudioGraph(int32_t sampleRate, int32_t framesPerCallback, int32_t channelsInAudioBus, int32_t numWorkerThreads) :
+        AudioGraph(sampleRate, framesPerCallback, channelsInAudioBus),
+        num_worker_threads(numWorkerThreads) {
+    if (num_worker_threads < 0)
+        num_worker_threads = std::min(std::max((int32_t) std::thread::hardware_concurrency() - 1, 0),
+                                      AAP_AUDIO_GRAPH_MAX_DEFAULT_WORKERS);
+}
+
+aap::BasicAudioGraph::~BasicAudioGraph() {
+    pauseProcessing();
+    delete schedule.exchange(nullptr);
+}
+
+void aap::BasicAudioGraph::addNode(AudioGraphNode* node) {
+    const std::lock_guard<std::mutex> lock{topology_mutex};
+    if (std::find(nodes.begin(), nodes.end(), node) != nodes.end())
+        return;
+    nodes.emplace_back(node);
+    rebuildSchedule();
+}
+
+void aap::BasicAudioGraph::removeNode(AudioGraphNode* node) {
+    const std::lock_guard<std::mutex> lock{topology_mutex};
+    nodes.erase(std::remove(nodes.begin(), nodes.end(), node), nodes.end());
+    edges.erase(std::remove_if(edges.begin(), edges.end(), [node](Edge& e) {
+        return e.source == node || e.destination == node;
+    }), edges.end());
+    rebuildSchedule();
+}
+
+bool aap::BasicAudioGraph::attachNode(AudioGraphNode* sourceNode, int32_t sourceOutputBusIndex,
+                                      AudioGraphNode* destinationNode, int32_t destinationInputBusIndex) {
+    if (sourceOutputBusIndex != 0 || destinationInputBusIndex != 0) {
+        aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Only bus 0 is supported (source: %d, destination: %d)",
+                     sourceOutputBusIndex, destinationInputBusIndex);
+        return false;
+    }
+    if (sourceNode == destinationNode) {
+        aap::a_log(AAP_LOG_LEVEL_ERROR, LOG_TAG, "A node cannot be attached to itself");
+        return false;
+    }
+
+    const std::lock_guard<std::mutex> lock{topology_mutex};
+    for (auto node : {sourceNode, destinationNode})
+        if (std::find(nodes.begin(), nodes.end(), node) == nodes.end())
+            nodes.emplace_back(node);
+    for (auto& e : edges)
+        if (e.source == sourceNode && e.destination == destinationNode)
+            return true;
+    edges.emplace_back(Edge{sourceNode, destinationNode});
+    if (!rebuildSchedule()) {
+        edges.pop_back();
+        return false;
+    }
+    return true;
+}
+
+void aap::BasicAudioGraph::detachNode(AudioGraphNode* sourceNode, int32_t sourceOutputBusIndex) {
+    if (sourceOutputBusIndex != 0)
+        return; // there is no such edge
+    const std::lock_guard<std::mutex> lock{topology_mutex};
+    edges.erase(std::remove_if(edges.begin(), edges.end(), [sourceNode](Edge& e) {
+        return e.source == sourceNode;
+    }), edges.end());
+    rebuildSchedule();
+}
+
+// must be called under topology_mutex.
+bool aap::BasicAudioGraph::rebuildSchedule() {
+    auto n = (int32_t) nodes.size();
+    auto indexOf = [&](AudioGraphNode* node) {
+        return (int32_t) (std::find(nodes.begin(), nodes.end(), node) - nodes.begin());
+    };
+
+    // Kahn's algorithm
+    std::vector<std::vector<int32_t>> successors(n);
+    std::vector<int32_t> inDegree(n, 0);
+    for (auto& e : edges) {
+        auto s = indexOf(e.source);
+        auto d = indexOf(e.destination);
+        successors[s].emplace_back(d);
+        inDegree[d]++;
+    }
+    std::vector<int32_t> order{};
+    for (int32_t i = 0; i < n; i++)
+        if (inDegree[i] == 0)
+            order.emplace_back(i);
+    for (size_t i = 0; i < order.size(); i++)
+        for (auto d : successors[order[i]])
+            if (--inDegree[d] == 0)
+                order.emplace_back(d);
+    if ((int32_t) order.size() != n) {
+        aap::a_log(AAP_LOG_LEVEL_ERROR, LOG_TAG, "The audio graph contains a cycle; topology change is rejected.");
+        return false;
+    }
+
+    auto next = new Schedule();
+    std::vector<int32_t> position(n);
+    for (int32_t i = 0; i < n; i++)
+        position[order[i]] = i;
+    next->entries.resize(n);
+    for (int32_t i = 0; i < n; i++) {
+        auto& entry = next->entries[i];
+        entry.node = nodes[order[i]];
+        for (auto d : successors[order[i]]) {
+            entry.outputs.emplace_back(position[d]);
+            next->entries[position[d]].inputs.emplace_back(i);
+        }
+    }
+    // An exclusive edge (the only output of the source, the only input of the destination) lets
+    // the destination work on the source's buffer. Inputs are always earlier in the order, so
+    // their views are already determined.
+    for (int32_t i = 0; i < n; i++) {
+        auto& entry = next->entries[i];
+        if (entry.inputs.size() == 1 && next->entries[entry.inputs[0]].outputs.size() == 1) {
+            auto& source = next->entries[entry.inputs[0]];
+            entry.aliased = true;
+            entry.view = source.view;
+            source.defer_output = entry.node->canReadDeferredAudio();
+        } else {
+            entry.buffer = std::make_unique<AudioBuffer>(getChannelsInAudioBus(), getFramesPerCallback());
+            entry.view = entry.buffer.get();
+        }
+    }
+
+    // Where the MIDI sequences of each buffer come from, as sorted entry indices (-1 is the buffer
+    // passed to processAudio()). Every root gets the MIDI of the graph input, so parallel branches
+    // that only pass it along carry the same sequence; it must be merged only once where they meet.
+    std::vector<std::vector<int32_t>> midiInOrigins(n), midiOutOrigins(n);
+    auto planMix = [&](MixPlan& plan, const std::vector<int32_t>& sources) {
+        std::vector<int32_t> mergedIn{}, mergedOut{};
+        for (auto source : sources) {
+            auto& in = midiInOrigins[source];
+            auto& out = midiOutOrigins[source];
+            plan.views.emplace_back(next->entries[source].view);
+            // the first source is copied as a whole.
+            plan.merge_midi_in.emplace_back(!std::includes(mergedIn.begin(), mergedIn.end(), in.begin(), in.end()));
+            plan.merge_midi_out.emplace_back(!std::includes(mergedOut.begin(), mergedOut.end(), out.begin(), out.end()));
+            unite(mergedIn, in);
+            unite(mergedOut, out);
+        }
+        if (sources.size() > 1)
+            plan.midi_scratch.resize(AAP_MANAGER_MIDI_BUFFER_SIZE);
+    };
+    next->input_mixes.resize(n);
+    for (int32_t i = 0; i < n; i++) {
+        auto& entry = next->entries[i];
+        entry.writes_midi_output = entry.node->writesMidiOutput();
+        if (entry.inputs.empty()) {
+            next->roots.emplace_back(i);
+            midiInOrigins[i] = {-1};
+            midiOutOrigins[i] = {-1};
+        }
+        for (auto input : entry.inputs) {
+            unite(midiInOrigins[i], midiInOrigins[input]);
+            unite(midiOutOrigins[i], midiOutOrigins[input]);
+        }
+        if (entry.node->writesMidiInput())
+            unite(midiInOrigins[i], {i});
+        if (entry.writes_midi_output)
+            midiOutOrigins[i] = {i};
+        if (!entry.aliased && !entry.inputs.empty())
+            planMix(next->input_mixes[i], entry.inputs);
+        if (entry.outputs.empty())
+            next->sinks.emplace_back(i);
+    }
+    planMix(next->sink_mix, next->sinks);
+    next->pending = std::make_unique<std::atomic<int32_t>[]>(n);
+    next->ready = std::make_unique<std::atomic<int32_t>[]>(n);
+
+    // swap it in, then wait until the audio thread is done with the old one (if it is in a cycle).
+    auto old = schedule.exchange(next);
+    auto epoch = cycle_epoch.load();
+    if (epoch & 1) {
+        const auto delay = timespec{0, 100000}; // 100 microseconds
+        while (cycle_epoch.load() == epoch)
+            clock_nanosleep(CLOCK_REALTIME, 0, &delay, nullptr);
+    }
+    delete old;
+    return true;
+}
+
+void aap::BasicAudioGraph::processNode(Schedule* s, int32_t index) {
+    auto& entry = s->entries[index];
+    auto buffer = entry.view;
+    if (entry.aliased)
+        ; // the input is already there.
+    else if (entry.inputs.empty())
+        copyBuffer(buffer, s->graph_buffer, s->num_frames);
+    else {
+        auto& mix = s->input_mixes[index];
+        copyBuffer(buffer, mix.views[0], s->num_frames);
+        for (size_t i = 1; i < mix.views.size(); i++)
+            mixBuffer(buffer, mix, i, s->num_frames);
+    }
+
+    buffer->setAudioDeferralAllowed(entry.defer_output);
+    if (!entry.node->shouldSkip())
+        entry.node->processAudio(buffer, s->num_frames);
+    else if (entry.writes_midi_output)
+        // its MIDI output is empty then, not what it got from its inputs (see rebuildSchedule()).
+        ((AAPMidiBufferHeader*) buffer->midi_out)->length = 0;
+    // whoever comes next (including the node itself when it is skipped) cannot read deferred audio.
+    if (!entry.defer_output)
+        buffer->resolveDeferredAudio();
+
+    for (auto o : entry.outputs)
+        if (s->pending[o].fetch_sub(1, std::memory_order_acq_rel) == 1)
+            s->push(o);
+    s->completed.fetch_add(1, std::memory_order_acq_rel);
+}
+
+// Takes one node from the ready queue and processes it. Returns false if there was nothing ready.
+bool aap::BasicAudioGraph::runReadyNode(Schedule* s) {
+    auto head = s->ready_head.load(std::memory_order_acquire);
+    if (head >= s->ready_tail.load(std::memory_order_acquire))
+        return false;
+    if (!s->ready_head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel))
+        return true; // someone else took it; try again
+    int32_t value;
+    // the slot is reserved but might not be published yet.
+    while ((value = s->ready[head].load(std::memory_order_acquire)) == 0)
+        ;
+    processNode(s, value - 1);
+    return true;
+}
+
+void aap::BasicAudioGraph::processAudio(AudioBuffer *audioData, int32_t numFrames) {
+    struct timespec timeSpecBegin{}, timeSpecEnd{};
+#if ANDROID
+    if (ATrace_isEnabled()) {
+        ATrace_beginSection("AAP::BasicAudioGraph_processAudio");
+        clock_gettime(CLOCK_REALTIME, &timeSpecBegin);
+    }
+#endif
+
+    cycle_epoch.fetch_add(1);
+    // the workers follow it (see workerLoop()). It is queried once per startProcessing().
+    if (audio_thread_policy.load(std::memory_order_relaxed) < 0) {
+        int policy;
+        sched_param param{};
+        if (pthread_getschedparam(pthread_self(), &policy, &param) == 0) {
+            audio_thread_priority.store(param.sched_priority, std::memory_order_relaxed);
+            audio_thread_policy.store(policy, std::memory_order_release);
+        }
+    }
+    auto s = schedule.load();
+    if (s && s->size() > 0) {
+        auto n = s->size();
+        for (int32_t i = 0; i < n; i++) {
+            s->pending[i].store((int32_t) s->entries[i].inputs.size(), std::memory_order_relaxed);
+            s->ready[i].store(0, std::memory_order_relaxed);
+        }
+        s->ready_head.store(0, std::memory_order_relaxed);
+        s->ready_tail.store(0, std::memory_order_relaxed);
+        s->completed.store(0, std::memory_order_relaxed);
+        s->graph_buffer = audioData;
+        s->num_frames = numFrames;
+        for (auto r : s->roots)
+            s->push(r);
+
+        // let the workers join, and work on the nodes by ourselves too.
+        cycle_schedule.store(s);
+        cycle_generation.fetch_add(1);
+        if (parked_workers.load() > 0)
+            wakeAll(&cycle_generation);
+        while (s->completed.load(std::memory_order_acquire) < n)
+            runReadyNode(s);
+        cycle_schedule.store(nullptr);
+        // workers leave as soon as they see the cycle completed; make sure none of them still
+        // looks at this cycle before we reset it next time.
+        while (active_workers.load() > 0)
+            ;
+
+        copyBuffer(audioData, s->sink_mix.views[0], numFrames);
+        for (size_t i = 1; i < s->sink_mix.views.size(); i++)
+            mixBuffer(audioData, s->sink_mix, i, numFrames);
+    }
+    cycle_epoch.fetch_add(1);
+
+#if ANDROID
+    if (ATrace_isEnabled()) {
+        clock_gettime(CLOCK_REALTIME, &timeSpecEnd);
+        ATrace_setCounter("AAP::BasicAudioGraph_processAudio",
+                          (timeSpecEnd.tv_sec - timeSpecBegin.tv_sec) * 1000000000 + timeSpecEnd.tv_nsec - timeSpecBegin.tv_nsec);
+        ATrace_endSection();
+    }
+#endif
+}
+
+void aap::BasicAudioGraph::workerLoop() {
+    uint32_t seen = cycle_generation.load(std::memory_order_acquire);
+    int32_t followedPolicy = -1;
+    bool canJoin = true;
+    while (workers_running.load(std::memory_order_acquire)) {
+        auto generation = cycle_generation.load(std::memory_order_acquire);
+        if (generation == seen) {
+            // sleep until the next cycle (or stopWorkers()). The audio thread increments the
+            // generation before it looks at `parked_workers`, and the futex wait returns at once
+            // if the generation has changed meanwhile, so no wakeup gets lost.
+            parked_workers.fetch_add(1);
+            waitForChange(&cycle_generation, seen);
+            parked_workers.fetch_sub(1);
+            continue;
+        }
+        seen = generation;
+
+        // The audio thread busy-waits for the nodes that the workers took. If a worker could be
+        // preempted by the audio thread's competitors, it must not take any node.
+        auto policy = audio_thread_policy.load(std::memory_order_acquire);
+        if (policy != followedPolicy) {
+            followedPolicy = policy;
+            canJoin = policy < 0 || followAudioThreadScheduling(policy, audio_thread_priority.load(std::memory_order_relaxed));
+        }
+        if (!canJoin)
+            continue; // keep sleeping
+
+        active_workers.fetch_add(1);
+        auto s = cycle_schedule.load();
+        if (s) {
+            auto n = s->size();
+            while (s->completed.load(std::memory_order_acquire) < n)
+                if (!runReadyNode(s))
+                    std::this_thread::yield();
+        }
+        active_workers.fetch_sub(1);
+    }
+}
+
+void aap::BasicAudioGraph::stopWorkers() {
+    workers_running.store(false);
+    cycle_generation.fetch_add(1);
+    wakeAll(&cycle_generation);
+    for (auto& t : workers)
+        if (t.joinable())
+            t.join();
+    workers.clear();
+}
+
+void aap::BasicAudioGraph::startProcessing() {
+    if (isProcessing())
+        return;
+    is_processing = true;
+    {
+        const std::lock_guard<std::mutex> lock{topology_mutex};
+        for (auto node : nodes)
+            node->start();
+    }
+    audio_thread_policy.store(-1);
+    workers_running.store(true);
+    for (int32_t i = 0; i < num_worker_threads; i++)
+        workers.emplace_back([this] { workerLoop(); });
+}
+
+void aap::BasicAudioGraph::pauseProcessing() {
+    if (!isProcessing())
+        return;
+    is_processing = false;
+    stopWorkers();
+    const std::lock_guard<std::mutex> lock{topology_mutex};
+    for (auto node : nodes)
+        node->pause();
+}
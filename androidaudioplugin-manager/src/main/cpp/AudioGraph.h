@@ -3,6 +3,10 @@
 
 #include <cstdint>
 #include <cassert>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "LocalDefinitions.h"
 #include "AudioDeviceManager.h"
@@ -20,6 +24,7 @@ namespace aap {
                 frames_per_callback(framesPerCallback),
                 num_channels(channelsInAudioBus) {
         }
+        virtual ~AudioGraph() = default;
 
         virtual void processAudio(AudioBuffer* audioData, int32_t numFrames) = 0;
 
@@ -73,15 +78,100 @@ namespace aap {
         }
     };
 
-    // Not planned to implement so far.
+    /**
+     * BasicAudioGraph processes an arbitrary DAG of AudioGraphNodes.
+     *
+     * Each node processes its own AudioBuffer. Its input is the sum of the outputs of the nodes
+     * attached to it (audio is mixed, MIDI2 sequences are appended), or the buffer passed to
+     * `processAudio()` if nothing is attached to it. The outputs of the nodes that are not attached
+     * to anything are mixed back into that buffer.
+     *
+     * Where an edge is the only output of its source and the only input of its destination, the
+     * destination processes the source's AudioBuffer in place instead of a copy of it. If the
+     * destination can read deferred audio (e.g. AudioPluginNode), the source may even leave its
+     * audio outputs in its own buffer (see `AudioBuffer::deferAudioChannel()`).
+     *
+     * Nodes run in topological order, and independent branches run in parallel on worker threads.
+     * The audio thread takes part in the processing too, so it never waits for idle workers.
+     * The workers take the scheduling policy and priority of the audio thread. A worker that cannot
+     * get the realtime scheduling of the audio thread does not take part, as the audio thread
+     * would wait for the nodes that it took while it is preempted. Between cycles the workers
+     * sleep until `processAudio()` wakes them up, and they are stopped by `pauseProcessing()`.
+     *
+     * Every node that has no input gets the MIDI2 sequences of the buffer passed to `processAudio()`.
+     * Where parallel branches meet, their sequences are merged in the order of their JR Timestamps.
+     * The graph tracks which nodes each sequence comes from (see `AudioGraphNode::writesMidiInput()`
+     * and `writesMidiOutput()`), so a sequence that an earlier branch already brought (e.g. the
+     * same input passed along) is not merged again.
+     *
+     * Topology changes are not realtime safe: they build a new schedule that the audio thread
+     * picks up at the next cycle. The graph does not own the nodes.
+     */
     class BasicAudioGraph : public AudioGraph {
+        struct Edge {
+            AudioGraphNode* source;
+            AudioGraphNode* destination;
+        };
+        struct Schedule;
+
+        std::mutex topology_mutex{};
+        std::vector<AudioGraphNode*> nodes{};
+        std::vector<Edge> edges{};
+        // the schedule that the audio thread uses. Replaced by `rebuildSchedule()`.
+        std::atomic<Schedule*> schedule{nullptr};
+        // incremented at both beginning and end of each cycle (i.e. odd while processing).
+        std::atomic<uint32_t> cycle_epoch{0};
+
+        int32_t num_worker_threads;
+        std::vector<std::thread> workers{};
+        std::atomic<bool> workers_running{false};
+        // incremented at the beginning of each cycle; idle workers sleep on it.
+        std::atomic<uint32_t> cycle_generation{0};
+        std::atomic<int32_t> parked_workers{0};
+        // non-null only while a cycle is in progress.
+        std::atomic<Schedule*> cycle_schedule{nullptr};
+        std::atomic<int32_t> active_workers{0};
+        // the scheduling of the audio thread that the workers follow; -1 until the first cycle.
+        std::atomic<int32_t> audio_thread_policy{-1};
+        std::atomic<int32_t> audio_thread_priority{0};
+        bool is_processing{false};
+
+        bool rebuildSchedule();
+        void workerLoop();
+        void stopWorkers();
+        static bool runReadyNode(Schedule* s);
+        static void processNode(Schedule* s, int32_t index);
+
     public:
-        BasicAudioGraph(int32_t sampleRate, int32_t framesPerCallback, int32_t channelsInAudioBus) :
-                AudioGraph(sampleRate, framesPerCallback, channelsInAudioBus) {
+        struct MixPlan;
+
+        // `numWorkerThreads` < 0 picks a default from the number of CPU cores.
+        BasicAudioGraph(int32_t sampleRate, int32_t framesPerCallback, int32_t channelsInAudioBus, int32_t numWorkerThreads = -1);
+        ~BasicAudioGraph() override;
+
+        // It can be passed to `AudioDeviceOut::setAudioCallback()` with the graph as the context.
+        static void audioCallback(void* callbackContext, AudioBuffer* audioData, int32_t numFrames) {
+            ((BasicAudioGraph*) callbackContext)->processAudio(audioData, numFrames);
         }
 
-        void attachNode(AudioGraphNode* sourceNode, int32_t sourceOutputBusIndex, AudioGraphNode* destinationNode, int32_t destinationInputBusIndex) {}
-        void detachNode(AudioGraphNode* sourceNode, int32_t sourceOutputBusIndex) {}
+        int32_t getWorkerThreadCount() { return num_worker_threads; }
+
+        void addNode(AudioGraphNode* node);
+        // Removes the node and all the edges from/to it. The node can be destroyed once it returns.
+        void removeNode(AudioGraphNode* node);
+
+        // Nodes are added if they are not in the graph yet. Only bus 0 is supported so far
+        // (every node processes one AudioBuffer). Returns false if the edge would make a cycle.
+        bool attachNode(AudioGraphNode* sourceNode, int32_t sourceOutputBusIndex, AudioGraphNode* destinationNode, int32_t destinationInputBusIndex);
+        void detachNode(AudioGraphNode* sourceNode, int32_t sourceOutputBusIndex);
+
+        void processAudio(AudioBuffer* audioData, int32_t numFrames) override;
+
+        bool isProcessing() { return is_processing; }
+
+        void startProcessing();
+
+        void pauseProcessing();
     };
 }
 
@@ -1,5 +1,8 @@
 #include "AudioGraphNode.h"
 #include "AudioGraph.h"
+#include <cmath>
+#include <thread>
+#include <aap/unstable/logging.h>
 #include <choc/audio/choc_AudioFileFormat_WAV.h>
 #include <choc/audio/choc_AudioFileFormat_MP3.h>
 #include <choc/audio/choc_AudioFileFormat_Ogg.h>
@@ -9,8 +12,10 @@
 
 class SeekableByteBuffer : public std::streambuf {
 public:
-    SeekableByteBuffer(uint8_t* data, std::size_t size) {
-        setg(reinterpret_cast<char*>(data), reinterpret_cast<char*>(data), reinterpret_cast<char*>(data) + size);
+    // the get area is only read.
+    SeekableByteBuffer(const uint8_t* data, std::size_t size) {
+        auto p = const_cast<char*>(reinterpret_cast<const char*>(data));
+        setg(p, p, p + size);
     }
 
     std::streampos seekoff(std::streamoff off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
@@ -46,14 +51,9 @@ void aap::AudioDataSourceNode::pause() {
     active = false;
 }
 
-void aap::AudioDataSourceNode::setPlaying(bool newPlayingState) {
-    // if it was already playing, reset current position.
-    if (playing)
-        current_frame_offset = 0;
-    playing = newPlayingState;
-}
-
 int32_t aap::AudioDataSourceNode::read(AudioBuffer *dst, int32_t numFrames) {
+    if (stream.load() != nullptr)
+        return readStream(dst, numFrames);
 
     uint32_t size = std::min(audio_data->audio.getNumFrames() - current_frame_offset,
                              (uint32_t) numFrames);
@@ -84,14 +84,270 @@ choc::audio::OggAudioFileFormat<false> formatOgg{};
 choc::audio::FLACAudioFileFormat<false> formatFlac{};
 choc::audio::AudioFileFormat* formats[] {&formatWav, &formatMp3, &formatOgg, &formatFlac};
 
+//--------
+// streaming mode
+
+namespace {
+    // Band-limited (Lanczos-windowed sinc) resampler that works on consecutive chunks.
+    // It keeps the tail of the previous chunk as the history for the next one, so that
+    // there is no discontinuity at chunk boundaries.
+    class StreamingResampler {
+        static constexpr int32_t LOBES = 8;
+        uint32_t num_channels;
+        double step; // source frames per output frame
+        double cutoff;
+        int32_t half_width;
+        std::vector<std::vector<float>> work;
+        std::vector<float> weights;
+        double position;
+
+        static double sinc(double x) {
+            return x == 0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+        }
+
+    public:
+        StreamingResampler(uint32_t numChannels, double sourceRate, double targetRate) :
+                num_channels(numChannels),
+                step(sourceRate / targetRate),
+                cutoff(std::min(1.0, targetRate / sourceRate)),
+                half_width((int32_t) std::ceil(LOBES / cutoff)),
+                work(numChannels),
+                weights(half_width * 2),
+                // starts at the first source frame, with silence as its history.
+                position(half_width) {
+            for (auto& w : work)
+                w.assign(half_width, 0);
+        }
+
+        // Appends `numFrames` frames from `source` and produces as many output frames as possible.
+        void process(choc::buffer::ChannelArrayBuffer<float>& source, uint32_t numFrames, std::vector<std::vector<float>>& output) {
+            for (uint32_t ch = 0; ch < num_channels; ch++) {
+                auto src = source.getChannel(ch).data.data;
+                work[ch].insert(work[ch].end(), src, src + numFrames);
+                output[ch].clear();
+            }
+            auto available = (int64_t) work[0].size();
+            while ((int64_t) position + half_width < available) {
+                auto center = (int64_t) position;
+                auto fraction = position - center;
+                for (int32_t k = -half_width + 1; k <= half_width; k++) {
+                    auto x = (k - fraction) * cutoff;
+                    weights[k + half_width - 1] = std::abs(x) < LOBES ? (float) (cutoff * sinc(x) * sinc(x / LOBES)) : 0;
+                }
+                for (uint32_t ch = 0; ch < num_channels; ch++) {
+                    auto w = work[ch].data() + center - half_width + 1;
+                    float v = 0;
+                    for (int32_t i = 0; i < half_width * 2; i++)
+                        v += w[i] * weights[i];
+                    output[ch].emplace_back(v);
+                }
+                position += step;
+            }
+            // drop the frames that are no longer needed as history.
+            auto discard = std::max((int64_t) 0, (int64_t) position - half_width);
+            for (auto& w : work)
+                w.erase(w.begin(), w.begin() + discard);
+            position -= discard;
+        }
+
+        // Feeds silence so that the last source frames are rendered too.
+        void flush(std::vector<std::vector<float>>& output) {
+            choc::buffer::ChannelArrayBuffer<float> silence(num_channels, (uint32_t) half_width + 1);
+            silence.clear();
+            process(silence, (uint32_t) half_width + 1, output);
+        }
+    };
+}
+
+// Decodes (and resamples) an audio source on a background thread into a single-reader
+// single-writer lock-free ring, which the audio thread reads.
+class aap::AudioDataStream {
+    std::shared_ptr<const std::vector<uint8_t>> encoded;
+    SeekableByteBuffer byte_buffer;
+    std::shared_ptr<std::istream> input;
+    std::unique_ptr<choc::audio::AudioFileReader> reader{};
+    uint32_t num_channels{0};
+    uint64_t num_source_frames{0};
+    double source_sample_rate{0};
+    int32_t target_sample_rate;
+
+    // ring buffer; positions only increase (wrapped by the mask on access).
+    std::vector<std::vector<float>> ring;
+    std::atomic<uint64_t> write_position{0};
+    std::atomic<uint64_t> read_position{0};
+    std::atomic<bool> finished{false};
+    std::atomic<bool> stopping{false};
+    std::thread decoder{};
+
+    AudioDataStream(std::shared_ptr<const std::vector<uint8_t>> data, int32_t targetSampleRate) :
+            encoded(std::move(data)),
+            byte_buffer(encoded->data(), encoded->size()),
+            input(std::make_shared<std::istream>(&byte_buffer)),
+            target_sample_rate(targetSampleRate) {
+    }
+
+    bool writeToRing(std::vector<std::vector<float>>& frames, uint32_t numFrames) {
+        const auto delay = timespec{0, 1000000}; // 1 millisecond
+        uint32_t done = 0;
+        while (done < numFrames) {
+            if (stopping.load())
+                return false;
+            auto w = write_position.load(std::memory_order_relaxed);
+            auto space = AAP_MANAGER_AUDIO_STREAM_RING_FRAMES - (uint32_t) (w - read_position.load(std::memory_order_acquire));
+            auto size = std::min(space, numFrames - done);
+            if (size == 0) {
+                clock_nanosleep(CLOCK_REALTIME, 0, &delay, nullptr);
+                continue;
+            }
+            for (uint32_t ch = 0; ch < num_channels; ch++)
+                for (uint32_t i = 0; i < size; i++)
+                    ring[ch][(w + i) % AAP_MANAGER_AUDIO_STREAM_RING_FRAMES] = frames[ch][done + i];
+            write_position.store(w + size, std::memory_order_release);
+            done += size;
+        }
+        return true;
+    }
+
+    void run() {
+        choc::buffer::ChannelArrayBuffer<float> chunk(num_channels, AAP_MANAGER_AUDIO_STREAM_CHUNK_FRAMES);
+        std::vector<std::vector<float>> output(num_channels);
+        std::unique_ptr<StreamingResampler> resampler{};
+        if ((int32_t) source_sample_rate != target_sample_rate)
+            resampler = std::make_unique<StreamingResampler>(num_channels, source_sample_rate, target_sample_rate);
+
+        for (uint64_t position = 0; position < num_source_frames && !stopping.load(); ) {
+            auto size = (uint32_t) std::min((uint64_t) AAP_MANAGER_AUDIO_STREAM_CHUNK_FRAMES, num_source_frames - position);
+            if (!reader->readFrames(position, chunk.getStart(size))) {
+                aap::a_log_f(AAP_LOG_LEVEL_ERROR, AAP_MANAGER_LOG_TAG, "Failed to decode audio source at frame %d", (int32_t) position);
+                break;
+            }
+            position += size;
+            if (resampler)
+                resampler->process(chunk, size, output);
+            else
+                for (uint32_t ch = 0; ch < num_channels; ch++)
+                    output[ch].assign(chunk.getChannel(ch).data.data, chunk.getChannel(ch).data.data + size);
+            if (!writeToRing(output, (uint32_t) output[0].size()))
+                break;
+        }
+        if (resampler && !stopping.load()) {
+            resampler->flush(output);
+            writeToRing(output, (uint32_t) output[0].size());
+        }
+        finished.store(true);
+    }
+
+public:
+    // Returns nullptr if the data is not in any supported format.
+    static AudioDataStream* create(const std::shared_ptr<const std::vector<uint8_t>>& data, const char* filename, int32_t targetSampleRate) {
+        for (auto format : formats) {
+            if (!format->filenameSuffixMatches(filename))
+                continue;
+            auto ret = new AudioDataStream(data, targetSampleRate);
+            ret->reader = format->createReader(ret->input);
+            if (!ret->reader) {
+                delete ret;
+                return nullptr;
+            }
+            auto props = ret->reader->getProperties();
+            ret->num_channels = props.numChannels;
+            ret->num_source_frames = props.numFrames;
+            ret->source_sample_rate = props.sampleRate;
+            ret->ring.resize(ret->num_channels);
+            for (auto& r : ret->ring)
+                r.resize(AAP_MANAGER_AUDIO_STREAM_RING_FRAMES);
+            ret->decoder = std::thread([ret] { ret->run(); });
+            return ret;
+        }
+        return nullptr;
+    }
+
+    ~AudioDataStream() {
+        stopping.store(true);
+        if (decoder.joinable())
+            decoder.join();
+    }
+
+    bool hasData() {
+        return !finished.load(std::memory_order_acquire) ||
+               read_position.load(std::memory_order_relaxed) < write_position.load(std::memory_order_acquire);
+    }
+
+    // Realtime safe. If `bypass` is true, it consumes the frames without copying.
+    int32_t read(AudioBuffer* dst, int32_t numFrames, bool bypass) {
+        auto r = read_position.load(std::memory_order_relaxed);
+        auto available = write_position.load(std::memory_order_acquire) - r;
+        auto size = (uint32_t) std::min((uint64_t) numFrames, available);
+        if (!bypass && num_channels > 0) {
+            for (uint32_t ch = 0; ch < dst->audio.getNumChannels(); ch++) {
+                // mono source goes to every channel.
+                auto& src = ring[ch % num_channels];
+                auto d = dst->audio.getChannel(ch).data.data;
+                auto start = (uint32_t) (r % AAP_MANAGER_AUDIO_STREAM_RING_FRAMES);
+                auto first = std::min(size, AAP_MANAGER_AUDIO_STREAM_RING_FRAMES - start);
+                memcpy(d, src.data() + start, first * sizeof(float));
+                memcpy(d + first, src.data(), (size - first) * sizeof(float));
+            }
+        }
+        read_position.store(r + size, std::memory_order_release);
+        return (int32_t) size;
+    }
+};
+
+void aap::AudioDataSourceNode::replaceStream(AudioDataStream* newStream) {
+    auto old = stream.exchange(newStream);
+    // wait until the audio thread is done with the old stream.
+    const auto delay = timespec{0, 1000}; // 1 microsecond
+    while (stream_readers.load() > 0)
+        clock_nanosleep(CLOCK_REALTIME, 0, &delay, nullptr);
+    delete old;
+}
+
+int32_t aap::AudioDataSourceNode::readStream(AudioBuffer* dst, int32_t numFrames) {
+    stream_readers.fetch_add(1);
+    auto s = stream.load();
+    auto ret = s ? s->read(dst, numFrames, shouldConsumeButBypass()) : 0;
+    stream_readers.fetch_sub(1);
+    return ret;
+}
+
+void aap::AudioDataSourceNode::setPlaying(bool newPlayingState) {
+    // if it was already playing, reset current position.
+    if (playing) {
+        current_frame_offset = 0;
+        if (stream.load() != nullptr)
+            replaceStream(AudioDataStream::create(stream_source, stream_source_filename.c_str(), graph->getSampleRate()));
+    }
+    playing = newPlayingState;
+}
+
+bool aap::AudioDataSourceNode::hasData() {
+    stream_readers.fetch_add(1);
+    auto s = stream.load();
+    bool ret = s != nullptr ? s->hasData() :
+            audio_data != nullptr && (uint32_t) current_frame_offset < audio_data->audio.getNumFrames();
+    stream_readers.fetch_sub(1);
+    return ret;
+}
+
 bool aap::AudioDataSourceNode::setAudioSource(uint8_t *data, int dataLength, const char *filename) {
+    if (streaming_enabled || dataLength >= AAP_MANAGER_AUDIO_STREAM_MIN_SOURCE_BYTES) {
+        stream_source = std::make_shared<const std::vector<uint8_t>>(data, data + dataLength);
+        stream_source_filename = filename;
+        auto newStream = AudioDataStream::create(stream_source, filename, graph->getSampleRate());
+        replaceStream(newStream);
+        return newStream != nullptr;
+    }
+    replaceStream(nullptr);
+    stream_source.reset();
+
     const std::lock_guard <NanoSleepLock> lock{data_source_mutex};
 
     for (auto format : formats) {
         if (format->filenameSuffixMatches(filename)) {
             SeekableByteBuffer buffer(data, dataLength);
-            auto stream = std::make_shared<std::istream>(&buffer);
-            auto reader = format->createReader(stream);
+            auto input = std::make_shared<std::istream>(&buffer);
+            auto reader = format->createReader(input);
             auto props = reader->getProperties();
             AudioBuffer tmpData{(int32_t) props.numChannels, (int32_t) props.numFrames};
             if (!reader->readFrames(0, tmpData.audio)) {
@@ -115,5 +371,6 @@ bool aap::AudioDataSourceNode::setAudioSource(uint8_t *data, int dataLength, con
 aap::AudioDataSourceNode::~AudioDataSourceNode() {
     playing = false;
     active = false;
+    replaceStream(nullptr);
 }
 
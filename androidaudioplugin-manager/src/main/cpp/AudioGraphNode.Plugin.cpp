@@ -16,7 +16,8 @@ void aap::AudioPluginNode::processAudio(AudioBuffer *audioData, int32_t numFrame
 
     // Copy input audioData into each plugin's buffer (it is inevitable; each plugin has
     // shared memory between the service and this host, which are not sharable with other plugins
-    // in the chain. So, it's optimal enough.)
+    // in the chain). If the previous node was a plugin that deferred its outputs, they are copied
+    // directly from its buffer, so it is the only copy in between.
 
     auto aapBuffer = plugin->getAudioPluginBuffer();
 
@@ -27,7 +28,7 @@ void aap::AudioPluginNode::processAudio(AudioBuffer *audioData, int32_t numFrame
         switch (plugin->getPort(i)->getContentType()) {
             case AAP_CONTENT_TYPE_AUDIO:
                 memcpy(aapBuffer->get_buffer(aapBuffer, i),
-                       audioData->audio.getView().getChannel(currentChannelInAudioData).data.data,
+                       audioData->getAudioChannelData(currentChannelInAudioData),
                        numFrames * sizeof(float));
                 currentChannelInAudioData++;
                 break;
@@ -45,21 +46,32 @@ void aap::AudioPluginNode::processAudio(AudioBuffer *audioData, int32_t numFrame
 
     plugin->process(numFrames, 0); // FIXME: timeout?
 
+    // If the graph allows, leave the audio outputs in our buffer; the next plugin reads them
+    // from there. They stay valid until our next process().
+    bool deferAudio = audioData->isAudioDeferralAllowed();
     currentChannelInAudioData = 0;
+    // the MIDI output is the plugin's, if any (see writesMidiOutput()).
+    ((AAPMidiBufferHeader*) audioData->midi_out)->length = 0;
     for (int32_t i = 0, n = aapBuffer->num_ports(aapBuffer); i < n; i++) {
         if (plugin->getPort(i)->getPortDirection() != AAP_PORT_DIRECTION_OUTPUT)
             continue;
         switch (plugin->getPort(i)->getContentType()) {
             case AAP_CONTENT_TYPE_AUDIO:
-                memcpy(audioData->audio.getView().getChannel(currentChannelInAudioData).data.data,
-                       aapBuffer->get_buffer(aapBuffer, i),
-                       numFrames * sizeof(float));
+                if (deferAudio)
+                    audioData->deferAudioChannel(currentChannelInAudioData,
+                                                 (const float*) aapBuffer->get_buffer(aapBuffer, i),
+                                                 numFrames);
+                else
+                    memcpy(audioData->getAudioChannelForWrite(currentChannelInAudioData),
+                           aapBuffer->get_buffer(aapBuffer, i),
+                           numFrames * sizeof(float));
                 currentChannelInAudioData++;
                 break;
             case AAP_CONTENT_TYPE_MIDI2: {
-                size_t midiSize = std::min(aapBuffer->get_buffer_size(aapBuffer, i),
-                                           audioData->midi_capacity);
                 auto* midiBuffer = aapBuffer->get_buffer(aapBuffer, i);
+                // copy only what the header says is valid, not the whole plugin buffer.
+                size_t midiSize = std::min((int32_t) (sizeof(AAPMidiBufferHeader) + ((AAPMidiBufferHeader*) midiBuffer)->length),
+                                           std::min(aapBuffer->get_buffer_size(aapBuffer, i), audioData->midi_capacity));
                 memcpy(audioData->midi_out, midiBuffer, midiSize);
                 ((AAPMidiBufferHeader*) midiBuffer)->length = 0;
                 break;
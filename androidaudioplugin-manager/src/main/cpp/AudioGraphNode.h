@@ -1,8 +1,13 @@
 #ifndef AAP_CORE_AUDIOGRAPHNODE_H
 #define AAP_CORE_AUDIOGRAPHNODE_H
 
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
 #include "AudioDevice.h"
 #include "AAPMidiEventTranslator.h"
+#include "UmpRingBuffer.h"
 #include <aap/core/host/plugin-instance.h>
 #include <aap/unstable/utility.h>
 #ifndef CMIDI2_H_INCLUDED // it is only a workaround to avoid reference resolution failure at aap-juce-* repos.
@@ -22,6 +27,13 @@ namespace aap {
     public:
         virtual ~AudioGraphNode() = default;
         virtual bool shouldSkip() { return false; }
+        // True if processAudio() reads the audio inputs only via AudioBuffer::getAudioChannelData().
+        virtual bool canReadDeferredAudio() { return false; }
+        // True if processAudio() may add events to the MIDI input sequence of its buffer.
+        virtual bool writesMidiInput() { return false; }
+        // True if processAudio() replaces the MIDI output sequence of its buffer (when it is
+        // skipped, the graph clears it instead of passing the one of its inputs along).
+        virtual bool writesMidiOutput() { return false; }
         virtual void start() = 0;
         virtual void pause() = 0;
         virtual void processAudio(AudioBuffer* audioData, int32_t numFrames) = 0;
@@ -105,12 +117,16 @@ namespace aap {
         void start() override;
         void pause() override;
         bool shouldSkip() override;
+        bool canReadDeferredAudio() override { return true; }
+        bool writesMidiOutput() override { return true; }
         void processAudio(AudioBuffer* audioData, int32_t numFrames) override;
 
         // FIXME: this should be generalized to invoke arbitrary extension functions.
         void setPresetIndex(int index);
     };
 
+    class AudioDataStream;
+
     class AudioDataSourceNode : public AudioGraphNode {
         bool active{false};
         bool playing{false};
@@ -119,6 +135,17 @@ namespace aap {
 
         int32_t current_frame_offset{0};
 
+        // streaming mode: `stream` is in use while `stream_readers` is non-zero.
+        bool streaming_enabled{false};
+        // shared with the streams, which decode it again at every restart.
+        std::shared_ptr<const std::vector<uint8_t>> stream_source{};
+        std::string stream_source_filename{};
+        std::atomic<AudioDataStream*> stream{nullptr};
+        std::atomic<int32_t> stream_readers{0};
+
+        void replaceStream(AudioDataStream* newStream);
+        int32_t readStream(AudioBuffer* dst, int32_t numFrames);
+
     public:
         explicit AudioDataSourceNode(AudioGraph* ownerGraph);
         ~AudioDataSourceNode() override;
@@ -129,7 +156,7 @@ namespace aap {
         virtual bool shouldConsumeButBypass() { return playing && !active; }
         void processAudio(AudioBuffer* audioData, int32_t numFrames) override;
 
-        bool hasData() { return audio_data != nullptr && current_frame_offset < audio_data->audio.getNumFrames(); };
+        bool hasData();
 
         void setPlaying(bool newPlayingState);
 
@@ -142,21 +169,33 @@ namespace aap {
         /// Returns true if loaded successfully, false if not.
         ///
         /// It locks the data source until it finishes loading and converting data into `audio_data`.
+        /// In streaming mode, it only checks that the data can be decoded, and starts streaming.
         bool setAudioSource(uint8_t *data, int dataLength, const char *filename);
+
+        /// In streaming mode, the audio source is not decoded upfront. It is decoded and resampled
+        /// in chunks on a background thread, and the audio thread reads it from a lock-free ring.
+        /// It takes effect at the next `setAudioSource()` call. Sources of at least
+        /// `AAP_MANAGER_AUDIO_STREAM_MIN_SOURCE_BYTES` are streamed regardless.
+        void setStreamingEnabled(bool enabled) { streaming_enabled = enabled; }
     };
 
 
     class MidiSourceNode : public AudioGraphNode {
-        uint8_t* buffer;
-        int32_t capacity;
-
-        NanoSleepLock midi_buffer_mutex{};
+        // events are queued by the producers with their in-cycle timestamps, and the audio
+        // thread turns them into JR Timestamps + UMPs in processAudio().
+        UmpInputQueue queue;
+        int32_t default_source;
         AAPMidiEventTranslator translator;
+        // `default_source` (and `translator`) take one producer at a time, but `addMidiEvent()`
+        // is called from any thread. The audio thread never takes it.
+        std::mutex default_source_mutex{};
 
         // needed for sample accurate time calculation
         int32_t sample_rate{0};
         int32_t aap_frame_size{1024};
-        struct timespec last_aap_process_time{0, 0};
+        std::atomic<int64_t> last_aap_process_time_nanoseconds{0};
+
+        int64_t toCycleTimestamp(int64_t timestampInNanoseconds);
 
     public:
         MidiSourceNode(AudioGraph* ownerGraph,
@@ -168,20 +207,29 @@ namespace aap {
 
         ~MidiSourceNode() override;
 
-        void setPlugin(RemotePluginInstance* instance) { translator.setPlugin(instance); }
+        void setPlugin(RemotePluginInstance* instance) {
+            std::lock_guard<std::mutex> lock{default_source_mutex};
+            translator.setPlugin(instance);
+        }
 
         void addMidiEvent(uint8_t *data, int32_t length, int64_t timestampInNanoseconds);
 
+        /// Adds another MIDI input source that can be written concurrently with the others,
+        /// and returns its ID (-1 if there are too many). Not for the audio thread.
+        int32_t addInputSource() { return queue.addSource(); }
+
+        /// Queues UMPs from an input source added by `addInputSource()`. Unlike `addMidiEvent()`,
+        /// the events are not translated; they must be in the protocol the plugin expects.
+        bool addUmpEvents(int32_t sourceId, const uint8_t *ump, int32_t length, int64_t timestampInNanoseconds);
+
         void start() override;
         void pause() override;
+        bool writesMidiInput() override { return true; }
         void processAudio(AudioBuffer* audioData, int32_t numFrames) override;
     };
 
     class MidiDestinationNode : public AudioGraphNode {
-        uint8_t* buffer;
-        int32_t capacity;
-
-        NanoSleepLock midi_buffer_mutex{};
+        UmpRingBuffer queue;
 
     public:
         explicit MidiDestinationNode(AudioGraph* ownerGraph, int32_t internalBufferSize = AAP_PLUGIN_PLAYER_DEFAULT_MIDI_RING_BUFFER_SIZE);
@@ -192,6 +240,7 @@ namespace aap {
 
         void start() override;
         void pause() override;
+        bool writesMidiOutput() override { return true; }
         void processAudio(AudioBuffer* audioData, int32_t numFrames) override;
     };
 }
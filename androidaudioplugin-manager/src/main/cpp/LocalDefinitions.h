@@ -5,6 +5,13 @@
 
 #define AAP_MANAGER_MIDI_BUFFER_SIZE 65536
 #define AAP_PLUGIN_PLAYER_DEFAULT_MIDI_RING_BUFFER_SIZE 8192
+// MidiSourceNode: maximum number of concurrent MIDI input sources
+#define AAP_MANAGER_MIDI_MAX_INPUT_SOURCES 8
+// streaming AudioDataSourceNode: ring size and decoding unit, in frames
+#define AAP_MANAGER_AUDIO_STREAM_RING_FRAMES 65536
+#define AAP_MANAGER_AUDIO_STREAM_CHUNK_FRAMES 4096
+// AudioDataSourceNode streams encoded audio sources at least this large (in bytes) even if streaming is not enabled.
+#define AAP_MANAGER_AUDIO_STREAM_MIN_SOURCE_BYTES (1024 * 1024)
 #define AAP_MANAGER_LOG_TAG "AAPManager"
 
 #endif //AAP_CORE_LOCALDEFINITIONS_H
@@ -2,6 +2,7 @@
 #include "OboeAudioDeviceManager.h"
 #include <choc/audio/choc_SampleBuffers.h>
 #include <choc/containers/choc_VariableSizeFIFO.h>
+#include <aap/unstable/audio-interleave.h>
 #if ANDROID
 #include <aap/unstable/logging.h>
 #include <android/trace.h>
@@ -164,17 +165,16 @@ oboe::DataCallbackResult
 aap::OboeAudioDevice::onAudioInputReady(oboe::AudioStream *audioStream, void *oboeAudioData,
                                         int32_t numFrames) {
     if (aap_callback != nullptr) {
-        auto interleavedBytes = static_cast<size_t>(numFrames) *
-                                static_cast<size_t>(audioStream->getChannelCount()) *
-                                sizeof(float);
-        aap_buffer.audio.clear();
-        memset(aap_buffer.midi_in, 0, aap_buffer.midi_capacity);
-        memset(aap_buffer.midi_out, 0, aap_buffer.midi_capacity);
-
-        memset(oboeAudioData, 0, interleavedBytes);
-
-        auto oboeView = choc::buffer::createInterleavedView((float*) oboeAudioData, audioStream->getChannelCount(), numFrames);
-        choc::buffer::copy(aap_buffer.audio.getStart(numFrames), oboeView);
+        // (do not clear oboeAudioData here; it is the recorded input.)
+        auto numChannels = audioStream->getChannelCount();
+        bool overwrite = numChannels == (int32_t) aap_buffer.audio.getNumChannels();
+        aap_buffer.clearDirtyRegions(numFrames, overwrite ? numFrames : 0);
+        if (overwrite)
+            deinterleaveAudio(aap_buffer.audio.getView().data.channels, (const float*) oboeAudioData, numChannels, numFrames);
+        else {
+            auto oboeView = choc::buffer::createInterleavedView((float*) oboeAudioData, numChannels, numFrames);
+            choc::buffer::copyRemappingChannels(aap_buffer.audio.getStart(numFrames), oboeView);
+        }
 
         aap_callback(callback_context, &aap_buffer, numFrames);
     }
@@ -194,21 +194,18 @@ aap::OboeAudioDevice::onAudioOutputReady(oboe::AudioStream *audioStream, void *o
             clock_gettime(CLOCK_REALTIME, &timeSpecBegin);
         }
 #endif
-        auto interleavedBytes = static_cast<size_t>(numFrames) *
-                                static_cast<size_t>(audioStream->getChannelCount()) *
-                                sizeof(float);
-
-        aap_buffer.audio.clear();
-        memset(aap_buffer.midi_in, 0, aap_buffer.midi_capacity);
-        memset(aap_buffer.midi_out, 0, aap_buffer.midi_capacity);
-        memset(oboeAudioData, 0, interleavedBytes);
+        aap_buffer.clearDirtyRegions(numFrames);
 
         aap_callback(callback_context, &aap_buffer, numFrames);
 
-        memset(oboeAudioData, 0, interleavedBytes);
-
-        auto oboeView = choc::buffer::createInterleavedView((float*) oboeAudioData, audioStream->getChannelCount(), numFrames);
-        choc::buffer::copy(oboeView, aap_buffer.audio.getStart(numFrames));
+        auto numChannels = audioStream->getChannelCount();
+        if (numChannels == (int32_t) aap_buffer.audio.getNumChannels())
+            interleaveAudio((float*) oboeAudioData, aap_buffer.audio.getView().data.channels, numChannels, numFrames);
+        else {
+            memset(oboeAudioData, 0, static_cast<size_t>(numFrames) * numChannels * sizeof(float));
+            auto oboeView = choc::buffer::createInterleavedView((float*) oboeAudioData, numChannels, numFrames);
+            choc::buffer::copyRemappingChannels(oboeView, aap_buffer.audio.getStart(numFrames));
+        }
 
 #if ANDROID
         if (ATrace_isEnabled()) {
@@ -0,0 +1,71 @@
+#include "UmpRingBuffer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+aap::UmpRingBuffer::UmpRingBuffer(int32_t capacityInBytes) {
+    // power of two, and large enough for at least a few records.
+    capacity = 64;
+    while (capacity < (uint32_t) capacityInBytes)
+        capacity <<= 1;
+    mask = capacity - 1;
+    buffer = (uint8_t*) calloc(1, capacity);
+}
+
+aap::UmpRingBuffer::~UmpRingBuffer() {
+    free(buffer);
+}
+
+bool aap::UmpRingBuffer::write(int64_t timestamp, const uint8_t* data, int32_t length) {
+    if (length < 0)
+        return false;
+    auto size = recordSize((uint32_t) length);
+    auto w = write_position.load(std::memory_order_relaxed);
+    auto r = read_position.load(std::memory_order_acquire);
+    auto freeBytes = capacity - (w - r);
+    // a record never wraps around; if it does not fit at the end, it starts over at the beginning.
+    auto contiguous = capacity - (w & mask);
+    auto skip = size > contiguous ? contiguous : 0;
+    if (skip + size > freeBytes)
+        return false;
+    if (skip > 0) {
+        if (skip >= sizeof(RecordHeader))
+            ((RecordHeader*) (buffer + (w & mask)))->length = WRAP_MARKER;
+        w += skip;
+    }
+    auto header = (RecordHeader*) (buffer + (w & mask));
+    header->timestamp = timestamp;
+    header->length = (uint32_t) length;
+    memcpy(header + 1, data, (size_t) length);
+    write_position.store(w + size, std::memory_order_release);
+    return true;
+}
+
+int32_t aap::UmpRingBuffer::readBytes(uint8_t* dst, int32_t dstCapacity) {
+    beginRead();
+    int32_t done = 0;
+    int64_t timestamp;
+    const uint8_t* data;
+    int32_t length;
+    while (done < dstCapacity && peek(timestamp, data, length)) {
+        auto size = std::min(length - (int32_t) partial_read_offset, dstCapacity - done);
+        memcpy(dst + done, data + partial_read_offset, (size_t) size);
+        done += size;
+        if (partial_read_offset + size < (uint32_t) length) {
+            partial_read_offset += size;
+            break;
+        }
+        pop();
+    }
+    return done;
+}
+
+int32_t aap::UmpInputQueue::addSource() {
+    std::lock_guard<std::mutex> lock{add_source_mutex};
+    auto n = num_sources.load(std::memory_order_relaxed);
+    if (n >= (int32_t) sources.size())
+        return -1;
+    sources[n] = std::make_unique<UmpRingBuffer>(capacity_per_source);
+    num_sources.store(n + 1, std::memory_order_release);
+    return n;
+}
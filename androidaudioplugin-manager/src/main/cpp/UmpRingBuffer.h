@@ -0,0 +1,157 @@
+#ifndef AAP_CORE_UMPRINGBUFFER_H
+#define AAP_CORE_UMPRINGBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include "LocalDefinitions.h"
+
+namespace aap {
+
+    /**
+     * Wait-free single-producer single-consumer queue of timestamped MIDI events (UMP bytes).
+     *
+     * Each event is stored contiguously as a record header (timestamp and length) followed by the
+     * event bytes, so the consumer can look at an event in place and consume it only if it fits
+     * into wherever it goes. Neither side ever blocks; `write()` fails (the event is dropped)
+     * when the queue is full. All the memory is allocated in the constructor.
+     */
+    class UmpRingBuffer {
+        struct RecordHeader {
+            int64_t timestamp;
+            uint32_t length;
+            uint32_t reserved;
+        };
+        static constexpr uint32_t WRAP_MARKER = UINT32_MAX;
+
+        uint8_t* buffer{nullptr};
+        uint32_t capacity;
+        uint32_t mask;
+        // monotonically increasing byte positions (wrapping around at 2^32), masked on access.
+        alignas(64) std::atomic<uint32_t> write_position{0};
+        alignas(64) std::atomic<uint32_t> read_position{0};
+        // consumer-only state
+        uint32_t read_limit{0};
+        uint32_t partial_read_offset{0};
+
+        static uint32_t recordSize(uint32_t length) {
+            return (uint32_t) ((sizeof(RecordHeader) + length + 7) & ~7u);
+        }
+
+        // skips padding and wrap markers. Returns false if no record is readable before `read_limit`.
+        bool seekRecord(uint32_t& position) {
+            while (position != read_limit) {
+                auto contiguous = capacity - (position & mask);
+                if (contiguous < sizeof(RecordHeader) ||
+                    ((RecordHeader*) (buffer + (position & mask)))->length == WRAP_MARKER) {
+                    position += contiguous;
+                    continue;
+                }
+                return true;
+            }
+            return false;
+        }
+
+    public:
+        explicit UmpRingBuffer(int32_t capacityInBytes);
+        ~UmpRingBuffer();
+
+        // producer
+
+        bool write(int64_t timestamp, const uint8_t* data, int32_t length);
+
+        // consumer
+
+        /// Takes a snapshot of what is written so far. `peek()` returns only events from it,
+        /// which bounds the consumer work for a cycle.
+        void beginRead() { read_limit = write_position.load(std::memory_order_acquire); }
+        /// Returns the next event without consuming it, or false if there is none (in the snapshot).
+        bool peek(int64_t& timestamp, const uint8_t*& data, int32_t& length) {
+            auto r = read_position.load(std::memory_order_relaxed);
+            if (!seekRecord(r)) {
+                // let the producer reuse the skipped padding.
+                read_position.store(r, std::memory_order_release);
+                return false;
+            }
+            auto header = (RecordHeader*) (buffer + (r & mask));
+            timestamp = header->timestamp;
+            data = (const uint8_t*) (header + 1);
+            length = (int32_t) header->length;
+            return true;
+        }
+        /// Consumes the event that `peek()` returned.
+        void pop() {
+            auto r = read_position.load(std::memory_order_relaxed);
+            if (!seekRecord(r))
+                return;
+            auto header = (RecordHeader*) (buffer + (r & mask));
+            partial_read_offset = 0;
+            read_position.store(r + recordSize(header->length), std::memory_order_release);
+        }
+
+        /// Copies the bytes of the queued events (without timestamps) into `dst` as a stream.
+        /// An event that does not fit is split and the rest is returned by the next call.
+        int32_t readBytes(uint8_t* dst, int32_t dstCapacity);
+    };
+
+    /**
+     * Multi-producer front-end for UmpRingBuffer: every input source gets its own queue, so
+     * the sources never contend with each other or with the audio thread. The consumer merges
+     * the events from all the sources in timestamp order (each source must write its events
+     * in timestamp order).
+     */
+    class UmpInputQueue {
+        std::array<std::unique_ptr<UmpRingBuffer>, AAP_MANAGER_MIDI_MAX_INPUT_SOURCES> sources{};
+        std::atomic<int32_t> num_sources{0};
+        std::mutex add_source_mutex{};
+        int32_t capacity_per_source;
+
+    public:
+        explicit UmpInputQueue(int32_t capacityPerSource) : capacity_per_source(capacityPerSource) {}
+
+        /// Adds an input source and returns its ID, or -1 if there are too many. Not for the audio thread.
+        int32_t addSource();
+
+        /// Queues an event from the source. Each source must be written by one thread at a time.
+        bool write(int32_t sourceId, int64_t timestamp, const uint8_t* data, int32_t length) {
+            if (sourceId < 0 || sourceId >= num_sources.load(std::memory_order_acquire))
+                return false;
+            return sources[sourceId]->write(timestamp, data, length);
+        }
+
+        /**
+         * Consumer: calls `onEvent(timestamp, data, length)` for the events queued so far, in
+         * timestamp order. If `onEvent` returns false, that event is kept for the next call and
+         * reading stops. Returns the number of consumed events.
+         */
+        template <typename F>
+        int32_t readAll(F&& onEvent) {
+            int32_t n = num_sources.load(std::memory_order_acquire);
+            // the head event of each source; only the source that was consumed is peeked again.
+            bool available[AAP_MANAGER_MIDI_MAX_INPUT_SOURCES];
+            int64_t timestamps[AAP_MANAGER_MIDI_MAX_INPUT_SOURCES];
+            const uint8_t* data[AAP_MANAGER_MIDI_MAX_INPUT_SOURCES];
+            int32_t lengths[AAP_MANAGER_MIDI_MAX_INPUT_SOURCES];
+            for (int32_t i = 0; i < n; i++) {
+                sources[i]->beginRead();
+                available[i] = sources[i]->peek(timestamps[i], data[i], lengths[i]);
+            }
+            int32_t count = 0;
+            while (true) {
+                int32_t earliest = -1;
+                for (int32_t i = 0; i < n; i++)
+                    if (available[i] && (earliest < 0 || timestamps[i] < timestamps[earliest]))
+                        earliest = i;
+                if (earliest < 0 || !onEvent(timestamps[earliest], data[earliest], lengths[earliest]))
+                    return count;
+                sources[earliest]->pop();
+                available[earliest] = sources[earliest]->peek(timestamps[earliest], data[earliest], lengths[earliest]);
+                count++;
+            }
+        }
+    };
+}
+
+#endif //AAP_CORE_UMPRINGBUFFER_H
@@ -1 +1,186 @@
 #include "VirtualAudioDeviceManager.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <time.h>
+#include <choc/audio/choc_AudioFileFormat_WAV.h>
+#include <aap/unstable/logging.h>
+
+aap::AudioDeviceIn *
+aap::VirtualAudioDeviceManager::ensureDefaultInputOpened(int32_t sampleRate, int32_t framesPerCallback, int32_t numChannels) {
+    if (input == nullptr)
+        input = std::make_shared<VirtualAudioDeviceIn>();
+    return input.get();
+}
+
+aap::AudioDeviceOut *
+aap::VirtualAudioDeviceManager::ensureDefaultOutputOpened(int32_t sampleRate, int32_t framesPerCallback, int32_t numChannels) {
+    if (output == nullptr)
+        output = std::make_shared<VirtualAudioDeviceOut>(sampleRate, framesPerCallback, numChannels);
+    return output.get();
+}
+
+//--------
+
+void aap::VirtualAudioDeviceIn::read(AudioBuffer *dstAudioData, int32_t bufferPosition, int32_t numFrames) {
+    auto total = source.getNumFrames();
+    auto numChannels = std::min(dstAudioData->audio.getNumChannels(), source.getNumChannels());
+    for (uint32_t ch = 0; ch < dstAudioData->audio.getNumChannels(); ch++)
+        memset(dstAudioData->audio.getChannel(ch).data.data, 0, numFrames * sizeof(float));
+    if (total == 0)
+        return;
+
+    int32_t done = 0;
+    uint32_t position = loop ? (uint32_t) (bufferPosition % total) : (uint32_t) bufferPosition;
+    while (done < numFrames && position < total) {
+        auto size = std::min((uint32_t) (numFrames - done), total - position);
+        for (uint32_t ch = 0; ch < numChannels; ch++)
+            memcpy(dstAudioData->audio.getChannel(ch).data.data + done,
+                   source.getChannel(ch).data.data + position,
+                   size * sizeof(float));
+        done += size;
+        position += size;
+        if (loop && position == total)
+            position = 0;
+    }
+}
+
+//--------
+
+aap::VirtualAudioDeviceOut::VirtualAudioDeviceOut(int32_t sampleRate, int32_t framesPerCallback, int32_t numChannels) :
+        sample_rate(sampleRate),
+        frames_per_callback(framesPerCallback),
+        aap_buffer(numChannels, framesPerCallback) {
+}
+
+aap::VirtualAudioDeviceOut::~VirtualAudioDeviceOut() {
+    stopCallback();
+}
+
+void aap::VirtualAudioDeviceOut::setRecordingCapacity(int64_t numFrames) {
+    recorded = choc::buffer::ChannelArrayBuffer<float>(aap_buffer.audio.getNumChannels(), (uint32_t) numFrames);
+    recorded.clear();
+    recorded_frames = 0;
+}
+
+void aap::VirtualAudioDeviceOut::setStatisticsCapacity(int64_t numCallbacks) {
+    callback_durations.clear();
+    callback_durations.reserve(numCallbacks);
+}
+
+void aap::VirtualAudioDeviceOut::renderCycle(int32_t numFrames) {
+    // same as OboeAudioDevice: the graph processes `aap_buffer` in place.
+    aap_buffer.clearDirtyRegions(numFrames);
+
+    auto begin = std::chrono::steady_clock::now();
+    if (aap_callback != nullptr)
+        aap_callback(callback_context, &aap_buffer, numFrames);
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+
+    // no allocation here; measurements beyond the capacity are dropped.
+    if (callback_durations.size() < callback_durations.capacity())
+        callback_durations.emplace_back(duration);
+    num_callbacks++;
+    rendered_frames += numFrames;
+
+    auto size = std::min((int64_t) numFrames, (int64_t) recorded.getNumFrames() - recorded_frames);
+    if (size > 0) {
+        choc::buffer::FrameRange range{(uint32_t) recorded_frames, (uint32_t) (recorded_frames + size)};
+        choc::buffer::copy(recorded.getFrameRange(range), aap_buffer.audio.getStart((uint32_t) size));
+        recorded_frames += size;
+    }
+}
+
+void aap::VirtualAudioDeviceOut::render(int64_t numFrames) {
+    auto begin = std::chrono::steady_clock::now();
+    auto period = std::chrono::nanoseconds((int64_t) frames_per_callback * 1000000000 / sample_rate);
+    auto next = begin;
+    for (int64_t done = 0; done < numFrames; done += frames_per_callback) {
+        renderCycle((int32_t) std::min((int64_t) frames_per_callback, numFrames - done));
+        if (simulate_realtime) {
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+    wall_time_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void aap::VirtualAudioDeviceOut::startCallback() {
+    if (running.exchange(true))
+        return;
+    render_thread = std::thread([this] {
+        auto begin = std::chrono::steady_clock::now();
+        auto period = std::chrono::nanoseconds((int64_t) frames_per_callback * 1000000000 / sample_rate);
+        auto next = begin;
+        while (running.load()) {
+            renderCycle(frames_per_callback);
+            if (simulate_realtime) {
+                next += period;
+                std::this_thread::sleep_until(next);
+            }
+        }
+        wall_time_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+    });
+}
+
+void aap::VirtualAudioDeviceOut::stopCallback() {
+    running.store(false);
+    if (render_thread.joinable())
+        render_thread.join();
+}
+
+void aap::VirtualAudioDeviceOut::write(AudioBuffer *audioDataToWrite, int32_t bufferPosition, int32_t numFrames) {
+    // The output node usually writes the callback buffer itself back; otherwise copy it
+    // to the buffer that is recorded at the end of the cycle.
+    if (audioDataToWrite == &aap_buffer)
+        return;
+    choc::buffer::FrameRange range{0, (uint32_t) numFrames};
+    choc::buffer::copy(aap_buffer.audio.getFrameRange(range), audioDataToWrite->audio.getView().getFrameRange(range));
+}
+
+bool aap::VirtualAudioDeviceOut::saveRecordedAudioAsWav(const std::string &path) {
+    auto stream = std::make_shared<std::ofstream>(path, std::ios::binary);
+    if (!stream->good()) {
+        aap::a_log_f(AAP_LOG_LEVEL_ERROR, AAP_MANAGER_LOG_TAG, "Failed to open %s for writing", path.c_str());
+        return false;
+    }
+    choc::audio::AudioFileProperties props{};
+    props.sampleRate = sample_rate;
+    props.numChannels = recorded.getNumChannels();
+    props.numFrames = (uint64_t) recorded_frames;
+    props.bitDepth = choc::audio::BitDepth::float32;
+    choc::audio::WAVAudioFileFormat<true> format{};
+    auto writer = format.createWriter(stream, props);
+    if (!writer || !writer->appendFrames(recorded.getStart((uint32_t) recorded_frames)) || !writer->flush()) {
+        aap::a_log_f(AAP_LOG_LEVEL_ERROR, AAP_MANAGER_LOG_TAG, "Failed to write WAV to %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+aap::VirtualAudioDeviceStatistics aap::VirtualAudioDeviceOut::getStatistics() {
+    VirtualAudioDeviceStatistics ret{};
+    ret.num_callbacks = num_callbacks;
+    ret.rendered_frames = rendered_frames;
+    ret.wall_time_nanoseconds = wall_time_nanoseconds;
+    ret.realtime_factor = wall_time_nanoseconds > 0 ?
+            (1.0 * rendered_frames / sample_rate) / (wall_time_nanoseconds / 1000000000.0) : 0;
+
+    auto sorted = callback_durations;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double p) {
+        return sorted.empty() ? 0 : sorted[std::min(sorted.size() - 1, (size_t) (p * sorted.size()))];
+    };
+    ret.callback_p50_nanoseconds = percentile(0.5);
+    ret.callback_p90_nanoseconds = percentile(0.9);
+    ret.callback_p99_nanoseconds = percentile(0.99);
+    ret.callback_max_nanoseconds = sorted.empty() ? 0 : sorted.back();
+    return ret;
+}
+
+void aap::VirtualAudioDeviceOut::resetStatistics() {
+    callback_durations.clear();
+    num_callbacks = 0;
+    rendered_frames = 0;
+    wall_time_nanoseconds = 0;
+}
@@ -1,15 +1,28 @@
 #ifndef AAP_CORE_VIRTUALAUDIODEVICEMANAGER_H
 #define AAP_CORE_VIRTUALAUDIODEVICEMANAGER_H
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "AudioDeviceManager.h"
 
 namespace aap {
 
+    /**
+     * VirtualAudioDeviceIn is a clock-free pull source for headless processing.
+     *
+     * It has no callback of its own; it returns the input data set by `setInputData()`
+     * (or silence) whenever the graph reads from it. The clock is driven by VirtualAudioDeviceOut.
+     */
     class VirtualAudioDeviceIn : public AudioDeviceIn {
         bool running{false};
+        bool loop{false};
+        choc::buffer::ChannelArrayBuffer<float> source{};
+
     public:
         explicit VirtualAudioDeviceIn() = default;
         virtual ~VirtualAudioDeviceIn() = default;
@@ -17,27 +30,93 @@ namespace aap {
         void startCallback() override { running = true; }
         void stopCallback() override { running = false; }
         void setAudioCallback(AudioDeviceCallback audioDeviceCallback, void* callbackContext) override {
-            // should we implement something here?
+            // nothing to do; VirtualAudioDeviceOut drives the graph.
         }
-        void read(AudioBuffer *dstAudioData, int32_t bufferPosition, int32_t numFrames) override {
-            // should we implement something here?
+
+        /// Sets the audio that this device "records". It must be called before processing starts.
+        /// If `loopData` is true, the data is repeated, otherwise silence follows.
+        void setInputData(choc::buffer::ChannelArrayBuffer<float> data, bool loopData = false) {
+            source = std::move(data);
+            loop = loopData;
         }
+
+        void read(AudioBuffer *dstAudioData, int32_t bufferPosition, int32_t numFrames) override;
+    };
+
+    struct VirtualAudioDeviceStatistics {
+        int64_t num_callbacks;
+        int64_t rendered_frames;
+        int64_t wall_time_nanoseconds;
+        // rendered audio duration divided by the wall time; > 1 means faster than realtime.
+        double realtime_factor;
+        // per-callback processing time
+        int64_t callback_p50_nanoseconds;
+        int64_t callback_p90_nanoseconds;
+        int64_t callback_p99_nanoseconds;
+        int64_t callback_max_nanoseconds;
     };
 
+    /**
+     * VirtualAudioDeviceOut is a headless sink that also drives the audio callback.
+     *
+     * It renders either synchronously by `render()`, or on its own thread between `startCallback()`
+     * and `stopCallback()`. By default it renders as fast as possible; with simulated realtime
+     * it waits for the wall clock to catch up with each callback, like an audio device would.
+     *
+     * The output is recorded into memory (up to `setRecordingCapacity()`) and can be saved as WAV.
+     * Per-callback processing time is recorded (up to `setStatisticsCapacity()` callbacks).
+     */
     class VirtualAudioDeviceOut : public AudioDeviceOut {
-        bool running{false};
+        int32_t sample_rate;
+        int32_t frames_per_callback;
+        AudioBuffer aap_buffer;
+        AudioDeviceCallback* aap_callback{nullptr};
+        void* callback_context{nullptr};
+
+        bool simulate_realtime{false};
+        std::atomic<bool> running{false};
+        std::thread render_thread{};
+
+        choc::buffer::ChannelArrayBuffer<float> recorded{};
+        int64_t recorded_frames{0};
+
+        std::vector<int64_t> callback_durations{};
+        int64_t num_callbacks{0};
+        int64_t rendered_frames{0};
+        int64_t wall_time_nanoseconds{0};
+
+        void renderCycle(int32_t numFrames);
+
     public:
-        explicit VirtualAudioDeviceOut() = default;
-        virtual ~VirtualAudioDeviceOut() = default;
+        VirtualAudioDeviceOut(int32_t sampleRate, int32_t framesPerCallback, int32_t numChannels);
+        virtual ~VirtualAudioDeviceOut();
 
-        void startCallback() override { running = true; }
-        void stopCallback() override { running = false; }
+        /// Whether it paces the callbacks in realtime or not (default: as fast as possible).
+        void setSimulatedRealtime(bool enabled) { simulate_realtime = enabled; }
+        /// Allocates the in-memory recording buffer. Anything beyond the capacity is not recorded.
+        void setRecordingCapacity(int64_t numFrames);
+        /// Allocates the per-callback timing storage. Callbacks beyond the capacity are not measured.
+        void setStatisticsCapacity(int64_t numCallbacks);
+
+        void startCallback() override;
+        void stopCallback() override;
         void setAudioCallback(AudioDeviceCallback audioDeviceCallback, void* callbackContext) override {
-            // should we implement something here?
-        }
-        void write(AudioBuffer *audioDataToWrite, int32_t bufferPosition, int32_t numFrames) override {
-            // should we implement something here?
+            aap_callback = audioDeviceCallback;
+            callback_context = callbackContext;
         }
+        void write(AudioBuffer *audioDataToWrite, int32_t bufferPosition, int32_t numFrames) override;
+
+        /// Renders `numFrames` frames synchronously on the calling thread.
+        /// It must not be used while the device is started.
+        void render(int64_t numFrames);
+
+        const choc::buffer::ChannelArrayBuffer<float>& getRecordedAudio() { return recorded; }
+        int64_t getRecordedFrames() { return recorded_frames; }
+        /// Saves the recorded audio as 32-bit float WAV. Returns false if it failed.
+        bool saveRecordedAudioAsWav(const std::string& path);
+
+        VirtualAudioDeviceStatistics getStatistics();
+        void resetStatistics();
     };
 
     class VirtualAudioDeviceManager : public AudioDeviceManager {
@@ -45,13 +124,10 @@ namespace aap {
         std::shared_ptr<VirtualAudioDeviceOut> output{};
 
     public:
-        VirtualAudioDeviceManager()
-                : input(std::make_shared<VirtualAudioDeviceIn>()),
-                  output(std::make_shared<VirtualAudioDeviceOut>()) {
-        }
+        VirtualAudioDeviceManager() = default;
 
-        AudioDeviceIn * ensureDefaultInputOpened(int32_t sampleRate, int32_t framesPerCallback, int32_t numChannels) override { return input.get(); }
-        AudioDeviceOut * ensureDefaultOutputOpened(int32_t sampleRate, int32_t framesPerCallback, int32_t numChannels) override { return output.get(); }
+        AudioDeviceIn * ensureDefaultInputOpened(int32_t sampleRate, int32_t framesPerCallback, int32_t numChannels) override;
+        AudioDeviceOut * ensureDefaultOutputOpened(int32_t sampleRate, int32_t framesPerCallback, int32_t numChannels) override;
     };
 
 }
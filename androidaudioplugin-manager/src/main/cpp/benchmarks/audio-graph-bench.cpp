@@ -0,0 +1,104 @@
+// Benchmark of BasicAudioGraph on serial chains of plugin-like nodes, with and without the buffer
+// aliasing between adjacent nodes (deferred audio outputs). Each node works like AudioPluginNode:
+// it copies its inputs into its own port buffers, processes them there, and hands the outputs on
+// either by copying them back or by deferring them. Both modes must render the same output.
+//
+// usage: aap-audio-graph-bench [cycles]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include "../AudioGraph.h"
+
+using namespace aap;
+
+namespace {
+    const int32_t sample_rate = 48000;
+    const int32_t frames_per_callback = 256;
+
+    // 2 audio in, 2 audio out, in its own buffer (like the shared memory of a plugin instance).
+    class ChainedEffectNode : public AudioGraphNode {
+        std::vector<float> port_buffers;
+        bool deferral;
+
+    public:
+        static int64_t copied_bytes;
+
+        ChainedEffectNode(AudioGraph* ownerGraph, bool useDeferral)
+                : AudioGraphNode(ownerGraph), port_buffers(4 * frames_per_callback), deferral(useDeferral) {
+        }
+
+        bool canReadDeferredAudio() override { return deferral; }
+        void start() override {}
+        void pause() override {}
+
+        void processAudio(AudioBuffer* audioData, int32_t numFrames) override {
+            for (int32_t c = 0; c < 2; c++) {
+                memcpy(&port_buffers[c * frames_per_callback], audioData->getAudioChannelData(c), numFrames * sizeof(float));
+                copied_bytes += numFrames * sizeof(float);
+            }
+            for (int32_t c = 0; c < 2; c++) {
+                auto in = &port_buffers[c * frames_per_callback];
+                auto out = &port_buffers[(2 + c) * frames_per_callback];
+                for (int32_t i = 0; i < numFrames; i++)
+                    out[i] = in[i] * 0.999f;
+            }
+            bool defer = audioData->isAudioDeferralAllowed();
+            for (int32_t c = 0; c < 2; c++) {
+                auto out = &port_buffers[(2 + c) * frames_per_callback];
+                if (defer) {
+                    audioData->deferAudioChannel(c, out, numFrames);
+                    continue;
+                }
+                memcpy(audioData->getAudioChannelForWrite(c), out, numFrames * sizeof(float));
+                copied_bytes += numFrames * sizeof(float);
+            }
+        }
+    };
+    int64_t ChainedEffectNode::copied_bytes = 0;
+}
+
+int main(int argc, char** argv) {
+    int32_t cycles = argc > 1 ? atoi(argv[1]) : 4000;
+
+    bool ok = true;
+    for (int32_t length : {2, 8, 32}) {
+        float outputs[2]{};
+        for (bool deferral : {false, true}) {
+            BasicAudioGraph graph{sample_rate, frames_per_callback, 2, 0};
+            std::vector<std::unique_ptr<ChainedEffectNode>> nodes{};
+            for (int32_t i = 0; i < length; i++) {
+                nodes.emplace_back(std::make_unique<ChainedEffectNode>(&graph, deferral));
+                if (i == 0)
+                    graph.addNode(nodes.back().get());
+                else
+                    graph.attachNode(nodes[i - 1].get(), 0, nodes.back().get(), 0);
+            }
+            graph.startProcessing();
+
+            AudioBuffer buffer{2, frames_per_callback};
+            std::vector<double> latencies(cycles);
+            ChainedEffectNode::copied_bytes = 0;
+            for (int32_t k = 0; k < cycles; k++) {
+                for (int32_t c = 0; c < 2; c++)
+                    std::fill_n(buffer.audio.getChannel(c).data.data, frames_per_callback, 1.0f);
+                auto begin = std::chrono::steady_clock::now();
+                graph.processAudio(&buffer, frames_per_callback);
+                latencies[k] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+            }
+            graph.pauseProcessing();
+            outputs[deferral] = buffer.audio.getChannel(1).data.data[frames_per_callback - 1];
+
+            std::sort(latencies.begin(), latencies.end());
+            printf("%2d nodes, aliasing %s: median %.2f us, p99 %.2f us, %lld bytes copied by the nodes per cycle, output %.6f\n",
+                   length, deferral ? "on " : "off", latencies[cycles / 2], latencies[cycles * 99 / 100],
+                   (long long) (ChainedEffectNode::copied_bytes / cycles), outputs[deferral]);
+        }
+        ok &= outputs[0] == outputs[1];
+    }
+    printf("outputs %s\n", ok ? "match" : "DIFFER");
+    return ok ? 0 : 1;
+}
@@ -1,5 +1,6 @@
 #include <sys/mman.h>
 #include <mutex>
+#include "aap/unstable/audio-interleave.h"
 #include "aap/unstable/logging.h"
 #include "aap/ext/midi.h"
 #include "AAPMidiProcessor.h"
@@ -100,19 +101,20 @@ namespace aap::midi {
     }
 
     void AAPMidiProcessor::terminate() {
-        if (instance_data != nullptr) {
-            if (instance_data->instance_id >= 0) {
-                auto instance = client->getInstanceById(instance_data->instance_id);
+        for (auto& data : chain) {
+            if (data->instance_id >= 0) {
+                auto instance = client->getInstanceById(data->instance_id);
                 if (!instance)
                     aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "instance of instance_id %d was not found",
-                                 instance_data->instance_id);
+                                 data->instance_id);
                 else
                     client->destroyInstance(instance);
             }
             else
                 aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "detected unexpected instance_id: %d",
-                             instance_data->instance_id);
+                             data->instance_id);
         }
+        chain.clear();
         ci_session.reset();
 
         if (aap_input_ring_buffer)
@@ -145,8 +147,6 @@ namespace aap::midi {
 
     // Instantiate AAP plugin and proceed up to prepare().
     void AAPMidiProcessor::instantiatePlugin(std::string pluginId) {
-        aap::a_log_f(AAP_LOG_LEVEL_INFO, LOG_TAG, "instantiating plugin %s", pluginId.c_str());
-
         if (state != AAP_MIDI_PROCESSOR_STATE_CREATED) {
             aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Unexpected call to instantiatePlugin() at %s state.",
                          convertStateToText(state).c_str());
@@ -154,25 +154,41 @@ namespace aap::midi {
             return;
         }
 
-        if (instance_data) {
-            const auto& instance = client->getInstanceById(instance_data->instance_id);
+        if (!chain.empty()) {
+            const auto& instance = client->getInstanceById(chain.front()->instance_id);
             if (instance)
                 aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "There is an already instantiated plugin \"%s\" for this MidiDeviceService.",
                              instance->getPluginInformation()->getDisplayName().c_str());
             else
-                aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Internal error: stale plugin instance data remains in the memory.",
-                             instance->getPluginInformation()->getDisplayName().c_str());
+                aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Internal error: stale plugin instance data remains in the memory.");
             state = AAP_MIDI_PROCESSOR_STATE_ERROR;
             return;
         }
 
+        instantiateChainPlugin(pluginId, true);
+    }
+
+    void AAPMidiProcessor::addEffectPlugin(std::string pluginId) {
+        if (state != AAP_MIDI_PROCESSOR_STATE_INACTIVE || chain.empty()) {
+            aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Unexpected call to addEffectPlugin() at %s state (chain length: %d).",
+                         convertStateToText(state).c_str(), (int32_t) chain.size());
+            state = AAP_MIDI_PROCESSOR_STATE_ERROR;
+            return;
+        }
+
+        instantiateChainPlugin(pluginId, false);
+    }
+
+    void AAPMidiProcessor::instantiateChainPlugin(std::string pluginId, bool isHead) {
+        aap::a_log_f(AAP_LOG_LEVEL_INFO, LOG_TAG, "instantiating plugin %s", pluginId.c_str());
+
         auto pluginInfo = plugin_list.getPluginInformation(pluginId);
         if (!pluginInfo) {
             aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Plugin of ID \"%s\" is not found.", pluginId.c_str());
             state = AAP_MIDI_PROCESSOR_STATE_ERROR;
             return;
         }
-        if (!pluginInfo->isInstrument()) {
+        if (isHead && !pluginInfo->isInstrument()) {
             aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Plugin \"%s\" is not an instrument.",
                          pluginInfo->getDisplayName().c_str());
             state = AAP_MIDI_PROCESSOR_STATE_ERROR;
@@ -203,18 +219,20 @@ namespace aap::midi {
                 return;
             }
 
-            instrument_instance_id = instanceId;
-
             int32_t numPorts = instance->getNumPorts();
             auto data = std::make_unique<PluginInstanceData>(instanceId, numPorts);
 
             data->instance_id = instanceId;
+            data->instance = instance;
 
             for (int i = 0; i < numPorts; i++) {
                 auto port = instance->getPort(i);
                 if (port->getContentType() == AAP_CONTENT_TYPE_AUDIO &&
                     port->getPortDirection() == AAP_PORT_DIRECTION_OUTPUT)
                     data->getAudioOutPorts()->emplace_back(i);
+                else if (port->getContentType() == AAP_CONTENT_TYPE_AUDIO &&
+                         port->getPortDirection() == AAP_PORT_DIRECTION_INPUT)
+                    data->getAudioInPorts()->emplace_back(i);
                 else if (port->getContentType() == AAP_CONTENT_TYPE_MIDI2 &&
                          port->getPortDirection() == AAP_PORT_DIRECTION_INPUT)
                     data->midi2_in_port = i;
@@ -222,73 +240,70 @@ namespace aap::midi {
                          port->getPortDirection() == AAP_PORT_DIRECTION_INPUT)
                     data->midi1_in_port = i;
             }
+            data->getAudioOutBuffers()->resize(data->getAudioOutPorts()->size());
+            if (!isHead && data->getAudioInPorts()->empty())
+                aap::a_log_f(AAP_LOG_LEVEL_WARN, LOG_TAG, "Plugin \"%s\" has no audio input; the preceding plugins in the chain will not be heard.",
+                             pluginInfo->getDisplayName().c_str());
 
             instance->prepare(aap_frame_size, sample_rate);
 
-            instance_data = std::move(data);
+            chain.emplace_back(std::move(data));
 
             state = AAP_MIDI_PROCESSOR_STATE_INACTIVE;
 
-            aap::a_log_f(AAP_LOG_LEVEL_INFO, LOG_TAG, "instantiated plugin %s", pluginId.c_str());
+            aap::a_log_f(AAP_LOG_LEVEL_INFO, LOG_TAG, "instantiated plugin %s (chain length: %d)", pluginId.c_str(), (int32_t) chain.size());
         };
         client->connectToPluginService(pluginId, cb);
     }
 
     // Note that it is an expensive operation so we cache it at activate().
     int32_t AAPMidiProcessor::getInstrumentMidiMappingPolicy() {
-        for (int i = 0; i < client->getInstanceCount(); i++) {
-            auto instance = client->getInstanceByIndex(i);
-            if (instance->getPluginInformation()->isInstrument())
-                return instance->getStandardExtensions().getMidiMappingPolicy();
-        }
-        return 0;
+        auto instance = getInstrumentInstance();
+        return instance ? instance->getStandardExtensions().getMidiMappingPolicy() : 0;
     }
 
-    // Set up the MIDI-CI session for the first instrument instance found.
+    // Set up the MIDI-CI session for the instrument at the head of the chain.
     // Called from activate() before audio streaming starts.
     void AAPMidiProcessor::setupCISession() {
         if (ci_session)
             return; // already set up
-        for (int i = 0; i < client->getInstanceCount(); i++) {
-            auto instance = client->getInstanceByIndex(i);
-            if (!instance->getPluginInformation()->isInstrument())
-                continue;
-            ci_session = std::make_unique<AAPMidiCISession>(instance);
-            ci_session->setupMidiCISession(
-                [this](umppi::UmpWordSpan words, uint64_t ts) {
-                    if (!midi_output_sender || words.empty())
-                        return;
-
-                    auto sendBytes = [this, ts](const std::vector<uint8_t>& bytes) {
-                        if (!bytes.empty())
-                            midi_output_sender(bytes.data(), 0, bytes.size(), ts);
-                    };
-
-                    if (receiver_midi_protocol == CMIDI2_PROTOCOL_TYPE_MIDI2) {
-                        ci_output_byte_buffer.resize(words.size() * sizeof(uint32_t));
-                        memcpy(ci_output_byte_buffer.data(), words.data(),
-                               ci_output_byte_buffer.size());
-                        sendBytes(ci_output_byte_buffer);
-                        return;
-                    }
+        auto instance = getInstrumentInstance();
+        if (!instance)
+            return;
+        ci_session = std::make_unique<AAPMidiCISession>(instance);
+        ci_session->setupMidiCISession(
+            [this](umppi::UmpWordSpan words, uint64_t ts) {
+                if (!midi_output_sender || words.empty())
+                    return;
 
-                    auto umps = umppi::parseUmpsFromWords(words);
-                    if (umps.empty())
-                        return;
-
-                    ci_output_byte_buffer.clear();
-                    const int result = umppi::UmpTranslator::translateUmpToMidi1Bytes(
-                        ci_output_byte_buffer, umps);
-                    if (result != umppi::UmpTranslationResult::OK) {
-                        aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG,
-                                     "Failed to convert CI response UMP to MIDI1 bytes (err=%d)",
-                                     result);
-                        return;
-                    }
+                auto sendBytes = [this, ts](const std::vector<uint8_t>& bytes) {
+                    if (!bytes.empty())
+                        midi_output_sender(bytes.data(), 0, bytes.size(), ts);
+                };
+
+                if (receiver_midi_protocol == CMIDI2_PROTOCOL_TYPE_MIDI2) {
+                    ci_output_byte_buffer.resize(words.size() * sizeof(uint32_t));
+                    memcpy(ci_output_byte_buffer.data(), words.data(),
+                           ci_output_byte_buffer.size());
                     sendBytes(ci_output_byte_buffer);
-                });
-            break;
-        }
+                    return;
+                }
+
+                auto umps = umppi::parseUmpsFromWords(words);
+                if (umps.empty())
+                    return;
+
+                ci_output_byte_buffer.clear();
+                const int result = umppi::UmpTranslator::translateUmpToMidi1Bytes(
+                    ci_output_byte_buffer, umps);
+                if (result != umppi::UmpTranslationResult::OK) {
+                    aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG,
+                                 "Failed to convert CI response UMP to MIDI1 bytes (err=%d)",
+                                 result);
+                    return;
+                }
+                sendBytes(ci_output_byte_buffer);
+            });
     }
 
     // Activate audio processing. Starts audio (oboe) streaming, CPU-intensive operations happen from here.
@@ -339,10 +354,41 @@ namespace aap::midi {
         state = AAP_MIDI_PROCESSOR_STATE_INACTIVE;
     }
 
+    // Feeds the audio outputs of `from` into the audio inputs of `to`, paired in the audio port order.
+    // A mono output feeds all the inputs. Inputs without any counterpart are silent.
+    void feedChainAudio(PluginInstanceData* from, PluginInstanceData* to, int32_t numFrames) {
+        auto src = from->instance->getAudioPluginBuffer();
+        auto dst = to->instance->getAudioPluginBuffer();
+        auto& outs = *from->getAudioOutPorts();
+        auto& ins = *to->getAudioInPorts();
+        for (size_t i = 0; i < ins.size(); i++) {
+            auto in = (float*) dst->get_buffer(dst, ins[i]);
+            auto frames = std::min(numFrames, dst->get_buffer_size(dst, ins[i]) / (int32_t) sizeof(float));
+            if (outs.empty()) {
+                memset(in, 0, frames * sizeof(float));
+                continue;
+            }
+            auto outPort = outs.size() == 1 ? outs[0] : i < outs.size() ? outs[i] : -1;
+            if (outPort < 0) {
+                memset(in, 0, frames * sizeof(float));
+                continue;
+            }
+            frames = std::min(frames, src->get_buffer_size(src, outPort) / (int32_t) sizeof(float));
+            memcpy(in, src->get_buffer(src, outPort), frames * sizeof(float));
+        }
+    }
+
     int32_t failed_plugin_process_count;
-    // Called by Oboe audio callback implementation. It calls process.
+    // Called by Oboe audio callback implementation. It calls process() of every plugin in the chain.
     void AAPMidiProcessor::callPluginProcess() {
+        if (chain.empty()) {
+            // It's not ready to process audio yet.
+            if (failed_plugin_process_count++ < 10)
+                aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "callPluginProcess() failed. Plugin instance data Not ready uet.");
+            return;
+        }
 
+        // MIDI inputs go to the head of the chain.
         auto dstBuffer = (AAPMidiBufferHeader*) getAAPMidiInputBuffer();
         if (std::unique_lock<NanoSleepLock> tryLock(midi_buffer_mutex, std::try_to_lock); tryLock.owns_lock()) {
             auto srcBuffer = (AAPMidiBufferHeader*) midi_input_buffer;
@@ -356,16 +402,18 @@ namespace aap::midi {
         }
         dstBuffer->time_options = 0; // reserved in MIDI2 mode
 
-        auto data = instance_data.get();
-        if (!data) {
-            // It's not ready to process audio yet.
-            if (failed_plugin_process_count++ < 10)
-                aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "callPluginProcess() failed. Plugin instance data Not ready uet.");
-            return;
+        for (size_t i = 0; i < chain.size(); i++) {
+            auto data = chain[i].get();
+            if (i > 0) {
+                feedChainAudio(chain[i - 1].get(), data, aap_frame_size);
+                // effects receive no MIDI inputs (except for AAPXS SysEx8 that process() merges).
+                auto b = data->instance->getAudioPluginBuffer();
+                for (auto port : {data->midi2_in_port, data->midi1_in_port})
+                    if (port >= 0)
+                        ((AAPMidiBufferHeader*) b->get_buffer(b, port))->length = 0;
+            }
+            data->instance->process(aap_frame_size, 1000000000);
         }
-
-        auto instance = client->getInstanceById(data->instance_id);
-        instance->process(aap_frame_size, 1000000000);
     }
 
     int32_t failed_audio_output_count{0};
@@ -374,44 +422,31 @@ namespace aap::midi {
     //  fill the audio outputs into an intermediate buffer, interleaving the results,
     //  then copied into the ring buffer.
     void AAPMidiProcessor::fillAudioOutput() {
-        // FIXME: the final processing result should not be the instrument instance output buffer
-        //  but should be chained output result. Right now we don't support chaining.
-
         memset(interleave_buffer, 0, channel_count * aap_frame_size * sizeof(float));
 
-        auto data = instance_data.get();
-        if (!data) {
+        if (chain.empty()) {
             // It's not ready to process audio yet.
             if (failed_audio_output_count++ < 10)
                 aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "fillAudioOutput() for Oboe audio callback failed. Plugin instance data Not ready uet.");
             return;
         }
-        else
-            failed_audio_output_count = 0;
-
-        if (data->instance_id == instrument_instance_id) {
-            int numPorts = data->getAudioOutPorts()->size();
-            auto instance = client->getInstanceById(data->instance_id);
-            auto b = instance->getAudioPluginBuffer();
-            for (int p = 0; p < numPorts; p++) {
-                int portIndex = data->getAudioOutPorts()->at(p);
-                auto src = (float*) b->get_buffer(b, portIndex);
-                // We have to interleave separate port outputs to copy...
-                for (int i = 0; i < aap_frame_size; i++)
-                    interleave_buffer[i * numPorts + p] = src[i];
-            }
-            failed_audio_output_count = 0;
-        } else {
-            if (failed_audio_output_count++ < 10)
-                aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "fillAudioOutput() is invoked while there is no instrument plugin instantiated.");
-            return;
-        }
+
+        // the output of the chain is the one of its last plugin.
+        auto data = chain.back().get();
+        int numPorts = data->getAudioOutPorts()->size();
+        auto b = data->instance->getAudioPluginBuffer();
+        auto buffers = data->getAudioOutBuffers();
+        for (int p = 0; p < numPorts; p++)
+            buffers->at(p) = (const float*) b->get_buffer(b, data->getAudioOutPorts()->at(p));
+        // We have to interleave separate port outputs to copy...
+        interleaveAudio(interleave_buffer, buffers->data(), numPorts, aap_frame_size);
+        failed_audio_output_count = 0;
 
         zix_ring_write(aap_input_ring_buffer, interleave_buffer, channel_count * aap_frame_size * sizeof(float));
     }
 
     int32_t AAPMidiProcessor::getAAPMidiInputPortType() {
-        auto data = instance_data.get();
+        auto data = getAAPMidiInputData();
         if (!data) {
             AAP_ASSERT_FALSE;
             return 0;
@@ -427,14 +462,13 @@ namespace aap::midi {
     }
 
     void* AAPMidiProcessor::getAAPMidiInputBuffer() {
-        auto data = instance_data.get();
+        auto data = getAAPMidiInputData();
         if (!data) {
             AAP_ASSERT_FALSE;
             return nullptr;
         }
         int portIndex = getAAPMidiInputPortType() == CMIDI2_PROTOCOL_TYPE_MIDI2 ? data->midi2_in_port : data->midi1_in_port;
-        auto instance = client->getInstanceById(data->instance_id);
-        auto b = instance->getAudioPluginBuffer();
+        auto b = data->instance->getAudioPluginBuffer();
         return b->get_buffer(b, portIndex);
     }
 
@@ -483,11 +517,8 @@ namespace aap::midi {
                     break;
             }
             if (presetIndex >= 0) {
-                for (int i = 0; i < client->getInstanceCount(); i++) {
-                    auto instance = client->getInstanceByIndex(i);
-                    if (instance->getPluginInformation()->isInstrument())
-                        instance->getStandardExtensions().setCurrentPresetIndex(presetIndex);
-                }
+                if (auto instance = getInstrumentInstance())
+                    instance->getStandardExtensions().setCurrentPresetIndex(presetIndex);
             }
             // If a translated AAP parameter change message is detected, then output sysex8.
             if (parameterIndex < 0) {
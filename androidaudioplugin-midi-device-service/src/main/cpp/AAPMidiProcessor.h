@@ -54,20 +54,30 @@ namespace aap::midi {
     };
 
     class PluginInstanceData {
+        std::vector<int> audio_in_ports{};
         std::vector<int> audio_out_ports{};
+        // sized to audio_out_ports so that fillAudioOutput() does not allocate.
+        std::vector<const float*> audio_out_buffers{};
 
     public:
         PluginInstanceData(int instanceId, size_t numPorts) : instance_id(instanceId) {
             auto arr = (void**) calloc(sizeof(void*), numPorts + 1);
             arr[numPorts] = nullptr;
         }
+        inline std::vector<int32_t>* getAudioInPorts() { return &audio_in_ports; }
         inline std::vector<int32_t>* getAudioOutPorts() { return &audio_out_ports; }
+        inline std::vector<const float*>* getAudioOutBuffers() { return &audio_out_buffers; }
 
         int instance_id;
+        // cached so that the audio callback does not have to look it up by instance_id.
+        aap::PluginInstance* instance{nullptr};
         int midi1_in_port{-1};
         int midi2_in_port{-1};
     };
 
+    // Feeds the audio outputs of `from` into the audio inputs of `to` (between two plugins in the chain).
+    void feedChainAudio(PluginInstanceData* from, PluginInstanceData* to, int32_t numFrames);
+
     class AAPMidiProcessor {
         static std::string convertStateToText(AAPMidiProcessorState state);
 
@@ -78,14 +88,19 @@ namespace aap::midi {
         int32_t aap_frame_size{1024};
         int32_t midi_buffer_size{4096};
         int32_t channel_count{2};
-        std::unique_ptr<PluginInstanceData> instance_data{nullptr};
-        int32_t instrument_instance_id{0};
+        // The plugins that are processed in series within one processAudioIO() cycle: the instrument
+        // that receives the MIDI inputs at the head, followed by the effects that take the audio
+        // outputs of the previous one. The last one makes the audio output.
+        std::vector<std::unique_ptr<PluginInstanceData>> chain{};
         // MIDI protocol type of the messages it receives via JNI
         int32_t receiver_midi_protocol{CMIDI2_PROTOCOL_TYPE_MIDI1};
         int32_t current_mapping_policy{AAP_PARAMETERS_MAPPING_POLICY_NONE};
 
         int32_t getAAPMidiInputPortType();
-        PluginInstanceData* getAAPMidiInputData();
+        PluginInstanceData* getAAPMidiInputData() { return chain.empty() ? nullptr : chain.front().get(); }
+        // the instrument that receives the MIDI inputs; nullptr if nothing is instantiated yet.
+        aap::PluginInstance* getInstrumentInstance() { return chain.empty() ? nullptr : chain.front()->instance; }
+        void instantiateChainPlugin(std::string pluginId, bool isHead);
         void* getAAPMidiInputBuffer();
         // used when we need MIDI1<->UMP translation.
         uint8_t* translation_buffer{nullptr};
@@ -125,8 +140,15 @@ namespace aap::midi {
                         int32_t sampleRate, int32_t channelCount,
                         int32_t aapFrameSize, int32_t midiBufferSize, int32_t midiMessageFormat);
 
+        // Instantiates the instrument plugin (the head of the chain).
         void instantiatePlugin(std::string pluginId);
 
+        // Appends an effect plugin to the chain. It has to be called after instantiatePlugin() and
+        // before activate(). Its plugin service must be connected in advance, like the instrument.
+        void addEffectPlugin(std::string pluginId);
+
+        inline int32_t getChainLength() { return (int32_t) chain.size(); }
+
         int32_t getInstrumentMidiMappingPolicy();
 
         void activate();
@@ -114,6 +114,16 @@ JNIEXPORT void JNICALL Java_org_androidaudioplugin_midideviceservice_AudioPlugin
     free((void *) pluginIdPtr);
 }
 
+JNIEXPORT void JNICALL Java_org_androidaudioplugin_midideviceservice_AudioPluginMidiDeviceInstance_addEffectPlugin(
+        JNIEnv *env, jobject midiReceiver, jstring pluginId) {
+    auto pluginIdPtr = dupFromJava(env, pluginId);
+    std::string pluginIdString = pluginIdPtr;
+
+    AAPMIDIDEVICE_INSTANCE->addEffectPlugin(pluginIdString);
+
+    free((void *) pluginIdPtr);
+}
+
 jbyte jni_midi_buffer[1024]{};
 
 JNIEXPORT void JNICALL Java_org_androidaudioplugin_midideviceservice_AudioPluginMidiDeviceInstance_processMessage(
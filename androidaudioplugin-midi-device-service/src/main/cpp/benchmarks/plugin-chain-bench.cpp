@@ -0,0 +1,93 @@
+// Benchmark of the plugin chain in AAPMidiProcessor: an instrument followed by 0..7 effects is
+// processed the way callPluginProcess() does it (feedChainAudio() between the plugins), on
+// client shared memory port buffers. It reports the cycle time, the part of it spent in
+// feedChainAudio(), and the end-to-end latency compared to stacking one MIDI device service
+// (each with its own audio callback period) per plugin.
+//
+// usage: aap-plugin-chain-bench [cycles]
+
+#include <cstdlib>
+#include "AAPMidiProcessor.h"
+#include "benchmark-support.h"
+
+using namespace aap;
+using namespace aap::midi;
+
+namespace {
+    const int32_t frames_per_callback = 512;
+    const int32_t sample_rate = 48000;
+
+    struct ChainedPlugin {
+        benchmark::BenchmarkPluginInstance instance{benchmark::BenchmarkPluginInstance::stereoEffectPorts(),
+                                                    frames_per_callback, sample_rate};
+        PluginInstanceData data{0, 6};
+        float state[2]{};
+
+        explicit ChainedPlugin(bool isInstrument) {
+            data.instance = &instance;
+            data.midi2_in_port = 4;
+            if (!isInstrument)
+                *data.getAudioInPorts() = {0, 1};
+            *data.getAudioOutPorts() = {2, 3};
+            instance.dsp = [this, isInstrument](aap_buffer_t* buffer, int32_t frameCount) {
+                for (int32_t c = 0; c < 2; c++) {
+                    auto in = (const float*) buffer->get_buffer(buffer, c);
+                    auto out = (float*) buffer->get_buffer(buffer, c + 2);
+                    float z = state[c];
+                    for (int32_t i = 0; i < frameCount; i++) {
+                        float x = isInstrument ? (float) ((i * (c + 1)) % 64) / 64.0f : in[i];
+                        z += 0.1f * (x - z);
+                        out[i] = z * 0.9f;
+                    }
+                    state[c] = z;
+                }
+            };
+        }
+    };
+
+    // the chain part of AAPMidiProcessor::callPluginProcess().
+    void processChain(std::vector<std::unique_ptr<ChainedPlugin>>& chain) {
+        for (size_t i = 0; i < chain.size(); i++) {
+            auto data = &chain[i]->data;
+            if (i > 0) {
+                feedChainAudio(&chain[i - 1]->data, data, frames_per_callback);
+                auto b = data->instance->getAudioPluginBuffer();
+                for (auto port : {data->midi2_in_port, data->midi1_in_port})
+                    if (port >= 0)
+                        ((AAPMidiBufferHeader*) b->get_buffer(b, port))->length = 0;
+            }
+            data->instance->process(frames_per_callback, 1000000000);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    int32_t cycles = argc > 1 ? atoi(argv[1]) : 20000;
+
+    for (int32_t length = 1; length <= 8; length++) {
+        std::vector<std::unique_ptr<ChainedPlugin>> chain{};
+        for (int32_t i = 0; i < length; i++)
+            chain.emplace_back(std::make_unique<ChainedPlugin>(i == 0));
+
+        benchmark::LatencySamples samples{(size_t) cycles};
+        for (int32_t c = 0; c < cycles; c++) {
+            auto begin = benchmark::nowNanoseconds();
+            processChain(chain);
+            samples.add(benchmark::nowNanoseconds() - begin);
+        }
+
+        auto begin = benchmark::nowNanoseconds();
+        for (int32_t c = 0; c < cycles; c++)
+            for (int32_t i = 1; i < length; i++)
+                feedChainAudio(&chain[i - 1]->data, &chain[i]->data, frames_per_callback);
+        double feed = (double) (benchmark::nowNanoseconds() - begin) / cycles / 1000.0;
+
+        char name[64];
+        snprintf(name, sizeof(name), "%d plugin(s), cycle", length);
+        samples.print(name);
+        printf("  feedChainAudio() %.2f us/cycle; end-to-end latency %.2f ms (vs %.2f ms for %d stacked services)\n",
+               feed, frames_per_callback * 1000.0 / sample_rate,
+               length * frames_per_callback * 1000.0 / sample_rate, length);
+    }
+    return 0;
+}
@@ -33,8 +33,9 @@ class AudioPluginMidiDeviceInstance private constructor(
          * @param outputPortReceiverProvider supplies the [MidiReceiver] for an output port declared
          *   in the service's midi_device_info.xml. It may return null when the output side is not
          *   currently open, in which case CI responses are dropped.
+         * @param effectPluginIds the effect plugins to chain after the instrument `pluginId`, in order.
          */
-        suspend fun create(pluginId: String, ownerService: AudioPluginMidiDevice,
+        suspend fun create(pluginId: String, effectPluginIds: List<String>, ownerService: AudioPluginMidiDevice,
                            midiTransport: Int,
                            outputPortReceiverProvider: MidiOutputReceiverProvider) : AudioPluginMidiDeviceInstance {
             val audioManager = ownerService.applicationContext.getSystemService(Context.AUDIO_SERVICE) as AudioManager
@@ -54,6 +55,11 @@ class AudioPluginMidiDeviceInstance private constructor(
             val pluginInfo = ownerService.plugins.first { p -> p.pluginId == pluginId }
             client.connectToPluginService(pluginInfo.packageName)
             ret.instantiatePlugin(pluginId)
+            for (effectId in effectPluginIds) {
+                val effectInfo = ownerService.effectPlugins.first { p -> p.pluginId == effectId }
+                client.connectToPluginService(effectInfo.packageName)
+                ret.addEffectPlugin(effectId)
+            }
             ret.activate()
 
             ret.setMidiOutputCallback(MidiOutputCallback { data, offset, count, timestamp ->
@@ -94,6 +100,7 @@ class AudioPluginMidiDeviceInstance private constructor(
         midiTransport: Int)
     private external fun terminateMidiProcessor()
     private external fun instantiatePlugin(pluginId: String)
+    private external fun addEffectPlugin(pluginId: String)
     private external fun processMessage(msg: ByteArray?, offset: Int, count: Int, timestampInNanoseconds: Long)
     private external fun activate()
     private external fun deactivate()
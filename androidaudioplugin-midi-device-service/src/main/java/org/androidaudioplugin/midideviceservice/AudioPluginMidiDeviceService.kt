@@ -16,6 +16,10 @@ abstract class AudioPluginMidiUmpDeviceService : MidiUmpDeviceService() {
     // It is designed to be open overridable.
     abstract val plugins: List<PluginInformation>
 
+    // Effect plugins that are chained after the instrument, in this order. Their audio outputs
+    // feed the next plugin's audio inputs within the same audio cycle.
+    open val effectPlugins: List<PluginInformation> = listOf()
+
     override fun onGetInputPortReceivers() = impl.onGetInputPortReceivers().toMutableList()
     override fun onDeviceStatusChanged(status: MidiDeviceStatus) {
         super.onDeviceStatusChanged(status)
@@ -29,6 +33,10 @@ abstract class AudioPluginMidiDeviceService : MidiDeviceService() {
     // It is designed to be open overridable.
     abstract val plugins: List<PluginInformation>
 
+    // Effect plugins that are chained after the instrument, in this order. Their audio outputs
+    // feed the next plugin's audio inputs within the same audio cycle.
+    open val effectPlugins: List<PluginInformation> = listOf()
+
     override fun onGetInputPortReceivers(): Array<MidiReceiver> = impl.onGetInputPortReceivers()
     override fun onDeviceStatusChanged(status: MidiDeviceStatus) {
         super.onDeviceStatusChanged(status)
@@ -37,7 +45,7 @@ abstract class AudioPluginMidiDeviceService : MidiDeviceService() {
 }
 
 internal class AudioPluginMidi1Device(private val owner: AudioPluginMidiDeviceService)
-    : AudioPluginMidiDevice({ owner.applicationContext }, { owner.deviceInfo }, owner.plugins) {
+    : AudioPluginMidiDevice({ owner.applicationContext }, { owner.deviceInfo }, owner.plugins, owner.effectPlugins) {
 
     override val midiProtocol = 1
 
@@ -49,7 +57,7 @@ internal class AudioPluginMidi1Device(private val owner: AudioPluginMidiDeviceSe
 
 @RequiresApi(35)
 internal class AudioPluginMidi2Device(private val owner: AudioPluginMidiUmpDeviceService)
-    : AudioPluginMidiDevice({ owner.applicationContext }, { owner.deviceInfo!! }, owner.plugins) {
+    : AudioPluginMidiDevice({ owner.applicationContext }, { owner.deviceInfo!! }, owner.plugins, owner.effectPlugins) {
 
     override val midiProtocol = 2
 
@@ -62,7 +70,8 @@ internal class AudioPluginMidi2Device(private val owner: AudioPluginMidiUmpDevic
 abstract class AudioPluginMidiDevice(
     lazyGetApplicationContext: ()->Context,
     lazyGetDeviceInfo: ()->MidiDeviceInfo,
-    candidatePlugins: List<PluginInformation>
+    candidatePlugins: List<PluginInformation>,
+    val effectPlugins: List<PluginInformation> = listOf()
 ) {
     val applicationContext by lazy { lazyGetApplicationContext() }
     val deviceInfo by lazy { lazyGetDeviceInfo() }
@@ -147,4 +156,8 @@ abstract class AudioPluginMidiDevice(
         assert (plugin != null || acceptAnyIndexForSinglePlugin && plugins.size == 1)
         return (plugin ?: plugins.first()).pluginId!!
     }
+
+    // The effect plugins to chain after the instrument for the port. By default, every port uses
+    // all the `effectPlugins`.
+    open fun getEffectPluginIds(portIndex: Int): List<String> = effectPlugins.map { it.pluginId!! }
 }
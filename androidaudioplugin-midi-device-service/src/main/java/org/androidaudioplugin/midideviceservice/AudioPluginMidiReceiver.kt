@@ -37,7 +37,7 @@ open class AudioPluginMidiReceiver(
     fun onDeviceOpened() {
         assert(instance == null)
         runBlocking {
-            instance = AudioPluginMidiDeviceInstance.create(owner.getPluginId(portIndex), owner,
+            instance = AudioPluginMidiDeviceInstance.create(owner.getPluginId(portIndex), owner.getEffectPluginIds(portIndex), owner,
                 midiTransport, MidiOutputReceiverProvider { owner.getOutputPortReceiver(portIndex) })
         }
     }
@@ -1,6 +1,8 @@
 #ifndef ANDROIDAUDIOPLUGIN_AUDIOPLUGININTERFACEIMPL_H
 #define ANDROIDAUDIOPLUGIN_AUDIOPLUGININTERFACEIMPL_H
 
+#include <map>
+#include <mutex>
 #include <sstream>
 #include <utility>
 #include <android/sharedmem.h>
@@ -15,6 +17,7 @@
 #include "aidl/org/androidaudioplugin/BnAudioPluginExtensionCallback.h"
 #include "aap/core/host/audio-plugin-host.h"
 #include "aap/core/host/shared-memory-store.h"
+#include "aap/core/host/process-transport.h"
 #include "../core/hosting/plugin-service-list.h"
 
 #define AAP_AIDL_SVC_LOG_TAG "AAP.aidl.svc"
@@ -60,6 +63,10 @@ class AudioPluginInterfaceImpl : public aidl::org::androidaudioplugin::BnAudioPl
     std::unique_ptr<PluginService> svc;
     std::vector<aap_buffer_t> buffers{};
     std::unique_ptr<AudioPluginServiceCallbackAndroid> plugin_service_callback{nullptr};
+    // instanceId -> render thread that serves PROCESS_TRANSPORT_SHARED_MEMORY_FUTEX clients.
+    // Binder calls for different instances arrive on different threads, so guard every access.
+    std::mutex process_transports_mutex{};
+    std::map<int32_t, std::unique_ptr<FutexProcessTransportService>> process_transports{};
 
 public:
 
@@ -167,6 +174,33 @@ public:
                                       int32_t in_size) override {
         auto instance = svc->getLocalInstance(in_instanceID);
         CHECK_INSTANCE(instance, in_instanceID)
+        // Not an actual extension; the client asks to process() via the futex control block.
+        // If we do not start the service, the client notices it and keeps using process() IPC.
+        if (in_uri == AAP_PROCESS_TRANSPORT_FUTEX_URI) {
+            auto fdRemote = in_sharedMemoryFD.get();
+            if (fdRemote < 0 || in_size < (int32_t) sizeof(ProcessControlBlock))
+                return ndk::ScopedAStatus::ok();
+            auto transport = std::make_unique<FutexProcessTransportService>(dup(fdRemote),
+                [instance](int32_t frameCount, int64_t timeoutInNanoseconds) {
+                    instance->process(frameCount, timeoutInNanoseconds);
+                });
+            if (transport->start()) {
+                std::unique_ptr<FutexProcessTransportService> replaced{};
+                {
+                    std::lock_guard<std::mutex> lock{process_transports_mutex};
+                    auto& slot = process_transports[in_instanceID];
+                    replaced = std::move(slot);
+                    slot = std::move(transport);
+                }
+                // the replaced render thread (if any) is joined outside the lock.
+            }
+            return ndk::ScopedAStatus::ok();
+        }
+        // Not an actual extension either; the client asks whether we accept the port buffer arena.
+        if (in_uri == AAP_PORT_BUFFER_ARENA_URI) {
+            aap::acknowledgePortBufferArena(in_sharedMemoryFD.get(), in_size);
+            return ndk::ScopedAStatus::ok();
+        }
         if (in_size > 0) {
             auto shmExt = instance->getSharedMemoryStore();
             if (shmExt == nullptr) {
@@ -204,8 +238,8 @@ public:
         return ndk::ScopedAStatus::ok();
     }
 
-    // Since AIDL does not support sending List of ParcelFileDescriptor it is sent one by one.
-    // Here we just cache the FDs, and process them later at prepare().
+    // Current clients send one arena FD for all ports (in_shmFDIndex == PORT_BUFFER_ARENA_FD_INDEX);
+    // older clients send one FD per port. Either way we just cache the FDs, and process them later at prepare().
     ::ndk::ScopedAStatus prepareMemory(int32_t in_instanceID, int32_t in_shmFDIndex,
                                        const ::ndk::ScopedFileDescriptor &in_sharedMemoryFD) override {
         auto instance = svc->getLocalInstance(in_instanceID);
@@ -316,6 +350,17 @@ public:
         auto instance = svc->getLocalInstance(in_instanceID);
         CHECK_INSTANCE(instance, in_instanceID)
 
+        // the render thread must be gone before the instance. It is joined outside the lock.
+        std::unique_ptr<FutexProcessTransportService> transport{};
+        {
+            std::lock_guard<std::mutex> lock{process_transports_mutex};
+            auto it = process_transports.find(in_instanceID);
+            if (it != process_transports.end()) {
+                transport = std::move(it->second);
+                process_transports.erase(it);
+            }
+        }
+        transport.reset();
         svc->destroyInstance(instance);
         return ndk::ScopedAStatus::ok();
     }
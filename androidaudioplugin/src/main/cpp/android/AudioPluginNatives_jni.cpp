@@ -320,8 +320,15 @@ Java_org_androidaudioplugin_hosting_NativeRemotePluginInstance_getState(JNIEnv *
 																		jbyteArray data) {
     auto client = (aap::PluginClient*) (void*) nativeClient;
     auto instance = client->getInstanceById(instanceId);
-	auto state = instance->getStandardExtensions().getState().value;
-	env->SetByteArrayRegion(data, 0, state.data_size, static_cast<const jbyte *>(state.data));
+	// stream the chunks straight into the array, instead of holding another copy of the whole state.
+	size_t length = env->GetArrayLength(data);
+	size_t offset = 0;
+	instance->getStandardExtensions().readState([env, data, length, &offset](const uint8_t* chunk, size_t size, size_t) {
+		if (offset < length)
+			env->SetByteArrayRegion(data, offset, std::min(size, length - offset), reinterpret_cast<const jbyte *>(chunk));
+		offset += size;
+		return true;
+	});
 }
 
 extern "C"
@@ -333,10 +340,10 @@ Java_org_androidaudioplugin_hosting_NativeRemotePluginInstance_setState(JNIEnv *
     auto client = (aap::PluginClient*) (void*) nativeClient;
     auto instance = client->getInstanceById(instanceId);
 	auto length = env->GetArrayLength(data);
-	jboolean wasCopy;
-	auto buf = env->GetByteArrayElements(data, &wasCopy);
-	instance->getStandardExtensions().setState(buf, length);
-	env->ReleaseByteArrayElements(data, buf, JNI_ABORT);
+	instance->getStandardExtensions().writeState(length, [env, data](uint8_t* destination, size_t offset, size_t size) {
+		env->GetByteArrayRegion(data, offset, size, reinterpret_cast<jbyte *>(destination));
+		return true;
+	});
 }
 
 // Presets extensions
@@ -766,3 +773,102 @@ Java_org_androidaudioplugin_ui_compose_ComposeAudioPluginView_readParameterOutpu
         return 0;
     return readLocalGuiListenerMidi2Output(instance, output, size);
 }
+
+// Process trace
+
+namespace {
+
+aap::PluginInstance* getRemoteInstanceForProcessTrace(jlong nativeClient, jint instanceId) {
+    auto client = (aap::PluginClient*) (void*) nativeClient;
+    return client ? client->getInstanceById(instanceId) : nullptr;
+}
+
+aap::PluginInstance* getLocalInstanceForProcessTrace(jlong nativeService, jint instanceId) {
+    auto service = (aap::PluginService*) (void*) nativeService;
+    return service ? service->getInstanceById(instanceId) : nullptr;
+}
+
+void setProcessTraceFlags(aap::PluginInstance* instance, jint flags) {
+    if (instance)
+        instance->getProcessTrace().setFlags((uint32_t) flags);
+}
+
+void resetProcessTraceHistograms(aap::PluginInstance* instance) {
+    if (instance)
+        instance->getProcessTrace().resetHistograms();
+}
+
+jstring dumpProcessTrace(JNIEnv* env, aap::PluginInstance* instance, bool events) {
+    if (!instance)
+        return env->NewStringUTF("");
+    auto& trace = instance->getProcessTrace();
+    return env->NewStringUTF((events ? trace.dumpEventsAsJson() : trace.dumpHistograms()).c_str());
+}
+
+} // namespace
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_org_androidaudioplugin_hosting_NativeRemotePluginInstance_setProcessTraceFlags(JNIEnv*, jclass,
+                                                                                    jlong nativeClient,
+                                                                                    jint instanceId,
+                                                                                    jint flags) {
+    setProcessTraceFlags(getRemoteInstanceForProcessTrace(nativeClient, instanceId), flags);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_org_androidaudioplugin_hosting_NativeRemotePluginInstance_resetProcessTraceHistograms(JNIEnv*, jclass,
+                                                                                           jlong nativeClient,
+                                                                                           jint instanceId) {
+    resetProcessTraceHistograms(getRemoteInstanceForProcessTrace(nativeClient, instanceId));
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_org_androidaudioplugin_hosting_NativeRemotePluginInstance_dumpProcessTraceHistograms(JNIEnv* env, jclass,
+                                                                                          jlong nativeClient,
+                                                                                          jint instanceId) {
+    return dumpProcessTrace(env, getRemoteInstanceForProcessTrace(nativeClient, instanceId), false);
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_org_androidaudioplugin_hosting_NativeRemotePluginInstance_dumpProcessTraceEventsAsJson(JNIEnv* env, jclass,
+                                                                                            jlong nativeClient,
+                                                                                            jint instanceId) {
+    return dumpProcessTrace(env, getRemoteInstanceForProcessTrace(nativeClient, instanceId), true);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_org_androidaudioplugin_NativeLocalPluginInstance_setProcessTraceFlags(JNIEnv*, jclass,
+                                                                           jlong nativeService,
+                                                                           jint instanceId,
+                                                                           jint flags) {
+    setProcessTraceFlags(getLocalInstanceForProcessTrace(nativeService, instanceId), flags);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_org_androidaudioplugin_NativeLocalPluginInstance_resetProcessTraceHistograms(JNIEnv*, jclass,
+                                                                                  jlong nativeService,
+                                                                                  jint instanceId) {
+    resetProcessTraceHistograms(getLocalInstanceForProcessTrace(nativeService, instanceId));
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_org_androidaudioplugin_NativeLocalPluginInstance_dumpProcessTraceHistograms(JNIEnv* env, jclass,
+                                                                                 jlong nativeService,
+                                                                                 jint instanceId) {
+    return dumpProcessTrace(env, getLocalInstanceForProcessTrace(nativeService, instanceId), false);
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_org_androidaudioplugin_NativeLocalPluginInstance_dumpProcessTraceEventsAsJson(JNIEnv* env, jclass,
+                                                                                   jlong nativeService,
+                                                                                   jint instanceId) {
+    return dumpProcessTrace(env, getLocalInstanceForProcessTrace(nativeService, instanceId), true);
+}
@@ -11,6 +11,7 @@
 #include "aap/android-audio-plugin.h"
 #include "aap/core/host/android/audio-plugin-host-android.h"
 #include "aap/core/aapxs/extension-service.h"
+#include "aap/core/host/process-transport.h"
 #include "aap/unstable/logging.h"
 #include "AudioPluginInterfaceImpl.h"
 #include "../core/hosting/audio-plugin-host-internals.h"
@@ -20,6 +21,18 @@
 
 // AAP plugin implementation that performs actual work via AAP binder client.
 
+class AAPClientContext;
+
+// PROCESS_TRANSPORT_IPC: one Binder `process()` transaction per audio block.
+class BinderProcessTransport : public aap::ProcessTransport {
+    AAPClientContext* ctx;
+public:
+    explicit BinderProcessTransport(AAPClientContext* ctx) : ctx(ctx) {}
+
+    aap::ProcessTransportType getType() override { return aap::PROCESS_TRANSPORT_IPC; }
+    bool process(int32_t frameCount, int64_t timeoutInNanoseconds) override;
+};
+
 class AAPClientContext {
 
 public:
@@ -29,6 +42,7 @@ public:
     aap::PluginInstantiationState proxy_state{aap::PLUGIN_INSTANTIATION_STATE_INITIAL};
 	AndroidAudioPluginHost host;
     AndroidAudioPlugin* plugin{nullptr};
+    std::unique_ptr<aap::ProcessTransport> process_transport{};
 
     ~AAPClientContext();
 
@@ -66,6 +80,8 @@ public:
 
 
 AAPClientContext::~AAPClientContext() {
+    // release the futex control block (if any) so that the service render thread quits.
+    process_transport.reset();
     if (connection_data && instance_id >= 0) {
         connection_data->unregisterRemoteInstance(instance_id);
     }
@@ -88,14 +104,64 @@ void aap_bcap_log_error_with_details(const char* fmtBase, ndk::ScopedAStatus& st
 	}
 }
 
+bool BinderProcessTransport::process(int32_t frameCount, int64_t timeoutInNanoseconds) {
+	auto status = ctx->getProxy()->process(ctx->instance_id, frameCount, timeoutInNanoseconds);
+	if (!status.isOk()) {
+		aap_bcap_log_error_with_details("process() failed", status);
+		return false;
+	}
+	return true;
+}
+
+// Tries to set up PROCESS_TRANSPORT_SHARED_MEMORY_FUTEX. Returns null if the platform or the service does not support it.
+std::unique_ptr<aap::ProcessTransport> aap_bcap_create_futex_transport(AAPClientContext* ctx) {
+	if (!aap::FutexProcessTransport::isSupported())
+		return nullptr;
+	auto size = sizeof(aap::ProcessControlBlock);
+	auto fd = ASharedMemory_create(nullptr, size);
+	if (fd < 0)
+		return nullptr;
+	auto transport = std::make_unique<aap::FutexProcessTransport>(fd);
+	if (!transport->isMapped())
+		return nullptr;
+	// Services that do not know the URI just store it as an extension buffer and never
+	// acknowledge it, so we detect the lack of support via isServiceReady().
+	ndk::ScopedFileDescriptor sfd{dup(fd)};
+	auto stat = ctx->getProxy()->addExtension(ctx->instance_id, AAP_PROCESS_TRANSPORT_FUTEX_URI, sfd, (int32_t) size);
+	if (!stat.isOk() || !transport->isServiceReady())
+		return nullptr;
+	return transport;
+}
+
+// Asks the service whether it accepts all port buffers as one arena (see AAP_PORT_BUFFER_ARENA_URI).
+bool aap_bcap_negotiate_port_buffer_arena(AAPClientContext* ctx) {
+	auto size = sizeof(aap::PortBufferArenaNegotiation);
+	auto fd = ASharedMemory_create(nullptr, size);
+	if (fd < 0)
+		return false;
+	auto block = (aap::PortBufferArenaNegotiation*) mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (block == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+	block->service_ready.store(0, std::memory_order_relaxed);
+	// Services that do not know the URI just store it as an extension buffer and never
+	// acknowledge it, so we keep sending one FD per port to them.
+	ndk::ScopedFileDescriptor sfd{dup(fd)};
+	auto stat = ctx->getProxy()->addExtension(ctx->instance_id, AAP_PORT_BUFFER_ARENA_URI, sfd, (int32_t) size);
+	bool supported = stat.isOk() &&
+		block->service_ready.load(std::memory_order_acquire) == aap::PortBufferArenaNegotiation::SERVICE_READY_MAGIC;
+	munmap(block, size);
+	close(fd);
+	return supported;
+}
+
 void aap_client_as_plugin_prepare(AndroidAudioPlugin *plugin, int32_t sampleRate, aap_buffer_t* buffer)
 {
 	auto ctx = (AAPClientContext*) plugin->plugin_specific;
 	if (ctx->proxy_state == aap::PLUGIN_INSTANTIATION_STATE_ERROR)
 		return;
 
-	int n = buffer->num_ports(buffer);
-
 	if (ctx->proxy_state != aap::PLUGIN_INSTANTIATION_STATE_ERROR) {
 		auto status = ctx->getProxy()->beginPrepare(ctx->instance_id);
 		if (!status.isOk()) {
@@ -104,18 +170,22 @@ void aap_client_as_plugin_prepare(AndroidAudioPlugin *plugin, int32_t sampleRate
 		}
 	}
 
-    // allocate shm FDs, first locally, then send it to the target AAP.
+    // The shm arena that holds all port buffers is allocated locally, then sent to the target AAP at once.
+	// Services that do not support the arena get one shm FD per port instead.
 	auto instance = (aap::RemotePluginInstance*) ctx->host.context;
 	auto shm = dynamic_cast<aap::ClientPluginSharedMemoryStore*>(instance->getSharedMemoryStore());
-    for (int i = 0; i < n; i++) {
-		auto fd = shm->getPortBufferFD(i);
-        ::ndk::ScopedFileDescriptor sfd{dup(fd)};
-        auto status = ctx->getProxy()->prepareMemory(ctx->instance_id, i, sfd);
-        if (!status.isOk()) {
-			aap_bcap_log_error_with_details("prepareMemory() failed", status);
-            ctx->proxy_state = aap::PLUGIN_INSTANTIATION_STATE_ERROR;
-            break;
-        }
+	if (ctx->proxy_state != aap::PLUGIN_INSTANTIATION_STATE_ERROR) {
+		bool arena = shm->isPortBufferArenaEnabled();
+		for (int i = 0, n = arena ? 1 : buffer->num_ports(buffer); i < n; i++) {
+			auto fd = arena ? shm->getPortBufferArenaFD() : shm->getPortBufferFD(i);
+			::ndk::ScopedFileDescriptor sfd{dup(fd)};
+			auto status = ctx->getProxy()->prepareMemory(ctx->instance_id, arena ? aap::PORT_BUFFER_ARENA_FD_INDEX : i, sfd);
+			if (!status.isOk()) {
+				aap_bcap_log_error_with_details("prepareMemory() failed", status);
+				ctx->proxy_state = aap::PLUGIN_INSTANTIATION_STATE_ERROR;
+				break;
+			}
+		}
     }
 
     if (ctx->proxy_state != aap::PLUGIN_INSTANTIATION_STATE_ERROR) {
@@ -161,9 +231,9 @@ void aap_client_as_plugin_process(AndroidAudioPlugin *plugin,
 		for (int32_t i = 0; i < buffer->num_ports(buffer); i++)
 			memcpy(shmBuffer->get_buffer(shmBuffer, i), buffer->get_buffer(buffer, i), buffer->get_buffer_size(buffer, i));
 
-	auto status = ctx->getProxy()->process(ctx->instance_id, frameCount, timeoutInNanoseconds);
-	if (!status.isOk()) {
-		aap_bcap_log_error_with_details("process() failed", status);
+	if (!ctx->process_transport->process(frameCount, timeoutInNanoseconds)) {
+		if (ctx->process_transport->getType() != aap::PROCESS_TRANSPORT_IPC)
+			aap::a_log_f(AAP_LOG_LEVEL_ERROR, AAP_PXORY_LOG_TAG, "process() failed (shared memory transport)");
 		ctx->proxy_state = aap::PLUGIN_INSTANTIATION_STATE_ERROR;
 	}
 
@@ -316,6 +386,20 @@ AndroidAudioPlugin* aap_client_as_plugin_new(
         }))
             ctx->proxy_state = aap::PLUGIN_INSTANTIATION_STATE_ERROR;
 
+        if (ctx->proxy_state != aap::PLUGIN_INSTANTIATION_STATE_ERROR &&
+            client->getProcessTransportType() == aap::PROCESS_TRANSPORT_SHARED_MEMORY_FUTEX) {
+            ctx->process_transport = aap_bcap_create_futex_transport(ctx);
+            if (!ctx->process_transport)
+                aap::a_log_f(AAP_LOG_LEVEL_INFO, AAP_PXORY_LOG_TAG, "shared memory process transport is not available for %s; falling back to Binder", pluginUniqueId);
+        }
+        if (!ctx->process_transport)
+            ctx->process_transport = std::make_unique<BinderProcessTransport>(ctx);
+
+        if (ctx->proxy_state != aap::PLUGIN_INSTANTIATION_STATE_ERROR) {
+            auto shm = dynamic_cast<aap::ClientPluginSharedMemoryStore*>(instance->getSharedMemoryStore());
+            shm->setPortBufferArenaEnabled(aap_bcap_negotiate_port_buffer_arena(ctx));
+        }
+
         if (ctx->proxy_state != aap::PLUGIN_INSTANTIATION_STATE_ERROR) {
             status = ctx->getProxy()->endCreate(ctx->instance_id);
             if (!status.isOk()) {
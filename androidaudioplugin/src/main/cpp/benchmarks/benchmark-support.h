@@ -0,0 +1,130 @@
+#ifndef AAP_CORE_BENCHMARK_SUPPORT_H
+#define AAP_CORE_BENCHMARK_SUPPORT_H
+
+// Shared pieces of the headless benchmarks: latency percentiles, and a plugin instance whose
+// process() runs an in-process function on real client shared memory port buffers.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "aap/core/host/plugin-instance.h"
+#include "aap/core/host/shared-memory-store.h"
+#include "aap/core/plugin-information.h"
+
+namespace aap::benchmark {
+
+    inline int64_t nowNanoseconds() { return ProcessTrace::nowNanoseconds(); }
+
+    // Collects latency samples (in nanoseconds) without allocating while it records.
+    class LatencySamples {
+        std::vector<int64_t> samples{};
+
+    public:
+        explicit LatencySamples(size_t capacity) { samples.reserve(capacity); }
+
+        void add(int64_t nanoseconds) {
+            if (samples.size() < samples.capacity())
+                samples.emplace_back(nanoseconds);
+        }
+
+        // "name: n samples, p50 ... p99 ... p99.99 ... max ..." in microseconds.
+        void print(const char* name) {
+            if (samples.empty()) {
+                printf("%s: no samples\n", name);
+                return;
+            }
+            std::sort(samples.begin(), samples.end());
+            auto at = [&](double percentile) {
+                return samples[std::min(samples.size() - 1, (size_t) (samples.size() * percentile / 100.0))] / 1000.0;
+            };
+            printf("%s: %zu samples, p50 %.3f us, p99 %.3f us, p99.99 %.3f us, max %.3f us\n",
+                   name, samples.size(), at(50), at(99), at(99.99), samples.back() / 1000.0);
+        }
+    };
+
+    /**
+     * A client-side plugin instance without any plugin behind it: process() calls `dsp` on the
+     * port buffers, which are allocated as client shared memory just like RemotePluginInstance does.
+     * process() merges the event inputs and runs the silence bypass as RemotePluginInstance does.
+     * It has no AAPXS, so only the parts of PluginInstance that do not need extensions are usable.
+     */
+    class BenchmarkPluginInstance : public PluginInstance {
+        static AndroidAudioPluginFactory* dummyFactory() {
+            static AndroidAudioPluginFactory factory{};
+            return &factory;
+        }
+        static const PluginInformation* dummyInformation() {
+            static PluginInformation info{false, "org.androidaudioplugin.benchmark", "Benchmark", "Benchmark",
+                                          "AAP", "0.0", "urn:org.androidaudioplugin/benchmark", "", "", "",
+                                          "Effect", "", "", ""};
+            return &info;
+        }
+
+    public:
+        typedef std::function<void(aap_buffer_t* buffer, int32_t frameCount)> ProcessFunction;
+
+        ProcessFunction dsp{};
+
+        // `controlBytesPerBlock` is the size of the non-audio (MIDI2) port buffers.
+        BenchmarkPluginInstance(std::vector<PortInformation> ports, int32_t frameCount, int32_t sampleRate,
+                                int32_t controlBytesPerBlock = 8192)
+                : PluginInstance(dummyInformation(), dummyFactory(), controlBytesPerBlock) {
+            configured_ports = std::make_unique<std::vector<PortInformation>>(std::move(ports));
+            sample_rate = sampleRate;
+            auto store = new ClientPluginSharedMemoryStore();
+            shared_memory_store = store;
+            if (store->allocateClientBuffer(configured_ports->size(), frameCount, *this, controlBytesPerBlock) !=
+                PluginSharedMemoryStore::PLUGIN_MEMORY_ALLOCATOR_SUCCESS)
+                fprintf(stderr, "failed to allocate the port buffers\n");
+            instantiation_state = PLUGIN_INSTANTIATION_STATE_ACTIVE;
+        }
+
+        // stereo in, stereo out, MIDI2 in and out.
+        static std::vector<PortInformation> stereoEffectPorts() {
+            return {{0, "Audio In L", AAP_CONTENT_TYPE_AUDIO, AAP_PORT_DIRECTION_INPUT},
+                    {1, "Audio In R", AAP_CONTENT_TYPE_AUDIO, AAP_PORT_DIRECTION_INPUT},
+                    {2, "Audio Out L", AAP_CONTENT_TYPE_AUDIO, AAP_PORT_DIRECTION_OUTPUT},
+                    {3, "Audio Out R", AAP_CONTENT_TYPE_AUDIO, AAP_PORT_DIRECTION_OUTPUT},
+                    {4, "MIDI2 In", AAP_CONTENT_TYPE_MIDI2, AAP_PORT_DIRECTION_INPUT},
+                    {5, "MIDI2 Out", AAP_CONTENT_TYPE_MIDI2, AAP_PORT_DIRECTION_OUTPUT}};
+        }
+
+        int32_t getInstanceId() override { return 0; }
+        void prepare(int, int32_t) override {}
+        void setupAAPXS() override {}
+        xs::StandardExtensions& getStandardExtensions() override {
+            // not reachable in the benchmarks.
+            std::abort();
+        }
+
+        // the host-side steps of RemotePluginInstance::process() around the plugin call.
+        void process(int32_t frameCount, int32_t) override {
+            process_trace.beginCycle();
+            ProcessTraceScope totalScope{process_trace, PROCESS_TRACE_STAGE_TOTAL};
+            auto buffer = getAudioPluginBuffer();
+            if (std::unique_lock<NanoSleepLock> tryLock(ump_sequence_merger_mutex, std::try_to_lock); tryLock.owns_lock()) {
+                ProcessTraceScope scope{process_trace, PROCESS_TRACE_STAGE_AAPXS_INPUT_MERGE};
+                merge_ump_sequences(AAP_PORT_DIRECTION_INPUT, event_midi2_merge_buffer, event_midi2_buffer_size,
+                                    event_midi2_buffer, event_midi2_buffer_offset, buffer, this);
+                memset(event_midi2_buffer, 0, event_midi2_buffer_offset);
+                event_midi2_buffer_offset = 0;
+            }
+            if (silence_bypass.beginBlock(buffer, frameCount))
+                return;
+            if (dsp) {
+                ProcessTraceScope scope{process_trace, PROCESS_TRACE_STAGE_PLUGIN_PROCESS};
+                dsp(buffer, frameCount);
+            }
+            silence_bypass.endBlock(buffer, frameCount);
+        }
+
+    protected:
+        AndroidAudioPluginHost* getHostFacadeForCompleteInstantiation() override { return nullptr; }
+    };
+}
+
+#endif //AAP_CORE_BENCHMARK_SUPPORT_H
@@ -0,0 +1,83 @@
+// Stress test of GuiListenerMidiBuffer: the audio thread writes a batch of UMPs every process
+// cycle while GUI readers poll the ring in tight loops. It reports the time that the write adds to
+// each process cycle (the worst case is what matters), how much the readers got, and what was dropped.
+//
+// usage: aap-gui-listener-midi-buffer-stress [cycles] [readers]
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "aap/core/host/gui-listener-midi-buffer.h"
+#include "benchmark-support.h"
+
+using namespace aap;
+
+namespace {
+    const int32_t ring_capacity = 8192;
+    // 16 MIDI2 CCs (64-bit UMPs) per cycle
+    const int32_t umps_per_cycle = 16;
+
+    // Checks that reads only return whole UMP packets and that overflows are counted.
+    bool checkPacketBoundaries() {
+        GuiListenerMidiBuffer ring{64};
+        // 64-bit, 64-bit, 32-bit, 32-bit UMPs (24 bytes)
+        uint32_t ump[6] = {0x40B00000, 1, 0x40B00000, 2, 0x20900000, 0x10000000};
+        ring.write(ump, sizeof(ump));
+        ring.write(ump, sizeof(ump));
+        // only the two 64-bit UMPs fit; the 32-bit ones (8 bytes) are dropped.
+        ring.write(ump, sizeof(ump));
+        uint8_t output[64];
+        // 18 bytes: the two 64-bit UMPs, but not a part of the next one.
+        auto first = ring.read(output, 18);
+        auto rest = ring.read(output, sizeof(output));
+        bool ok = first == 16 && rest == 48 && ring.getDroppedBytes() == 8 && ring.getDroppedWrites() == 1;
+        printf("packet boundaries: read(18) = %d, then %d; dropped %llu bytes in %llu writes: %s\n", first, rest,
+               (unsigned long long) ring.getDroppedBytes(), (unsigned long long) ring.getDroppedWrites(),
+               ok ? "OK" : "FAILED");
+        return ok;
+    }
+}
+
+int main(int argc, char** argv) {
+    int32_t cycles = argc > 1 ? atoi(argv[1]) : 200000;
+    int32_t numReaders = argc > 2 ? atoi(argv[2]) : 1;
+
+    if (!checkPacketBoundaries())
+        return 1;
+
+    GuiListenerMidiBuffer ring{ring_capacity};
+    std::atomic<bool> stopped{false};
+    std::atomic<int64_t> bytesRead{0};
+    std::vector<std::thread> readers{};
+    for (int32_t r = 0; r < numReaders; r++)
+        readers.emplace_back([&] {
+            uint8_t output[ring_capacity];
+            while (!stopped.load(std::memory_order_relaxed))
+                bytesRead += ring.read(output, sizeof(output));
+        });
+
+    uint32_t ump[umps_per_cycle * 2];
+    for (int32_t i = 0; i < umps_per_cycle; i++) {
+        ump[i * 2] = 0x40B00000 | (uint32_t) i << 8;
+        ump[i * 2 + 1] = 0x12345678;
+    }
+    benchmark::LatencySamples writes{(size_t) cycles};
+    for (int32_t c = 0; c < cycles; c++) {
+        auto begin = benchmark::nowNanoseconds();
+        ring.write(ump, sizeof(ump));
+        writes.add(benchmark::nowNanoseconds() - begin);
+        // let the readers catch up from time to time, like the gap between two audio callbacks does.
+        if (c % 64 == 0)
+            std::this_thread::yield();
+    }
+    stopped = true;
+    for (auto& reader : readers)
+        reader.join();
+
+    writes.print("write() per process cycle");
+    printf("%d reader(s) got %lld bytes; dropped %llu bytes in %llu writes (of %lld bytes written)\n",
+           numReaders, (long long) bytesRead.load(), (unsigned long long) ring.getDroppedBytes(),
+           (unsigned long long) ring.getDroppedWrites(), (long long) cycles * (long long) sizeof(ump));
+    return 0;
+}
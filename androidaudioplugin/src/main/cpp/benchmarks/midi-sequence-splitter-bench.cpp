@@ -0,0 +1,140 @@
+// Benchmark of MidiSequenceSplitter: a gain kernel that applies MIDI2 CC events at their frames,
+// once with the splitter (rendering sub-blocks between the events) and once with a per-sample event
+// check that decodes the JR timestamps inside the sample loop. Both must render the same output,
+// and the splitter must deliver every event at its frame.
+//
+// usage: aap-midi-sequence-splitter-bench [repetitions]
+
+#include <cstdlib>
+#include <cstring>
+#include "aap/unstable/midi-sequence-splitter.h"
+#include "benchmark-support.h"
+
+namespace {
+    const int32_t block_size = 256;
+    const int32_t sample_rate = 48000;
+
+    uint32_t umpWords(uint32_t word0) {
+        static constexpr uint8_t sizes[16] {1, 1, 1, 2, 2, 4, 1, 1, 2, 2, 2, 3, 3, 4, 4, 4};
+        return sizes[word0 >> 28];
+    }
+
+    // MIDI2 CC events spread evenly over the block; each one carries the gain (in 1/1000000) in its
+    // second word. `frames` gets the frame of each event.
+    std::vector<uint32_t> createSequence(int32_t numEvents, std::vector<int32_t>& frames) {
+        std::vector<uint32_t> memory(sizeof(AAPMidiBufferHeader) / sizeof(uint32_t) + numEvents * 3 + 16);
+        auto words = memory.data() + sizeof(AAPMidiBufferHeader) / sizeof(uint32_t);
+        uint32_t offset = 0;
+        int64_t lastTicks = 0;
+        for (int32_t i = 0; i < numEvents; i++) {
+            auto frame = (int64_t) i * block_size / numEvents;
+            // rounded up so that the frame of the ticks is `frame` again.
+            auto ticks = (frame * 31250 + sample_rate - 1) / sample_rate;
+            for (auto delta = ticks - lastTicks; delta > 0; delta -= 31250)
+                words[offset++] = 0x00200000 | (uint32_t) (delta > 31250 ? 31250 : delta);
+            lastTicks = ticks;
+            frames.emplace_back(std::min<int32_t>(block_size - 1, (int32_t) (ticks * sample_rate / 31250)));
+            words[offset++] = 0x40B00700;
+            words[offset++] = (uint32_t) (i + 1) * 1000;
+        }
+        ((AAPMidiBufferHeader*) memory.data())->length = offset * sizeof(uint32_t);
+        return memory;
+    }
+
+    __attribute__((noinline))
+    void renderPerSample(const AAPMidiBufferHeader* sequence, const float* in, float* out, float& gain) {
+        auto words = (const uint32_t*) (sequence + 1);
+        uint32_t numWords = sequence->length / sizeof(uint32_t), position = 0;
+        int64_t ticks = 0;
+        float g = gain;
+        for (int32_t i = 0; i < block_size; i++) {
+            while (position < numWords) {
+                auto word0 = words[position];
+                if ((word0 & 0xF0F00000) == 0x00200000) {
+                    ticks += word0 & 0xFFFF;
+                    position++;
+                    continue;
+                }
+                // events beyond the block are applied at its last frame, as the splitter does.
+                if (std::min<int64_t>(ticks * sample_rate / 31250, block_size - 1) > i)
+                    break;
+                if (word0 >> 28 == 4)
+                    g = words[position + 1] * 1e-6f;
+                position += umpWords(word0);
+            }
+            out[i] = in[i] * g;
+        }
+        gain = g;
+    }
+
+    __attribute__((noinline))
+    void renderSplit(const AAPMidiBufferHeader* sequence, const float* in, float* out, float& gain) {
+        aap::MidiSequenceSplitter splitter{sequence, block_size, sample_rate};
+        aap::MidiSequenceSplitter::Segment segment;
+        float g = gain;
+        while (splitter.next(segment)) {
+            for (uint32_t p = 0; p < segment.events_size / sizeof(uint32_t); p += umpWords(segment.events[p]))
+                if (segment.events[p] >> 28 == 4)
+                    g = segment.events[p + 1] * 1e-6f;
+            for (int32_t i = segment.frame_offset, end = i + segment.num_frames; i < end; i++)
+                out[i] = in[i] * g;
+        }
+        gain = g;
+    }
+
+    // Returns true if every event arrives at its frame and the segments cover the whole block.
+    bool checkSegments(const AAPMidiBufferHeader* sequence, const std::vector<int32_t>& frames) {
+        aap::MidiSequenceSplitter splitter{sequence, block_size, sample_rate};
+        aap::MidiSequenceSplitter::Segment segment;
+        size_t delivered = 0;
+        int32_t covered = 0;
+        bool ok = true;
+        while (splitter.next(segment)) {
+            covered += segment.num_frames;
+            for (uint32_t p = 0; p < segment.events_size / sizeof(uint32_t); p += umpWords(segment.events[p]))
+                if (segment.events[p] >> 28 == 4)
+                    ok &= delivered < frames.size() && frames[delivered++] == segment.frame_offset;
+        }
+        return ok && delivered == frames.size() && covered == block_size;
+    }
+}
+
+int main(int argc, char** argv) {
+    int32_t repetitions = argc > 1 ? atoi(argv[1]) : 200000;
+
+    float in[block_size], perSampleOut[block_size], splitOut[block_size];
+    for (int32_t i = 0; i < block_size; i++)
+        in[i] = (float) (i % 7) * 0.1f;
+
+    bool ok = true;
+    for (int32_t numEvents : {0, 10, 1000}) {
+        std::vector<int32_t> frames{};
+        auto memory = createSequence(numEvents, frames);
+        auto sequence = (const AAPMidiBufferHeader*) memory.data();
+
+        float perSampleGain = 0.5f, splitGain = 0.5f;
+        renderPerSample(sequence, in, perSampleOut, perSampleGain);
+        renderSplit(sequence, in, splitOut, splitGain);
+        bool identical = memcmp(perSampleOut, splitOut, sizeof(splitOut)) == 0;
+        bool segmented = checkSegments(sequence, frames);
+        ok &= identical && segmented;
+
+        // the best of 5 runs, to filter out preemption.
+        double bestPerSample = 1e18, bestSplit = 1e18;
+        for (int32_t run = 0; run < 5; run++) {
+            auto t0 = aap::benchmark::nowNanoseconds();
+            for (int32_t r = 0; r < repetitions; r++)
+                renderPerSample(sequence, in, perSampleOut, perSampleGain);
+            auto t1 = aap::benchmark::nowNanoseconds();
+            for (int32_t r = 0; r < repetitions; r++)
+                renderSplit(sequence, in, splitOut, splitGain);
+            auto t2 = aap::benchmark::nowNanoseconds();
+            bestPerSample = std::min(bestPerSample, (double) (t1 - t0) / repetitions);
+            bestSplit = std::min(bestSplit, (double) (t2 - t1) / repetitions);
+        }
+        printf("%4d events: per-sample check %.1f ns/block, splitter %.1f ns/block (%.2fx); output %s, segments %s\n",
+               numEvents, bestPerSample, bestSplit, bestPerSample / bestSplit,
+               identical ? "identical" : "DIFFERS", segmented ? "OK" : "WRONG");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// Benchmark of PluginInstance::renderOffline() against driving process() block by block from the
+// caller (the native part of what a scripted render loop does: fill the inputs, queue the events
+// with addEventUmpInput(), process, read the outputs). The plugin is an in-process gain.
+// Both drivers must produce the same output checksum.
+//
+// usage: aap-offline-render-bench [seconds]
+
+#include <cmath>
+#include <cstdlib>
+#include "aap/ext/midi.h"
+#include "benchmark-support.h"
+
+using namespace aap;
+
+namespace {
+    const int32_t block_size = 256;
+    const int32_t sample_rate = 48000;
+    // one note-on every 100ms
+    const int32_t event_interval = 4800;
+
+    void synthesize(int64_t position, int32_t port, float* data, int32_t frames) {
+        for (int32_t i = 0; i < frames; i++) {
+            auto phase = static_cast<double>((position + i + port * 31) % 97) / 97.0;
+            data[i] = static_cast<float>((std::sin(phase * 6.283185307179586) * 0.7 +
+                                          std::sin(phase * 18.84955592153876) * 0.3) * 0.5);
+        }
+    }
+
+    void printResult(const char* name, int32_t blocks, int64_t elapsedNanoseconds, int64_t totalFrames, double checksum) {
+        printf("%s: %d blocks, %.1f ms, %.3f us/block, %.0fx realtime, checksum %.6f\n",
+               name, blocks, elapsedNanoseconds / 1e6, elapsedNanoseconds / 1000.0 / blocks,
+               (double) totalFrames / sample_rate * 1e9 / elapsedNanoseconds, checksum);
+    }
+}
+
+int main(int argc, char** argv) {
+    int64_t totalFrames = (int64_t) (argc > 1 ? atoi(argv[1]) : 600) * sample_rate;
+
+    benchmark::BenchmarkPluginInstance instance{benchmark::BenchmarkPluginInstance::stereoEffectPorts(),
+                                                block_size, sample_rate};
+    int64_t midiBytes = 0;
+    instance.dsp = [&](aap_buffer_t* buffer, int32_t frameCount) {
+        for (int32_t c = 0; c < 2; c++) {
+            auto in = (const float*) buffer->get_buffer(buffer, c);
+            auto out = (float*) buffer->get_buffer(buffer, c + 2);
+            for (int32_t i = 0; i < frameCount; i++)
+                out[i] = in[i] * 0.5f;
+        }
+        midiBytes += ((AAPMidiBufferHeader*) buffer->get_buffer(buffer, 4))->length;
+    };
+
+    uint32_t noteOn[2] = {0x40903c00, 0x80000000};
+    std::vector<OfflineRenderEvent> events{};
+    for (int64_t frame = 0; frame < totalFrames; frame += event_interval)
+        events.push_back({frame, noteOn, sizeof(noteOn)});
+
+    double renderChecksum = 0;
+    OfflineRenderRequest request{};
+    request.total_frames = totalFrames;
+    request.input_source = synthesize;
+    request.events = events.data();
+    request.num_events = (int32_t) events.size();
+    request.output_sink = [&](int64_t, int32_t, const float* data, int32_t frames) {
+        for (int32_t i = 0; i < frames; i++)
+            renderChecksum += data[i];
+    };
+    auto result = instance.renderOffline(request);
+    printResult("renderOffline()", result.num_blocks, result.elapsed_nanoseconds, totalFrames, renderChecksum);
+    printf("  dropped events: %d, MIDI2 bytes delivered: %lld\n", result.num_dropped_events, (long long) midiBytes);
+
+    auto buffer = instance.getAudioPluginBuffer();
+    double driverChecksum = 0;
+    size_t nextEvent = 0;
+    int32_t blocks = 0;
+    auto begin = benchmark::nowNanoseconds();
+    for (int64_t position = 0; position < totalFrames; position += block_size, blocks++) {
+        auto frameCount = (int32_t) std::min<int64_t>(block_size, totalFrames - position);
+        for (int32_t c = 0; c < 2; c++)
+            synthesize(position, c, (float*) buffer->get_buffer(buffer, c), frameCount);
+        ((AAPMidiBufferHeader*) buffer->get_buffer(buffer, 4))->length = 0;
+        for (; nextEvent < events.size() && events[nextEvent].frame < position + frameCount; nextEvent++)
+            instance.addEventUmpInput((void*) events[nextEvent].ump, events[nextEvent].size);
+        instance.process(frameCount, 1000000000);
+        for (int32_t c = 0; c < 2; c++) {
+            auto out = (const float*) buffer->get_buffer(buffer, c + 2);
+            for (int32_t i = 0; i < frameCount; i++)
+                driverChecksum += out[i];
+        }
+    }
+    printResult("process() per block", blocks, benchmark::nowNanoseconds() - begin, totalFrames, driverChecksum);
+
+    bool ok = renderChecksum == driverChecksum && result.num_dropped_events == 0;
+    printf("checksums %s\n", ok ? "match" : "DIFFER");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+// Benchmark of SilenceBypass: a bank of idle effects (silent inputs, no events) is processed for a
+// number of cycles with the bypass on and off. Each process() is a round trip to a server thread
+// that runs a DSP kernel, like an out-of-process plugin. It reports the CPU time and the ratio of
+// skipped blocks; after the tail time, almost every block should be skipped.
+//
+// usage: aap-silence-bypass-bench [cycles] [effects]
+
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+#include <unistd.h>
+#include "aap/ext/midi.h"
+#include "benchmark-support.h"
+
+using namespace aap;
+
+namespace {
+    const int32_t block_size = 256;
+    const int32_t sample_rate = 48000;
+    const int32_t tail_time_ms = 500;
+
+    // A one-pole lowpass with a long decay, running on its own thread as the plugin "service".
+    class Effect {
+        int request_pipe[2]{-1, -1};
+        int reply_pipe[2]{-1, -1};
+        std::thread server{};
+        float state[2]{};
+
+        void render(aap_buffer_t* buffer, int32_t frameCount) {
+            for (int32_t c = 0; c < 2; c++) {
+                auto in = (const float*) buffer->get_buffer(buffer, c);
+                auto out = (float*) buffer->get_buffer(buffer, c + 2);
+                float z = state[c];
+                for (int32_t pass = 0; pass < 8; pass++)
+                    for (int32_t i = 0; i < frameCount; i++)
+                        out[i] = z = z * 0.99f + in[i] * 0.01f;
+                state[c] = z;
+            }
+        }
+
+    public:
+        benchmark::BenchmarkPluginInstance instance{benchmark::BenchmarkPluginInstance::stereoEffectPorts(),
+                                                    block_size, sample_rate};
+
+        explicit Effect(bool bypass) {
+            if (pipe(request_pipe) || pipe(reply_pipe))
+                abort();
+            server = std::thread([this] {
+                int32_t frameCount;
+                while (read(request_pipe[0], &frameCount, sizeof(frameCount)) == sizeof(frameCount) && frameCount > 0) {
+                    render(instance.getAudioPluginBuffer(), frameCount);
+                    if (write(reply_pipe[1], &frameCount, sizeof(frameCount)) != sizeof(frameCount))
+                        break;
+                }
+            });
+            instance.dsp = [this](aap_buffer_t*, int32_t frameCount) {
+                if (write(request_pipe[1], &frameCount, sizeof(frameCount)) == sizeof(frameCount))
+                    read(reply_pipe[0], &frameCount, sizeof(frameCount));
+            };
+            instance.getSilenceBypass().setEnabled(bypass);
+            instance.getSilenceBypass().configure(&instance, tail_time_ms);
+        }
+
+        ~Effect() {
+            int32_t quit = 0;
+            write(request_pipe[1], &quit, sizeof(quit));
+            server.join();
+            for (auto fd : {request_pipe[0], request_pipe[1], reply_pipe[0], reply_pipe[1]})
+                close(fd);
+        }
+
+        void process() { instance.process(block_size, 1000000000); }
+    };
+
+    double cpuSeconds() {
+        timespec ts{};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+    }
+}
+
+int main(int argc, char** argv) {
+    int32_t cycles = argc > 1 ? atoi(argv[1]) : 20000;
+    int32_t numEffects = argc > 2 ? atoi(argv[2]) : 32;
+
+    for (bool bypass : {false, true}) {
+        std::vector<std::unique_ptr<Effect>> effects{};
+        for (int32_t i = 0; i < numEffects; i++)
+            effects.emplace_back(std::make_unique<Effect>(bypass));
+
+        auto cpuBegin = cpuSeconds();
+        auto begin = benchmark::nowNanoseconds();
+        for (int32_t c = 0; c < cycles; c++)
+            for (auto& effect : effects)
+                effect->process();
+        auto elapsed = benchmark::nowNanoseconds() - begin;
+        auto cpu = cpuSeconds() - cpuBegin;
+
+        uint64_t skipped = 0;
+        for (auto& effect : effects)
+            skipped += effect->instance.getSilenceBypass().getSkippedBlockCount();
+        double audioSeconds = (double) cycles * block_size / sample_rate;
+        printf("bypass %s: %d effects x %d cycles, CPU %.3f s (%.2f%% of one core over %.1f s of audio), "
+               "%.1f us/cycle, %.1f%% of the blocks skipped\n",
+               bypass ? "on " : "off", numEffects, cycles, cpu, 100 * cpu / audioSeconds, audioSeconds,
+               elapsed / 1000.0 / cycles, 100.0 * skipped / ((double) cycles * numEffects));
+    }
+    return 0;
+}
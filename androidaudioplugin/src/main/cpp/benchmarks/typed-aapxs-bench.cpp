@@ -0,0 +1,169 @@
+// Benchmark of the synchronous TypedAAPXS calls (the preallocated completion slots). A TypedAAPXS
+// client talks to an in-process responder that replies either inline (within the send call) or from
+// a service thread, and it reports the heap allocations and the latency per call. It also checks
+// that failAllPending() releases a waiting call and leaves the extension usable.
+//
+// usage: aap-typed-aapxs-bench [calls]
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include "aap/core/aapxs/typed-aapxs.h"
+#include "benchmark-support.h"
+
+using namespace aap::xs;
+
+namespace {
+    std::atomic<int64_t> allocation_count{0};
+}
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (auto p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+namespace {
+    const int32_t OPCODE_GET_COUNT = 0;
+    const int32_t OPCODE_NEVER_REPLY = 1;
+
+    // Replies to every request with a 32-bit value; OPCODE_NEVER_REPLY requests are left unanswered.
+    class Responder {
+        std::thread thread{};
+        std::atomic<AAPXSRequestContext*> pending{nullptr};
+        std::atomic<bool> stopped{false};
+        AAPXSRequestContext request{};
+
+        static void reply(AAPXSRequestContext* request) {
+            *(int32_t*) request->serialization->data = 42;
+            request->serialization->data_size = sizeof(int32_t);
+            if (request->callback)
+                request->callback(request->callback_user_data, nullptr);
+        }
+
+    public:
+        const bool threaded;
+
+        explicit Responder(bool threadedResponder) : threaded(threadedResponder) {
+            if (threaded)
+                thread = std::thread([this] {
+                    while (!stopped.load(std::memory_order_acquire))
+                        if (auto r = pending.exchange(nullptr, std::memory_order_acq_rel))
+                            reply(r);
+                });
+        }
+        ~Responder() {
+            stopped.store(true, std::memory_order_release);
+            if (thread.joinable())
+                thread.join();
+        }
+
+        void send(AAPXSRequestContext* r) {
+            if (r->opcode == OPCODE_NEVER_REPLY)
+                return;
+            if (!threaded) {
+                reply(r);
+                return;
+            }
+            request = *r;
+            pending.store(&request, std::memory_order_release);
+        }
+    };
+
+    Responder* responder{nullptr};
+
+    bool sendRequest(AAPXSInitiatorInstance*, AAPXSRequestContext* request) {
+        responder->send(request);
+        return true;
+    }
+
+    uint32_t newRequestId(AAPXSInitiatorInstance*) {
+        static std::atomic<uint32_t> serial{0};
+        return ++serial;
+    }
+
+    class BenchmarkClientAAPXS : public TypedAAPXS {
+    public:
+        BenchmarkClientAAPXS(AAPXSInitiatorInstance* initiator, AAPXSSerializationContext* serializationContext)
+                : TypedAAPXS("urn://androidaudioplugin.org/extensions/benchmark", initiator, serializationContext) {
+        }
+
+        // callAndWait() semantics, as ParametersClientAAPXS::getParameterCount() does.
+        int32_t getCountAndWait(int32_t opcode = OPCODE_GET_COUNT) {
+            serialization->data_size = 0;
+            auto result = callTypedFunctionAndWait<int32_t>(opcode);
+            return result.isOk() ? result.value : -1;
+        }
+
+        // as StateClientAAPXS::getStateSize() does.
+        int32_t getCountSynchronously() {
+            serialization->data_size = 0;
+            return callTypedFunctionSynchronously<int32_t>(OPCODE_GET_COUNT);
+        }
+    };
+}
+
+int main(int argc, char** argv) {
+    int32_t calls = argc > 1 ? atoi(argv[1]) : 100000;
+
+    uint8_t data[256];
+    AAPXSSerializationContext serialization{};
+    serialization.data = data;
+    serialization.data_capacity = sizeof(data);
+    AAPXSInitiatorInstance initiator{};
+    initiator.serialization = &serialization;
+    initiator.urid = 1;
+    initiator.get_new_request_id = newRequestId;
+    initiator.send_aapxs_request = sendRequest;
+
+    bool ok = true;
+    for (bool threaded : {false, true}) {
+        Responder currentResponder{threaded};
+        responder = &currentResponder;
+        BenchmarkClientAAPXS client{&initiator, &serialization};
+        for (bool andWait : {true, false}) {
+            auto call = [&] { return andWait ? client.getCountAndWait() : client.getCountSynchronously(); };
+            int32_t n = threaded ? calls / 10 : calls;
+            for (int32_t i = 0; i < 1000; i++)
+                call();
+            aap::benchmark::LatencySamples latencies{(size_t) n};
+            int64_t failures = 0;
+            auto allocationsBefore = allocation_count.load();
+            for (int32_t i = 0; i < n; i++) {
+                auto begin = aap::benchmark::nowNanoseconds();
+                failures += call() != 42;
+                latencies.add(aap::benchmark::nowNanoseconds() - begin);
+            }
+            auto allocations = allocation_count.load() - allocationsBefore;
+            char name[128];
+            snprintf(name, sizeof(name), "%s responder, %s (%.2f allocs/call, %lld failed)",
+                     threaded ? "threaded" : "inline", andWait ? "callTypedFunctionAndWait" : "callTypedFunctionSynchronously",
+                     (double) allocations / n, (long long) failures);
+            latencies.print(name);
+            ok &= failures == 0;
+        }
+
+        // a waiting call is released by failAllPending() (e.g. at service death) instead of timing out...
+        client.setRequestTimeoutMs(5000);
+        std::thread failer([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            client.failAllPending("benchmark: service died");
+        });
+        auto begin = aap::benchmark::nowNanoseconds();
+        auto released = client.getCountAndWait(OPCODE_NEVER_REPLY);
+        auto waited = aap::benchmark::nowNanoseconds() - begin;
+        failer.join();
+        // ...and the extension remains usable after that.
+        auto next = client.getCountAndWait();
+        bool checked = released == -1 && waited < 1000000000 && next == 42;
+        printf("failAllPending(): released a waiting call after %.1f ms, next call returned %d: %s\n",
+               waited / 1e6, next, checked ? "OK" : "FAILED");
+        ok &= checked;
+    }
+    return ok ? 0 : 1;
+}
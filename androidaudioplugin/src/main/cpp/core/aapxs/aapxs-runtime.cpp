@@ -104,6 +104,11 @@ void aap::xs::AAPXSServiceDispatcher::setupInstances(void* hostContext,
     already_setup = true;
 }
 
+AAPXSSerializationContext *aap::xs::AAPXSServiceDispatcher::getSerialization(const char *uri) {
+    auto it = serialization_store.find(registry->getUridMapping()->getUrid(uri));
+    return it != serialization_store.end() ? it->second.get() : nullptr;
+}
+
 AAPXSRecipientInstance
 aap::xs::AAPXSServiceDispatcher::populateAAPXSRecipientInstance(
         void* hostContext,
@@ -2,8 +2,19 @@
 #include "aap/core/aapxs/midi-aapxs.h"
 #include "../AAPJniFacade.h"
 
+#if !ANDROID
+namespace aap {
+    // desktop/audio-plugin-host-desktop-internal.cpp
+    int32_t getMidiSettingsFromLocalConfig(std::string pluginId);
+}
+#endif
+
 int32_t getMidiSettingsFromLocalConfig2(std::string pluginId) {
+#if ANDROID
     return aap::AAPJniFacade::getInstance()->getMidiSettingsFromLocalConfig(pluginId);
+#else
+    return aap::getMidiSettingsFromLocalConfig(pluginId);
+#endif
 }
 
 void aap::xs::AAPXSDefinition_Midi::aapxs_midi_process_incoming_plugin_aapxs_request(
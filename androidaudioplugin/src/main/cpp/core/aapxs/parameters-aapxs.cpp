@@ -17,6 +17,38 @@ void notify_parameters_changed(aap_parameters_host_extension_t* ext,
 }
 
 aap_parameters_host_extension_t parameters_host_receiver{nullptr, notify_parameters_changed};
+
+// Fills `dst` with the parameters from `startIndex` as many as fit, in the layout described at
+// OPCODE_PARAMETERS_GET_PARAMETER_DESCRIPTORS. Returns the page size.
+int32_t write_parameter_descriptor_page(aap_parameters_extension_t* ext, AndroidAudioPlugin* plugin,
+                                        int32_t startIndex, uint8_t* dst, size_t capacity) {
+    aap::xs::ParameterDescriptorPageHeader header{0, 0};
+    size_t offset = sizeof(header);
+    int32_t count = ext && ext->get_parameter_count && ext->get_parameter ? ext->get_parameter_count(ext, plugin) : 0;
+    for (int32_t i = std::max(startIndex, 0); i < count; i++) {
+        auto info = ext->get_parameter(ext, plugin, i);
+        int32_t numEnums = ext->get_enumeration_count && ext->get_enumeration ? ext->get_enumeration_count(ext, plugin, info.stable_id) : 0;
+        size_t minimumSize = sizeof(info) + sizeof(int32_t);
+        if (offset + minimumSize + std::max(numEnums, 0) * sizeof(aap_parameter_enum_t) > capacity) {
+            if (header.num_parameters > 0 || offset + minimumSize > capacity)
+                break; // next page
+            numEnums = -1; // they would never fit; the client retrieves them per item.
+        }
+        memcpy(dst + offset, &info, sizeof(info));
+        offset += sizeof(info);
+        memcpy(dst + offset, &numEnums, sizeof(numEnums));
+        offset += sizeof(numEnums);
+        for (int32_t e = 0; e < numEnums; e++) {
+            auto en = ext->get_enumeration(ext, plugin, info.stable_id, e);
+            memcpy(dst + offset, &en, sizeof(en));
+            offset += sizeof(en);
+        }
+        header.num_parameters++;
+    }
+    header.size_in_bytes = (int32_t) offset;
+    memcpy(dst, &header, sizeof(header));
+    return header.size_in_bytes;
+}
 }
 
 // AAPXSDefinition_Parameters
@@ -29,8 +61,20 @@ void aap::xs::AAPXSDefinition_Parameters::aapxs_parameters_process_incoming_plug
         case OPCODE_PARAMETERS_GET_PARAMETER_COUNT:
             *((int32_t*) aapxsInstance->serialization->data) = (ext && ext->get_parameter_count) ? ext->get_parameter_count(ext, plugin) : -1;
             request->serialization->data_size = sizeof(int32_t);
+            if (aapxsInstance->serialization->data_capacity >= sizeof(int32_t) * 2) {
+                *((int32_t*) aapxsInstance->serialization->data + 1) = AAP_PARAMETERS_COUNT_REPLY_DESCRIPTOR_PAGES;
+                request->serialization->data_size = sizeof(int32_t) * 2;
+            }
             aapxsInstance->send_aapxs_reply(aapxsInstance, request);
             break;
+        case OPCODE_PARAMETERS_GET_PARAMETER_DESCRIPTORS: {
+            int32_t startIndex = *((int32_t *) aapxsInstance->serialization->data);
+            request->serialization->data_size = write_parameter_descriptor_page(
+                    ext, plugin, startIndex, (uint8_t*) aapxsInstance->serialization->data,
+                    aapxsInstance->serialization->data_capacity);
+            aapxsInstance->send_aapxs_reply(aapxsInstance, request);
+            break;
+        }
         case OPCODE_PARAMETERS_GET_PARAMETER:
             if (ext != nullptr && ext->get_parameter) {
                 int32_t index = *((int32_t *) aapxsInstance->serialization->data);
@@ -153,13 +197,80 @@ void* aap::xs::AAPXSDefinition_Parameters::aapxs_parameters_as_host_receiver(
 
 int32_t aap::xs::ParametersClientAAPXS::getParameterCount() {
     serialization->data_size = 0;
-    auto result = callAndWait<int32_t>(OPCODE_PARAMETERS_GET_PARAMETER_COUNT,
-                                       [](AAPXSSerializationContext* ctx) -> int32_t {
-        return getTypedResult<int32_t>(ctx);
+    if (serialization->data_capacity < sizeof(ParameterCountReply)) {
+        descriptor_pages_supported = false;
+        auto result = callTypedFunctionAndWait<int32_t>(OPCODE_PARAMETERS_GET_PARAMETER_COUNT);
+        return result.isOk() ? result.value : -1;
+    }
+    // services that do not know OPCODE_PARAMETERS_GET_PARAMETER_DESCRIPTORS leave the flags as is.
+    *((ParameterCountReply*) serialization->data) = {};
+    auto result = callTypedFunctionAndWait<ParameterCountReply>(OPCODE_PARAMETERS_GET_PARAMETER_COUNT);
+    descriptor_pages_supported = result.isOk() && result.value.flags == AAP_PARAMETERS_COUNT_REPLY_DESCRIPTOR_PAGES;
+    return result.isOk() ? result.value.count : -1;
+}
+
+int32_t aap::xs::ParametersClientAAPXS::getParameterDescriptorPage(int32_t startIndex, uint8_t* buffer, int32_t bufferSize) {
+    if (!descriptor_pages_supported || bufferSize < (int32_t) sizeof(ParameterDescriptorPageHeader))
+        return -1;
+    *((int32_t*) serialization->data) = startIndex;
+    serialization->data_size = sizeof(int32_t);
+    auto result = callAndWait<int32_t>(OPCODE_PARAMETERS_GET_PARAMETER_DESCRIPTORS,
+                                       [buffer, bufferSize](AAPXSSerializationContext* ctx) -> int32_t {
+        ParameterDescriptorPageHeader header;
+        memcpy(&header, ctx->data, sizeof(header));
+        if (header.size_in_bytes < (int32_t) sizeof(header) ||
+            header.size_in_bytes > bufferSize || (size_t) header.size_in_bytes > ctx->data_capacity)
+            return -1;
+        memcpy(buffer, ctx->data, header.size_in_bytes);
+        return header.size_in_bytes;
     });
     return result.isOk() ? result.value : -1;
 }
 
+bool aap::xs::ParametersClientAAPXS::getParameterDescriptors(int32_t parameterCount,
+                                                             uint8_t* pageBuffer, int32_t pageBufferSize,
+                                                             ParameterDescriptorCallback onParameter) {
+    std::vector<aap_parameter_enum_t> enums{};
+    int32_t index = 0;
+    while (index < parameterCount) {
+        auto pageSize = getParameterDescriptorPage(index, pageBuffer, pageBufferSize);
+        if (pageSize < 0)
+            return false;
+        ParameterDescriptorPageHeader header;
+        memcpy(&header, pageBuffer, sizeof(header));
+        if (header.num_parameters <= 0)
+            return false; // parameters went away while scanning, or the page is broken.
+        size_t offset = sizeof(header);
+        for (int32_t i = 0; i < header.num_parameters; i++) {
+            aap_parameter_info_t info;
+            int32_t numEnums;
+            if (offset + sizeof(info) + sizeof(numEnums) > (size_t) pageSize)
+                return false;
+            memcpy(&info, pageBuffer + offset, sizeof(info));
+            offset += sizeof(info);
+            memcpy(&numEnums, pageBuffer + offset, sizeof(numEnums));
+            offset += sizeof(numEnums);
+            if (numEnums < 0) {
+                // too many to fit in a page. The page is already copied, so it is safe to make other calls.
+                numEnums = getEnumerationCount(info.stable_id);
+                enums.resize(numEnums);
+                for (int32_t e = 0; e < numEnums; e++)
+                    enums[e] = getEnumeration(info.stable_id, e);
+            } else {
+                if (offset + numEnums * sizeof(aap_parameter_enum_t) > (size_t) pageSize)
+                    return false;
+                enums.resize(numEnums);
+                if (numEnums > 0)
+                    memcpy(enums.data(), pageBuffer + offset, numEnums * sizeof(aap_parameter_enum_t));
+                offset += numEnums * sizeof(aap_parameter_enum_t);
+            }
+            onParameter(info, enums.data(), numEnums);
+        }
+        index += header.num_parameters;
+    }
+    return true;
+}
+
 aap_parameter_info_t aap::xs::ParametersClientAAPXS::getParameter(int32_t index) {
     *((int32_t*) serialization->data) = index;
     serialization->data_size = sizeof(int32_t);
@@ -1,5 +1,32 @@
 #include <algorithm>
+#include <new>
 #include "aap/core/aapxs/state-aapxs.h"
+#include "aap/unstable/logging.h"
+
+#define LOG_TAG "AAP.StateAAPXS"
+
+namespace {
+    // Not cryptographic; it only has to tell whether a block of the same plugin state changed.
+    // Four independent lanes keep the multiplications from stalling each other.
+    uint64_t hash_state_block(const uint8_t* data, size_t size) {
+        const uint64_t prime = 0x9E3779B97F4A7C15ull;
+        uint64_t lanes[4] = {size, prime, ~size, prime ^ size};
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            for (int l = 0; l < 4; l++) {
+                uint64_t w;
+                memcpy(&w, data + i + l * 8, sizeof(w));
+                lanes[l] = (lanes[l] ^ w) * prime;
+                lanes[l] ^= lanes[l] >> 29;
+            }
+        }
+        uint64_t h = lanes[0] ^ (lanes[1] * 3) ^ (lanes[2] * 5) ^ (lanes[3] * 7);
+        for (; i < size; i++)
+            h = (h ^ data[i]) * prime;
+        h ^= h >> 32;
+        return h * prime;
+    }
+}
 
 void aap::xs::AAPXSDefinition_State::aapxs_state_process_incoming_plugin_aapxs_request(
         struct AAPXSDefinition *feature, AAPXSRecipientInstance *aapxsInstance,
@@ -8,12 +35,22 @@ void aap::xs::AAPXSDefinition_State::aapxs_state_process_incoming_plugin_aapxs_r
     if (!ext)
         return; // FIXME: should there be any global error handling?
     switch(request->opcode) {
-        case OPCODE_GET_STATE_SIZE:
-            *((int32_t *) request->serialization->data) = ext->get_state_size(ext, plugin);
+        case OPCODE_GET_STATE_SIZE: {
+            auto size = ext->get_state_size(ext, plugin);
+            *((int32_t *) request->serialization->data) = static_cast<int32_t>(std::min<size_t>(size, INT32_MAX));
             request->serialization->data_size = sizeof(int32_t);
+            if (request->serialization->data_capacity >= sizeof(int32_t) * 4 + sizeof(int64_t)) {
+                auto serializedData = (uint8_t*) request->serialization->data;
+                *((int32_t *) serializedData + 1) = AAP_STATE_SIZE_REPLY_CHUNKED;
+                auto fullSize = static_cast<int64_t>(size);
+                memcpy(serializedData + sizeof(int32_t) * 2, &fullSize, sizeof(fullSize));
+                *((int32_t *) (serializedData + sizeof(int32_t) * 2 + sizeof(int64_t))) = AAP_STATE_SIZE_REPLY_DELTA;
+                request->serialization->data_size = sizeof(int32_t) * 4 + sizeof(int64_t);
+            }
             // RT_SAFE. Send reply now.
             aapxsInstance->send_aapxs_reply(aapxsInstance, request);
             break;
+        }
         case OPCODE_GET_STATE: {
             aap_state_t state;
             auto serializedData = (uint8_t*) request->serialization->data;
@@ -42,6 +79,143 @@ void aap::xs::AAPXSDefinition_State::aapxs_state_process_incoming_plugin_aapxs_r
                 aapxsInstance->send_aapxs_reply(aapxsInstance, request);
             break;
         }
+        case OPCODE_GET_STATE_CHUNK: {
+            auto definition = (AAPXSDefinition_State*) feature->aapxs_context;
+            auto serializedData = (uint8_t*) request->serialization->data;
+            StateChunkHeader header{0, 0, 0, 0};
+            memcpy(&header.offset, serializedData, sizeof(header.offset));
+            if (header.offset < 0) { // the client cancelled the transfer.
+                definition->releaseStagedState(request->serialization);
+            } else {
+                auto& staged = definition->getStagedState(request->serialization);
+                if (header.offset == 0)
+                    captureState(ext, plugin, staged);
+                header.total_size = static_cast<int64_t>(staged.size);
+                if (header.offset <= header.total_size) {
+                    auto payloadCapacity = request->serialization->data_capacity - sizeof(header);
+                    auto chunkSize = std::min<size_t>(payloadCapacity, staged.size - header.offset);
+                    if (chunkSize > 0)
+                        memcpy(serializedData + sizeof(header), staged.data.get() + header.offset, chunkSize);
+                    header.chunk_size = static_cast<int32_t>(chunkSize);
+                }
+                if (header.offset + header.chunk_size >= header.total_size)
+                    definition->releaseStagedState(request->serialization);
+            }
+            memcpy(serializedData, &header, sizeof(header));
+            request->serialization->data_size = sizeof(header) + header.chunk_size;
+            aapxsInstance->send_aapxs_reply(aapxsInstance, request);
+            break;
+        }
+        case OPCODE_GET_STATE_DELTA: {
+            auto definition = (AAPXSDefinition_State*) feature->aapxs_context;
+            auto serializedData = (uint8_t*) request->serialization->data;
+            auto capacity = request->serialization->data_capacity;
+            StateDeltaRequestHeader requestHeader;
+            memcpy(&requestHeader, serializedData, sizeof(requestHeader));
+            StateDeltaReplyHeader header{0, 0, 0, 0, 0};
+            size_t replySize = sizeof(header);
+            if (requestHeader.cursor < 0) { // the client cancelled the transfer.
+                definition->releaseStagedState(request->serialization);
+            } else {
+                auto& staged = definition->getStagedState(request->serialization);
+                if (requestHeader.cursor == 0) {
+                    captureState(ext, plugin, staged);
+                    // Every block must fit in a reply. If the client asked for something else, send everything.
+                    size_t numHashes = std::min<size_t>(std::max(requestHeader.num_hashes, 0),
+                                                        (capacity - sizeof(requestHeader)) / sizeof(uint64_t));
+                    staged.block_size = requestHeader.block_size;
+                    if (staged.block_size <= 0 ||
+                        sizeof(header) + sizeof(StateDeltaBlockHeader) + staged.block_size > capacity) {
+                        staged.block_size = STATE_DELTA_DEFAULT_BLOCK_SIZE;
+                        numHashes = 0;
+                    }
+                    auto blockSize = static_cast<size_t>(staged.block_size);
+                    auto knownHashes = serializedData + sizeof(requestHeader);
+                    staged.changed_blocks.clear();
+                    staged.changed_block_hashes.clear();
+                    for (size_t i = 0, n = (staged.size + blockSize - 1) / blockSize; i < n; i++) {
+                        auto hash = hash_state_block(staged.data.get() + i * blockSize, std::min(blockSize, staged.size - i * blockSize));
+                        uint64_t knownHash = 0;
+                        if (i < numHashes)
+                            memcpy(&knownHash, knownHashes + i * sizeof(uint64_t), sizeof(knownHash));
+                        if (i >= numHashes || knownHash != hash) {
+                            staged.changed_blocks.emplace_back(static_cast<int32_t>(i));
+                            staged.changed_block_hashes.emplace_back(hash);
+                        }
+                    }
+                }
+                header.total_size = static_cast<int64_t>(staged.size);
+                header.block_size = staged.block_size;
+                header.num_changed_blocks = static_cast<int32_t>(staged.changed_blocks.size());
+                auto cursor = static_cast<int32_t>(std::min<int64_t>(requestHeader.cursor, header.num_changed_blocks));
+                auto blockSize = static_cast<size_t>(staged.block_size);
+                while (cursor < header.num_changed_blocks) {
+                    auto index = staged.changed_blocks[cursor];
+                    auto offset = index * blockSize;
+                    StateDeltaBlockHeader block{staged.changed_block_hashes[cursor], index,
+                                                static_cast<int32_t>(std::min(blockSize, staged.size - offset))};
+                    if (replySize + sizeof(block) + block.size > capacity)
+                        break;
+                    memcpy(serializedData + replySize, &block, sizeof(block));
+                    memcpy(serializedData + replySize + sizeof(block), staged.data.get() + offset, block.size);
+                    replySize += sizeof(block) + block.size;
+                    header.num_blocks_in_reply++;
+                    cursor++;
+                }
+                header.next_cursor = cursor;
+                if (cursor >= header.num_changed_blocks)
+                    definition->releaseStagedState(request->serialization);
+            }
+            memcpy(serializedData, &header, sizeof(header));
+            request->serialization->data_size = replySize;
+            aapxsInstance->send_aapxs_reply(aapxsInstance, request);
+            break;
+        }
+        case OPCODE_SET_STATE_CHUNK: {
+            auto definition = (AAPXSDefinition_State*) feature->aapxs_context;
+            auto serializedData = (uint8_t*) request->serialization->data;
+            StateChunkHeader header;
+            memcpy(&header, serializedData, sizeof(header));
+            int32_t status = 0;
+            if (header.offset < 0) { // the client cancelled the transfer.
+                definition->releaseStagedState(request->serialization);
+            } else {
+                auto& staged = definition->getStagedState(request->serialization);
+                if (header.offset == 0) {
+                    // the size comes from the client; do not trust it.
+                    bool validSize = header.total_size >= 0 && header.total_size <= STATE_CHUNKED_TRANSFER_MAX_SIZE;
+                    staged.data.reset(validSize ? new (std::nothrow) uint8_t[std::max<int64_t>(header.total_size, 1)] : nullptr);
+                    staged.size = staged.data ? static_cast<size_t>(header.total_size) : 0;
+                    if (!staged.data)
+                        aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Cannot receive a state of %lld bytes",
+                                     (long long) header.total_size);
+                }
+                if (!staged.data ||
+                    header.total_size < 0 ||
+                    header.chunk_size < 0 ||
+                    static_cast<size_t>(header.chunk_size) + sizeof(header) > request->serialization->data_capacity ||
+                    static_cast<size_t>(header.offset) > staged.size ||
+                    static_cast<size_t>(header.chunk_size) > staged.size - static_cast<size_t>(header.offset) ||
+                    static_cast<size_t>(header.total_size) != staged.size) {
+                    aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "State chunk out of range (offset: %lld, size: %d)",
+                                 (long long) header.offset, header.chunk_size);
+                    definition->releaseStagedState(request->serialization);
+                    status = -1;
+                } else {
+                    if (header.chunk_size > 0)
+                        memcpy(staged.data.get() + header.offset, serializedData + sizeof(header), header.chunk_size);
+                    if (static_cast<size_t>(header.offset + header.chunk_size) == staged.size) {
+                        aap_state_t state{staged.data.get(), staged.size};
+                        ext->set_state(ext, plugin, &state);
+                        definition->releaseStagedState(request->serialization);
+                    }
+                }
+            }
+            *((int32_t*) serializedData) = status;
+            request->serialization->data_size = sizeof(int32_t);
+            aapxsInstance->send_aapxs_reply(aapxsInstance, request);
+            break;
+        }
     }
 }
 
@@ -66,6 +240,34 @@ void aap::xs::AAPXSDefinition_State::aapxs_state_process_incoming_host_aapxs_rep
         request->callback(request->callback_user_data, host);
 }
 
+aap::xs::AAPXSDefinition_State::StagedState&
+aap::xs::AAPXSDefinition_State::getStagedState(AAPXSSerializationContext *serialization) {
+    // The map is shared by all the instances, but each entry is used only by its own instance
+    // (one request at a time), and std::map entries stay where they are while others are added.
+    std::lock_guard<std::mutex> lock{staging_mutex};
+    return staging[serialization];
+}
+
+void aap::xs::AAPXSDefinition_State::captureState(aap_state_extension_t* ext, AndroidAudioPlugin* plugin,
+                                                  StagedState& staged) {
+    auto size = ext->get_state_size(ext, plugin);
+    staged.data.reset(new uint8_t[std::max<size_t>(size, 1)]);
+    aap_state_t state{staged.data.get(), size};
+    ext->get_state(ext, plugin, &state);
+    if (state.data != staged.data.get()) {
+        if (state.data_size > size)
+            staged.data.reset(new uint8_t[state.data_size]);
+        if (state.data_size > 0)
+            memcpy(staged.data.get(), state.data, state.data_size);
+    }
+    staged.size = state.data != staged.data.get() ? state.data_size : std::min(state.data_size, size);
+}
+
+void aap::xs::AAPXSDefinition_State::releaseStagedState(AAPXSSerializationContext *serialization) {
+    std::lock_guard<std::mutex> lock{staging_mutex};
+    staging.erase(serialization);
+}
+
 AAPXSExtensionClientProxy
 aap::xs::AAPXSDefinition_State::aapxs_state_get_plugin_proxy(struct AAPXSDefinition *feature,
                                                              AAPXSInitiatorInstance *aapxsInstance,
@@ -78,10 +280,48 @@ aap::xs::AAPXSDefinition_State::aapxs_state_get_plugin_proxy(struct AAPXSDefinit
 
 size_t aap::xs::StateClientAAPXS::getStateSize() {
     serialization->data_size = 0;
-    return callTypedFunctionSynchronously<int32_t>(OPCODE_GET_STATE_SIZE);
+    if (serialization->data_capacity < sizeof(StateSizeReply))
+        return callTypedFunctionSynchronously<int32_t>(OPCODE_GET_STATE_SIZE);
+    // services that do not know the chunked transfer leave the flags as is.
+    *((StateSizeReply*) serialization->data) = {};
+    auto result = callTypedFunctionAndWait<StateSizeReply>(OPCODE_GET_STATE_SIZE);
+    if (!result.isOk())
+        return 0;
+    chunks_supported = result.value.flags == AAP_STATE_SIZE_REPLY_CHUNKED;
+    delta_supported = chunks_supported && result.value.delta_flags == AAP_STATE_SIZE_REPLY_DELTA;
+    chunks_probed = true;
+    return chunks_supported ? static_cast<size_t>(result.value.full_size) : result.value.size;
 }
 
 std::string aap::xs::StateClientAAPXS::getState(aap_state_t &state) {
+    if (!chunks_probed)
+        getStateSize();
+    if (!chunks_supported)
+        return getStateAtOnce(state);
+    auto capacity = state.data_size;
+    state.data_size = 0;
+    // like getStateAtOnce(), it reports the actual size even if it is larger than the buffer.
+    return readState([&state, capacity](const uint8_t* data, size_t size, size_t totalSize) {
+        auto offset = state.data_size;
+        state.data_size = offset + size;
+        if (offset < capacity && state.data)
+            memcpy((uint8_t*) state.data + offset, data, std::min(size, capacity - offset));
+        return true;
+    });
+}
+
+std::string aap::xs::StateClientAAPXS::setState(aap_state_t &state) {
+    if (!chunks_probed)
+        getStateSize();
+    if (!chunks_supported)
+        return setStateAtOnce(state);
+    return writeState(state.data_size, [&state](uint8_t* destination, size_t offset, size_t size) {
+        memcpy(destination, (const uint8_t*) state.data + offset, size);
+        return true;
+    });
+}
+
+std::string aap::xs::StateClientAAPXS::getStateAtOnce(aap_state_t &state) {
     serialization->data_size = 0;
     auto result = callAndWait<int32_t>(OPCODE_GET_STATE, [&state](AAPXSSerializationContext* s) -> int32_t {
         auto serializedData = (uint8_t*) s->data;
@@ -96,13 +336,213 @@ std::string aap::xs::StateClientAAPXS::getState(aap_state_t &state) {
     return result.error;
 }
 
-std::string aap::xs::StateClientAAPXS::setState(aap_state_t &state) {
+std::string aap::xs::StateClientAAPXS::setStateAtOnce(aap_state_t &state) {
+    if (state.data_size + sizeof(int32_t) > serialization->data_capacity)
+        return "The state is too large for the plugin service";
     *((int32_t*) serialization->data) = static_cast<int32_t>(state.data_size);
     memcpy((uint8_t*) serialization->data + sizeof(int32_t), state.data, state.data_size);
     serialization->data_size = state.data_size + sizeof(int32_t);
     return callAndWait<bool>(OPCODE_SET_STATE, [](AAPXSSerializationContext*) -> bool { return true; }).error;
 }
 
+std::string aap::xs::StateClientAAPXS::readState(StateChunkReader onChunk) {
+    if (!chunks_probed)
+        getStateSize();
+    if (!chunks_supported) {
+        std::vector<uint8_t> buffer(serialization->data_capacity - sizeof(int32_t));
+        aap_state_t state{buffer.data(), buffer.size()};
+        auto error = getStateAtOnce(state);
+        if (error.empty() && state.data_size > 0)
+            onChunk(buffer.data(), std::min(state.data_size, buffer.size()), state.data_size);
+        return error;
+    }
+
+    int64_t offset = 0;
+    while (true) {
+        memcpy(serialization->data, &offset, sizeof(offset));
+        serialization->data_size = sizeof(offset);
+        std::string chunkError{};
+        bool done = false;
+        auto result = callAndWait<bool>(OPCODE_GET_STATE_CHUNK, [&](AAPXSSerializationContext* s) -> bool {
+            StateChunkHeader header;
+            memcpy(&header, s->data, sizeof(header));
+            if (header.offset != offset || header.chunk_size < 0 ||
+                static_cast<size_t>(header.chunk_size) + sizeof(header) > s->data_capacity ||
+                header.offset + header.chunk_size > header.total_size) {
+                chunkError = "Received broken state chunk";
+                return false;
+            }
+            if (header.chunk_size > 0 &&
+                !onChunk((const uint8_t*) s->data + sizeof(header), header.chunk_size, header.total_size)) {
+                chunkError = "cancelled";
+                return false;
+            }
+            offset += header.chunk_size;
+            done = offset >= header.total_size || header.chunk_size == 0;
+            return true;
+        });
+        if (!result.isOk() || !chunkError.empty()) {
+            // the service may still hold the captured state; tell it to drop it.
+            discardStateChunks(OPCODE_GET_STATE_CHUNK);
+            return result.isOk() ? chunkError : result.error;
+        }
+        if (done)
+            return "";
+    }
+}
+
+std::string aap::xs::StateClientAAPXS::writeState(size_t totalSize, StateChunkWriter nextChunk) {
+    if (!chunks_probed)
+        getStateSize();
+    if (!chunks_supported) {
+        std::vector<uint8_t> buffer(totalSize);
+        if (totalSize > 0 && !nextChunk(buffer.data(), 0, totalSize))
+            return "cancelled";
+        aap_state_t state{buffer.data(), totalSize};
+        return setStateAtOnce(state);
+    }
+
+    auto payloadCapacity = serialization->data_capacity - sizeof(StateChunkHeader);
+    auto payload = (uint8_t*) serialization->data + sizeof(StateChunkHeader);
+    size_t offset = 0;
+    do {
+        auto chunkSize = std::min(payloadCapacity, totalSize - offset);
+        if (chunkSize > 0 && !nextChunk(payload, offset, chunkSize)) {
+            if (offset > 0)
+                discardStateChunks(OPCODE_SET_STATE_CHUNK);
+            return "cancelled";
+        }
+        StateChunkHeader header{static_cast<int64_t>(totalSize), static_cast<int64_t>(offset), static_cast<int32_t>(chunkSize), 0};
+        memcpy(serialization->data, &header, sizeof(header));
+        serialization->data_size = sizeof(header) + chunkSize;
+        auto result = callAndWait<int32_t>(OPCODE_SET_STATE_CHUNK, [](AAPXSSerializationContext* s) -> int32_t {
+            return getTypedResult<int32_t>(s);
+        });
+        if (!result.isOk() || result.value != 0) {
+            // the service may still hold the partial state; tell it to drop it.
+            discardStateChunks(OPCODE_SET_STATE_CHUNK);
+            return result.isOk() ? "The plugin service rejected the state chunk" : result.error;
+        }
+        offset += chunkSize;
+    } while (offset < totalSize);
+    return "";
+}
+
+std::string aap::xs::StateClientAAPXS::updateStateSnapshot(StateSnapshot &snapshot) {
+    if (!chunks_probed)
+        getStateSize();
+    snapshot.last_transferred_size = 0;
+    if (!delta_supported) {
+        snapshot.clear();
+        auto error = readState([&snapshot](const uint8_t* data, size_t size, size_t totalSize) {
+            snapshot.data.reserve(totalSize);
+            snapshot.data.insert(snapshot.data.end(), data, data + size);
+            return true;
+        });
+        snapshot.last_transferred_size = snapshot.data.size();
+        if (!error.empty())
+            snapshot.clear();
+        return error;
+    }
+
+    // The hashes have to fit in the request; pick larger blocks for larger states.
+    auto maxHashes = (serialization->data_capacity - sizeof(StateDeltaRequestHeader)) / sizeof(uint64_t);
+    if (snapshot.block_hashes.size() > maxHashes)
+        snapshot.clear();
+    if (snapshot.block_size == 0) {
+        auto stateSize = getStateSize();
+        snapshot.block_size = STATE_DELTA_DEFAULT_BLOCK_SIZE;
+        while (stateSize / snapshot.block_size >= maxHashes / 2 &&
+               static_cast<size_t>(snapshot.block_size) * 4 <= serialization->data_capacity)
+            snapshot.block_size *= 2;
+    }
+
+    int64_t cursor = 0;
+    while (true) {
+        auto numHashes = cursor == 0 ? snapshot.block_hashes.size() : 0;
+        StateDeltaRequestHeader requestHeader{cursor, snapshot.block_size, static_cast<int32_t>(numHashes)};
+        memcpy(serialization->data, &requestHeader, sizeof(requestHeader));
+        if (numHashes > 0)
+            memcpy((uint8_t*) serialization->data + sizeof(requestHeader), snapshot.block_hashes.data(), numHashes * sizeof(uint64_t));
+        serialization->data_size = sizeof(requestHeader) + numHashes * sizeof(uint64_t);
+        std::string blockError{};
+        bool done = false;
+        auto result = callAndWait<bool>(OPCODE_GET_STATE_DELTA, [&](AAPXSSerializationContext* s) -> bool {
+            auto serializedData = (const uint8_t*) s->data;
+            StateDeltaReplyHeader header;
+            memcpy(&header, serializedData, sizeof(header));
+            if (header.total_size < 0 || header.block_size <= 0 || header.num_blocks_in_reply < 0 ||
+                header.next_cursor != cursor + header.num_blocks_in_reply) {
+                blockError = "Received broken state delta";
+                return false;
+            }
+            auto blockSize = static_cast<size_t>(header.block_size);
+            auto totalSize = static_cast<size_t>(header.total_size);
+            if (cursor == 0) {
+                if (header.block_size != snapshot.block_size)
+                    snapshot.block_hashes.clear(); // the service sends everything then.
+                snapshot.block_size = header.block_size;
+                snapshot.data.resize(totalSize);
+                snapshot.block_hashes.resize((totalSize + blockSize - 1) / blockSize);
+            } else if (header.block_size != snapshot.block_size || totalSize != snapshot.data.size()) {
+                // the state must not change its shape between the pages of one transfer.
+                blockError = "Received inconsistent state delta";
+                return false;
+            }
+            size_t offset = sizeof(header);
+            for (int32_t i = 0; i < header.num_blocks_in_reply; i++) {
+                StateDeltaBlockHeader block;
+                if (offset + sizeof(block) > s->data_capacity) {
+                    blockError = "Received broken state delta";
+                    return false;
+                }
+                memcpy(&block, serializedData + offset, sizeof(block));
+                offset += sizeof(block);
+                if (block.index < 0 || static_cast<size_t>(block.index) >= snapshot.block_hashes.size() ||
+                    static_cast<size_t>(block.index) * blockSize >= totalSize ||
+                    static_cast<size_t>(block.size) != std::min(blockSize, totalSize - block.index * blockSize) ||
+                    offset + block.size > s->data_capacity) {
+                    blockError = "Received broken state delta";
+                    return false;
+                }
+                memcpy(snapshot.data.data() + block.index * blockSize, serializedData + offset, block.size);
+                snapshot.block_hashes[block.index] = block.hash;
+                snapshot.last_transferred_size += block.size;
+                offset += block.size;
+            }
+            cursor = header.next_cursor;
+            done = cursor >= header.num_changed_blocks;
+            return true;
+        });
+        if (!result.isOk() || !blockError.empty()) {
+            // a timed-out request may still have been processed; the service may hold the state either way.
+            discardStateChunks(OPCODE_GET_STATE_DELTA);
+            snapshot.clear();
+            return result.isOk() ? blockError : result.error;
+        }
+        if (done)
+            return "";
+    }
+}
+
+void aap::xs::StateClientAAPXS::discardStateChunks(int32_t opcode) {
+    // a negative offset tells the service to release the state it holds for the transfer.
+    if (opcode == OPCODE_GET_STATE_DELTA) {
+        StateDeltaRequestHeader header{-1, 0, 0};
+        memcpy(serialization->data, &header, sizeof(header));
+        serialization->data_size = sizeof(header);
+    } else if (opcode == OPCODE_GET_STATE_CHUNK) {
+        int64_t offset = -1;
+        memcpy(serialization->data, &offset, sizeof(offset));
+        serialization->data_size = sizeof(offset);
+    } else {
+        StateChunkHeader header{0, -1, 0, 0};
+        memcpy(serialization->data, &header, sizeof(header));
+        serialization->data_size = sizeof(header);
+    }
+    callAndWait<bool>(opcode, [](AAPXSSerializationContext*) -> bool { return true; });
+}
+
 int32_t aap::xs::StateClientAAPXS::requestStateAsync(std::function<void(Result<aap_state_t>)> callback) {
     serialization->data_size = 0;
     return callFunctionAsync(OPCODE_GET_STATE,
@@ -0,0 +1,56 @@
+
+#include "aap/core/aapxs/tail-aapxs.h"
+
+void aap::xs::AAPXSDefinition_Tail::aapxs_tail_process_incoming_plugin_aapxs_request(
+        struct AAPXSDefinition *feature, AAPXSRecipientInstance *aapxsInstance,
+        AndroidAudioPlugin *plugin, AAPXSRequestContext *request) {
+    auto ext = (aap_tail_extension_t*) plugin->get_extension(plugin, AAP_TAIL_EXTENSION_URI);
+    switch (request->opcode) {
+        case OPCODE_GET_TAIL_TIME:
+            // plugins that do not implement the extension are never skipped.
+            *((int32_t*) request->serialization->data) =
+                    ext && ext->get_tail_time_in_milliseconds ? ext->get_tail_time_in_milliseconds(ext, plugin) : AAP_TAIL_TIME_INFINITE;
+            request->serialization->data_size = sizeof(int32_t);
+            aapxsInstance->send_aapxs_reply(aapxsInstance, request);
+            break;
+    }
+}
+
+void aap::xs::AAPXSDefinition_Tail::aapxs_tail_process_incoming_host_aapxs_request(
+        struct AAPXSDefinition *feature, AAPXSRecipientInstance *aapxsInstance,
+        AndroidAudioPluginHost *host, AAPXSRequestContext *request) {
+    throw std::runtime_error("There is no tail host extension");
+}
+
+void aap::xs::AAPXSDefinition_Tail::aapxs_tail_process_incoming_plugin_aapxs_reply(
+        struct AAPXSDefinition *feature, AAPXSInitiatorInstance *aapxsInstance,
+        AndroidAudioPlugin *plugin, AAPXSRequestContext *request) {
+    if (request->callback != nullptr)
+        request->callback(request->callback_user_data, plugin);
+}
+
+void aap::xs::AAPXSDefinition_Tail::aapxs_tail_process_incoming_host_aapxs_reply(
+        struct AAPXSDefinition *feature, AAPXSInitiatorInstance *aapxsInstance,
+        AndroidAudioPluginHost *host, AAPXSRequestContext *request) {
+    if (request->callback != nullptr)
+        request->callback(request->callback_user_data, host);
+}
+
+AAPXSExtensionClientProxy
+aap::xs::AAPXSDefinition_Tail::aapxs_tail_get_plugin_proxy(struct AAPXSDefinition *feature,
+                                                           AAPXSInitiatorInstance *aapxsInstance,
+                                                           AAPXSSerializationContext *serialization) {
+    auto client = (AAPXSDefinition_Tail*) feature->aapxs_context;
+    client->typed_client = std::make_unique<TailClientAAPXS>(aapxsInstance, serialization);
+    client->client_proxy = AAPXSExtensionClientProxy{client->typed_client.get(), aapxs_tail_as_plugin_extension};
+    return client->client_proxy;
+}
+
+int32_t aap::xs::TailClientAAPXS::getTailTimeInMilliseconds() {
+    // A service that does not know this extension completes the request without writing the
+    // reply, so what we leave in the shared memory is what we read back. Make it mean "never skip".
+    *((int32_t*) serialization->data) = AAP_TAIL_TIME_INFINITE;
+    serialization->data_size = 0;
+    auto result = callTypedFunctionAndWait<int32_t>(OPCODE_GET_TAIL_TIME);
+    return result.isOk() ? result.value : AAP_TAIL_TIME_INFINITE;
+}
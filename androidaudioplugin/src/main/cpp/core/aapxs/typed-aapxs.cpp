@@ -1,4 +1,10 @@
 #include <algorithm>
+#include <ctime>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 #include "aap/core/aapxs/typed-aapxs.h"
 #include "aap/core/host/plugin-instance.h"
 
@@ -6,11 +12,97 @@
 // aap::PluginInstance definition, and typed-aapxs.h is included *by* plugin-instance.h
 // (via standard-extensions.h) — including it back here would be circular.
 
+namespace {
+    // A reply through the in-process path or SysEx8 arrives within microseconds, so we spin
+    // briefly before falling back to the (syscall-based) futex wait.
+    const int32_t SYNC_REPLY_SPIN_COUNT = 256;
+
+    int64_t monotonic_nanoseconds() {
+        timespec ts{};
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+
+    // The slot is process-local, so we can use the private futex operations.
+    void sleep_on(std::atomic<uint32_t>* word, uint32_t expected, int64_t timeoutInNanoseconds) {
+#if defined(__linux__)
+        timespec timeout{(time_t) (timeoutInNanoseconds / 1000000000), (long) (timeoutInNanoseconds % 1000000000)};
+        syscall(SYS_futex, (uint32_t*) word, FUTEX_WAIT_PRIVATE, expected,
+                timeoutInNanoseconds >= 0 ? &timeout : nullptr, nullptr, 0);
+#else
+        const auto delay = timespec{0, 1000}; // 1 microsecond
+        clock_nanosleep(CLOCK_REALTIME, 0, &delay, nullptr);
+#endif
+    }
+
+    void wake(std::atomic<uint32_t>* word) {
+#if defined(__linux__)
+        syscall(SYS_futex, (uint32_t*) word, FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+#endif
+    }
+}
+
 namespace aap::xs {
 
+    void SyncCompletionSlot::complete(bool succeeded) {
+        auto previous = state.exchange(succeeded ? COMPLETED : FAILED, std::memory_order_acq_rel);
+        switch (previous) {
+            case WAITING:
+                wake(&state);
+                break;
+            case ABANDONED: {
+                // nobody waits for it anymore. The call still holds the serialization block of
+                // its owner, so let the owner send the calls that were deferred meanwhile.
+                auto previousOwner = owner.exchange(nullptr, std::memory_order_acq_rel);
+                state.store(IDLE, std::memory_order_release);
+                if (previousOwner)
+                    previousOwner->onSyncCallEnded();
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    uint32_t SyncCompletionSlot::wait(int32_t timeoutMs) {
+        for (int32_t i = 0; i < SYNC_REPLY_SPIN_COUNT; i++) {
+            auto current = state.load(std::memory_order_acquire);
+            if (current == COMPLETED || current == FAILED)
+                return current;
+        }
+        int64_t deadline = timeoutMs < 0 ? -1 : monotonic_nanoseconds() + (int64_t) timeoutMs * 1000000;
+        while (true) {
+            uint32_t current = PENDING;
+            // announce that we are going to sleep, so that complete() wakes us up.
+            if (!state.compare_exchange_strong(current, WAITING, std::memory_order_acq_rel) && current != WAITING)
+                return current; // COMPLETED or FAILED
+            int64_t remaining = -1;
+            if (deadline >= 0) {
+                remaining = deadline - monotonic_nanoseconds();
+                if (remaining <= 0) {
+                    current = WAITING;
+                    if (state.compare_exchange_strong(current, ABANDONED, std::memory_order_acq_rel))
+                        return ABANDONED;
+                    return current; // completed just now
+                }
+            }
+            sleep_on(&state, WAITING, remaining);
+        }
+    }
+
     TypedAAPXS::~TypedAAPXS() {
         detachAllPending("AAPXS owner destroyed");
         unregisterForAbort();
+        if (sync_slots) {
+            for (auto& slot : sync_slots->slots)
+                slot.detach();
+            for (auto& slot : sync_slots->slots)
+                if (slot.isAbandoned()) {
+                    // the transport may still complete it; leave the slots alive.
+                    (void) sync_slots.release();
+                    break;
+                }
+        }
     }
 
     void TypedAAPXS::registerForAbort() {
@@ -1,6 +1,7 @@
 
 
 #include "aap/core/AAPXSMidi2InitiatorSession.h"
+#include <algorithm>
 #include <cstdlib>
 #include "aap/core/aap_midi2_helper.h"
 #include "aap/ext/midi.h"
@@ -18,7 +19,15 @@ aap::AAPXSMidi2InitiatorSession::AAPXSMidi2InitiatorSession(int32_t midiBufferSi
                                           aapxs_rt_midi_buffer,
                                           aapxs_rt_conversion_helper_buffer,
                                           AAP_MIDI2_AAPXS_DATA_MAX_SIZE);
-    memset(pending_callbacks, 0, sizeof(CallbackUnit) * MAX_PENDING_CALLBACKS);
+    memset(pending_callbacks, 0, sizeof(pending_callbacks));
+    for (auto& head : timer_wheel)
+        head = -1;
+    for (auto& head : request_buckets)
+        head = -1;
+    for (int16_t i = AAPXS_PENDING_CALLBACK_SLOTS - 1; i >= 0; i--) {
+        pending_callbacks[i].bucket_next = free_slots;
+        free_slots = i;
+    }
 }
 
 aap::AAPXSMidi2InitiatorSession::~AAPXSMidi2InitiatorSession() {
@@ -38,7 +47,18 @@ void aap::AAPXSMidi2InitiatorSession::addSession(
         void* data,
         int32_t dataSize,
         int32_t opcode) {
-    size_t size = aap_midi2_generate_aapxs_sysex8((uint32_t*) aapxs_rt_midi_buffer,
+    size_t size = compact_frames && urid != 0 ?
+                  aap_midi2_generate_aapxs_sysex8_compact((uint32_t*) aapxs_rt_midi_buffer,
+                                                          midi_buffer_size / sizeof(int32_t),
+                                                          (uint8_t*) aapxs_rt_conversion_helper_buffer,
+                                                          midi_buffer_size,
+                                                          group,
+                                                          requestId,
+                                                          urid,
+                                                          opcode,
+                                                          (uint8_t*) data,
+                                                          dataSize) :
+                  aap_midi2_generate_aapxs_sysex8((uint32_t*) aapxs_rt_midi_buffer,
                                                   midi_buffer_size / sizeof(int32_t),
                                                   (uint8_t*) aapxs_rt_conversion_helper_buffer,
                                                   midi_buffer_size,
@@ -52,9 +72,62 @@ void aap::AAPXSMidi2InitiatorSession::addSession(
     addMidi2Event(this, addMidi2EventUserData, size);
 }
 
-void aap::AAPXSMidi2InitiatorSession::addSession(add_midi2_event_func addMidi2Event,
+int16_t aap::AAPXSMidi2InitiatorSession::acquireSlot(uint32_t requestId) {
+    // Request IDs come from a serial shared with other sessions and extensions, so the bucket
+    // may hold an unrelated request already; it is chained then.
+    auto slot = free_slots;
+    if (slot < 0)
+        return -1;
+    auto& unit = pending_callbacks[slot];
+    free_slots = unit.bucket_next;
+    auto& head = request_buckets[requestId & (AAPXS_PENDING_CALLBACK_SLOTS - 1)];
+    unit.bucket_next = head;
+    head = slot;
+    return slot;
+}
+
+int16_t aap::AAPXSMidi2InitiatorSession::findPendingSlot(uint32_t requestId) {
+    for (auto slot = request_buckets[requestId & (AAPXS_PENDING_CALLBACK_SLOTS - 1)]; slot >= 0;
+         slot = pending_callbacks[slot].bucket_next)
+        if (pending_callbacks[slot].request_id == requestId)
+            return slot;
+    return -1;
+}
+
+void aap::AAPXSMidi2InitiatorSession::releaseSlot(int16_t slot) {
+    auto& unit = pending_callbacks[slot];
+    auto* link = &request_buckets[unit.request_id & (AAPXS_PENDING_CALLBACK_SLOTS - 1)];
+    while (*link != slot)
+        link = &pending_callbacks[*link].bucket_next;
+    *link = unit.bucket_next;
+    memset(&unit, 0, sizeof(CallbackUnit));
+    unit.bucket_next = free_slots;
+    free_slots = slot;
+}
+
+bool aap::AAPXSMidi2InitiatorSession::addSession(add_midi2_event_func addMidi2Event,
                                                  void* addMidi2EventUserData,
                                                  AAPXSRequestContext *request) {
+    // reserve the pending callback slot first, so that a request whose reply could not be
+    // dispatched is never sent.
+    int16_t slot = -1;
+    if (request->callback) {
+        slot = acquireSlot(request->request_id);
+        if (slot < 0) {
+            aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG,
+                         "AAPXSMidi2InitiatorSession reached max pending callbacks. Request %d is not sent.",
+                         request->request_id);
+            return false;
+        }
+        uint64_t timeoutFrames = (uint64_t) request_timeout_ms * sample_rate / 1000;
+        pending_callbacks[slot] = CallbackUnit{request->request_id, request->callback,
+                                               request->callback_user_data,
+                                               request->error_callback,
+                                               (current_frame + timeoutFrames) / AAPXS_TIMER_WHEEL_TICK_FRAMES + 1,
+                                               -1, -1, pending_callbacks[slot].bucket_next, true};
+        linkTimer(slot);
+    }
+
     int32_t group = 0; // will we have to give special semantics on it?
     addSession(addMidi2Event, addMidi2EventUserData,
                group,
@@ -64,40 +137,52 @@ void aap::AAPXSMidi2InitiatorSession::addSession(add_midi2_event_func addMidi2Ev
                request->serialization->data,
                request->serialization->data_size,
                request->opcode);
-    // store its callback to the pending callbacks
-    if (request->callback) {
-        size_t i = 0;
-        auto cbu = CallbackUnit{request->request_id, request->callback,
-                                            request->callback_user_data,
-                                            request->error_callback,
-                                            std::chrono::steady_clock::now() +
-                                                std::chrono::milliseconds(request_timeout_ms)};
-        for (; i < MAX_PENDING_CALLBACKS; i++) {
-            if (pending_callbacks[i].request_id == 0) {
-                pending_callbacks[i] = cbu;
-                break;
-            }
-        }
-        if (i == MAX_PENDING_CALLBACKS) {
-            aap::a_log(AAP_LOG_LEVEL_ERROR, LOG_TAG, "AAPXSMidi2InitiatorSession reached max pending callbacks.");
-            AAP_ASSERT_FALSE; //
-        }
-    }
+    return true;
+}
+
+void aap::AAPXSMidi2InitiatorSession::linkTimer(int16_t slot) {
+    auto& unit = pending_callbacks[slot];
+    auto& head = timer_wheel[unit.deadline_tick % AAPXS_TIMER_WHEEL_SIZE];
+    unit.wheel_prev = -1;
+    unit.wheel_next = head;
+    if (head >= 0)
+        pending_callbacks[head].wheel_prev = slot;
+    head = slot;
 }
 
-void aap::AAPXSMidi2InitiatorSession::sweepTimeouts(void* pluginOrHost) {
-    auto now = std::chrono::steady_clock::now();
-    for (size_t i = 0; i < MAX_PENDING_CALLBACKS; i++) {
-        auto& unit = pending_callbacks[i];
-        if (unit.request_id == 0)
-            continue;
-        if (now < unit.deadline)
-            continue;
-        auto error_func = unit.error_func;
-        auto data = unit.data;
-        memset(&unit, 0, sizeof(CallbackUnit));
-        if (error_func)
-            error_func(data, pluginOrHost, "timeout");
+void aap::AAPXSMidi2InitiatorSession::unlinkTimer(int16_t slot) {
+    auto& unit = pending_callbacks[slot];
+    if (unit.wheel_prev >= 0)
+        pending_callbacks[unit.wheel_prev].wheel_next = unit.wheel_next;
+    else
+        timer_wheel[unit.deadline_tick % AAPXS_TIMER_WHEEL_SIZE] = unit.wheel_next;
+    if (unit.wheel_next >= 0)
+        pending_callbacks[unit.wheel_next].wheel_prev = unit.wheel_prev;
+    unit.wheel_prev = unit.wheel_next = -1;
+}
+
+void aap::AAPXSMidi2InitiatorSession::processTimeouts(int32_t frameCount, void* pluginOrHost) {
+    uint64_t previousTick = current_frame / AAPXS_TIMER_WHEEL_TICK_FRAMES;
+    current_frame += frameCount;
+    uint64_t currentTick = current_frame / AAPXS_TIMER_WHEEL_TICK_FRAMES;
+    // visit only the buckets for the ticks that have passed (at most one full round).
+    uint64_t ticks = std::min<uint64_t>(currentTick - previousTick, AAPXS_TIMER_WHEEL_SIZE);
+    for (uint64_t tick = currentTick - ticks + 1; tick <= currentTick; tick++) {
+        auto slot = timer_wheel[tick % AAPXS_TIMER_WHEEL_SIZE];
+        while (slot >= 0) {
+            auto& unit = pending_callbacks[slot];
+            auto next = unit.wheel_next;
+            // entries for later rounds share the bucket; leave them.
+            if (unit.deadline_tick <= currentTick) {
+                unlinkTimer(slot);
+                auto error_func = unit.error_func;
+                auto data = unit.data;
+                releaseSlot(slot);
+                if (error_func)
+                    error_func(data, pluginOrHost, "timeout");
+            }
+            slot = next;
+        }
     }
 }
 
@@ -110,19 +195,18 @@ void aap::AAPXSMidi2InitiatorSession::completeSession(void* buffer, void* plugin
             handle_reply(&aapxs_parse_context);
 
             // look for the corresponding pending callback
-            for (size_t i = 0; i < MAX_PENDING_CALLBACKS; i++) {
-                if (pending_callbacks[i].request_id == aapxs_parse_context.request_id) {
-                    pending_callbacks[i].func(pending_callbacks[i].data, pluginOrHost);
-                    memset(pending_callbacks + i, 0, sizeof(CallbackUnit));
-                    break;
-                }
+            auto slot = findPendingSlot(aapxs_parse_context.request_id);
+            if (slot >= 0) {
+                auto& unit = pending_callbacks[slot];
+                unlinkTimer(slot);
+                auto func = unit.func;
+                auto callbackData = unit.data;
+                releaseSlot(slot);
+                func(callbackData, pluginOrHost);
             }
         }
 
         // FIXME: should we remove those AAPXS SysEx8 from the UMP buffer?
         //  It is going to be extraneous to the host.
     }
-
-    // Detect and fail any requests whose reply never arrived within the timeout window.
-    sweepTimeouts(pluginOrHost);
 }
@@ -25,6 +25,10 @@ void aap::AAPXSMidi2RecipientSession::process(void* buffer) {
     CMIDI2_UMP_SEQUENCE_FOREACH(data, mbh->length, iter) {
         auto umpSize = mbh->length - ((uint8_t*) iter - (uint8_t*) data);
         if (aap_midi2_parse_aapxs_sysex8(&aapxs_parse_context, iter, umpSize)) {
+            // The initiator sends compact frames only once it knows we understand them,
+            // so we can reply in the same format.
+            if (aapxs_parse_context.compact)
+                compact_frames = true;
             call_extension(&aapxs_parse_context);
 
             auto ump = (cmidi2_ump*) iter;
@@ -51,7 +55,18 @@ void aap::AAPXSMidi2RecipientSession::addReply(
         void* data,
         int32_t dataSize,
         int32_t opcode) {
-    size_t size = aap_midi2_generate_aapxs_sysex8((uint32_t*) midi2_aapxs_data_buffer,
+    size_t size = compact_frames && extensionUrid != 0 ?
+                  aap_midi2_generate_aapxs_sysex8_compact((uint32_t*) midi2_aapxs_data_buffer,
+                                                          AAP_MIDI2_AAPXS_DATA_MAX_SIZE / sizeof(int32_t),
+                                                          (uint8_t*) midi2_aapxs_conversion_helper_buffer,
+                                                          AAP_MIDI2_AAPXS_DATA_MAX_SIZE,
+                                                          group,
+                                                          requestId,
+                                                          extensionUrid,
+                                                          opcode,
+                                                          (uint8_t*) data,
+                                                          dataSize) :
+                  aap_midi2_generate_aapxs_sysex8((uint32_t*) midi2_aapxs_data_buffer,
                                                   AAP_MIDI2_AAPXS_DATA_MAX_SIZE / sizeof(int32_t),
                                                   (uint8_t*) midi2_aapxs_conversion_helper_buffer,
                                                   AAP_MIDI2_AAPXS_DATA_MAX_SIZE,
@@ -1,60 +1,12 @@
 #include "aap/core/host/shared-memory-store.h"
 #include "aap/core/host/plugin-instance.h"
 #include "plugin-parameter-state.h"
-#include <unordered_map>
 #include <vector>
 
 #define LOG_TAG "AAP.Local.Instance"
 
-namespace {
-struct GuiListenerMidiBuffer {
-    explicit GuiListenerMidiBuffer(int32_t capacityInBytes) :
-            capacity(capacityInBytes > 0 ? capacityInBytes : 0),
-            data(capacity > 0 ? static_cast<size_t>(capacity) : 0) {}
-
-    aap::NanoSleepLock mutex{};
-    int32_t capacity{0};
-    std::vector<uint8_t> data;
-    int32_t length{0};
-};
-
-std::mutex gui_listener_registry_mutex;
-std::unordered_map<aap::LocalPluginInstance*, std::unique_ptr<GuiListenerMidiBuffer>> gui_listener_registry;
-
-GuiListenerMidiBuffer* getGuiListenerMidiBuffer(aap::LocalPluginInstance* instance) {
-    const std::lock_guard<std::mutex> lock{gui_listener_registry_mutex};
-    auto it = gui_listener_registry.find(instance);
-    return it != gui_listener_registry.end() ? it->second.get() : nullptr;
-}
-
-void appendGuiListenerMidiBuffer(aap::LocalPluginInstance* instance, const void* input, int32_t size) {
-    auto* buffer = getGuiListenerMidiBuffer(instance);
-    if (!buffer || !input || size <= 0)
-        return;
-    const std::lock_guard<aap::NanoSleepLock> lock{buffer->mutex};
-    if (buffer->length + size > buffer->capacity)
-        return;
-    memcpy(buffer->data.data() + buffer->length, input, size);
-    buffer->length += size;
-}
-}
-
 int32_t readLocalGuiListenerMidi2Output(aap::LocalPluginInstance* instance, void* output, int32_t size) {
-    auto* buffer = getGuiListenerMidiBuffer(instance);
-    if (!buffer || !output || size <= 0)
-        return 0;
-    if (std::unique_lock<aap::NanoSleepLock> tryLock(buffer->mutex, std::try_to_lock); tryLock.owns_lock()) {
-        auto readSize = std::min(buffer->length, size);
-        if (readSize <= 0)
-            return 0;
-        memcpy(output, buffer->data.data(), readSize);
-        auto remaining = buffer->length - readSize;
-        if (remaining > 0)
-            memmove(buffer->data.data(), buffer->data.data() + readSize, remaining);
-        buffer->length = remaining;
-        return readSize;
-    }
-    return 0;
+    return instance ? instance->getGuiListenerMidiBuffer().read(output, size) : 0;
 }
 
 void aapxsProcessorAddEventUmpOutput(aap::AAPXSMidi2RecipientSession* processor, void* context, int32_t messageSize) {
@@ -73,16 +25,14 @@ aap::LocalPluginInstance::LocalPluginInstance(
           host(host),
           aapxs_host_session(eventMidi2InputBufferSize),
           feature_registry(new xs::AAPXSDefinitionServiceRegistry(aapxsRegistry)),
-          aapxs_dispatcher(aapxsRegistry)
+          aapxs_dispatcher(aapxsRegistry),
+          gui_listener_midi_buffer(eventMidi2InputBufferSize)
           {
+    process_trace.setSectionNamePrefix("AAP::LocalPluginInstance_process");
     shared_memory_store = new aap::ServicePluginSharedMemoryStore();
     instance_id = instanceId;
     aapxs_out_midi2_buffer = calloc(1, event_midi2_buffer_size);
     aapxs_out_merge_buffer = calloc(1, event_midi2_buffer_size);
-    {
-        const std::lock_guard<std::mutex> lock{gui_listener_registry_mutex};
-        gui_listener_registry[this] = std::make_unique<GuiListenerMidiBuffer>(event_midi2_buffer_size);
-    }
 
     aapxs_midi2_in_session.setExtensionCallback([&](aap_midi2_aapxs_parse_context* context) {
         handleAAPXSInput(context);
@@ -90,12 +40,15 @@ aap::LocalPluginInstance::LocalPluginInstance(
 }
 
 aap::LocalPluginInstance::~LocalPluginInstance() {
+    // the state extension keeps an unfinished chunked transfer per instance (keyed by its serialization).
+    auto stateDefinition = feature_registry->items()->getByUri(AAP_STATE_EXTENSION_URI);
+    auto stateSerialization = aapxs_dispatcher.getSerialization(AAP_STATE_EXTENSION_URI);
+    if (stateDefinition && stateDefinition->aapxs_context && stateSerialization)
+        ((xs::AAPXSDefinition_State*) stateDefinition->aapxs_context)->releaseStagedState(stateSerialization);
     if (aapxs_out_midi2_buffer)
         free(aapxs_out_midi2_buffer);
     if (aapxs_out_merge_buffer)
         free(aapxs_out_merge_buffer);
-    const std::lock_guard<std::mutex> lock{gui_listener_registry_mutex};
-    gui_listener_registry.erase(this);
 }
 
 AndroidAudioPluginHost* aap::LocalPluginInstance::getHostFacadeForCompleteInstantiation() {
@@ -162,44 +115,42 @@ void aap::LocalPluginInstance::addEventUmpOutput(void *input, int32_t size) {
     aapxs_out_midi2_buffer_offset += size;
 }
 
-const char* local_trace_name = "AAP::LocalPluginInstance_process";
 void aap::LocalPluginInstance::process(int32_t frameCount, int32_t timeoutInNanoseconds) {
     process_requested_to_host = false;
 
-    struct timespec timeSpecBegin{}, timeSpecEnd{};
-#if ANDROID
-    if (ATrace_isEnabled()) {
-        ATrace_beginSection(local_trace_name);
-        clock_gettime(CLOCK_REALTIME, &timeSpecBegin);
-    }
-#endif
-
-    if (std::unique_lock<NanoSleepLock> tryLock(ump_sequence_merger_mutex, std::try_to_lock); tryLock.owns_lock()) {
-        // merge input from native UI into the host's MIDI inputs
-        memset(event_midi2_merge_buffer, 0, event_midi2_buffer_size);
-        merge_ump_sequences(AAP_PORT_DIRECTION_INPUT, event_midi2_merge_buffer, event_midi2_buffer_size,
-                            event_midi2_buffer, event_midi2_buffer_offset,
-                            getAudioPluginBuffer(), this);
-        memset(event_midi2_buffer, 0, event_midi2_buffer_offset);
-        event_midi2_buffer_offset = 0;
-    }
+    process_trace.beginCycle();
+    ProcessTraceScope totalScope{process_trace, PROCESS_TRACE_STAGE_TOTAL};
 
-    // retrieve AAPXS SysEx8 requests and start extension calls, if any.
-    // (might be synchronously done)
     AAPMidiBufferHeader* mbh{nullptr};
-    for (auto i = 0, n = getNumPorts(); i < n; i++) {
-        auto port = getPort(i);
-        if (port->getContentType() != AAP_CONTENT_TYPE_MIDI2 ||
-            port->getPortDirection() != AAP_PORT_DIRECTION_INPUT)
-            continue;
-        auto aapBuffer = getAudioPluginBuffer();
-        void *data = aapBuffer->get_buffer(aapBuffer, i);
-        aapxs_midi2_in_session.process(data);
-        mbh = (AAPMidiBufferHeader*) data;
+    {
+        ProcessTraceScope scope{process_trace, PROCESS_TRACE_STAGE_AAPXS_INPUT_MERGE};
+        if (std::unique_lock<NanoSleepLock> tryLock(ump_sequence_merger_mutex, std::try_to_lock); tryLock.owns_lock()) {
+            // merge input from native UI into the host's MIDI inputs
+            memset(event_midi2_merge_buffer, 0, event_midi2_buffer_size);
+            merge_ump_sequences(AAP_PORT_DIRECTION_INPUT, event_midi2_merge_buffer, event_midi2_buffer_size,
+                                event_midi2_buffer, event_midi2_buffer_offset,
+                                getAudioPluginBuffer(), this);
+            memset(event_midi2_buffer, 0, event_midi2_buffer_offset);
+            event_midi2_buffer_offset = 0;
+        }
+
+        // retrieve AAPXS SysEx8 requests and start extension calls, if any.
+        // (might be synchronously done)
+        for (auto i = 0, n = getNumPorts(); i < n; i++) {
+            auto port = getPort(i);
+            if (port->getContentType() != AAP_CONTENT_TYPE_MIDI2 ||
+                port->getPortDirection() != AAP_PORT_DIRECTION_INPUT)
+                continue;
+            auto aapBuffer = getAudioPluginBuffer();
+            void *data = aapBuffer->get_buffer(aapBuffer, i);
+            aapxs_midi2_in_session.process(data);
+            mbh = (AAPMidiBufferHeader*) data;
+        }
     }
 
     {
         const std::lock_guard<NanoSleepLock> pluginCallLock{plugin_call_mutex};
+        ProcessTraceScope scope{process_trace, PROCESS_TRACE_STAGE_PLUGIN_PROCESS};
         plugin->process(plugin, getAudioPluginBuffer(), frameCount, timeoutInNanoseconds);
     }
 
@@ -222,19 +173,13 @@ void aap::LocalPluginInstance::process(int32_t frameCount, int32_t timeoutInNano
             port->getPortDirection() != AAP_PORT_DIRECTION_OUTPUT)
             continue;
         auto* data = (AAPMidiBufferHeader*) aapBuffer->get_buffer(aapBuffer, i);
-        internal::updateParameterValueCacheFromOutputBuffer(*this, data);
+        {
+            ProcessTraceScope scope{process_trace, PROCESS_TRACE_STAGE_PARAMETER_CACHE_UPDATE};
+            internal::updateParameterValueCacheFromOutputBuffer(*this, data);
+        }
         if (data && data->length > 0)
-            appendGuiListenerMidiBuffer(this, data + 1, static_cast<int32_t>(data->length));
-    }
-
-#if ANDROID
-    if (ATrace_isEnabled()) {
-        clock_gettime(CLOCK_REALTIME, &timeSpecEnd);
-        ATrace_setCounter(local_trace_name,
-                          (timeSpecEnd.tv_sec - timeSpecBegin.tv_sec) * 1000000000 + timeSpecEnd.tv_nsec - timeSpecBegin.tv_nsec);
-        ATrace_endSection();
+            gui_listener_midi_buffer.write(data + 1, static_cast<int32_t>(data->length));
     }
-#endif
 }
 
 // ---- AAPXS v2
@@ -309,12 +254,19 @@ void aap::LocalPluginInstance::controlExtension(uint8_t urid, const std::string
     if (urid == 0 && uri == AAP_URID_EXTENSION_URI) {
         auto instance = getAAPXSDispatcher().getPluginAAPXSByUri(uri.c_str());
         auto parsedUrid = *(uint8_t*) instance->serialization->data;
-        auto len = *(int32_t*) (uint8_t*) instance->serialization->data + 1;
+        auto len = *(int32_t*) ((uint8_t*) instance->serialization->data + 1);
         auto s = (char*) calloc(len + 1, 1);
         strncpy(s, (char*) instance->serialization->data + 1 + sizeof(int32_t), len);
         s[len] = 0;
         urid_mapping.forceAdd(parsedUrid, s);
         free(s);
+
+        // tell the client that it can send compact AAPXS SysEx8 for mapped extensions.
+        size_t flagsOffset = 1 + sizeof(int32_t) + len;
+        if (flagsOffset + sizeof(int32_t) <= instance->serialization->data_capacity) {
+            *(int32_t*) ((uint8_t*) instance->serialization->data + flagsOffset) = AAP_URID_MAP_REPLY_COMPACT_AAPXS_SYSEX8;
+            instance->serialization->data_size = std::max(instance->serialization->data_size, flagsOffset + sizeof(int32_t));
+        }
     } // ... and the mapping could also be used by the plugin, so go on as well.
 
 
@@ -338,6 +290,8 @@ void aap::LocalPluginInstance::controlExtension(uint8_t urid, const std::string
 }
 
 void aap::LocalPluginInstance::handleAAPXSInput(aap_midi2_aapxs_parse_context *context) {
+    if (context->compact && !resolveCompactAAPXSUri(feature_registry.get()->items(), context))
+        return;
     if (context->opcode >= 0) {
         // plugin request
         auto& dispatcher = getAAPXSDispatcher();
@@ -64,6 +64,8 @@ aap::RemotePluginInstance::RemotePluginInstance(PluginClient* client,
           aapxs_dispatcher(aapxsRegistry),
           standards(std::make_unique<xs::ClientStandardExtensions>())
           {
+    process_trace.setSectionNamePrefix("AAP::RemotePluginInstance_process");
+    silence_bypass.setEnabled(true);
     shared_memory_store = new ClientPluginSharedMemoryStore();
 
     aapxs_session.setReplyHandler([&](aap_midi2_aapxs_parse_context* context) {
@@ -110,6 +112,7 @@ void aap::RemotePluginInstance::prepare(int frameCount, int32_t sampleRate) {
     }
 
     sample_rate = sampleRate;
+    aapxs_session.setSampleRate(sampleRate);
     auto numPorts = getNumPorts();
     auto shm = dynamic_cast<aap::ClientPluginSharedMemoryStore*>(getSharedMemoryStore());
     auto code = shm->allocateClientBuffer(numPorts, frameCount, *this, DEFAULT_CONTROL_BUFFER_SIZE);
@@ -118,6 +121,10 @@ void aap::RemotePluginInstance::prepare(int frameCount, int32_t sampleRate) {
     }
 
     plugin->prepare(plugin, sample_rate, getAudioPluginBuffer());
+    // the audio thread may already be running (e.g. AAPMidiProcessor streams before activate()),
+    // so the bypass is configured here, before it is ever used at ACTIVE state.
+    if (silence_bypass.isEnabled())
+        silence_bypass.configure(this, getTailTimeInMilliseconds());
     instantiation_state = PLUGIN_INSTANTIATION_STATE_INACTIVE;
 }
 
@@ -211,17 +218,12 @@ void aap::RemotePluginInstance::configureRemoteNativeView(
 }
 
 void aap::RemotePluginInstance::process(int32_t frameCount, int32_t timeoutInNanoseconds) {
-    const char* remote_trace_name = "AAP::RemotePluginInstance_process";
-    struct timespec timeSpecBegin{}, timeSpecEnd{};
-#if ANDROID
-    if (ATrace_isEnabled()) {
-        ATrace_beginSection(remote_trace_name);
-        clock_gettime(CLOCK_REALTIME, &timeSpecBegin);
-    }
-#endif
+    process_trace.beginCycle();
+    ProcessTraceScope totalScope{process_trace, PROCESS_TRACE_STAGE_TOTAL};
 
     // merge input from AAPXS SysEx8 into the host's MIDI inputs
     if (std::unique_lock<NanoSleepLock> tryLock(ump_sequence_merger_mutex, std::try_to_lock); tryLock.owns_lock()) {
+        ProcessTraceScope scope{process_trace, PROCESS_TRACE_STAGE_AAPXS_INPUT_MERGE};
         merge_ump_sequences(AAP_PORT_DIRECTION_INPUT, event_midi2_merge_buffer, event_midi2_buffer_size,
                             event_midi2_buffer, event_midi2_buffer_offset,
                             getAudioPluginBuffer(), this);
@@ -229,8 +231,19 @@ void aap::RemotePluginInstance::process(int32_t frameCount, int32_t timeoutInNan
         event_midi2_buffer_offset = 0;
     }
 
+    // skip the plugin while it has nothing to render. Pending AAPXS requests are MIDI2 inputs,
+    // so they wake it up too.
+    bool bypassable = instantiation_state == PLUGIN_INSTANTIATION_STATE_ACTIVE;
+    if (bypassable && silence_bypass.beginBlock(getAudioPluginBuffer(), frameCount)) {
+        aapxs_session.processTimeouts(frameCount, plugin);
+        return;
+    }
+
     // now we can pass the input to the plugin.
-    plugin->process(plugin, getAudioPluginBuffer(), frameCount, timeoutInNanoseconds);
+    {
+        ProcessTraceScope scope{process_trace, PROCESS_TRACE_STAGE_PLUGIN_PROCESS};
+        plugin->process(plugin, getAudioPluginBuffer(), frameCount, timeoutInNanoseconds);
+    }
 
     // retrieve AAPXS SysEx8 replies if any.
     for (auto i = 0, n = getNumPorts(); i < n; i++) {
@@ -241,19 +254,22 @@ void aap::RemotePluginInstance::process(int32_t frameCount, int32_t timeoutInNan
         auto aapBuffer = getAudioPluginBuffer();
         void* data = aapBuffer->get_buffer(aapBuffer, i);
         // MIDI2 output buffer has to be processed by this `processReply()` in realtime manner.
-        aapxs_session.completeSession(data, plugin);
-        filterOutAAPXSReplies(data);
-        internal::updateParameterValueCacheFromOutputBuffer(*this, data);
-    }
-
-#if ANDROID
-    if (ATrace_isEnabled()) {
-        clock_gettime(CLOCK_REALTIME, &timeSpecEnd);
-        ATrace_setCounter(remote_trace_name,
-                          (timeSpecEnd.tv_sec - timeSpecBegin.tv_sec) * 1000000000 + timeSpecEnd.tv_nsec - timeSpecBegin.tv_nsec);
-        ATrace_endSection();
+        {
+            ProcessTraceScope scope{process_trace, PROCESS_TRACE_STAGE_COMPLETE_SESSION};
+            aapxs_session.completeSession(data, plugin);
+        }
+        {
+            ProcessTraceScope scope{process_trace, PROCESS_TRACE_STAGE_FILTER_AAPXS_REPLIES};
+            filterOutAAPXSReplies(data);
+        }
+        {
+            ProcessTraceScope scope{process_trace, PROCESS_TRACE_STAGE_PARAMETER_CACHE_UPDATE};
+            internal::updateParameterValueCacheFromOutputBuffer(*this, data);
+        }
     }
-#endif
+    if (bypassable)
+        silence_bypass.endBlock(getAudioPluginBuffer(), frameCount);
+    aapxs_session.processTimeouts(frameCount, plugin);
 }
 
 void *
@@ -284,19 +300,27 @@ aap::RemotePluginInstance::internalGetHostExtension(uint8_t urid, const char *ur
 //----
 
 aap::RemotePluginInstance::RemotePluginNativeUIController::RemotePluginNativeUIController(RemotePluginInstance* owner) {
+#if ANDROID
     handle = AAPJniFacade::getInstance()->createSurfaceControl();
+#endif
 }
 
 aap::RemotePluginInstance::RemotePluginNativeUIController::~RemotePluginNativeUIController() {
+#if ANDROID
     AAPJniFacade::getInstance()->disposeSurfaceControl(handle);
+#endif
 }
 
 void aap::RemotePluginInstance::RemotePluginNativeUIController::show() {
+#if ANDROID
     AAPJniFacade::getInstance()->showSurfaceControlView(handle);
+#endif
 }
 
 void aap::RemotePluginInstance::RemotePluginNativeUIController::hide() {
+#if ANDROID
     AAPJniFacade::getInstance()->hideSurfaceControlView(handle);
+#endif
 }
 
 
@@ -357,9 +381,8 @@ aap::RemotePluginInstance::sendPluginAAPXSRequest(AAPXSRequestContext* request)
     if (useSysEx8) {
         // request->serialization already contains binary data here, so we retrieve data from there.
         // This is an asynchronous function, so we do not wait for the result, and it has no awaiter (hence std::nullopt)
-        aapxs_session.addSession(aapxsSessionAddEventUmpInput,
-                                 this, request);
-        return true;
+        return aapxs_session.addSession(aapxsSessionAddEventUmpInput,
+                                        this, request);
     } else {
         // Here we have to get a native plugin instance and send extension message.
         // It is kind af annoying because we used to implement Binder-specific part only within the
@@ -432,6 +455,8 @@ void aap::RemotePluginInstance::setupAAPXS() {
 void aap::RemotePluginInstance::handleAAPXSReply(aap_midi2_aapxs_parse_context *context) {
     auto& dispatcher = getAAPXSDispatcher();
     auto registry = feature_registry->items();
+    if (context->compact && !resolveCompactAAPXSUri(registry, context))
+        return;
     auto aapxs = context->urid != 0 ? registry->getByUrid(context->urid) : registry->getByUri(context->uri);
     if (aapxs) {
         if (context->opcode >= 0) {
@@ -465,10 +490,27 @@ void aap::RemotePluginInstance::setupUrids() {
     if (!uridExt)
         return; // we cannot use URID, bear with any relevant potential latency!
 
+    // The service host puts AAP_URID_MAP_REPLY_COMPACT_AAPXS_SYSEX8 after the URI in the reply
+    // if it understands compact AAPXS SysEx8. We clear the slot before each request so that
+    // we do not mistake our own leftover for it.
+    auto serialization = getAAPXSDispatcher().getPluginAAPXSByUri(AAP_URID_EXTENSION_URI)->serialization;
+    bool compact = true;
+    bool mapped = false;
     auto mapping = getAAPXSRegistry()->items()->getUridMapping();
-    for (uint8_t urid : *mapping)
-        if (urid != 0)
-            uridExt->map(uridExt, plugin, urid, mapping->getUri(urid));
+    for (uint8_t urid : *mapping) {
+        if (urid == 0)
+            continue;
+        auto uri = mapping->getUri(urid);
+        size_t flagsOffset = 1 + sizeof(int32_t) + strlen(uri);
+        bool flagsAvailable = flagsOffset + sizeof(int32_t) <= serialization->data_capacity;
+        if (flagsAvailable)
+            *(int32_t*) ((uint8_t*) serialization->data + flagsOffset) = 0;
+        uridExt->map(uridExt, plugin, urid, uri);
+        mapped = true;
+        compact &= flagsAvailable &&
+                *(int32_t*) ((uint8_t*) serialization->data + flagsOffset) == AAP_URID_MAP_REPLY_COMPACT_AAPXS_SYSEX8;
+    }
+    aapxs_session.setCompactFramesEnabled(mapped && compact);
 }
 
 void aap::RemotePluginInstance::setupStandardExtensions() {
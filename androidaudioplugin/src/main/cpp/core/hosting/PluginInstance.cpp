@@ -6,35 +6,13 @@
 #include <algorithm>
 #include <cstring>
 #include <mutex>
-#include <unordered_map>
 #include <vector>
 #include "../include_cmidi2.h"
 
 #define LOG_TAG "AAP.Instance"
 
 namespace {
-struct PluginParameterState {
-    aap::NanoSleepLock mutex{};
-    std::vector<double> values{};
-    std::unordered_map<int32_t, int32_t> id_to_index{};
-};
-
-std::mutex parameter_state_registry_mutex;
 std::mutex parameter_layout_scan_mutex;
-std::unordered_map<aap::PluginInstance*, std::unique_ptr<PluginParameterState>> parameter_state_registry;
-
-PluginParameterState* get_parameter_state(aap::PluginInstance* instance, bool create = true) {
-    const std::lock_guard<std::mutex> lock{parameter_state_registry_mutex};
-    auto it = parameter_state_registry.find(instance);
-    if (it != parameter_state_registry.end())
-        return it->second.get();
-    if (!create)
-        return nullptr;
-    auto state = std::make_unique<PluginParameterState>();
-    auto* ret = state.get();
-    parameter_state_registry[instance] = std::move(state);
-    return ret;
-}
 
 std::string fixed_string(const char* s, size_t capacity) {
     if (!s || capacity == 0)
@@ -50,6 +28,7 @@ aap::PluginInstance::PluginInstance(const PluginInformation* pluginInformation,
           instantiation_state(PLUGIN_INSTANTIATION_STATE_INITIAL),
           plugin(nullptr),
           pluginInfo(pluginInformation),
+          parameter_values(std::make_unique<internal::ParameterValueTable>()),
         event_midi2_buffer_size(eventMidi2InputBufferSize) {
     if (!pluginInformation)
         AAP_ASSERT_FALSE; // should not happen
@@ -63,16 +42,6 @@ aap::PluginInstance::PluginInstance(const PluginInformation* pluginInformation,
     }
 }
 
-static void rebuild_parameter_id_index(aap::PluginInstance* instance,
-                                       std::unordered_map<int32_t, int32_t>& idToIndex) {
-    idToIndex.clear();
-    for (int32_t i = 0, n = instance->getNumParameters(); i < n; ++i) {
-        auto* parameter = instance->getParameter(i);
-        if (parameter)
-            idToIndex[parameter->getId()] = i;
-    }
-}
-
 aap::PluginInstance::~PluginInstance() {
     instantiation_state = PLUGIN_INSTANTIATION_STATE_TERMINATED;
     if (plugin != nullptr)
@@ -83,7 +52,6 @@ aap::PluginInstance::~PluginInstance() {
         free(event_midi2_buffer);
     if (event_midi2_merge_buffer)
         free(event_midi2_merge_buffer);
-    internal::cleanupParameterState(*this);
 }
 
 aap_buffer_t* aap::PluginInstance::getAudioPluginBuffer() {
@@ -195,6 +163,8 @@ void aap::PluginInstance::scanParametersAndBuildList() {
     auto& ext = getStandardExtensions();
     auto parameterCount = ext.getParameterCount();
     if (parameterCount == -1) { // explicitly indicates that the code is not going to return the parameter list.
+        // the value table still reflects the parameters from metadata.
+        internal::reindexParameterValues(*this);
         return;
     }
 
@@ -203,97 +173,104 @@ void aap::PluginInstance::scanParametersAndBuildList() {
     auto scannedParameters = std::make_unique<std::vector<ParameterInformation>>();
     scannedParameters->reserve(parameterCount);
 
-    for (auto i = 0; i < parameterCount; i++) {
-        auto para = ext.getParameter(i);
+    // Remote plugins can return the whole list in a few pages, instead of a round trip per item.
+    bool scanned = ext.getParameterDescriptors(parameterCount,
+            [&](const aap_parameter_info_t& para, const aap_parameter_enum_t* enums, int32_t numEnums) {
         ParameterInformation p{para.stable_id,
                                fixed_string(para.display_name, AAP_MAX_PARAMETER_NAME_CHARS),
                                para.min_value,
                                para.max_value,
                                para.default_value};
-        auto parameterId = para.stable_id;
-        for (auto e = 0, en = ext.getEnumerationCount(parameterId); e < en; e++) {
-            auto pe = ext.getEnumeration(parameterId, e);
-            ParameterInformation::Enumeration eDef{e, pe.value, fixed_string(pe.name, AAP_MAX_PARAMETER_ENUM_NAME)};
+        for (auto e = 0; e < numEnums; e++) {
+            ParameterInformation::Enumeration eDef{e, enums[e].value, fixed_string(enums[e].name, AAP_MAX_PARAMETER_ENUM_NAME)};
             p.addEnumeration(eDef);
         }
         scannedParameters->emplace_back(p);
+    });
+    if (!scanned) {
+        scannedParameters->clear();
+        for (auto i = 0; i < parameterCount; i++) {
+            auto para = ext.getParameter(i);
+            ParameterInformation p{para.stable_id,
+                                   fixed_string(para.display_name, AAP_MAX_PARAMETER_NAME_CHARS),
+                                   para.min_value,
+                                   para.max_value,
+                                   para.default_value};
+            auto parameterId = para.stable_id;
+            for (auto e = 0, en = ext.getEnumerationCount(parameterId); e < en; e++) {
+                auto pe = ext.getEnumeration(parameterId, e);
+                ParameterInformation::Enumeration eDef{e, pe.value, fixed_string(pe.name, AAP_MAX_PARAMETER_ENUM_NAME)};
+                p.addEnumeration(eDef);
+            }
+            scannedParameters->emplace_back(p);
+        }
     }
     cached_parameters = std::move(scannedParameters);
-}
 
-void aap::internal::cleanupParameterState(aap::PluginInstance& instance) {
-    const std::lock_guard<std::mutex> lock{parameter_state_registry_mutex};
-    parameter_state_registry.erase(&instance);
+    // The audio thread must never build the value table by itself, so publish it right here.
+    internal::reindexParameterValues(*this);
 }
 
 void aap::internal::reindexParameterValues(aap::PluginInstance& instance) {
-    // Rebuilds the id->index map and value vector from the *current* cached_parameters, preserving
-    // previously-known values by id. The caller must have already populated cached_parameters.
-    auto* state = get_parameter_state(&instance);
-    if (!state)
+    // Builds a new value table layout from the *current* parameter list, and publishes it for
+    // the audio thread. publish() preserves the previously-known values by id. (non-RT)
+    auto* table = instance.getParameterValueTable();
+    if (!table)
         return;
-    std::unordered_map<int32_t, double> previousValues;
-    previousValues.reserve(state->values.size());
-    for (auto& entry : state->id_to_index) {
-        auto index = entry.second;
-        if (index >= 0 && index < state->values.size())
-            previousValues[entry.first] = state->values[index];
-    }
-
-    rebuild_parameter_id_index(&instance, state->id_to_index);
 
-    std::vector<double> newValues;
-    newValues.reserve(instance.getNumParameters());
-    for (int32_t i = 0, n = instance.getNumParameters(); i < n; ++i) {
+    auto count = instance.getNumParameters();
+    auto layout = std::make_unique<ParameterValueTable::Layout>(count);
+    std::vector<std::pair<int32_t, int32_t>> idToIndex;
+    idToIndex.reserve(count);
+    for (int32_t i = 0; i < count; ++i) {
         auto* parameter = instance.getParameter(i);
-        auto it = previousValues.find(parameter->getId());
-        if (it != previousValues.end())
-            newValues.emplace_back(it->second);
-        else
-            newValues.emplace_back(parameter->getDefaultValue());
+        auto parameterId = parameter ? parameter->getId() : -1;
+        double value = parameter ? parameter->getDefaultValue() : 0.0;
+        layout->min_values[i] = parameter ? parameter->getMinimumValue() : 0.0;
+        layout->max_values[i] = parameter ? parameter->getMaximumValue() : 0.0;
+        layout->values[i].store(value, std::memory_order_relaxed);
+        idToIndex.emplace_back(parameterId, i);
+    }
+    std::sort(idToIndex.begin(), idToIndex.end());
+    for (int32_t i = 0; i < count; ++i) {
+        layout->sorted_ids[i] = idToIndex[i].first;
+        layout->sorted_indices[i] = idToIndex[i].second;
     }
 
-    const std::lock_guard<NanoSleepLock> lock{state->mutex};
-    state->values = std::move(newValues);
+    table->publish(std::move(layout));
 }
 
 void aap::internal::rebuildParameterIndexAndValues(aap::PluginInstance& instance) {
+    // scanParametersAndBuildList() also reindexes the value table.
     instance.scanParametersAndBuildList();
-    reindexParameterValues(instance);
-}
-
-bool aap::internal::updateCachedParameterValueById(aap::PluginInstance& instance, int32_t parameterId, double plainValue) {
-    auto* state = get_parameter_state(&instance, false);
-    if (!state)
-        return false;
-    auto it = state->id_to_index.find(parameterId);
-    if (it == state->id_to_index.end())
-        return false;
-    auto index = it->second;
-    if (index < 0 || index >= state->values.size())
-        return false;
-    state->values[index] = plainValue;
-    return true;
 }
 
 void aap::internal::updateParameterValueCacheFromOutputBuffer(aap::PluginInstance& instance, void* buffer) {
     if (!buffer)
         return;
-    auto* state = get_parameter_state(&instance);
-    if (!state)
+    auto* table = instance.getParameterValueTable();
+    if (!table)
         return;
-    if (std::unique_lock<NanoSleepLock> tryLock(state->mutex, std::try_to_lock); !tryLock.owns_lock())
+    // Not scanned yet. We do not build the table here, as it would allocate on the audio thread.
+    ParameterValueTable::LayoutReference reference{*table};
+    auto* layout = reference.get();
+    if (!layout || layout->count == 0)
         return;
 
-    if (state->id_to_index.empty())
-        rebuild_parameter_id_index(&instance, state->id_to_index);
-    if (state->values.empty()) {
-        state->values.reserve(instance.getNumParameters());
-        for (int32_t i = 0, n = instance.getNumParameters(); i < n; ++i) {
-            auto* parameter = instance.getParameter(i);
-            state->values.emplace_back(parameter ? parameter->getDefaultValue() : 0.0);
+    bool writing = false;
+    auto storeValue = [&](int32_t parameterId, uint32_t transportValue) {
+        auto index = layout->indexOf(parameterId);
+        if (index < 0)
+            return;
+        if (!writing) {
+            ParameterValueTable::beginWrite(layout);
+            writing = true;
         }
-    }
+        auto plainValue = aapParameterTransportUint32ToPlain(layout->min_values[index],
+                                                             layout->max_values[index],
+                                                             transportValue);
+        layout->values[index].store(plainValue, std::memory_order_relaxed);
+    };
 
     auto* mbh = (AAPMidiBufferHeader*) buffer;
     auto* data = (uint8_t*) (mbh + 1);
@@ -322,61 +299,39 @@ void aap::internal::updateParameterValueCacheFromOutputBuffer(aap::PluginInstanc
                     default:
                         break;
                 }
-                if (parameterId >= 0) {
-                    auto it = state->id_to_index.find(parameterId);
-                    if (it != state->id_to_index.end()) {
-                        auto index = it->second;
-                        if (index >= 0 && index < instance.getNumParameters()) {
-                            auto* parameter = instance.getParameter(index);
-                            auto plainValue = aapParameterTransportUint32ToPlain(
-                                    parameter->getMinimumValue(),
-                                    parameter->getMaximumValue(),
-                                    word1);
-                            updateCachedParameterValueById(instance, parameterId, plainValue);
-                        }
-                    }
-                }
+                if (parameterId >= 0)
+                    storeValue(parameterId, word1);
             }
         } else if (messageType == 5 && messageSize >= 16) {
             auto word0 = ump[0];
             auto word1 = ump[1];
             auto word2 = ump[2];
             auto word3 = ump[3];
-            if ((word0 & 0xFF) == 0x7E && (word1 >> 8) == 0x7F0000 && (word1 & 0x0F) == 0) {
-                auto parameterId = static_cast<int32_t>(word2 & 0xFFFF);
-                auto it = state->id_to_index.find(parameterId);
-                if (it != state->id_to_index.end()) {
-                    auto index = it->second;
-                    if (index >= 0 && index < instance.getNumParameters()) {
-                        auto* parameter = instance.getParameter(index);
-                        auto plainValue = aapParameterTransportUint32ToPlain(
-                                parameter->getMinimumValue(),
-                                parameter->getMaximumValue(),
-                                word3);
-                        updateCachedParameterValueById(instance, parameterId, plainValue);
-                    }
-                }
-            }
+            if ((word0 & 0xFF) == 0x7E && (word1 >> 8) == 0x7F0000 && (word1 & 0x0F) == 0)
+                storeValue(static_cast<int32_t>(word2 & 0xFFFF), word3);
         }
 
         offset += static_cast<uint32_t>(messageSize);
     }
 
+    if (writing)
+        ParameterValueTable::endWrite(layout);
 }
 
 double aap::internal::getParameterValue(aap::PluginInstance& instance, int32_t index) {
-    auto* state = get_parameter_state(&instance, false);
-    if (!state) {
-        auto* parameter = instance.getParameter(index);
-        return parameter ? parameter->getDefaultValue() : 0.0;
-    }
-    const std::lock_guard<NanoSleepLock> lock{state->mutex};
-    if (index >= 0 && index < state->values.size())
-        return state->values[index];
+    auto* table = instance.getParameterValueTable();
+    double value;
+    if (table && table->tryGetValue(index, value))
+        return value;
     auto* parameter = instance.getParameter(index);
     return parameter ? parameter->getDefaultValue() : 0.0;
 }
 
+int32_t aap::internal::snapshotParameterValues(aap::PluginInstance& instance, double* values, int32_t capacity) {
+    auto* table = instance.getParameterValueTable();
+    return table ? table->snapshot(values, capacity) : 0;
+}
+
 void aap::internal::handleParameterLayoutChanged(aap::PluginInstance& instance) {
     // A plugin can notify a parameter-layout change from within its own instantiate()
     // (e.g. JUCE/Dexed populate parameters during construction), which arrives before
@@ -416,6 +371,97 @@ void aap::PluginInstance::deactivate() {
     instantiation_state = PLUGIN_INSTANTIATION_STATE_INACTIVE;
 }
 
+aap::OfflineRenderResult aap::PluginInstance::renderOffline(const OfflineRenderRequest& request) {
+    OfflineRenderResult result{};
+    if (instantiation_state != PLUGIN_INSTANTIATION_STATE_ACTIVE) {
+        aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "renderOffline() requires an active instance (state: %d)", instantiation_state);
+        return result;
+    }
+    auto buffer = getAudioPluginBuffer();
+    auto blockSize = buffer ? buffer->num_frames(buffer) : 0;
+    if (blockSize <= 0 || sample_rate <= 0) {
+        aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "renderOffline() requires a prepared instance");
+        return result;
+    }
+
+    // resolve the ports once; nothing is allocated in the render loop.
+    std::vector<int32_t> audioInputs{}, audioOutputs{};
+    int32_t midiInput = -1;
+    for (int32_t i = 0, n = getNumPorts(); i < n; i++) {
+        auto port = getPort(i);
+        if (port->getContentType() == AAP_CONTENT_TYPE_AUDIO)
+            (port->getPortDirection() == AAP_PORT_DIRECTION_INPUT ? audioInputs : audioOutputs).emplace_back(i);
+        // the same port that merge_ump_sequences() delivers the event inputs to.
+        else if (port->getContentType() == AAP_CONTENT_TYPE_MIDI2 &&
+                 port->getPortDirection() == AAP_PORT_DIRECTION_INPUT && midiInput < 0)
+            midiInput = i;
+    }
+    auto framesIn = [&](int32_t port, int32_t frameCount) {
+        return std::min(frameCount, buffer->get_buffer_size(buffer, port) / (int32_t) sizeof(float));
+    };
+    // JR Timestamp ticks (1/31250 seconds) from the beginning of the block.
+    auto ticksAt = [&](int64_t frameInBlock) {
+        return frameInBlock * 31250 / sample_rate;
+    };
+
+    int32_t nextEvent = 0;
+    auto begin = ProcessTrace::nowNanoseconds();
+    for (int64_t position = 0; position < request.total_frames; position += blockSize) {
+        auto frameCount = (int32_t) std::min<int64_t>(blockSize, request.total_frames - position);
+
+        for (size_t i = 0; i < audioInputs.size(); i++) {
+            auto dst = (float*) buffer->get_buffer(buffer, audioInputs[i]);
+            auto frames = framesIn(audioInputs[i], frameCount);
+            if (request.input_source)
+                request.input_source(position, (int32_t) i, dst, frames);
+            else
+                memset(dst, 0, frames * sizeof(float));
+        }
+
+        AAPMidiBufferHeader* mbh = midiInput < 0 ? nullptr : (AAPMidiBufferHeader*) buffer->get_buffer(buffer, midiInput);
+        uint32_t midiOffset = 0;
+        auto midiCapacity = mbh ? (uint32_t) std::max(0, buffer->get_buffer_size(buffer, midiInput) - (int32_t) sizeof(AAPMidiBufferHeader)) : 0;
+        int64_t lastTicks = 0;
+        for (; nextEvent < request.num_events && request.events[nextEvent].frame < position + frameCount; nextEvent++) {
+            auto& ev = request.events[nextEvent];
+            // (events earlier than the block, i.e. unsorted ones, go to the beginning of it.)
+            auto ticks = ticksAt(std::max<int64_t>(0, ev.frame - position));
+            auto deltaTicks = ticks - lastTicks;
+            auto jrTimestampCount = deltaTicks > 0 ? (uint32_t) ((deltaTicks - 1) / 31250 + 1) : 0;
+            auto requiredBytes = jrTimestampCount * (uint32_t) sizeof(uint32_t) + (uint32_t) ev.size;
+            if (!mbh || ev.size < 0 || midiOffset + requiredBytes > midiCapacity) {
+                result.num_dropped_events++;
+                continue;
+            }
+            auto dst8 = (uint8_t*) (mbh + 1);
+            for (int64_t t = deltaTicks; t > 0; t -= 31250, midiOffset += 4)
+                *(uint32_t*) (dst8 + midiOffset) = cmidi2_ump_jr_timestamp_direct(t > 31250 ? 31250 : t);
+            memcpy(dst8 + midiOffset, ev.ump, (size_t) ev.size);
+            midiOffset += (uint32_t) ev.size;
+            lastTicks = ticks;
+        }
+        if (mbh)
+            mbh->length = midiOffset;
+
+        process(frameCount, request.timeout_in_nanoseconds);
+
+        if (request.output_sink)
+            for (size_t i = 0; i < audioOutputs.size(); i++)
+                request.output_sink(position, (int32_t) i,
+                                    (const float*) buffer->get_buffer(buffer, audioOutputs[i]),
+                                    framesIn(audioOutputs[i], frameCount));
+
+        result.frames_rendered += frameCount;
+        result.num_blocks++;
+    }
+    result.elapsed_nanoseconds = ProcessTrace::nowNanoseconds() - begin;
+
+    if (result.num_dropped_events > 0)
+        aap::a_log_f(AAP_LOG_LEVEL_WARN, LOG_TAG, "renderOffline(): %d event(s) did not fit into the MIDI2 input buffer and were dropped",
+                     result.num_dropped_events);
+    return result;
+}
+
 void aap::PluginInstance::addEventUmpInput(void *input, int32_t size) {
     const std::lock_guard<NanoSleepLock> lock{ump_sequence_merger_mutex};
     if (event_midi2_buffer_offset + size > event_midi2_buffer_size) {
@@ -538,3 +584,14 @@ void aap::PluginInstance::aapxsSessionAddEventUmpInput(aap::AAPXSMidi2InitiatorS
     auto instance = (aap::RemotePluginInstance *) context;
     instance->addEventUmpInput(client->aapxs_rt_midi_buffer, messageSize);
 }
+
+bool aap::PluginInstance::resolveCompactAAPXSUri(xs::AAPXSDefinitionRegistry* registry, aap_midi2_aapxs_parse_context* context) {
+    auto def = registry->getByUrid(context->urid);
+    if (!def || !def->uri) {
+        aap::a_log_f(AAP_LOG_LEVEL_WARN, LOG_TAG, "AAPXS for URID %d is not registered (opcode: %d)", context->urid, context->opcode);
+        return false;
+    }
+    strncpy(context->uri, def->uri, AAP_MAX_EXTENSION_URI_SIZE - 1);
+    context->uri[AAP_MAX_EXTENSION_URI_SIZE - 1] = 0;
+    return true;
+}
@@ -84,6 +84,50 @@ size_t aap_midi2_generate_aapxs_sysex8(uint32_t* dst,
     return forge.offset;
 }
 
+size_t aap_midi2_generate_aapxs_sysex8_compact(uint32_t* dst,
+                                               size_t dstSizeInInt,
+                                               uint8_t* conversionHelperBuffer,
+                                               size_t conversionHelperBufferSize,
+                                               uint8_t group,
+                                               uint32_t requestId,
+                                               uint8_t urid,
+                                               int32_t opcode,
+                                               const uint8_t* data,
+                                               size_t dataSize) {
+    if (urid == 0)
+        return 0; // compact format cannot identify the extension without URID.
+    size_t required = 17 + dataSize;
+    // SysEx8 packets carry up to 13 bytes each, in 16-byte UMPs.
+    size_t requiredUmp = (required + 12) / 13 * 16;
+    if (dstSizeInInt * sizeof(int32_t) < requiredUmp || conversionHelperBufferSize < required)
+        return 0;
+
+    uint8_t* sysex = conversionHelperBuffer;
+    uint8_t* ptr = sysex;
+    uint8_t sysexStart[] {
+        0x7Eu, 0x7Fu, // universal sysex
+        0, 2, // code (compact)
+        urid
+        };
+    memcpy(ptr, sysexStart, sizeof(sysexStart));
+    ptr += sizeof(sysexStart);
+    aapMidi2ExtensionHelperPutUInt32(ptr, requestId);
+    ptr += sizeof(uint32_t);
+    aapMidi2ExtensionHelperPutUInt32(ptr, (uint32_t) opcode);
+    ptr += sizeof(uint32_t);
+    aapMidi2ExtensionHelperPutUInt32(ptr, dataSize);
+    ptr += sizeof(uint32_t);
+    memcpy(ptr, data, dataSize);
+    ptr += dataSize;
+
+    cmidi2_ump_forge forge;
+    cmidi2_ump_forge_init(&forge, dst, dstSizeInInt * sizeof(int32_t));
+    cmidi2_ump_sysex8_process(group, sysex, ptr - sysex, 0,
+                              aapMidi2ExtensionInvokeHelperSysEx8Forge, &forge);
+
+    return forge.offset;
+}
+
 cmidi2_ump_binary_read_state* sysex8_binary_reader_helper_select_stream(uint8_t targetStreamId, void* context) {
     return (cmidi2_ump_binary_read_state*) context;
 }
@@ -110,13 +154,13 @@ bool aap_midi2_parse_aapxs_sysex8(aap_midi2_aapxs_parse_context* context,
     // It's time to parse the buffer according to the AAPXS SysEx8:
     // > `[5g sz si 7E]  [7F co-de ext-flag]  [re-se-rv-ed]  [uri-size]  [..uri..]  [value-size]  [..value..]`
 
-    // Check if it is long enough to contain the expected data...
-    if (state.dataSize < 24)
+    // Check if it is long enough to contain the expected data (the compact format is the shortest)...
+    if (state.dataSize < 17)
         return false;
 
     uint8_t* data = state.data;
-    // Check if this sysex8 is Universal SysEx, and contains code field for AAPXS
-    if (data[0] != 0x7E || data[1] != 0x7F || data[2] != 0 || data[3] != 1)
+    // Check if this sysex8 is Universal SysEx, and contains code field for AAPXS (00-01 or compact 00-02)
+    if (data[0] != 0x7E || data[1] != 0x7F || data[2] != 0 || (data[3] != 1 && data[3] != 2))
         return false;
 
     // filling in results...
@@ -124,6 +168,24 @@ bool aap_midi2_parse_aapxs_sysex8(aap_midi2_aapxs_parse_context* context,
     size_t requestId = aapMidi2ExtensionHelperGetUInt32(data + 5);
     context->request_id = requestId;
 
+    if (data[3] == 2) {
+        // `7E 7F 00 02 urid [reqId] [opcode] [value-size] [..value..]`
+        if (context->urid == 0)
+            return false;
+        context->compact = true;
+        context->uri[0] = 0;
+        context->opcode = aapMidi2ExtensionHelperGetUInt32(data + 9);
+        size_t dataSize = aapMidi2ExtensionHelperGetUInt32(data + 13);
+        if (state.dataSize < 17 + dataSize)
+            return false;
+        memcpy(context->data, data + 17, dataSize);
+        context->dataSize = dataSize;
+        return true;
+    }
+    context->compact = false;
+    if (state.dataSize < 24)
+        return false;
+
     size_t uriSize = aapMidi2ExtensionHelperGetUInt32(data + 9);
     if (state.dataSize < 17 + uriSize)
         return false;
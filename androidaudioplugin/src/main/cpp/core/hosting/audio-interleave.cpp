@@ -0,0 +1,536 @@
+#include "aap/unstable/audio-interleave.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AAP_INTERLEAVE_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AAP_INTERLEAVE_NEON 1
+#endif
+
+namespace aap {
+
+namespace {
+
+typedef void (*interleave_func)(float* dst, const float* const* src, int32_t numFrames);
+typedef void (*deinterleave_func)(float* const* dst, const float* src, int32_t numFrames);
+
+#define AAP_INTERLEAVE_MAX_KERNEL_CHANNELS 8
+
+struct InterleaveKernels {
+    const char* name;
+    // indexed by the channel count. Index 0 is unused.
+    interleave_func interleave[AAP_INTERLEAVE_MAX_KERNEL_CHANNELS + 1];
+    deinterleave_func deinterleave[AAP_INTERLEAVE_MAX_KERNEL_CHANNELS + 1];
+};
+
+// Scalar kernels. The channel count is a template argument so that the stride is a constant
+// (iterating channels in the outer loop measured faster than frames). SIMD kernels use them
+// for the remaining frames too (starting at `from`).
+
+template <int N>
+void interleaveScalar(float* dst, const float* const* src, int32_t from, int32_t numFrames) {
+    for (int c = 0; c < N; c++) {
+        auto s = src[c];
+        for (int32_t i = from; i < numFrames; i++)
+            dst[i * N + c] = s[i];
+    }
+}
+
+template <int N>
+void deinterleaveScalar(float* const* dst, const float* src, int32_t from, int32_t numFrames) {
+    for (int c = 0; c < N; c++) {
+        auto d = dst[c];
+        for (int32_t i = from; i < numFrames; i++)
+            d[i] = src[i * N + c];
+    }
+}
+
+template <int N>
+void interleaveScalar(float* dst, const float* const* src, int32_t numFrames) {
+    interleaveScalar<N>(dst, src, 0, numFrames);
+}
+
+template <int N>
+void deinterleaveScalar(float* const* dst, const float* src, int32_t numFrames) {
+    deinterleaveScalar<N>(dst, src, 0, numFrames);
+}
+
+void copyMono(float* dst, const float* const* src, int32_t numFrames) {
+    memcpy(dst, src[0], numFrames * sizeof(float));
+}
+
+void copyMono(float* const* dst, const float* src, int32_t numFrames) {
+    memcpy(dst[0], src, numFrames * sizeof(float));
+}
+
+#if AAP_INTERLEAVE_X86
+
+// SSE2 is part of the x86-64 baseline, so they need no runtime check there.
+
+void interleave2SSE2(float* dst, const float* const* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        auto l = _mm_loadu_ps(src[0] + i);
+        auto r = _mm_loadu_ps(src[1] + i);
+        _mm_storeu_ps(dst + i * 2, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(dst + i * 2 + 4, _mm_unpackhi_ps(l, r));
+    }
+    interleaveScalar<2>(dst, src, i, numFrames);
+}
+
+void deinterleave2SSE2(float* const* dst, const float* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        auto x0 = _mm_loadu_ps(src + i * 2);
+        auto x1 = _mm_loadu_ps(src + i * 2 + 4);
+        _mm_storeu_ps(dst[0] + i, _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(dst[1] + i, _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    deinterleaveScalar<2>(dst, src, i, numFrames);
+}
+
+// 4x4 transposes turn 4 frames of 4 channels into 4 channels of 4 frames, and vice versa.
+
+void interleave4SSE2(float* dst, const float* const* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        auto r0 = _mm_loadu_ps(src[0] + i);
+        auto r1 = _mm_loadu_ps(src[1] + i);
+        auto r2 = _mm_loadu_ps(src[2] + i);
+        auto r3 = _mm_loadu_ps(src[3] + i);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(dst + i * 4, r0);
+        _mm_storeu_ps(dst + i * 4 + 4, r1);
+        _mm_storeu_ps(dst + i * 4 + 8, r2);
+        _mm_storeu_ps(dst + i * 4 + 12, r3);
+    }
+    interleaveScalar<4>(dst, src, i, numFrames);
+}
+
+void deinterleave4SSE2(float* const* dst, const float* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        auto r0 = _mm_loadu_ps(src + i * 4);
+        auto r1 = _mm_loadu_ps(src + i * 4 + 4);
+        auto r2 = _mm_loadu_ps(src + i * 4 + 8);
+        auto r3 = _mm_loadu_ps(src + i * 4 + 12);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(dst[0] + i, r0);
+        _mm_storeu_ps(dst[1] + i, r1);
+        _mm_storeu_ps(dst[2] + i, r2);
+        _mm_storeu_ps(dst[3] + i, r3);
+    }
+    deinterleaveScalar<4>(dst, src, i, numFrames);
+}
+
+// 6 channels (5.1): channels 0-3 are transposed, and channels 4-5 are paired.
+
+void interleave6SSE2(float* dst, const float* const* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        auto a0 = _mm_loadu_ps(src[0] + i);
+        auto a1 = _mm_loadu_ps(src[1] + i);
+        auto a2 = _mm_loadu_ps(src[2] + i);
+        auto a3 = _mm_loadu_ps(src[3] + i);
+        auto c4 = _mm_loadu_ps(src[4] + i);
+        auto c5 = _mm_loadu_ps(src[5] + i);
+        _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+        auto b01 = _mm_unpacklo_ps(c4, c5);
+        auto b23 = _mm_unpackhi_ps(c4, c5);
+        auto d = dst + i * 6;
+        _mm_storeu_ps(d, a0);
+        _mm_storel_pi((__m64*) (d + 4), b01);
+        _mm_storeu_ps(d + 6, a1);
+        _mm_storeh_pi((__m64*) (d + 10), b01);
+        _mm_storeu_ps(d + 12, a2);
+        _mm_storel_pi((__m64*) (d + 16), b23);
+        _mm_storeu_ps(d + 18, a3);
+        _mm_storeh_pi((__m64*) (d + 22), b23);
+    }
+    interleaveScalar<6>(dst, src, i, numFrames);
+}
+
+void deinterleave6SSE2(float* const* dst, const float* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        auto s = src + i * 6;
+        auto a0 = _mm_loadu_ps(s);
+        auto a1 = _mm_loadu_ps(s + 6);
+        auto a2 = _mm_loadu_ps(s + 12);
+        auto a3 = _mm_loadu_ps(s + 18);
+        auto b01 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*) (s + 4)), (const __m64*) (s + 10));
+        auto b23 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*) (s + 16)), (const __m64*) (s + 22));
+        _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+        _mm_storeu_ps(dst[0] + i, a0);
+        _mm_storeu_ps(dst[1] + i, a1);
+        _mm_storeu_ps(dst[2] + i, a2);
+        _mm_storeu_ps(dst[3] + i, a3);
+        _mm_storeu_ps(dst[4] + i, _mm_shuffle_ps(b01, b23, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(dst[5] + i, _mm_shuffle_ps(b01, b23, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    deinterleaveScalar<6>(dst, src, i, numFrames);
+}
+
+void interleave8SSE2(float* dst, const float* const* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        auto a0 = _mm_loadu_ps(src[0] + i);
+        auto a1 = _mm_loadu_ps(src[1] + i);
+        auto a2 = _mm_loadu_ps(src[2] + i);
+        auto a3 = _mm_loadu_ps(src[3] + i);
+        auto b0 = _mm_loadu_ps(src[4] + i);
+        auto b1 = _mm_loadu_ps(src[5] + i);
+        auto b2 = _mm_loadu_ps(src[6] + i);
+        auto b3 = _mm_loadu_ps(src[7] + i);
+        _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+        _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+        auto d = dst + i * 8;
+        _mm_storeu_ps(d, a0);
+        _mm_storeu_ps(d + 4, b0);
+        _mm_storeu_ps(d + 8, a1);
+        _mm_storeu_ps(d + 12, b1);
+        _mm_storeu_ps(d + 16, a2);
+        _mm_storeu_ps(d + 20, b2);
+        _mm_storeu_ps(d + 24, a3);
+        _mm_storeu_ps(d + 28, b3);
+    }
+    interleaveScalar<8>(dst, src, i, numFrames);
+}
+
+void deinterleave8SSE2(float* const* dst, const float* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        auto s = src + i * 8;
+        auto a0 = _mm_loadu_ps(s);
+        auto b0 = _mm_loadu_ps(s + 4);
+        auto a1 = _mm_loadu_ps(s + 8);
+        auto b1 = _mm_loadu_ps(s + 12);
+        auto a2 = _mm_loadu_ps(s + 16);
+        auto b2 = _mm_loadu_ps(s + 20);
+        auto a3 = _mm_loadu_ps(s + 24);
+        auto b3 = _mm_loadu_ps(s + 28);
+        _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+        _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+        _mm_storeu_ps(dst[0] + i, a0);
+        _mm_storeu_ps(dst[1] + i, a1);
+        _mm_storeu_ps(dst[2] + i, a2);
+        _mm_storeu_ps(dst[3] + i, a3);
+        _mm_storeu_ps(dst[4] + i, b0);
+        _mm_storeu_ps(dst[5] + i, b1);
+        _mm_storeu_ps(dst[6] + i, b2);
+        _mm_storeu_ps(dst[7] + i, b3);
+    }
+    deinterleaveScalar<8>(dst, src, i, numFrames);
+}
+
+// AVX2 kernels are compiled for the target by attribute, and selected only if the CPU (and OS) supports it.
+
+#define AAP_AVX2 __attribute__((target("avx2")))
+
+AAP_AVX2 void interleave2AVX2(float* dst, const float* const* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 8 <= numFrames; i += 8) {
+        auto l = _mm256_loadu_ps(src[0] + i);
+        auto r = _mm256_loadu_ps(src[1] + i);
+        // per 128-bit lane: L0 R0 L1 R1 | L4 R4 L5 R5 and L2 R2 L3 R3 | L6 R6 L7 R7
+        auto lo = _mm256_unpacklo_ps(l, r);
+        auto hi = _mm256_unpackhi_ps(l, r);
+        _mm256_storeu_ps(dst + i * 2, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(dst + i * 2 + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    interleaveScalar<2>(dst, src, i, numFrames);
+}
+
+AAP_AVX2 void deinterleave2AVX2(float* const* dst, const float* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 8 <= numFrames; i += 8) {
+        auto x0 = _mm256_loadu_ps(src + i * 2);
+        auto x1 = _mm256_loadu_ps(src + i * 2 + 8);
+        // frames 0,1,4,5 and 2,3,6,7 so that in-lane shuffles give frames 0-7 in order.
+        auto t0 = _mm256_permute2f128_ps(x0, x1, 0x20);
+        auto t1 = _mm256_permute2f128_ps(x0, x1, 0x31);
+        _mm256_storeu_ps(dst[0] + i, _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm256_storeu_ps(dst[1] + i, _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    deinterleaveScalar<2>(dst, src, i, numFrames);
+}
+
+AAP_AVX2 inline void transpose8x8AVX2(__m256& r0, __m256& r1, __m256& r2, __m256& r3,
+                                      __m256& r4, __m256& r5, __m256& r6, __m256& r7) {
+    auto t0 = _mm256_unpacklo_ps(r0, r1);
+    auto t1 = _mm256_unpackhi_ps(r0, r1);
+    auto t2 = _mm256_unpacklo_ps(r2, r3);
+    auto t3 = _mm256_unpackhi_ps(r2, r3);
+    auto t4 = _mm256_unpacklo_ps(r4, r5);
+    auto t5 = _mm256_unpackhi_ps(r4, r5);
+    auto t6 = _mm256_unpacklo_ps(r6, r7);
+    auto t7 = _mm256_unpackhi_ps(r6, r7);
+    auto u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    auto u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    auto u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    auto u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    auto u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    auto u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    auto u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    auto u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+    r0 = _mm256_permute2f128_ps(u0, u4, 0x20);
+    r1 = _mm256_permute2f128_ps(u1, u5, 0x20);
+    r2 = _mm256_permute2f128_ps(u2, u6, 0x20);
+    r3 = _mm256_permute2f128_ps(u3, u7, 0x20);
+    r4 = _mm256_permute2f128_ps(u0, u4, 0x31);
+    r5 = _mm256_permute2f128_ps(u1, u5, 0x31);
+    r6 = _mm256_permute2f128_ps(u2, u6, 0x31);
+    r7 = _mm256_permute2f128_ps(u3, u7, 0x31);
+}
+
+AAP_AVX2 void interleave8AVX2(float* dst, const float* const* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 8 <= numFrames; i += 8) {
+        auto r0 = _mm256_loadu_ps(src[0] + i);
+        auto r1 = _mm256_loadu_ps(src[1] + i);
+        auto r2 = _mm256_loadu_ps(src[2] + i);
+        auto r3 = _mm256_loadu_ps(src[3] + i);
+        auto r4 = _mm256_loadu_ps(src[4] + i);
+        auto r5 = _mm256_loadu_ps(src[5] + i);
+        auto r6 = _mm256_loadu_ps(src[6] + i);
+        auto r7 = _mm256_loadu_ps(src[7] + i);
+        transpose8x8AVX2(r0, r1, r2, r3, r4, r5, r6, r7);
+        auto d = dst + i * 8;
+        _mm256_storeu_ps(d, r0);
+        _mm256_storeu_ps(d + 8, r1);
+        _mm256_storeu_ps(d + 16, r2);
+        _mm256_storeu_ps(d + 24, r3);
+        _mm256_storeu_ps(d + 32, r4);
+        _mm256_storeu_ps(d + 40, r5);
+        _mm256_storeu_ps(d + 48, r6);
+        _mm256_storeu_ps(d + 56, r7);
+    }
+    interleaveScalar<8>(dst, src, i, numFrames);
+}
+
+AAP_AVX2 void deinterleave8AVX2(float* const* dst, const float* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 8 <= numFrames; i += 8) {
+        auto s = src + i * 8;
+        auto r0 = _mm256_loadu_ps(s);
+        auto r1 = _mm256_loadu_ps(s + 8);
+        auto r2 = _mm256_loadu_ps(s + 16);
+        auto r3 = _mm256_loadu_ps(s + 24);
+        auto r4 = _mm256_loadu_ps(s + 32);
+        auto r5 = _mm256_loadu_ps(s + 40);
+        auto r6 = _mm256_loadu_ps(s + 48);
+        auto r7 = _mm256_loadu_ps(s + 56);
+        transpose8x8AVX2(r0, r1, r2, r3, r4, r5, r6, r7);
+        _mm256_storeu_ps(dst[0] + i, r0);
+        _mm256_storeu_ps(dst[1] + i, r1);
+        _mm256_storeu_ps(dst[2] + i, r2);
+        _mm256_storeu_ps(dst[3] + i, r3);
+        _mm256_storeu_ps(dst[4] + i, r4);
+        _mm256_storeu_ps(dst[5] + i, r5);
+        _mm256_storeu_ps(dst[6] + i, r6);
+        _mm256_storeu_ps(dst[7] + i, r7);
+    }
+    deinterleaveScalar<8>(dst, src, i, numFrames);
+}
+
+#endif // AAP_INTERLEAVE_X86
+
+#if AAP_INTERLEAVE_NEON
+
+// NEON is mandatory on arm64-v8a (and armeabi-v7a as of NDK r21), so they need no runtime check.
+
+void interleave2NEON(float* dst, const float* const* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4)
+        vst2q_f32(dst + i * 2, (float32x4x2_t{{vld1q_f32(src[0] + i), vld1q_f32(src[1] + i)}}));
+    interleaveScalar<2>(dst, src, i, numFrames);
+}
+
+void deinterleave2NEON(float* const* dst, const float* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        auto v = vld2q_f32(src + i * 2);
+        vst1q_f32(dst[0] + i, v.val[0]);
+        vst1q_f32(dst[1] + i, v.val[1]);
+    }
+    deinterleaveScalar<2>(dst, src, i, numFrames);
+}
+
+void interleave3NEON(float* dst, const float* const* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4)
+        vst3q_f32(dst + i * 3, (float32x4x3_t{{vld1q_f32(src[0] + i), vld1q_f32(src[1] + i), vld1q_f32(src[2] + i)}}));
+    interleaveScalar<3>(dst, src, i, numFrames);
+}
+
+void deinterleave3NEON(float* const* dst, const float* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        auto v = vld3q_f32(src + i * 3);
+        vst1q_f32(dst[0] + i, v.val[0]);
+        vst1q_f32(dst[1] + i, v.val[1]);
+        vst1q_f32(dst[2] + i, v.val[2]);
+    }
+    deinterleaveScalar<3>(dst, src, i, numFrames);
+}
+
+void interleave4NEON(float* dst, const float* const* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4)
+        vst4q_f32(dst + i * 4, (float32x4x4_t{{vld1q_f32(src[0] + i), vld1q_f32(src[1] + i),
+                                               vld1q_f32(src[2] + i), vld1q_f32(src[3] + i)}}));
+    interleaveScalar<4>(dst, src, i, numFrames);
+}
+
+void deinterleave4NEON(float* const* dst, const float* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        auto v = vld4q_f32(src + i * 4);
+        vst1q_f32(dst[0] + i, v.val[0]);
+        vst1q_f32(dst[1] + i, v.val[1]);
+        vst1q_f32(dst[2] + i, v.val[2]);
+        vst1q_f32(dst[3] + i, v.val[3]);
+    }
+    deinterleaveScalar<4>(dst, src, i, numFrames);
+}
+
+inline void transpose4x4NEON(float32x4_t& r0, float32x4_t& r1, float32x4_t& r2, float32x4_t& r3) {
+    auto p01 = vtrnq_f32(r0, r1);
+    auto p23 = vtrnq_f32(r2, r3);
+    r0 = vcombine_f32(vget_low_f32(p01.val[0]), vget_low_f32(p23.val[0]));
+    r1 = vcombine_f32(vget_low_f32(p01.val[1]), vget_low_f32(p23.val[1]));
+    r2 = vcombine_f32(vget_high_f32(p01.val[0]), vget_high_f32(p23.val[0]));
+    r3 = vcombine_f32(vget_high_f32(p01.val[1]), vget_high_f32(p23.val[1]));
+}
+
+void interleave8NEON(float* dst, const float* const* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        auto a0 = vld1q_f32(src[0] + i);
+        auto a1 = vld1q_f32(src[1] + i);
+        auto a2 = vld1q_f32(src[2] + i);
+        auto a3 = vld1q_f32(src[3] + i);
+        auto b0 = vld1q_f32(src[4] + i);
+        auto b1 = vld1q_f32(src[5] + i);
+        auto b2 = vld1q_f32(src[6] + i);
+        auto b3 = vld1q_f32(src[7] + i);
+        transpose4x4NEON(a0, a1, a2, a3);
+        transpose4x4NEON(b0, b1, b2, b3);
+        auto d = dst + i * 8;
+        vst1q_f32(d, a0);
+        vst1q_f32(d + 4, b0);
+        vst1q_f32(d + 8, a1);
+        vst1q_f32(d + 12, b1);
+        vst1q_f32(d + 16, a2);
+        vst1q_f32(d + 20, b2);
+        vst1q_f32(d + 24, a3);
+        vst1q_f32(d + 28, b3);
+    }
+    interleaveScalar<8>(dst, src, i, numFrames);
+}
+
+void deinterleave8NEON(float* const* dst, const float* src, int32_t numFrames) {
+    int32_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        auto s = src + i * 8;
+        auto a0 = vld1q_f32(s);
+        auto b0 = vld1q_f32(s + 4);
+        auto a1 = vld1q_f32(s + 8);
+        auto b1 = vld1q_f32(s + 12);
+        auto a2 = vld1q_f32(s + 16);
+        auto b2 = vld1q_f32(s + 20);
+        auto a3 = vld1q_f32(s + 24);
+        auto b3 = vld1q_f32(s + 28);
+        transpose4x4NEON(a0, a1, a2, a3);
+        transpose4x4NEON(b0, b1, b2, b3);
+        vst1q_f32(dst[0] + i, a0);
+        vst1q_f32(dst[1] + i, a1);
+        vst1q_f32(dst[2] + i, a2);
+        vst1q_f32(dst[3] + i, a3);
+        vst1q_f32(dst[4] + i, b0);
+        vst1q_f32(dst[5] + i, b1);
+        vst1q_f32(dst[6] + i, b2);
+        vst1q_f32(dst[7] + i, b3);
+    }
+    deinterleaveScalar<8>(dst, src, i, numFrames);
+}
+
+#endif // AAP_INTERLEAVE_NEON
+
+InterleaveKernels selectKernels() {
+    InterleaveKernels k{"scalar",
+        {nullptr, copyMono, interleaveScalar<2>, interleaveScalar<3>, interleaveScalar<4>,
+         interleaveScalar<5>, interleaveScalar<6>, interleaveScalar<7>, interleaveScalar<8>},
+        {nullptr, copyMono, deinterleaveScalar<2>, deinterleaveScalar<3>, deinterleaveScalar<4>,
+         deinterleaveScalar<5>, deinterleaveScalar<6>, deinterleaveScalar<7>, deinterleaveScalar<8>}};
+#if AAP_INTERLEAVE_X86
+#if defined(__SSE2__)
+    k.name = "sse2";
+    k.interleave[2] = interleave2SSE2;
+    k.deinterleave[2] = deinterleave2SSE2;
+    k.interleave[4] = interleave4SSE2;
+    k.deinterleave[4] = deinterleave4SSE2;
+    k.interleave[6] = interleave6SSE2;
+    k.deinterleave[6] = deinterleave6SSE2;
+    k.interleave[8] = interleave8SSE2;
+    k.deinterleave[8] = deinterleave8SSE2;
+#endif
+    // it runs in a static initializer, possibly before the runtime initialized the CPU model.
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        k.name = "avx2";
+        k.interleave[2] = interleave2AVX2;
+        k.deinterleave[2] = deinterleave2AVX2;
+        k.interleave[8] = interleave8AVX2;
+        k.deinterleave[8] = deinterleave8AVX2;
+    }
+#elif AAP_INTERLEAVE_NEON
+    k.name = "neon";
+    k.interleave[2] = interleave2NEON;
+    k.deinterleave[2] = deinterleave2NEON;
+    k.interleave[3] = interleave3NEON;
+    k.deinterleave[3] = deinterleave3NEON;
+    k.interleave[4] = interleave4NEON;
+    k.deinterleave[4] = deinterleave4NEON;
+    k.interleave[8] = interleave8NEON;
+    k.deinterleave[8] = deinterleave8NEON;
+#endif
+    return k;
+}
+
+// selected once when the library is loaded, so that the audio thread only makes an indirect call.
+const InterleaveKernels kernels = selectKernels();
+
+} // namespace
+
+void interleaveAudio(float* dst, const float* const* src, int32_t numChannels, int32_t numFrames) {
+    if (numChannels <= 0 || numFrames <= 0)
+        return;
+    if (numChannels <= AAP_INTERLEAVE_MAX_KERNEL_CHANNELS) {
+        kernels.interleave[numChannels](dst, src, numFrames);
+        return;
+    }
+    for (int32_t c = 0; c < numChannels; c++)
+        for (int32_t i = 0; i < numFrames; i++)
+            dst[i * numChannels + c] = src[c][i];
+}
+
+void deinterleaveAudio(float* const* dst, const float* src, int32_t numChannels, int32_t numFrames) {
+    if (numChannels <= 0 || numFrames <= 0)
+        return;
+    if (numChannels <= AAP_INTERLEAVE_MAX_KERNEL_CHANNELS) {
+        kernels.deinterleave[numChannels](dst, src, numFrames);
+        return;
+    }
+    for (int32_t c = 0; c < numChannels; c++)
+        for (int32_t i = 0; i < numFrames; i++)
+            dst[c][i] = src[i * numChannels + c];
+}
+
+const char* getAudioInterleaveKernelName() {
+    return kernels.name;
+}
+
+} // namespace aap
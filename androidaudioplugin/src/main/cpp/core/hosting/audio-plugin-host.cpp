@@ -48,27 +48,39 @@ bool AbstractPluginBuffer::initialize(int32_t numPorts, int32_t numFrames) {
 
 //-----------------------------------
 
+static inline size_t alignToCacheLine(size_t size) {
+	return (size + PORT_BUFFER_ALIGNMENT - 1) / PORT_BUFFER_ALIGNMENT * PORT_BUFFER_ALIGNMENT;
+}
+
 int32_t ClientPluginSharedMemoryStore::allocateClientBuffer(size_t numPorts, size_t numFrames, aap::PluginInstance& instance, size_t defaultControllBytesPerBlock) {
 	memory_origin = PLUGIN_BUFFER_ORIGIN_LOCAL;
 
-	size_t commonMemSize = numFrames * sizeof(float);
 	port_buffer = std::make_unique<SharedMemoryPluginBuffer>(&instance);
     if (!port_buffer) {
         AAP_ASSERT_FALSE;
         return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_FAILED_LOCAL_ALLOC;
     }
-	port_buffer->initialize(numPorts, numFrames);
+	if (!port_buffer->initialize(numPorts, numFrames))
+		return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_FAILED_LOCAL_ALLOC;
 
+	return port_buffer_arena_enabled ?
+		allocateClientArena(numPorts, numFrames, instance, defaultControllBytesPerBlock) :
+		allocateClientPortBuffers(numPorts, numFrames, instance, defaultControllBytesPerBlock);
+}
+
+// for services that do not support the arena (see AAP_PORT_BUFFER_ARENA_URI): one shm per port.
+int32_t ClientPluginSharedMemoryStore::allocateClientPortBuffers(size_t numPorts, size_t numFrames, aap::PluginInstance& instance, size_t defaultControllBytesPerBlock) {
+	size_t commonMemSize = numFrames * sizeof(float);
 	for (size_t i = 0; i < numPorts; i++) {
 		auto port = instance.getPort(i);
 		auto memSize = port->hasProperty(AAP_PORT_MINIMUM_SIZE) ? port->getPropertyAsInteger(AAP_PORT_MINIMUM_SIZE) :
 				port->getContentType() == AAP_CONTENT_TYPE_AUDIO ? commonMemSize : defaultControllBytesPerBlock;
 		int32_t fd = PluginClientSystem::getInstance()->createSharedMemory(memSize);
-		if (!fd)
+		if (fd < 0)
 			return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_FAILED_SHM_CREATE;
 		port_buffer_fds->emplace_back(fd);
 		auto mapped = mmap(nullptr, memSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-		if (!mapped)
+		if (mapped == MAP_FAILED)
 			return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_FAILED_MMAP;
 		port_buffer->setBuffer(i, mapped);
 	}
@@ -76,6 +88,95 @@ int32_t ClientPluginSharedMemoryStore::allocateClientBuffer(size_t numPorts, siz
 	return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_SUCCESS;
 }
 
+int32_t ClientPluginSharedMemoryStore::allocateClientArena(size_t numPorts, size_t numFrames, aap::PluginInstance& instance, size_t defaultControllBytesPerBlock) {
+	size_t commonMemSize = numFrames * sizeof(float);
+
+	// Lay out all the port buffers in one arena: header, offset table, then cache-line-aligned buffers.
+	// It takes one shm, one mmap and one IPC for all ports, and keeps the buffers contiguous.
+	std::vector<int32_t> offsets(numPorts), sizes(numPorts);
+	size_t arenaSize = alignToCacheLine(sizeof(PortBufferArenaHeader) + sizeof(int32_t) * 2 * numPorts);
+	for (size_t i = 0; i < numPorts; i++) {
+		auto port = instance.getPort(i);
+		auto memSize = port->hasProperty(AAP_PORT_MINIMUM_SIZE) ? port->getPropertyAsInteger(AAP_PORT_MINIMUM_SIZE) :
+				port->getContentType() == AAP_CONTENT_TYPE_AUDIO ? commonMemSize : defaultControllBytesPerBlock;
+		offsets[i] = (int32_t) arenaSize;
+		sizes[i] = (int32_t) memSize;
+		arenaSize += alignToCacheLine(memSize);
+	}
+
+	int32_t fd = PluginClientSystem::getInstance()->createSharedMemory(arenaSize);
+	if (fd < 0)
+		return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_FAILED_SHM_CREATE;
+	port_buffer_fds->emplace_back(fd);
+	auto mapped = mmap(nullptr, arenaSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (mapped == MAP_FAILED)
+		return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_FAILED_MMAP;
+	port_buffer->arena = mapped;
+	port_buffer->arena_size = arenaSize;
+
+	auto header = (PortBufferArenaHeader*) mapped;
+	header->magic = PortBufferArenaHeader::MAGIC;
+	header->num_ports = (int32_t) numPorts;
+	auto table = (int32_t*) (header + 1);
+	for (size_t i = 0; i < numPorts; i++) {
+		table[i] = offsets[i];
+		table[numPorts + i] = sizes[i];
+		port_buffer->setBuffer(i, (uint8_t*) mapped + offsets[i]);
+	}
+
+	return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_SUCCESS;
+}
+
+int32_t ServicePluginSharedMemoryStore::mapServiceArena(int32_t arenaFD, size_t numFrames, aap::PluginInstance& instance) {
+	memory_origin = PLUGIN_BUFFER_ORIGIN_REMOTE;
+
+	port_buffer_fds->emplace_back(arenaFD);
+	struct stat st;
+	if (fstat(arenaFD, &st) != 0 || (size_t) st.st_size < sizeof(PortBufferArenaHeader))
+		return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_FAILED_SHM_CREATE;
+	auto arenaSize = (size_t) st.st_size;
+	auto mapped = mmap(nullptr, arenaSize, PROT_READ | PROT_WRITE, MAP_SHARED, arenaFD, 0);
+	if (mapped == MAP_FAILED)
+		return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_FAILED_MMAP;
+
+	port_buffer = std::make_unique<SharedMemoryPluginBuffer>(&instance);
+	if (!port_buffer) {
+		munmap(mapped, arenaSize);
+		AAP_ASSERT_FALSE;
+		return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_FAILED_LOCAL_ALLOC;
+	}
+	port_buffer->arena = mapped;
+	port_buffer->arena_size = arenaSize;
+
+	auto header = (PortBufferArenaHeader*) mapped;
+	auto numPorts = header->num_ports;
+	if (header->magic != PortBufferArenaHeader::MAGIC || numPorts < 0 ||
+		sizeof(PortBufferArenaHeader) + sizeof(int32_t) * 2 * numPorts > arenaSize) {
+		aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Invalid port buffer arena header");
+		return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_FAILED_MMAP;
+	}
+	// the plugin accesses its ports by index, so the client must have laid out exactly our ports.
+	if (numPorts != instance.getNumPorts()) {
+		aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Port buffer arena has %d ports, while the instance has %d",
+					 numPorts, instance.getNumPorts());
+		return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_FAILED_MMAP;
+	}
+	if (!port_buffer->initialize(numPorts, numFrames))
+		return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_FAILED_LOCAL_ALLOC;
+	auto table = (int32_t*) (header + 1);
+	for (int32_t i = 0; i < numPorts; i++) {
+		auto offset = table[i];
+		auto size = table[numPorts + i];
+		if (offset < 0 || size < 0 || (size_t) offset + (size_t) size > arenaSize) {
+			aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Port %d is out of the port buffer arena", i);
+			return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_FAILED_MMAP;
+		}
+		port_buffer->setBuffer(i, (uint8_t*) mapped + offset);
+	}
+
+	return PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_SUCCESS;
+}
+
 int32_t ServicePluginSharedMemoryStore::allocateServiceBuffer(std::vector<int32_t>& clientFDs, size_t numFrames, aap::PluginInstance& instance, size_t defaultControllBytesPerBlock) {
 	memory_origin = PLUGIN_BUFFER_ORIGIN_REMOTE;
 
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include "aap/core/host/gui-listener-midi-buffer.h"
+#include "aap/unstable/logging.h"
+
+#define LOG_TAG "AAP.GuiListener"
+
+namespace {
+    // UMP packet size in bytes, by the message type (the top 4 bits of the first word).
+    const uint32_t ump_packet_sizes[16] {4, 4, 4, 8, 8, 16, 4, 4, 8, 8, 8, 12, 12, 16, 16, 16};
+
+    uint32_t umpPacketSize(uint32_t word0) { return ump_packet_sizes[word0 >> 28]; }
+}
+
+aap::GuiListenerMidiBuffer::GuiListenerMidiBuffer(int32_t capacityInBytes) {
+    capacity = 64;
+    while (capacity < (uint32_t) capacityInBytes)
+        capacity <<= 1;
+    mask = capacity - 1;
+    buffer = (uint8_t*) calloc(1, capacity);
+}
+
+aap::GuiListenerMidiBuffer::~GuiListenerMidiBuffer() {
+    free(buffer);
+}
+
+void aap::GuiListenerMidiBuffer::copyIn(uint32_t position, const uint8_t* src, uint32_t size) {
+    auto offset = position & mask;
+    auto first = std::min(size, capacity - offset);
+    memcpy(buffer + offset, src, first);
+    if (first < size)
+        memcpy(buffer, src + first, size - first);
+}
+
+void aap::GuiListenerMidiBuffer::copyOut(uint32_t position, uint8_t* dst, uint32_t size) {
+    auto offset = position & mask;
+    auto first = std::min(size, capacity - offset);
+    memcpy(dst, buffer + offset, first);
+    if (first < size)
+        memcpy(dst + first, buffer, size - first);
+}
+
+void aap::GuiListenerMidiBuffer::write(const void* ump, int32_t size) {
+    if (!ump || size <= 0)
+        return;
+    auto w = write_position.load(std::memory_order_relaxed);
+    auto r = read_position.load(std::memory_order_acquire);
+    auto freeBytes = capacity - (w - r);
+    auto src = (const uint8_t*) ump;
+    auto total = (uint32_t) size;
+
+    // if everything does not fit, keep the leading packets that do.
+    uint32_t fit = total;
+    if (total > freeBytes) {
+        fit = 0;
+        while (fit + sizeof(uint32_t) <= total) {
+            uint32_t word0;
+            memcpy(&word0, src + fit, sizeof(word0));
+            auto packetSize = umpPacketSize(word0);
+            if (fit + packetSize > freeBytes || fit + packetSize > total)
+                break;
+            fit += packetSize;
+        }
+        dropped_bytes.store(dropped_bytes.load(std::memory_order_relaxed) + (total - fit), std::memory_order_relaxed);
+        dropped_writes.store(dropped_writes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    if (fit == 0)
+        return;
+    copyIn(w, src, fit);
+    write_position.store(w + fit, std::memory_order_release);
+}
+
+int32_t aap::GuiListenerMidiBuffer::read(void* output, int32_t size) {
+    if (!output || size <= 0)
+        return 0;
+    std::unique_lock<NanoSleepLock> tryLock(read_mutex, std::try_to_lock);
+    if (!tryLock.owns_lock())
+        return 0;
+
+    // report overflows, at most once per second.
+    auto droppedWrites = getDroppedWrites();
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    auto nowNs = (int64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+    if (droppedWrites != reported_dropped_writes && nowNs - last_report_time_ns >= 1000000000) {
+        aap::a_log_f(AAP_LOG_LEVEL_WARN, LOG_TAG,
+                     "GUI listener MIDI2 output overflowed: %" PRIu64 " bytes in %" PRIu64 " process cycles have been dropped so far",
+                     getDroppedBytes(), droppedWrites);
+        reported_dropped_writes = droppedWrites;
+        last_report_time_ns = nowNs;
+    }
+
+    auto r = read_position.load(std::memory_order_relaxed);
+    auto w = write_position.load(std::memory_order_acquire);
+    auto available = w - r;
+    // whole packets only. Every write() consists of whole packets, so we never see a partial one.
+    uint32_t readSize = 0;
+    while (readSize < available) {
+        uint32_t word0;
+        copyOut(r + readSize, (uint8_t*) &word0, sizeof(word0));
+        auto packetSize = umpPacketSize(word0);
+        if (readSize + packetSize > (uint32_t) size)
+            break;
+        readSize += packetSize;
+    }
+    if (readSize == 0)
+        return 0;
+    copyOut(r, (uint8_t*) output, readSize);
+    read_position.store(r + readSize, std::memory_order_release);
+    return (int32_t) readSize;
+}
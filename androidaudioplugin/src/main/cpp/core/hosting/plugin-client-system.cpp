@@ -1,14 +1,332 @@
-
 #include "aap/core/host/plugin-client-system.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include "aap/unstable/logging.h"
+
+#define LOG_TAG "AAP.PluginClientSystem"
+
+// The index is a host-local cache, so it is written in the native byte order.
+// Bump the version whenever the layout or PluginInformation contents change.
+#define AAP_METADATA_INDEX_MAGIC "AAPMDIDX"
+#define AAP_METADATA_INDEX_VERSION 1
 
 namespace aap {
 
+namespace {
+
+class MetadataIndexWriter {
+    std::string buffer{};
+
+public:
+    const std::string& getBuffer() { return buffer; }
+
+    template <typename T>
+    void write(T value) { buffer.append((const char*) &value, sizeof(T)); }
+
+    void writeString(const std::string& s) {
+        write((uint32_t) s.size());
+        buffer.append(s);
+    }
+
+    void writeProperties(const PropertyContainer& container) {
+        auto& properties = container.getProperties();
+        write((uint32_t) properties.size());
+        for (auto& p : properties) {
+            writeString(p.first);
+            writeString(p.second);
+        }
+    }
+
+    void writePlugin(const PluginInformation* p) {
+        write((uint8_t) p->isOutProcess());
+        for (auto s : {&p->getPluginPackageName(), &p->getPluginLocalName(), &p->getDisplayName(),
+                       &p->getDeveloperName(), &p->getVersion(), &p->getPluginID(),
+                       &p->getLocalPluginSharedLibrary(), &p->getLocalPluginLibraryEntryPoint(),
+                       &p->getMetadataFullPath(), &p->getPrimaryCategory(), &p->getUiViewFactory(),
+                       &p->getUiActivity(), &p->getUiWeb()})
+            writeString(*s);
+
+        write((uint32_t) p->getNumDeclaredPorts());
+        for (int i = 0, n = p->getNumDeclaredPorts(); i < n; i++) {
+            auto port = p->getDeclaredPort(i);
+            write((uint32_t) port->getIndex());
+            writeString(port->getName());
+            write((int32_t) port->getContentType());
+            write((int32_t) port->getPortDirection());
+            writeProperties(*port);
+        }
+
+        write((uint32_t) p->getNumDeclaredParameters());
+        for (int i = 0, n = p->getNumDeclaredParameters(); i < n; i++) {
+            auto para = p->getDeclaredParameter(i);
+            write((int32_t) para->getId());
+            writeString(para->getName());
+            write(para->getMinimumValue());
+            write(para->getMaximumValue());
+            write(para->getDefaultValue());
+            write((uint32_t) para->getEnumCount());
+            for (auto& e : para->getEnumerations()) {
+                write((int32_t) e.second.getIndex());
+                write(e.second.getValue());
+                writeString(e.second.getName());
+            }
+            writeProperties(*para);
+        }
+
+        write((uint32_t) p->getNumExtensions());
+        for (int i = 0, n = p->getNumExtensions(); i < n; i++) {
+            auto ext = p->getExtension(i);
+            write((uint8_t) ext.required);
+            writeString(ext.uri);
+        }
+    }
+};
+
+// Every read is bounds-checked; once anything fails, `ok` stays false and the index is discarded.
+class MetadataIndexReader {
+    const std::string& buffer;
+    size_t pos{0};
+
+public:
+    bool ok{true};
+
+    explicit MetadataIndexReader(const std::string& buffer) : buffer(buffer) {}
+
+    template <typename T>
+    T read() {
+        T value{};
+        if (!ok || buffer.size() - pos < sizeof(T)) {
+            ok = false;
+            return value;
+        }
+        memcpy(&value, buffer.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    std::string readString() {
+        auto size = read<uint32_t>();
+        if (!ok || buffer.size() - pos < size) {
+            ok = false;
+            return "";
+        }
+        std::string ret = buffer.substr(pos, size);
+        pos += size;
+        return ret;
+    }
+
+    void readProperties(PropertyContainer& container) {
+        for (uint32_t i = 0, n = read<uint32_t>(); ok && i < n; i++) {
+            auto key = readString();
+            auto value = readString();
+            container.setPropertyValueString(key, value);
+        }
+    }
+
+    PluginInformation* readPlugin() {
+        bool isOutProcess = read<uint8_t>() != 0;
+        std::string s[13];
+        for (auto& str : s)
+            str = readString();
+        if (!ok)
+            return nullptr;
+        auto p = new PluginInformation(isOutProcess, s[0].c_str(), s[1].c_str(), s[2].c_str(),
+                                       s[3].c_str(), s[4].c_str(), s[5].c_str(), s[6].c_str(),
+                                       s[7].c_str(), s[8].c_str(), s[9].c_str(), s[10].c_str(),
+                                       s[11].c_str(), s[12].c_str());
+
+        for (uint32_t i = 0, n = read<uint32_t>(); ok && i < n; i++) {
+            auto index = read<uint32_t>();
+            auto name = readString();
+            auto content = (aap_content_type) read<int32_t>();
+            auto direction = (aap_port_direction) read<int32_t>();
+            auto port = new PortInformation(index, name, content, direction);
+            readProperties(*port);
+            p->addDeclaredPort(port);
+        }
+
+        for (uint32_t i = 0, n = read<uint32_t>(); ok && i < n; i++) {
+            auto id = read<int32_t>();
+            auto name = readString();
+            auto minValue = read<double>();
+            auto maxValue = read<double>();
+            auto defaultValue = read<double>();
+            auto para = new ParameterInformation(id, name, minValue, maxValue, defaultValue);
+            for (uint32_t e = 0, numEnums = read<uint32_t>(); ok && e < numEnums; e++) {
+                auto index = read<int32_t>();
+                auto value = read<double>();
+                ParameterInformation::Enumeration en{index, value, readString()};
+                para->addEnumeration(en);
+            }
+            readProperties(*para);
+            p->addDeclaredParameter(para);
+        }
+
+        for (uint32_t i = 0, n = read<uint32_t>(); ok && i < n; i++) {
+            bool required = read<uint8_t>() != 0;
+            p->addExtension(PluginExtensionInformation{required, readString()});
+        }
+        // a partially read entry is not returned (it is leaked just like any other PluginInformation).
+        return ok ? p : nullptr;
+    }
+};
+
+} // namespace
+
+void PluginClientSystem::loadMetadataIndex() {
+    metadata_index_loaded = true;
+    auto path = getMetadataIndexPath();
+    if (path.empty())
+        return;
+    std::ifstream file{path, std::ios::binary};
+    if (!file)
+        return; // not created yet
+    std::stringstream ss{};
+    ss << file.rdbuf();
+    auto buffer = ss.str();
+
+    MetadataIndexReader reader{buffer};
+    char magic[8];
+    for (auto& c : magic)
+        c = reader.read<char>();
+    if (!reader.ok || memcmp(magic, AAP_METADATA_INDEX_MAGIC, sizeof(magic)) != 0 ||
+        reader.read<uint32_t>() != AAP_METADATA_INDEX_VERSION) {
+        aap::a_log_f(AAP_LOG_LEVEL_INFO, LOG_TAG, "Ignoring incompatible plugin metadata index %s", path.c_str());
+        return;
+    }
+    std::map<std::string, MetadataEntry> entries{};
+    for (uint32_t i = 0, n = reader.read<uint32_t>(); reader.ok && i < n; i++) {
+        auto metadataPath = reader.readString();
+        auto& entry = entries[metadataPath];
+        entry.stamp.modified_time_nanoseconds = reader.read<int64_t>();
+        entry.stamp.size = reader.read<int64_t>();
+        for (uint32_t p = 0, numPlugins = reader.read<uint32_t>(); reader.ok && p < numPlugins; p++)
+            if (auto plugin = reader.readPlugin())
+                entry.plugins.emplace_back(plugin);
+    }
+    if (!reader.ok) {
+        aap::a_log_f(AAP_LOG_LEVEL_WARN, LOG_TAG, "Plugin metadata index %s is corrupted. Ignoring it.", path.c_str());
+        return;
+    }
+    metadata_entries = std::move(entries);
+}
+
+void PluginClientSystem::saveMetadataIndex() {
+    auto path = getMetadataIndexPath();
+    if (path.empty())
+        return;
+    MetadataIndexWriter writer{};
+    for (auto c : std::string{AAP_METADATA_INDEX_MAGIC})
+        writer.write(c);
+    writer.write((uint32_t) AAP_METADATA_INDEX_VERSION);
+    writer.write((uint32_t) metadata_entries.size());
+    for (auto& e : metadata_entries) {
+        writer.writeString(e.first);
+        writer.write(e.second.stamp.modified_time_nanoseconds);
+        writer.write(e.second.stamp.size);
+        writer.write((uint32_t) e.second.plugins.size());
+        for (auto p : e.second.plugins)
+            writer.writePlugin(p);
+    }
+
+    // write to a temporary file and rename it, so that concurrent hosts never read a partial index.
+    auto tmpPath = path + ".tmp";
+    {
+        std::ofstream file{tmpPath, std::ios::binary | std::ios::trunc};
+        if (file)
+            file.write(writer.getBuffer().data(), (std::streamsize) writer.getBuffer().size());
+        if (!file) {
+            aap::a_log_f(AAP_LOG_LEVEL_WARN, LOG_TAG, "Failed to write plugin metadata index %s", tmpPath.c_str());
+            return;
+        }
+    }
+    if (rename(tmpPath.c_str(), path.c_str()) != 0)
+        aap::a_log_f(AAP_LOG_LEVEL_WARN, LOG_TAG, "Failed to replace plugin metadata index %s", path.c_str());
+}
+
 std::vector<PluginInformation*> PluginClientSystem::getInstalledPlugins(bool returnCacheIfExists, std::vector<std::string>* searchPaths) {
+    const std::lock_guard<std::mutex> lock{installed_plugins_mutex};
+    if (returnCacheIfExists && installed_plugins_cached && searchPaths == nullptr)
+        return installed_plugins;
+    if (!metadata_index_loaded)
+        loadMetadataIndex();
+
     std::vector<std::string> aapPaths{};
-    for (auto path : getPluginPaths())
+    for (auto path : searchPaths ? *searchPaths : getPluginPaths())
         getAAPMetadataPaths(path, aapPaths);
-    auto ret = getPluginsFromMetadataPaths(aapPaths);
+
+    // Reuse the entries whose stamps are unchanged, and parse everything else at once.
+    std::vector<std::string> pathsToParse{};
+    std::map<std::string, PluginMetadataStamp> stamps{};
+    for (auto& path : aapPaths) {
+        PluginMetadataStamp stamp{};
+        if (getMetadataStamp(path, stamp)) {
+            stamps[path] = stamp;
+            auto entry = metadata_entries.find(path);
+            if (entry != metadata_entries.end() &&
+                entry->second.stamp.modified_time_nanoseconds == stamp.modified_time_nanoseconds &&
+                entry->second.stamp.size == stamp.size)
+                continue;
+        }
+        pathsToParse.emplace_back(path);
+    }
+    bool indexChanged = false;
+    std::vector<PluginInformation*> unstamped{};
+    if (!pathsToParse.empty()) {
+        // Existing PluginInformation may still be referenced (e.g. by PluginListSnapshot), so
+        // replaced entries are not deleted.
+        for (auto& path : pathsToParse) {
+            auto stamp = stamps.find(path);
+            if (stamp != stamps.end()) {
+                metadata_entries[path] = MetadataEntry{stamp->second, {}};
+                indexChanged = true;
+            }
+        }
+        for (auto p : getPluginsFromMetadataPaths(pathsToParse)) {
+            auto entry = stamps.find(p->getMetadataFullPath()) != stamps.end() ?
+                    metadata_entries.find(p->getMetadataFullPath()) : metadata_entries.end();
+            if (entry != metadata_entries.end())
+                entry->second.plugins.emplace_back(p);
+            else
+                unstamped.emplace_back(p);
+        }
+    }
+
+    std::vector<PluginInformation*> ret{};
+    for (auto& path : aapPaths) {
+        if (stamps.find(path) == stamps.end())
+            continue;
+        for (auto p : metadata_entries[path].plugins)
+            ret.emplace_back(p);
+    }
+    for (auto p : unstamped)
+        ret.emplace_back(p);
+
+    if (searchPaths == nullptr) {
+        // drop the entries for the metadata that no longer exists.
+        std::set<std::string> current{aapPaths.begin(), aapPaths.end()};
+        for (auto it = metadata_entries.begin(); it != metadata_entries.end();) {
+            if (current.find(it->first) == current.end()) {
+                it = metadata_entries.erase(it);
+                indexChanged = true;
+            } else
+                it++;
+        }
+        installed_plugins = ret;
+        installed_plugins_cached = true;
+    }
+    if (indexChanged)
+        saveMetadataIndex();
     return ret;
 }
 
+void PluginClientSystem::invalidateInstalledPluginsCache() {
+    const std::lock_guard<std::mutex> lock{installed_plugins_mutex};
+    installed_plugins_cached = false;
+    installed_plugins.clear();
+}
+
 } // namespace aap
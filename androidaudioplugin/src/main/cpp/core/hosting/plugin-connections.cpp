@@ -6,7 +6,9 @@ namespace aap {
 
 PluginListSnapshot PluginListSnapshot::queryServices() {
     PluginListSnapshot ret{};
-    for (auto p : PluginClientSystem::getInstance()->getInstalledPlugins())
+    // rescan, so that the snapshot reflects plugins installed or updated since the last query.
+    // Unchanged metadata is not parsed again.
+    for (auto p : PluginClientSystem::getInstance()->getInstalledPlugins(false))
         ret.plugins.emplace_back(p);
     return ret;
 }
@@ -1,8 +1,14 @@
 #ifndef AAP_CORE_HOSTING_PLUGIN_PARAMETER_STATE_H
 #define AAP_CORE_HOSTING_PLUGIN_PARAMETER_STATE_H
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <time.h>
+#include <vector>
 
 namespace aap {
 
@@ -11,13 +17,181 @@ class RemotePluginInstance;
 
 namespace internal {
 
-void cleanupParameterState(PluginInstance& instance);
+/**
+ * Per-instance parameter value table that the audio thread updates without locks or allocation.
+ *
+ * The parameter layout (ids, ranges) is built on a non-RT thread and published as an immutable
+ * `Layout` through an atomic pointer. Each value is an atomic slot, and a sequence counter
+ * (seqlock) lets readers on any thread take a consistent snapshot of all values without
+ * contending with the single writer (`process()`), which never waits.
+ *
+ * Readers hold the layout through a `LayoutReference`, which registers them in one of two reader
+ * counters (chosen by the publish epoch). `publish()` swaps the layout, advances the epoch, and
+ * frees the previous layout once the readers that may still hold it are gone. It also carries
+ * the values over by id, including the ones that the audio thread stored during the swap.
+ */
+class ParameterValueTable {
+public:
+    struct Layout {
+        int32_t count{0};
+        // sorted by id, for binary search on the audio thread.
+        std::unique_ptr<int32_t[]> sorted_ids{};
+        std::unique_ptr<int32_t[]> sorted_indices{};
+        std::unique_ptr<double[]> min_values{};
+        std::unique_ptr<double[]> max_values{};
+        std::unique_ptr<std::atomic<double>[]> values{};
+        std::atomic<uint32_t> sequence{0};
+
+        explicit Layout(int32_t count)
+                : count(count),
+                  sorted_ids(new int32_t[count]),
+                  sorted_indices(new int32_t[count]),
+                  min_values(new double[count]),
+                  max_values(new double[count]),
+                  values(new std::atomic<double>[count]) {}
+
+        // returns -1 if not found.
+        int32_t indexOf(int32_t parameterId) const {
+            auto end = sorted_ids.get() + count;
+            auto it = std::lower_bound(sorted_ids.get(), end, parameterId);
+            return it != end && *it == parameterId ? sorted_indices[it - sorted_ids.get()] : -1;
+        }
+    };
+
+private:
+    std::atomic<Layout*> current{nullptr};
+    std::mutex publish_mutex{};
+    // owns `current`. Guarded by `publish_mutex`.
+    std::unique_ptr<Layout> current_owner{};
+    mutable std::atomic<uint32_t> epoch{0};
+    // the number of readers that entered at an even / odd epoch.
+    mutable std::atomic<int32_t> readers[2]{};
+
+public:
+    // RT-safe (lock-free): keeps the layout it refers to alive until it is destroyed. The layout
+    // may be null before the first publish().
+    class LayoutReference {
+        const ParameterValueTable& table;
+        uint32_t parity{0};
+        Layout* layout{nullptr};
+
+    public:
+        explicit LayoutReference(const ParameterValueTable& table) : table(table) {
+            while (true) {
+                auto e = table.epoch.load();
+                parity = e & 1;
+                table.readers[parity].fetch_add(1);
+                // publish() might have waited for this counter already, if the epoch moved on.
+                if (table.epoch.load() == e)
+                    break;
+                table.readers[parity].fetch_sub(1);
+            }
+            layout = table.current.load();
+        }
+        ~LayoutReference() { table.readers[parity].fetch_sub(1, std::memory_order_release); }
+        LayoutReference(const LayoutReference&) = delete;
+        LayoutReference& operator=(const LayoutReference&) = delete;
+
+        Layout* get() const { return layout; }
+    };
+
+    // non-RT. `layout` must be fully populated, with default values. The values of the parameters
+    // that the previous layout has too (by id) are carried over.
+    void publish(std::unique_ptr<Layout> layout) {
+        const std::lock_guard<std::mutex> lock{publish_mutex};
+        auto previous = current_owner.get();
+        // (index in `layout`, index in `previous`, the copied value)
+        struct Carried { int32_t index; int32_t previousIndex; double value; };
+        std::vector<Carried> carried{};
+        if (previous) {
+            for (int32_t k = 0; k < layout->count; k++) {
+                auto previousIndex = previous->indexOf(layout->sorted_ids[k]);
+                if (previousIndex >= 0)
+                    carried.emplace_back(Carried{layout->sorted_indices[k], previousIndex, 0});
+            }
+            // copy them as a consistent snapshot, like snapshot() does.
+            while (true) {
+                auto seq = previous->sequence.load(std::memory_order_acquire);
+                if (seq & 1)
+                    continue;
+                for (auto& c : carried)
+                    c.value = previous->values[c.previousIndex].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (previous->sequence.load(std::memory_order_relaxed) == seq)
+                    break;
+            }
+            for (auto& c : carried)
+                layout->values[c.index].store(c.value, std::memory_order_relaxed);
+        }
+
+        current.store(layout.get());
+        auto oldParity = epoch.fetch_add(1) & 1;
+        // wait for the readers that may still see the previous layout (the audio thread is one).
+        const auto delay = timespec{0, 100000}; // 100 microseconds
+        while (readers[oldParity].load(std::memory_order_acquire) > 0)
+            clock_nanosleep(CLOCK_REALTIME, 0, &delay, nullptr);
+
+        // The audio thread may have stored values into the previous layout after we copied them.
+        // Take them unless it has stored newer ones into the new layout meanwhile.
+        for (auto& c : carried) {
+            auto latest = previous->values[c.previousIndex].load(std::memory_order_relaxed);
+            if (latest != c.value)
+                layout->values[c.index].compare_exchange_strong(c.value, latest, std::memory_order_relaxed);
+        }
+        current_owner = std::move(layout);
+    }
+
+    // RT-safe, single writer only: the audio thread, in updateParameterValueCacheFromOutputBuffer().
+    // Values stored between beginWrite() and endWrite() become visible to snapshot() readers
+    // atomically as a batch.
+    static void beginWrite(Layout* layout) {
+        auto seq = layout->sequence.load(std::memory_order_relaxed);
+        layout->sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    static void endWrite(Layout* layout) {
+        layout->sequence.fetch_add(1, std::memory_order_release);
+    }
+
+    // RT-safe (wait-free) single value read.
+    bool tryGetValue(int32_t index, double& value) const {
+        LayoutReference reference{*this};
+        auto layout = reference.get();
+        if (!layout || index < 0 || index >= layout->count)
+            return false;
+        value = layout->values[index].load(std::memory_order_relaxed);
+        return true;
+    }
+
+    // Copies up to `capacity` values into `dst` as a consistent snapshot, and returns the number
+    // of copied values. It retries while the audio thread is in the middle of a write batch.
+    int32_t snapshot(double* dst, int32_t capacity) const {
+        LayoutReference reference{*this};
+        auto layout = reference.get();
+        if (!layout || !dst)
+            return 0;
+        auto n = std::min(capacity, layout->count);
+        while (true) {
+            auto seq = layout->sequence.load(std::memory_order_acquire);
+            if (seq & 1)
+                continue;
+            for (int32_t i = 0; i < n; i++)
+                dst[i] = layout->values[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (layout->sequence.load(std::memory_order_relaxed) == seq)
+                return n;
+        }
+    }
+};
+
 void rebuildParameterIndexAndValues(PluginInstance& instance);
 // Reindexes ids and preserves values from the already-populated cached_parameters (no rescan).
 void reindexParameterValues(PluginInstance& instance);
+// RT-safe: neither locks nor allocates.
 void updateParameterValueCacheFromOutputBuffer(PluginInstance& instance, void* buffer);
-bool updateCachedParameterValueById(PluginInstance& instance, int32_t parameterId, double plainValue);
 double getParameterValue(PluginInstance& instance, int32_t index);
+// Copies a consistent snapshot of the current parameter values; returns the number of copied values.
+int32_t snapshotParameterValues(PluginInstance& instance, double* values, int32_t capacity);
 void handleParameterLayoutChanged(PluginInstance& instance);
 
 }
@@ -0,0 +1,192 @@
+#include <unistd.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#if ANDROID
+#include <android/trace.h>
+#endif
+#include "aap/core/host/process-trace.h"
+
+namespace {
+    const char* stage_names[aap::PROCESS_TRACE_STAGE_COUNT] {
+        "process",
+        "aapxs_input_merge",
+        "plugin_process",
+        "complete_session",
+        "filter_aapxs_replies",
+        "parameter_cache_update"
+    };
+
+    int32_t current_thread_id() {
+#if defined(__linux__)
+        // gettid() is a syscall; we do not want one for every event.
+        static thread_local int32_t tid = 0;
+        if (tid == 0)
+            tid = (int32_t) syscall(SYS_gettid);
+        return tid;
+#else
+        return 0;
+#endif
+    }
+}
+
+const char* aap::getProcessTraceStageName(ProcessTraceStage stage) {
+    return stage < PROCESS_TRACE_STAGE_COUNT ? stage_names[stage] : "(unknown)";
+}
+
+// LatencyHistogram
+
+uint64_t aap::LatencyHistogram::getBucketUpperBound(int32_t index) {
+    if (index < (1 << SUB_BUCKET_BITS))
+        return (uint64_t) index;
+    int32_t exponent = (index >> SUB_BUCKET_BITS) + SUB_BUCKET_BITS - 1;
+    uint64_t subBucket = (uint64_t) (index & ((1 << SUB_BUCKET_BITS) - 1));
+    uint64_t width = 1ull << (exponent - SUB_BUCKET_BITS);
+    return (((1ull << SUB_BUCKET_BITS) + subBucket) << (exponent - SUB_BUCKET_BITS)) + width - 1;
+}
+
+uint64_t aap::LatencyHistogram::getMean() const {
+    auto n = getCount();
+    return n == 0 ? 0 : total.load(std::memory_order_relaxed) / n;
+}
+
+uint64_t aap::LatencyHistogram::getPercentile(double percentile) const {
+    uint64_t counts[NUM_BUCKETS];
+    uint64_t n = 0;
+    for (int32_t i = 0; i < NUM_BUCKETS; i++)
+        n += counts[i] = buckets[i].load(std::memory_order_relaxed);
+    if (n == 0)
+        return 0;
+    auto rank = (uint64_t) std::max(1.0, percentile / 100.0 * (double) n + 0.5);
+    uint64_t seen = 0;
+    for (int32_t i = 0; i < NUM_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank)
+            return std::min(getBucketUpperBound(i), getMax());
+    }
+    return getMax();
+}
+
+void aap::LatencyHistogram::reset() {
+    for (auto& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_release);
+}
+
+// ProcessTrace
+
+void aap::ProcessTrace::setSectionNamePrefix(const char* sectionNamePrefix) {
+    for (int32_t i = 0; i < PROCESS_TRACE_STAGE_COUNT; i++) {
+        if (i == PROCESS_TRACE_STAGE_TOTAL)
+            snprintf(section_names[i], sizeof(section_names[i]), "%s", sectionNamePrefix);
+        else
+            snprintf(section_names[i], sizeof(section_names[i]), "%s::%s", sectionNamePrefix, stage_names[i]);
+    }
+}
+
+void aap::ProcessTrace::setFlags(uint32_t newFlags, uint32_t eventCapacity) {
+    // The event buffer is never reallocated, so the audio thread can keep writing to it.
+    if ((newFlags & PROCESS_TRACE_EVENTS) && !events) {
+        uint32_t capacity = 1;
+        while (capacity < eventCapacity)
+            capacity <<= 1;
+        events.reset(new ProcessTraceEvent[capacity]);
+        event_capacity = capacity;
+    }
+    flags.store(newFlags, std::memory_order_release);
+}
+
+int64_t aap::ProcessTrace::nowNanoseconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void aap::ProcessTrace::beginCycle() {
+    cycle_flags = flags.load(std::memory_order_acquire);
+#if ANDROID
+    atrace = ATrace_isEnabled();
+#endif
+    active = cycle_flags != 0 || atrace;
+}
+
+void aap::ProcessTrace::beginStage(ProcessTraceStage stage, int64_t& beginNanoseconds) {
+#if ANDROID
+    if (atrace)
+        ATrace_beginSection(section_names[stage]);
+#endif
+    beginNanoseconds = nowNanoseconds();
+}
+
+void aap::ProcessTrace::endStage(ProcessTraceStage stage, int64_t beginNanoseconds) {
+    auto duration = nowNanoseconds() - beginNanoseconds;
+    if (cycle_flags & PROCESS_TRACE_HISTOGRAMS)
+        histograms[stage].record((uint64_t) duration);
+    if ((cycle_flags & PROCESS_TRACE_EVENTS) && events) {
+        auto position = event_write_position.load(std::memory_order_relaxed);
+        events[position & (event_capacity - 1)] = ProcessTraceEvent{beginNanoseconds, duration, current_thread_id(), stage};
+        event_write_position.store(position + 1, std::memory_order_release);
+    }
+#if ANDROID
+    if (atrace) {
+        if (stage == PROCESS_TRACE_STAGE_TOTAL)
+            ATrace_setCounter(section_names[stage], duration);
+        ATrace_endSection();
+    }
+#endif
+}
+
+void aap::ProcessTrace::resetHistograms() {
+    for (auto& h : histograms)
+        h.reset();
+}
+
+std::string aap::ProcessTrace::dumpHistograms() const {
+    std::string result{"stage count p50(us) p99(us) max(us) mean(us)\n"};
+    char line[256];
+    for (int32_t i = 0; i < PROCESS_TRACE_STAGE_COUNT; i++) {
+        auto& h = histograms[i];
+        snprintf(line, sizeof(line), "%s %" PRIu64 " %.3f %.3f %.3f %.3f\n",
+                 stage_names[i], h.getCount(),
+                 h.getPercentile(50) / 1000.0, h.getPercentile(99) / 1000.0,
+                 h.getMax() / 1000.0, h.getMean() / 1000.0);
+        result += line;
+    }
+    return result;
+}
+
+std::string aap::ProcessTrace::dumpEventsAsJson() const {
+    std::string result{"{\"traceEvents\":["};
+    if (events) {
+        auto end = event_write_position.load(std::memory_order_acquire);
+        auto begin = end > event_capacity ? end - event_capacity : 0;
+        std::vector<ProcessTraceEvent> copied{};
+        copied.reserve(end - begin);
+        for (auto p = begin; p < end; p++)
+            copied.emplace_back(events[p & (event_capacity - 1)]);
+        // the audio thread may have overwritten the oldest ones (and may be writing one more)
+        // while we were copying.
+        auto after = event_write_position.load(std::memory_order_acquire);
+        auto firstValid = std::max(begin, after + 1 > event_capacity ? after + 1 - event_capacity : 0);
+        auto pid = (int32_t) getpid();
+        char item[256];
+        bool first = true;
+        for (auto p = firstValid; p < end; p++) {
+            auto& e = copied[p - begin];
+            snprintf(item, sizeof(item),
+                     "%s{\"name\":\"%s\",\"cat\":\"aap\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d}",
+                     first ? "" : ",", section_names[e.stage], e.begin_ns / 1000.0, e.duration_ns / 1000.0, pid, e.thread_id);
+            result += item;
+            first = false;
+        }
+    }
+    result += "],\"displayTimeUnit\":\"ns\"}";
+    return result;
+}
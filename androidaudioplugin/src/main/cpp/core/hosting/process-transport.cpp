@@ -0,0 +1,233 @@
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cerrno>
+#include <ctime>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#include "aap/core/host/process-transport.h"
+#include "aap/unstable/logging.h"
+
+#define LOG_TAG "AAP.ProcessTransport"
+
+namespace {
+#if defined(__linux__)
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be 32-bit");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "futex word must be lock-free");
+
+    // The control block is MAP_SHARED across processes, so we must not use FUTEX_PRIVATE_FLAG.
+    int futex_wait(std::atomic<uint32_t>* word, uint32_t expected, int64_t timeoutInNanoseconds) {
+        timespec timeout{(time_t) (timeoutInNanoseconds / 1000000000), (long) (timeoutInNanoseconds % 1000000000)};
+        return (int) syscall(SYS_futex, (uint32_t*) word, FUTEX_WAIT, expected,
+                             timeoutInNanoseconds > 0 ? &timeout : nullptr, nullptr, 0);
+    }
+
+    void futex_wake(std::atomic<uint32_t>* word) {
+        syscall(SYS_futex, (uint32_t*) word, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+    }
+#endif
+
+    int64_t monotonic_nanoseconds() {
+        timespec ts{};
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+
+    // A reply usually arrives within a few microseconds after the service woke up, so we spin
+    // briefly before falling back to the (syscall-based) futex wait.
+    const int32_t REPLY_SPIN_COUNT = 256;
+    // The service render thread wakes up periodically to check termination.
+    const int64_t SERVICE_IDLE_WAIT_NANOSECONDS = 100000000;
+
+    // Android's THREAD_PRIORITY_URGENT_AUDIO, for when realtime scheduling is not permitted.
+    const int32_t URGENT_AUDIO_NICE = -19;
+
+    // Makes the calling (render) thread follow the scheduling of the client's audio thread.
+    // `priority` is the nice value for the non-realtime policies.
+    void follow_caller_scheduling(int32_t policy, int32_t priority) {
+        sched_param param{};
+        if (policy != SCHED_FIFO && policy != SCHED_RR) {
+            pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+#if defined(__linux__)
+            setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), priority);
+#endif
+            return;
+        }
+        param.sched_priority = priority;
+        auto error = pthread_setschedparam(pthread_self(), policy, &param);
+        if (error == 0)
+            return;
+#if defined(__linux__)
+        // the service process is usually not permitted to use realtime scheduling.
+        if (setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), URGENT_AUDIO_NICE) == 0)
+            return;
+#endif
+        aap::a_log_f(AAP_LOG_LEVEL_WARN, LOG_TAG,
+                     "The render thread could not get the scheduling of the audio thread (error %d)", error);
+    }
+
+    aap::ProcessControlBlock* map_control_block(int32_t fd) {
+        if (fd < 0)
+            return nullptr;
+        auto mapped = mmap(nullptr, sizeof(aap::ProcessControlBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        return mapped == MAP_FAILED ? nullptr : (aap::ProcessControlBlock*) mapped;
+    }
+}
+
+// client
+
+aap::FutexProcessTransport::FutexProcessTransport(int32_t fd) : fd(fd) {
+    if (!isSupported())
+        return;
+    block = map_control_block(fd);
+    if (!block)
+        aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Failed to mmap process control block (fd: %d)", fd);
+}
+
+aap::FutexProcessTransport::~FutexProcessTransport() {
+    if (block) {
+        block->terminated.store(1, std::memory_order_release);
+#if defined(__linux__)
+        futex_wake(&block->request_sequence);
+#endif
+        munmap(block, sizeof(ProcessControlBlock));
+    }
+    if (fd >= 0)
+        close(fd);
+}
+
+bool aap::FutexProcessTransport::isSupported() {
+#if defined(__linux__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool aap::FutexProcessTransport::isServiceReady() {
+    return block && block->service_ready.load(std::memory_order_acquire) == ProcessControlBlock::SERVICE_READY_MAGIC;
+}
+
+bool aap::FutexProcessTransport::process(int32_t frameCount, int64_t timeoutInNanoseconds) {
+#if defined(__linux__)
+    if (!block)
+        return false;
+    block->frame_count = frameCount;
+    block->timeout_in_nanoseconds = timeoutInNanoseconds;
+    // publish the scheduling of the calling thread, which rarely changes (it is a syscall).
+    auto self = pthread_self();
+    if (!has_last_caller || !pthread_equal(self, last_caller)) {
+        int policy;
+        sched_param param{};
+        if (pthread_getschedparam(self, &policy, &param) == 0) {
+            auto priority = param.sched_priority;
+            if (policy != SCHED_FIFO && policy != SCHED_RR)
+                priority = getpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid));
+            block->caller_sched_priority.store(priority, std::memory_order_relaxed);
+            block->caller_sched_policy.store(policy, std::memory_order_relaxed);
+        }
+        last_caller = self;
+        has_last_caller = true;
+    }
+    auto requested = ++sequence;
+    block->request_sequence.store(requested, std::memory_order_release);
+    futex_wake(&block->request_sequence);
+
+    for (int32_t i = 0; i < REPLY_SPIN_COUNT; i++)
+        if (block->reply_sequence.load(std::memory_order_acquire) == requested)
+            return true;
+
+    // non-positive timeout means "wait infinitely".
+    bool waitInfinitely = timeoutInNanoseconds <= 0;
+    auto deadline = waitInfinitely ? 0 : monotonic_nanoseconds() + timeoutInNanoseconds;
+    while (true) {
+        auto replied = block->reply_sequence.load(std::memory_order_acquire);
+        if (replied == requested)
+            return true;
+        int64_t remaining = 0;
+        if (!waitInfinitely) {
+            remaining = deadline - monotonic_nanoseconds();
+            if (remaining <= 0)
+                return false;
+        }
+        if (futex_wait(&block->reply_sequence, replied, remaining) == -1 &&
+            errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT)
+            return false;
+    }
+#else
+    (void) frameCount;
+    (void) timeoutInNanoseconds;
+    return false;
+#endif
+}
+
+// service
+
+aap::FutexProcessTransportService::FutexProcessTransportService(
+        int32_t fd,
+        std::function<void(int32_t frameCount, int64_t timeoutInNanoseconds)> processFunc)
+        : fd(fd), process_func(std::move(processFunc)) {
+}
+
+aap::FutexProcessTransportService::~FutexProcessTransportService() {
+    stop();
+    if (block)
+        munmap(block, sizeof(ProcessControlBlock));
+    if (fd >= 0)
+        close(fd);
+}
+
+bool aap::FutexProcessTransportService::start() {
+    if (!FutexProcessTransport::isSupported())
+        return false;
+    if (render_thread.joinable())
+        return true;
+    block = map_control_block(fd);
+    if (!block) {
+        aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Failed to mmap process control block (fd: %d)", fd);
+        return false;
+    }
+    render_thread = std::thread([this] { run(); });
+    block->service_ready.store(ProcessControlBlock::SERVICE_READY_MAGIC, std::memory_order_release);
+    return true;
+}
+
+void aap::FutexProcessTransportService::stop() {
+    if (!render_thread.joinable())
+        return;
+    stopping.store(true, std::memory_order_release);
+#if defined(__linux__)
+    futex_wake(&block->request_sequence);
+#endif
+    render_thread.join();
+    block->service_ready.store(0, std::memory_order_release);
+}
+
+void aap::FutexProcessTransportService::run() {
+#if defined(__linux__)
+    uint32_t processed = block->request_sequence.load(std::memory_order_acquire);
+    int32_t followedPolicy = -1, followedPriority = -1;
+    while (!stopping.load(std::memory_order_acquire) && !block->terminated.load(std::memory_order_acquire)) {
+        auto requested = block->request_sequence.load(std::memory_order_acquire);
+        if (requested == processed) {
+            futex_wait(&block->request_sequence, processed, SERVICE_IDLE_WAIT_NANOSECONDS);
+            continue;
+        }
+        auto policy = block->caller_sched_policy.load(std::memory_order_relaxed);
+        auto priority = block->caller_sched_priority.load(std::memory_order_relaxed);
+        if (policy != followedPolicy || priority != followedPriority) {
+            follow_caller_scheduling(policy, priority);
+            followedPolicy = policy;
+            followedPriority = priority;
+        }
+        process_func(block->frame_count, block->timeout_in_nanoseconds);
+        processed = requested;
+        block->reply_sequence.store(requested, std::memory_order_release);
+        futex_wake(&block->reply_sequence);
+    }
+#endif
+}
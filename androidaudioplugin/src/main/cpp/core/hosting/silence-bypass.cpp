@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "aap/core/host/silence-bypass.h"
+#include "aap/core/host/plugin-instance.h"
+#include "aap/ext/midi.h"
+#include "aap/ext/tail.h"
+#include "aap/unstable/logging.h"
+
+#define LOG_TAG "AAP.SilenceBypass"
+
+namespace {
+    // scan unit; the inner loop has no early exit so that it can be vectorized.
+    const int32_t silence_scan_chunk = 64;
+
+    bool hasMidiEvents(aap_buffer_t* buffer, int32_t port) {
+        auto header = (AAPMidiBufferHeader*) buffer->get_buffer(buffer, port);
+        return header && header->length > 0;
+    }
+}
+
+bool aap::SilenceBypass::isSilent(const float* data, int32_t numFrames) {
+    for (int32_t i = 0; i < numFrames; i += silence_scan_chunk) {
+        auto end = std::min(numFrames, i + silence_scan_chunk);
+        float peak = 0;
+        for (int32_t j = i; j < end; j++) {
+            auto v = std::fabs(data[j]);
+            peak = v > peak ? v : peak;
+        }
+        if (peak > silence_threshold)
+            return false;
+    }
+    return true;
+}
+
+void aap::SilenceBypass::setEnabled(bool enabled) {
+    this->enabled = enabled;
+    if (!enabled) {
+        bypassing = false;
+        silent_input_frames = 0;
+    }
+}
+
+void aap::SilenceBypass::configure(PluginInstance* instance, int32_t tailTimeInMilliseconds) {
+    tail_frames.store(-1, std::memory_order_release);
+    audio_in_ports.clear();
+    audio_out_ports.clear();
+    midi_in_ports.clear();
+    midi_out_ports.clear();
+    for (int32_t i = 0, n = instance->getNumPorts(); i < n; i++) {
+        auto port = instance->getPort(i);
+        bool isInput = port->getPortDirection() == AAP_PORT_DIRECTION_INPUT;
+        switch (port->getContentType()) {
+            case AAP_CONTENT_TYPE_AUDIO:
+                (isInput ? audio_in_ports : audio_out_ports).emplace_back(i);
+                break;
+            case AAP_CONTENT_TYPE_MIDI:
+            case AAP_CONTENT_TYPE_MIDI2:
+                (isInput ? midi_in_ports : midi_out_ports).emplace_back(i);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // an instrument without audio inputs keeps ringing by itself as long as it gets no event,
+    // so only the tail decides. A plugin without any input would never be woken up again.
+    int64_t tailFrames = tailTimeInMilliseconds < 0 || (audio_in_ports.empty() && midi_in_ports.empty()) ?
+            -1 : (int64_t) tailTimeInMilliseconds * instance->getSampleRate() / 1000;
+    silent_input_frames = 0;
+    bypassing = false;
+    outputs_cleared = false;
+    tail_frames.store(tailFrames, std::memory_order_release);
+
+    aap::a_log_f(AAP_LOG_LEVEL_DEBUG, LOG_TAG, "instance %d: tail time %d ms (%s)",
+                 instance->getInstanceId(), tailTimeInMilliseconds,
+                 tailFrames < 0 ? "never bypassed" : "bypassed while silent");
+}
+
+bool aap::SilenceBypass::areInputsSilent(aap_buffer_t* buffer, int32_t frameCount) {
+    for (auto port : midi_in_ports)
+        if (hasMidiEvents(buffer, port))
+            return false;
+    for (auto port : audio_in_ports)
+        if (!isSilent((const float*) buffer->get_buffer(buffer, port), frameCount))
+            return false;
+    return true;
+}
+
+bool aap::SilenceBypass::areOutputsSilent(aap_buffer_t* buffer, int32_t frameCount) {
+    for (auto port : midi_out_ports)
+        if (hasMidiEvents(buffer, port))
+            return false;
+    for (auto port : audio_out_ports)
+        if (!isSilent((const float*) buffer->get_buffer(buffer, port), frameCount))
+            return false;
+    return true;
+}
+
+bool aap::SilenceBypass::beginBlock(aap_buffer_t* buffer, int32_t frameCount) {
+    if (!enabled || tail_frames.load(std::memory_order_acquire) < 0)
+        return false;
+
+    input_silent_in_block = areInputsSilent(buffer, frameCount);
+    if (!input_silent_in_block) {
+        // resume right at this block.
+        silent_input_frames = 0;
+        bypassing = false;
+        return false;
+    }
+    if (!bypassing)
+        return false;
+
+    // the audio outputs stay untouched by anyone else while we are bypassing, so clearing them once is enough.
+    if (!outputs_cleared) {
+        for (auto port : audio_out_ports)
+            memset(buffer->get_buffer(buffer, port), 0, buffer->get_buffer_size(buffer, port));
+        outputs_cleared = true;
+    }
+    for (auto port : midi_out_ports) {
+        auto header = (AAPMidiBufferHeader*) buffer->get_buffer(buffer, port);
+        if (header)
+            header->length = 0;
+    }
+    skipped_blocks++;
+    return true;
+}
+
+void aap::SilenceBypass::endBlock(aap_buffer_t* buffer, int32_t frameCount) {
+    auto tailFrames = tail_frames.load(std::memory_order_acquire);
+    if (!enabled || tailFrames < 0 || !input_silent_in_block)
+        return;
+    silent_input_frames += frameCount;
+    if (silent_input_frames > tailFrames && areOutputsSilent(buffer, frameCount)) {
+        bypassing = true;
+        outputs_cleared = false;
+    }
+}
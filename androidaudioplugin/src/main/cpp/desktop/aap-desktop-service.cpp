@@ -0,0 +1,24 @@
+#include <csignal>
+#include <cstdio>
+#include "aap/core/host/desktop/audio-plugin-host-desktop.h"
+
+// Serves the plugins in one plugin package (a directory under AAP_PLUGIN_PATH) over a Unix domain socket.
+
+static aap::DesktopPluginService* service{nullptr};
+
+static void handleSignal(int) {
+    if (service)
+        service->stop();
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "USAGE: %s [package name]\n", argv[0]);
+        return 1;
+    }
+    aap::DesktopPluginService svc{argv[1]};
+    service = &svc;
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+    return svc.run() ? 0 : 2;
+}
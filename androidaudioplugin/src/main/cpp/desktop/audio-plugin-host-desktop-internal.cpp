@@ -6,38 +6,710 @@
 
 #if !ANDROID
 
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include "aap/ext/gui.h"
+#include "aap/ext/midi.h"
+#include "aap/ext/parameters.h"
+#include "aap/ext/plugin-info.h"
+#include "aap/ext/port-config.h"
+#include "aap/ext/presets.h"
+#include "aap/ext/state.h"
+#include "aap/core/host/shared-memory-store.h"
+#include "aap/core/host/process-transport.h"
+#include "../core/hosting/audio-plugin-host-internals.h"
+#include "desktop-ipc.h"
+
+#define LOG_TAG "AAP.desktop"
+
 extern "C"
 int32_t createGui(std::string pluginId, int32_t instanceId, void* audioPluginView) {
-	assert(false); // It is not implemented (not even suposed to be).
+	// It is not implemented (not even suposed to be).
+	aap::a_log_f(AAP_LOG_LEVEL_WARN, LOG_TAG, "createGui() is not supported on desktop (%s)", pluginId.c_str());
+	return -1;
 }
 
 namespace aap {
 
+// Reads `${XDG_CONFIG_HOME:-~/.config}/androidaudioplugin/midi-settings.conf`, whose lines are
+// `<pluginId> <settings>`. It is the desktop counterpart of the SharedPreferences on Android.
 int32_t getMidiSettingsFromLocalConfig(std::string pluginId) {
-	assert(false); // FIXME: implement
+	std::string dir{};
+	if (auto xdg = getenv("XDG_CONFIG_HOME"))
+		dir = xdg;
+	else if (auto home = getenv("HOME"))
+		dir = std::string{home} + "/.config";
+	else
+		return 0;
+	std::ifstream file{dir + "/androidaudioplugin/midi-settings.conf"};
+	std::string id;
+	int32_t settings;
+	while (file >> id >> settings)
+		if (id == pluginId)
+			return settings;
+	return 0;
+}
+
+// Plugin directory scanning
+
+int32_t DesktopPluginClientSystem::createSharedMemory(size_t size) {
+	int32_t fd = memfd_create("aap-shm", MFD_CLOEXEC);
+	if (fd < 0)
+		return -1;
+	if (ftruncate(fd, (off_t) size) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+std::vector<std::string> DesktopPluginClientSystem::getPluginPaths() {
+	std::vector<std::string> ret{};
+	std::string paths{};
+	if (auto env = getenv(AAP_DESKTOP_PLUGIN_PATH_ENV))
+		paths = env;
+	else if (auto home = getenv("HOME"))
+		paths = std::string{home} + "/.local/lib/aap:/usr/local/lib/aap:/usr/lib/aap";
+	std::stringstream ss{paths};
+	std::string path;
+	while (std::getline(ss, path, ':'))
+		if (!path.empty())
+			ret.emplace_back(path);
+	return ret;
+}
+
+void DesktopPluginClientSystem::getAAPMetadataPaths(std::string path, std::vector<std::string>& results) {
+	auto dir = opendir(path.c_str());
+	if (!dir)
+		return;
+	while (auto entry = readdir(dir)) {
+		std::string name{entry->d_name};
+		if (name == "." || name == "..")
+			continue;
+		auto full = path + "/" + name;
+		struct stat st;
+		if (stat(full.c_str(), &st) != 0)
+			continue;
+		if (S_ISDIR(st.st_mode))
+			getAAPMetadataPaths(full, results);
+		else if (name == "aap_metadata.xml")
+			results.emplace_back(full);
+	}
+	closedir(dir);
+}
+
+std::vector<PluginInformation*> DesktopPluginClientSystem::getPluginsFromMetadataPaths(std::vector<std::string>& aapMetadataPaths) {
+	std::vector<PluginInformation*> results{};
+	for (auto& path : aapMetadataPaths) {
+		// package name is the name of the directory that contains aap_metadata.xml.
+		auto dirEnd = path.find_last_of('/');
+		auto dir = dirEnd == std::string::npos ? std::string{"."} : path.substr(0, dirEnd);
+		auto packageName = dir.substr(dir.find_last_of('/') + 1);
+		for (auto p : parseAAPMetadata(path, packageName, true))
+			results.emplace_back(p);
+	}
+	return results;
+}
+
+bool DesktopPluginClientSystem::getMetadataStamp(const std::string& aapMetadataPath, PluginMetadataStamp& stamp) {
+	struct stat st;
+	if (stat(aapMetadataPath.c_str(), &st) != 0)
+		return false;
+	stamp.modified_time_nanoseconds = (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+	stamp.size = (int64_t) st.st_size;
+	return true;
+}
+
+std::string DesktopPluginClientSystem::getMetadataIndexPath() {
+	if (auto env = getenv(AAP_DESKTOP_METADATA_INDEX_PATH_ENV))
+		return env;
+	std::string dir{};
+	if (auto xdg = getenv("XDG_CACHE_HOME"))
+		dir = xdg;
+	else if (auto home = getenv("HOME"))
+		dir = std::string{home} + "/.cache";
+	else
+		return "";
+	mkdir(dir.c_str(), 0755);
+	dir += "/androidaudioplugin";
+	mkdir(dir.c_str(), 0755);
+	return dir + "/plugin-metadata.idx";
+}
+
+std::string getDesktopServiceSocketPath(const std::string& packageName) {
+	std::string dir{"/tmp"};
+	if (auto env = getenv(AAP_DESKTOP_SERVICE_SOCKET_DIR_ENV))
+		dir = env;
+	else if (auto xdg = getenv("XDG_RUNTIME_DIR"))
+		dir = xdg;
+	return dir + "/aap-" + packageName + ".sock";
+}
+
+void DesktopPluginClientSystem::ensurePluginServiceConnected(aap::PluginClientConnectionList* connections, std::string serviceName, std::function<void(std::string&)> callback) {
+	std::string error{};
+	if (connections->getServiceHandleForConnectedPlugin(serviceName, AAP_DESKTOP_SERVICE_CLASS_NAME)) {
+		callback(error);
+		return;
+	}
+	auto path = getDesktopServiceSocketPath(serviceName);
+	sockaddr_un addr{};
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+	int32_t fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0 || connect(fd, (sockaddr*) &addr, sizeof(addr)) < 0) {
+		if (fd >= 0)
+			close(fd);
+		error = std::string{"Could not connect to plugin service at "} + path;
+		callback(error);
+		return;
+	}
+	connections->add(std::make_unique<PluginClientConnection>(serviceName, AAP_DESKTOP_SERVICE_CLASS_NAME,
+															  new DesktopPluginClientConnectionData(fd)));
+	callback(error);
+}
+
+// aap_metadata.xml parser.
+// It covers the same elements and attributes as AudioPluginHostHelper.parseAapMetadata() in Kotlin.
+// It is not a general XML parser (no DTD, no CDATA), which aap_metadata.xml does not need.
+
+namespace {
+	struct XmlElement {
+		std::string name{}; // local name, without prefix
+		std::map<std::string, std::string> attributes{}; // keyed by local name, without prefix
+		bool isEnd{false};
+		bool isEmpty{false};
+	};
+
+	std::string localName(const std::string& qname) {
+		auto idx = qname.find(':');
+		return idx == std::string::npos ? qname : qname.substr(idx + 1);
+	}
+
+	std::string unescapeXml(const std::string& s) {
+		std::string ret{};
+		for (size_t i = 0; i < s.size(); i++) {
+			if (s[i] != '&') {
+				ret += s[i];
+				continue;
+			}
+			auto end = s.find(';', i);
+			if (end == std::string::npos) {
+				ret += s.substr(i);
+				break;
+			}
+			auto entity = s.substr(i + 1, end - i - 1);
+			if (entity == "amp") ret += '&';
+			else if (entity == "lt") ret += '<';
+			else if (entity == "gt") ret += '>';
+			else if (entity == "quot") ret += '"';
+			else if (entity == "apos") ret += '\'';
+			else ret += s.substr(i, end - i + 1);
+			i = end;
+		}
+		return ret;
+	}
+
+	// Returns false at the end of the document.
+	bool nextElement(const std::string& xml, size_t& pos, XmlElement& element) {
+		while (true) {
+			auto start = xml.find('<', pos);
+			if (start == std::string::npos)
+				return false;
+			if (xml.compare(start, 4, "<!--") == 0) {
+				auto end = xml.find("-->", start);
+				if (end == std::string::npos)
+					return false;
+				pos = end + 3;
+				continue;
+			}
+			auto end = xml.find('>', start);
+			if (end == std::string::npos)
+				return false;
+			pos = end + 1;
+			if (xml[start + 1] == '?' || xml[start + 1] == '!')
+				continue;
+
+			std::string body = xml.substr(start + 1, end - start - 1);
+			element = {};
+			if (!body.empty() && body[0] == '/') {
+				element.isEnd = true;
+				body = body.substr(1);
+			}
+			if (!body.empty() && body.back() == '/') {
+				element.isEmpty = true;
+				body.pop_back();
+			}
+			size_t i = 0;
+			auto skipSpaces = [&] { while (i < body.size() && isspace((unsigned char) body[i])) i++; };
+			auto nameStart = i;
+			while (i < body.size() && !isspace((unsigned char) body[i]))
+				i++;
+			element.name = localName(body.substr(nameStart, i - nameStart));
+			while (true) {
+				skipSpaces();
+				auto eq = body.find('=', i);
+				if (eq == std::string::npos)
+					break;
+				auto attrName = body.substr(i, eq - i);
+				while (!attrName.empty() && isspace((unsigned char) attrName.back()))
+					attrName.pop_back();
+				auto quoteStart = body.find_first_of("\"'", eq);
+				if (quoteStart == std::string::npos)
+					break;
+				auto quoteEnd = body.find(body[quoteStart], quoteStart + 1);
+				if (quoteEnd == std::string::npos)
+					break;
+				// namespace declarations are not interesting for us.
+				if (attrName != "xmlns" && attrName.rfind("xmlns:", 0) != 0)
+					element.attributes[localName(attrName)] = unescapeXml(body.substr(quoteStart + 1, quoteEnd - quoteStart - 1));
+				i = quoteEnd + 1;
+			}
+			return true;
+		}
+	}
+
+	const char* attributeOr(XmlElement& e, const char* name, const char* defaultValue) {
+		auto it = e.attributes.find(name);
+		return it == e.attributes.end() ? defaultValue : it->second.c_str();
+	}
+
+	double attributeAsDouble(XmlElement& e, const char* name, double defaultValue) {
+		auto it = e.attributes.find(name);
+		if (it == e.attributes.end())
+			return defaultValue;
+		auto v = strtod(it->second.c_str(), nullptr);
+		return std::isfinite(v) ? v : 0.0;
+	}
+
+	void fillExtensionsFromBom(PluginInformation* plugin, const std::string& bom) {
+		// keep in sync with AudioPluginExtensionsBom.kt
+		if (bom == "0.12.0") {
+			for (auto uri : {AAP_PARAMETERS_EXTENSION_URI, AAP_STATE_EXTENSION_URI, AAP_PRESETS_EXTENSION_URI,
+							 AAP_MIDI_EXTENSION_URI, AAP_PORT_CONFIG_EXTENSION_URI, AAP_GUI_EXTENSION_URI})
+				plugin->addExtension(PluginExtensionInformation{false, uri});
+		}
+	}
+}
+
+std::vector<PluginInformation*> parseAAPMetadata(const std::string& metadataFullPath, const std::string& packageName, bool isOutProcess) {
+	std::vector<PluginInformation*> results{};
+	std::ifstream file{metadataFullPath};
+	if (!file) {
+		aap::a_log_f(AAP_LOG_LEVEL_WARN, LOG_TAG, "Could not read %s", metadataFullPath.c_str());
+		return results;
+	}
+	std::stringstream ss{};
+	ss << file.rdbuf();
+	auto xml = ss.str();
+
+	PluginInformation* currentPlugin{nullptr};
+	ParameterInformation* currentParameter{nullptr};
+	XmlElement e{};
+	size_t pos = 0;
+	while (nextElement(xml, pos, e)) {
+		if (e.isEnd) {
+			if (e.name == "plugin")
+				currentPlugin = nullptr;
+			else if (e.name == "parameter")
+				currentParameter = nullptr;
+			continue;
+		}
+		if (e.name == "plugin") {
+			if (currentPlugin)
+				continue;
+			currentPlugin = new PluginInformation(isOutProcess,
+												  packageName.c_str(),
+												  AAP_DESKTOP_SERVICE_CLASS_NAME,
+												  attributeOr(e, "name", ""),
+												  attributeOr(e, "developer", ""),
+												  attributeOr(e, "version", ""),
+												  attributeOr(e, "unique-id", ""),
+												  attributeOr(e, "library", ""),
+												  attributeOr(e, "entrypoint", ""),
+												  metadataFullPath.c_str(),
+												  attributeOr(e, "category", ""),
+												  attributeOr(e, "ui-view-factory", ""),
+												  attributeOr(e, "ui-activity", ""),
+												  attributeOr(e, "ui-web", ""));
+			results.emplace_back(currentPlugin);
+			if (e.isEmpty)
+				currentPlugin = nullptr;
+		} else if (!currentPlugin) {
+			continue;
+		} else if (e.name == "extensions") {
+			auto bom = e.attributes.find("bom");
+			if (bom != e.attributes.end())
+				fillExtensionsFromBom(currentPlugin, bom->second);
+		} else if (e.name == "extension") {
+			currentPlugin->addExtension(PluginExtensionInformation{
+				strcmp(attributeOr(e, "required", "false"), "true") == 0, attributeOr(e, "uri", "")});
+		} else if (e.name == "parameter") {
+			auto id = e.attributes.find("id");
+			auto name = e.attributes.find("name");
+			if (id == e.attributes.end() || name == e.attributes.end()) {
+				aap::a_log_f(AAP_LOG_LEVEL_WARN, LOG_TAG, "%s: <parameter> requires \"id\" and \"name\"", metadataFullPath.c_str());
+				continue;
+			}
+			currentParameter = new ParameterInformation(atoi(id->second.c_str()), name->second,
+														attributeAsDouble(e, "minimum", 0.0),
+														attributeAsDouble(e, "maximum", 1.0),
+														attributeAsDouble(e, "default", 0.0));
+			currentPlugin->addDeclaredParameter(currentParameter);
+			if (e.isEmpty)
+				currentParameter = nullptr;
+		} else if (e.name == "enumeration") {
+			if (currentParameter) {
+				ParameterInformation::Enumeration en{currentParameter->getEnumCount(),
+													 attributeAsDouble(e, "value", 0.0),
+													 attributeOr(e, "name", "")};
+				currentParameter->addEnumeration(en);
+			}
+		} else if (e.name == "port") {
+			auto content = std::string{attributeOr(e, "content", "")};
+			auto contentType = content == "midi" ? AAP_CONTENT_TYPE_MIDI :
+							   content == "midi2" ? AAP_CONTENT_TYPE_MIDI2 :
+							   content == "audio" ? AAP_CONTENT_TYPE_AUDIO : AAP_CONTENT_TYPE_UNDEFINED;
+			auto direction = strcmp(attributeOr(e, "direction", ""), "input") == 0 ? AAP_PORT_DIRECTION_INPUT : AAP_PORT_DIRECTION_OUTPUT;
+			auto index = e.attributes.find("index");
+			auto port = new PortInformation(index != e.attributes.end() ? (uint32_t) atoi(index->second.c_str()) : (uint32_t) currentPlugin->getNumDeclaredPorts(),
+											attributeOr(e, "name", ""), contentType, direction);
+			auto minimumSize = e.attributes.find("minimumSize");
+			if (minimumSize != e.attributes.end())
+				port->setPropertyValueString(AAP_PORT_MINIMUM_SIZE, minimumSize->second);
+			currentPlugin->addDeclaredPort(port);
+		}
+	}
+	return results;
+}
+
+// Service connection
+
+DesktopPluginClientConnectionData::~DesktopPluginClientConnectionData() {
+	if (socket_fd >= 0)
+		close(socket_fd);
+}
+
+bool DesktopPluginClientConnectionData::call(int32_t opcode, int32_t instanceId, int32_t arg0, int32_t arg1, int64_t arg2,
+											 const std::string& payload, int32_t fdToSend,
+											 int32_t& status, int32_t& value, std::string& error) {
+	const std::lock_guard<std::mutex> lock{call_mutex};
+	desktop::DesktopIpcRequestHeader req{opcode, instanceId, arg0, arg1, arg2, (uint32_t) payload.size()};
+	if (!desktop::writeMessage(socket_fd, &req, sizeof(req), payload, fdToSend))
+		return false;
+	desktop::DesktopIpcReplyHeader reply{};
+	if (!desktop::readHeader(socket_fd, &reply, sizeof(reply)) ||
+		!desktop::readPayload(socket_fd, error, reply.error_size))
+		return false;
+	status = reply.status;
+	value = reply.value;
+	return true;
 }
 
 PluginClientSystem* PluginClientSystem::getInstance() {
-	assert(false); // FIXME: implement
+	static DesktopPluginClientSystem instance{};
+	return &instance;
 }
 
 } // namespace aap
 
+// AAP plugin implementation that performs actual work via the desktop plugin service socket.
+// It is structured after binder-client-as-plugin.cpp, so that the same RemotePluginInstance
+// code path is exercised.
+
+class AAPDesktopClientContext;
+
+class DesktopIpcProcessTransport : public aap::ProcessTransport {
+	AAPDesktopClientContext* ctx;
+public:
+	explicit DesktopIpcProcessTransport(AAPDesktopClientContext* ctx) : ctx(ctx) {}
+
+	aap::ProcessTransportType getType() override { return aap::PROCESS_TRANSPORT_IPC; }
+	bool process(int32_t frameCount, int64_t timeoutInNanoseconds) override;
+};
+
+class AAPDesktopClientContext {
+public:
+	const char *unique_id{nullptr};
+	int32_t instance_id{-1};
+	aap::DesktopPluginClientConnectionData* connection_data{nullptr};
+	aap::PluginInstantiationState proxy_state{aap::PLUGIN_INSTANTIATION_STATE_INITIAL};
+	AndroidAudioPluginHost host;
+	AndroidAudioPlugin* plugin{nullptr};
+	std::unique_ptr<aap::ProcessTransport> process_transport{};
+
+	~AAPDesktopClientContext();
+
+	// Returns false (and moves to ERROR state) on failure.
+	bool call(const char* name, int32_t opcode, int32_t arg0 = 0, int32_t arg1 = 0, int64_t arg2 = 0,
+			  const std::string& payload = {}, int32_t fdToSend = -1, int32_t* value = nullptr) {
+		int32_t status = -1, ret = 0;
+		std::string error{};
+		if (!connection_data || !connection_data->call(opcode, instance_id, arg0, arg1, arg2, payload, fdToSend, status, ret, error)) {
+			aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "%s failed: lost connection to the plugin service", name);
+			proxy_state = aap::PLUGIN_INSTANTIATION_STATE_ERROR;
+			return false;
+		}
+		if (status != 0) {
+			aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "%s failed: %s", name, error.c_str());
+			proxy_state = aap::PLUGIN_INSTANTIATION_STATE_ERROR;
+			return false;
+		}
+		if (value)
+			*value = ret;
+		return true;
+	}
+};
+
+AAPDesktopClientContext::~AAPDesktopClientContext() {
+	process_transport.reset();
+	if (instance_id >= 0 && connection_data) {
+		call("destroy()", aap::desktop::DESKTOP_IPC_DESTROY);
+		instance_id = -1;
+	}
+}
+
+bool DesktopIpcProcessTransport::process(int32_t frameCount, int64_t timeoutInNanoseconds) {
+	return ctx->call("process()", aap::desktop::DESKTOP_IPC_PROCESS, frameCount, 0, timeoutInNanoseconds);
+}
+
+void aap_desktop_plugin_prepare(AndroidAudioPlugin *plugin, int32_t sampleRate, aap_buffer_t* buffer)
+{
+	auto ctx = (AAPDesktopClientContext*) plugin->plugin_specific;
+	if (ctx->proxy_state == aap::PLUGIN_INSTANTIATION_STATE_ERROR)
+		return;
+
+	if (!ctx->call("beginPrepare()", aap::desktop::DESKTOP_IPC_BEGIN_PREPARE))
+		return;
+
+	auto instance = (aap::RemotePluginInstance*) ctx->host.context;
+	auto shm = dynamic_cast<aap::ClientPluginSharedMemoryStore*>(instance->getSharedMemoryStore());
+	if (shm->isPortBufferArenaEnabled()) {
+		if (!ctx->call("prepareMemory()", aap::desktop::DESKTOP_IPC_PREPARE_MEMORY, aap::PORT_BUFFER_ARENA_FD_INDEX, 0, 0, {}, shm->getPortBufferArenaFD()))
+			return;
+	} else {
+		for (int i = 0, n = buffer->num_ports(buffer); i < n; i++)
+			if (!ctx->call("prepareMemory()", aap::desktop::DESKTOP_IPC_PREPARE_MEMORY, i, 0, 0, {}, shm->getPortBufferFD(i)))
+				return;
+	}
+
+	if (ctx->call("endPrepare()", aap::desktop::DESKTOP_IPC_END_PREPARE, buffer->num_frames(buffer), sampleRate))
+		ctx->proxy_state = aap::PLUGIN_INSTANTIATION_STATE_INACTIVE;
+}
+
+void aap_desktop_plugin_activate(AndroidAudioPlugin *plugin)
+{
+	auto ctx = (AAPDesktopClientContext*) plugin->plugin_specific;
+	if (ctx->proxy_state == aap::PLUGIN_INSTANTIATION_STATE_ERROR)
+		return;
+	if (ctx->call("activate()", aap::desktop::DESKTOP_IPC_ACTIVATE))
+		ctx->proxy_state = aap::PLUGIN_INSTANTIATION_STATE_ACTIVE;
+}
+
+void aap_desktop_plugin_process(AndroidAudioPlugin *plugin,
+	aap_buffer_t* buffer,
+	int32_t frameCount,
+	int64_t timeoutInNanoseconds)
+{
+	auto ctx = (AAPDesktopClientContext*) plugin->plugin_specific;
+	if (ctx->proxy_state == aap::PLUGIN_INSTANTIATION_STATE_ERROR)
+		return;
+
+	auto instance = (aap::RemotePluginInstance*) ctx->host.context;
+	auto shmBuffer = instance->getAudioPluginBuffer();
+
+	if (shmBuffer != buffer)
+		for (int32_t i = 0; i < buffer->num_ports(buffer); i++)
+			memcpy(shmBuffer->get_buffer(shmBuffer, i), buffer->get_buffer(buffer, i), buffer->get_buffer_size(buffer, i));
+
+	if (!ctx->process_transport->process(frameCount, timeoutInNanoseconds)) {
+		if (ctx->process_transport->getType() != aap::PROCESS_TRANSPORT_IPC)
+			aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "process() failed (shared memory transport)");
+		ctx->proxy_state = aap::PLUGIN_INSTANTIATION_STATE_ERROR;
+	}
+
+	if (shmBuffer != buffer)
+		for (int32_t i = 0; i < buffer->num_ports(buffer); i++)
+			memcpy(buffer->get_buffer(buffer, i), shmBuffer->get_buffer(shmBuffer, i), shmBuffer->get_buffer_size(shmBuffer, i));
+}
+
+void aap_desktop_plugin_deactivate(AndroidAudioPlugin *plugin)
+{
+	auto ctx = (AAPDesktopClientContext*) plugin->plugin_specific;
+	if (ctx->proxy_state == aap::PLUGIN_INSTANTIATION_STATE_ERROR)
+		return;
+	if (ctx->call("deactivate()", aap::desktop::DESKTOP_IPC_DEACTIVATE))
+		ctx->proxy_state = aap::PLUGIN_INSTANTIATION_STATE_INACTIVE;
+}
+
+void* aap_desktop_plugin_get_extension(AndroidAudioPlugin *plugin, const char *uri)
+{
+	auto ctx = (AAPDesktopClientContext*) plugin->plugin_specific;
+	auto instance = (aap::RemotePluginInstance*) ctx->host.context;
+	auto aapxsDefinition = instance->getAAPXSRegistry()->items()->getByUri(uri);
+	if (!aapxsDefinition) {
+		aap::a_log_f(AAP_LOG_LEVEL_WARN, LOG_TAG, "unregistered extension requested: %s", uri ? uri : "(null)");
+		return nullptr;
+	}
+	if (!aapxsDefinition->get_plugin_extension_proxy)
+		return nullptr;
+	auto aapxsInstance = instance->getAAPXSDispatcher().getPluginAAPXSByUri(uri);
+	auto proxy = aapxsDefinition->get_plugin_extension_proxy(aapxsDefinition, aapxsInstance, aapxsInstance->serialization);
+	return proxy.as_plugin_extension(&proxy);
+}
+
+aap_plugin_info_t aap_desktop_plugin_get_plugin_info(AndroidAudioPlugin *plugin)
+{
+	auto ctx = (AAPDesktopClientContext*) plugin->plugin_specific;
+	auto hostExt = (aap_host_plugin_info_extension_t*) ctx->host.get_extension(&ctx->host, AAP_PLUGIN_INFO_EXTENSION_URI);
+	return hostExt->get(hostExt, &ctx->host, ctx->unique_id);
+}
+
+bool aap_desktop_plugin_send_extension_message_delegate(void* context,
+														const char* uri,
+														int32_t instanceId,
+														int32_t messageSize,
+														int32_t requestId,
+														int32_t opcode,
+														aapxs_completion_callback callback,
+														void* callbackData,
+														aapxs_error_callback errorCallback) {
+	(void) messageSize;
+	(void) instanceId;
+	auto ctx = (AAPDesktopClientContext*) context;
+	if (ctx->proxy_state == aap::PLUGIN_INSTANTIATION_STATE_ERROR)
+		return false;
+
+	// The socket call is synchronous, so asynchronous requests are completed before returning.
+	int32_t status = -1, value = 0;
+	std::string error{};
+	if (!ctx->connection_data->call(aap::desktop::DESKTOP_IPC_EXTENSION, ctx->instance_id, opcode, requestId, 0,
+									uri, -1, status, value, error)) {
+		aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "extension() failed: lost connection to the plugin service");
+		ctx->proxy_state = aap::PLUGIN_INSTANTIATION_STATE_ERROR;
+		return false;
+	}
+	if (!callback)
+		return false;
+	if (status != 0 && errorCallback)
+		errorCallback(callbackData, ctx->plugin, error.c_str());
+	else
+		callback(callbackData, ctx->plugin);
+	return true;
+}
+
+// Tries to set up PROCESS_TRANSPORT_SHARED_MEMORY_FUTEX. Returns null if the service does not support it.
+std::unique_ptr<aap::ProcessTransport> aap_desktop_create_futex_transport(AAPDesktopClientContext* ctx) {
+	auto size = sizeof(aap::ProcessControlBlock);
+	auto fd = aap::PluginClientSystem::getInstance()->createSharedMemory(size);
+	if (fd < 0)
+		return nullptr;
+	auto transport = std::make_unique<aap::FutexProcessTransport>(fd);
+	if (!transport->isMapped())
+		return nullptr;
+	if (!ctx->call("addExtension()", aap::desktop::DESKTOP_IPC_ADD_EXTENSION, (int32_t) size, 0, 0,
+				   AAP_PROCESS_TRANSPORT_FUTEX_URI, fd) || !transport->isServiceReady())
+		return nullptr;
+	return transport;
+}
+
+// Asks the service whether it accepts all port buffers as one arena (see AAP_PORT_BUFFER_ARENA_URI).
+bool aap_desktop_negotiate_port_buffer_arena(AAPDesktopClientContext* ctx) {
+	auto size = sizeof(aap::PortBufferArenaNegotiation);
+	auto fd = aap::PluginClientSystem::getInstance()->createSharedMemory(size);
+	if (fd < 0)
+		return false;
+	auto block = (aap::PortBufferArenaNegotiation*) mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (block == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+	block->service_ready.store(0, std::memory_order_relaxed);
+	bool supported = ctx->call("addExtension()", aap::desktop::DESKTOP_IPC_ADD_EXTENSION, (int32_t) size, 0, 0,
+							   AAP_PORT_BUFFER_ARENA_URI, fd) &&
+		block->service_ready.load(std::memory_order_acquire) == aap::PortBufferArenaNegotiation::SERVICE_READY_MAGIC;
+	munmap(block, size);
+	close(fd);
+	return supported;
+}
+
 AndroidAudioPlugin* aap_desktop_plugin_new(
 	AndroidAudioPluginFactory *pluginFactory,
 	const char* pluginUniqueId,
-	int aapSampleRate,
 	AndroidAudioPluginHost* host
 	)
 {
-	assert(false); // FIXME: implement
+	if (!pluginFactory || !pluginUniqueId || !host) {
+		AAP_ASSERT_FALSE;
+		return nullptr;
+	}
+
+	auto client = (aap::PluginClient*) pluginFactory->factory_context;
+	auto ctx = new AAPDesktopClientContext();
+	ctx->host = *host;
+	ctx->connection_data = (aap::DesktopPluginClientConnectionData*) client->getConnections()->getServiceHandleForConnectedPlugin(pluginUniqueId);
+	ctx->unique_id = pluginUniqueId;
+
+	if (ctx->call("beginCreate()", aap::desktop::DESKTOP_IPC_BEGIN_CREATE, 0, 0, 0, pluginUniqueId, -1, &ctx->instance_id)) {
+		auto instance = (aap::RemotePluginInstance *) host->context;
+		instance->setInstanceId(ctx->instance_id);
+		instance->setIpcExtensionMessageSender(aap_desktop_plugin_send_extension_message_delegate);
+
+		if (!instance->setupAAPXSInstances([&](const char* uri, AAPXSSerializationContext *serialization) {
+			auto fd = aap::PluginClientSystem::getInstance()->createSharedMemory(serialization->data_capacity);
+			serialization->data = instance->getSharedMemoryStore()->addExtensionFD(fd, serialization->data_capacity);
+			return ctx->proxy_state != aap::PLUGIN_INSTANTIATION_STATE_ERROR &&
+				   ctx->call("addExtension()", aap::desktop::DESKTOP_IPC_ADD_EXTENSION, serialization->data_capacity, 0, 0, uri, fd);
+		}))
+			ctx->proxy_state = aap::PLUGIN_INSTANTIATION_STATE_ERROR;
+
+		if (ctx->proxy_state != aap::PLUGIN_INSTANTIATION_STATE_ERROR &&
+			client->getProcessTransportType() == aap::PROCESS_TRANSPORT_SHARED_MEMORY_FUTEX) {
+			ctx->process_transport = aap_desktop_create_futex_transport(ctx);
+			if (!ctx->process_transport)
+				aap::a_log_f(AAP_LOG_LEVEL_INFO, LOG_TAG, "shared memory process transport is not available for %s; falling back to socket IPC", pluginUniqueId);
+		}
+		if (!ctx->process_transport)
+			ctx->process_transport = std::make_unique<DesktopIpcProcessTransport>(ctx);
+
+		if (ctx->proxy_state != aap::PLUGIN_INSTANTIATION_STATE_ERROR) {
+			auto shm = dynamic_cast<aap::ClientPluginSharedMemoryStore*>(instance->getSharedMemoryStore());
+			shm->setPortBufferArenaEnabled(aap_desktop_negotiate_port_buffer_arena(ctx));
+		}
+
+		if (ctx->proxy_state != aap::PLUGIN_INSTANTIATION_STATE_ERROR &&
+			ctx->call("endCreate()", aap::desktop::DESKTOP_IPC_END_CREATE))
+			ctx->proxy_state = aap::PLUGIN_INSTANTIATION_STATE_INACTIVE;
+	}
+
+	auto result = new AndroidAudioPlugin {
+		ctx,
+		aap_desktop_plugin_prepare,
+		aap_desktop_plugin_activate,
+		aap_desktop_plugin_process,
+		aap_desktop_plugin_deactivate,
+		aap_desktop_plugin_get_extension,
+		aap_desktop_plugin_get_plugin_info
+		};
+	ctx->plugin = result;
+	return result;
 }
 
 void aap_desktop_plugin_delete(
-		AndroidAudioPluginFactory *pluginFactory,
+		AndroidAudioPluginFactory *pluginFactory,	// unused
 		AndroidAudioPlugin *instance)
 {
-	assert(false); // FIXME: implement
+	auto ctx = (AAPDesktopClientContext*) instance->plugin_specific;
+
+	delete ctx;
+	delete instance;
 }
 
 AndroidAudioPluginFactory *GetDesktopAudioPluginFactoryClientBridge(aap::PluginClient* client) {
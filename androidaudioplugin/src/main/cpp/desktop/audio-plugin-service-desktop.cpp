@@ -0,0 +1,289 @@
+#if !ANDROID
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <memory>
+#include "aap/core/host/desktop/audio-plugin-host-desktop.h"
+#include "aap/core/host/plugin-host.h"
+#include "aap/core/host/plugin-instance.h"
+#include "aap/core/host/shared-memory-store.h"
+#include "aap/core/host/process-transport.h"
+#include "aap/unstable/logging.h"
+#include "desktop-ipc.h"
+
+#define LOG_TAG "AAP.desktop.svc"
+
+namespace aap {
+
+// There is no host callback channel over the socket (yet), so host extensions are reported as failures.
+class AudioPluginServiceCallbackDesktop : public AudioPluginServiceCallback {
+public:
+    void hostExtension(int32_t in_instanceId,
+                       const std::string& in_uri,
+                       int32_t in_opcode,
+                       int32_t in_requestId,
+                       void* callback) override {
+        aap::a_log_f(AAP_LOG_LEVEL_WARN, LOG_TAG, "host extension %s (opcode %d) is not supported on desktop service (instance %d)",
+                     in_uri.c_str(), in_opcode, in_instanceId);
+    }
+    void requestProcess(int32_t in_instanceId) override {
+        aap::a_log_f(AAP_LOG_LEVEL_WARN, LOG_TAG, "requestProcess() is not supported on desktop service (instance %d)", in_instanceId);
+    }
+};
+
+// Per-connection state, the desktop counterpart of AudioPluginInterfaceImpl.
+class DesktopPluginServiceSession {
+    PluginListSnapshot plugins;
+    AudioPluginServiceCallbackDesktop plugin_service_callback{};
+    std::unique_ptr<PluginService> svc;
+    std::map<int32_t, std::unique_ptr<FutexProcessTransportService>> process_transports{};
+
+    static void aapxs_host_ipc_sender_func(void* context,
+                                           const char* uri,
+                                           int32_t instanceId,
+                                           int32_t opcode,
+                                           int32_t requestId,
+                                           aapxs_completion_callback callback,
+                                           void* callbackData,
+                                           void* callbackPluginOrHost,
+                                           aapxs_error_callback errorCallback) {
+        auto session = (DesktopPluginServiceSession*) context;
+        session->plugin_service_callback.hostExtension(instanceId, uri, opcode, requestId, nullptr);
+        if (errorCallback)
+            errorCallback(callbackData, callbackPluginOrHost, "host extensions are not supported on desktop service");
+    }
+
+public:
+    DesktopPluginServiceSession() {
+        plugins = PluginListSnapshot::queryServices();
+        svc = std::make_unique<PluginService>(&plugins, &plugin_service_callback);
+    }
+
+    ~DesktopPluginServiceSession() {
+        // the client is gone; clean up whatever it left behind.
+        process_transports.clear();
+        while (svc->getInstanceCount() > 0)
+            svc->destroyInstance(svc->getInstanceByIndex(0));
+    }
+
+    void handle(desktop::DesktopIpcRequestHeader& req, std::string& payload, int32_t fd,
+                desktop::DesktopIpcReplyHeader& reply, std::string& error) {
+        reply.status = 0;
+        reply.value = 0;
+        auto fail = [&](const char* message) {
+            reply.status = -1;
+            error = message;
+        };
+
+        if (req.opcode == desktop::DESKTOP_IPC_BEGIN_CREATE) {
+            reply.value = svc->createInstance(payload);
+            auto created = reply.value < 0 ? nullptr : svc->getLocalInstance(reply.value);
+            if (created == nullptr) {
+                fail("failed to create AAP service instance.");
+                return;
+            }
+            created->setIpcExtensionMessageSender(aapxs_host_ipc_sender_func, this);
+            return;
+        }
+
+        auto instance = svc->getLocalInstance(req.instance_id);
+        if (req.opcode == desktop::DESKTOP_IPC_IS_PLUGIN_ALIVE) {
+            reply.value = instance != nullptr;
+            return;
+        }
+        if (instance == nullptr) {
+            fail("The specified instance does not exist.");
+            if (fd >= 0)
+                close(fd);
+            return;
+        }
+
+        switch (req.opcode) {
+            case desktop::DESKTOP_IPC_ADD_EXTENSION: {
+                if (payload == AAP_PROCESS_TRANSPORT_FUTEX_URI) {
+                    if (fd < 0 || req.arg0 < (int32_t) sizeof(ProcessControlBlock))
+                        break;
+                    auto transport = std::make_unique<FutexProcessTransportService>(fd,
+                        [instance](int32_t frameCount, int64_t timeoutInNanoseconds) {
+                            instance->process(frameCount, timeoutInNanoseconds);
+                        });
+                    if (transport->start())
+                        process_transports[req.instance_id] = std::move(transport);
+                    return;
+                }
+                // Not an actual extension either; the client asks whether we accept the port buffer arena.
+                if (payload == AAP_PORT_BUFFER_ARENA_URI) {
+                    acknowledgePortBufferArena(fd, req.arg0);
+                    if (fd >= 0)
+                        close(fd);
+                    return;
+                }
+                if (req.arg0 > 0) {
+                    auto shmExt = instance->getSharedMemoryStore();
+                    if (shmExt == nullptr) {
+                        AAP_ASSERT_FALSE;
+                        fail("failed to get PluginSharedMemoryStore");
+                        break;
+                    }
+                    shmExt->addExtensionFD(fd, req.arg0);
+                    shmExt->getExtensionUriToIndexMap()[payload] = shmExt->getExtensionBufferCount() - 1;
+                    return;
+                }
+                break;
+            }
+            case desktop::DESKTOP_IPC_END_CREATE:
+                // see AudioPluginInterfaceImpl::endCreate() for the ordering.
+                instance->setupAAPXSInstances();
+                instance->completeInstantiation();
+                if (instance->getInstanceState() != PLUGIN_INSTANTIATION_STATE_UNPREPARED) {
+                    fail("failed to instantiate AAP service plugin backend.");
+                    break;
+                }
+                instance->setupAAPXS();
+                instance->startPortConfiguration();
+                break;
+            case desktop::DESKTOP_IPC_PREPARE_MEMORY: {
+                if (fd < 0) {
+                    fail("invalid shared memory fd was passed");
+                    break;
+                }
+                instance->getSharedMemoryStore()->setPortBufferFD(req.arg0, fd);
+                return;
+            }
+            case desktop::DESKTOP_IPC_BEGIN_PREPARE:
+                instance->confirmPorts();
+                instance->scanParametersAndBuildList();
+                instance->getSharedMemoryStore()->resizePortBufferByCount(instance->getNumPorts());
+                break;
+            case desktop::DESKTOP_IPC_END_PREPARE: {
+                auto shmExt = dynamic_cast<ServicePluginSharedMemoryStore*>(instance->getSharedMemoryStore());
+                if (shmExt == nullptr) {
+                    fail("unable to get shared memory extension");
+                    break;
+                }
+                if (!shmExt->completeServiceInitialization(req.arg0, *instance, DEFAULT_CONTROL_BUFFER_SIZE)) {
+                    fail("failed to allocate shared memory");
+                    break;
+                }
+                instance->prepare(req.arg0, req.arg1);
+                break;
+            }
+            case desktop::DESKTOP_IPC_ACTIVATE:
+                instance->activate();
+                break;
+            case desktop::DESKTOP_IPC_PROCESS:
+                instance->process(req.arg0, req.arg2);
+                break;
+            case desktop::DESKTOP_IPC_DEACTIVATE:
+                instance->deactivate();
+                break;
+            case desktop::DESKTOP_IPC_EXTENSION:
+                try {
+                    instance->controlExtension(0, payload, req.arg0, (uint32_t) req.arg1);
+                } catch (const std::exception& ex) {
+                    fail(ex.what());
+                } catch (...) {
+                    fail("Unknown extension error");
+                }
+                break;
+            case desktop::DESKTOP_IPC_DESTROY:
+                // the render thread must be gone before the instance.
+                process_transports.erase(req.instance_id);
+                svc->destroyInstance(instance);
+                break;
+            default:
+                fail("unknown request");
+                break;
+        }
+        if (fd >= 0)
+            close(fd);
+    }
+};
+
+DesktopPluginService::DesktopPluginService(std::string packageName)
+        : socket_path(getDesktopServiceSocketPath(packageName)) {
+}
+
+DesktopPluginService::~DesktopPluginService() {
+    stop();
+    for (auto& t : client_threads)
+        if (t.joinable())
+            t.join();
+}
+
+bool DesktopPluginService::run() {
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Failed to create service socket");
+        return false;
+    }
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Socket path is too long: %s", socket_path.c_str());
+        return false;
+    }
+    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(socket_path.c_str());
+    if (bind(listen_fd, (sockaddr*) &addr, sizeof(addr)) < 0 || listen(listen_fd, 8) < 0) {
+        aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "Failed to listen on %s", socket_path.c_str());
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+
+    while (!stopping.load()) {
+        auto clientFD = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (clientFD < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        client_threads.emplace_back([this, clientFD] { serveClient(clientFD); });
+    }
+    return true;
+}
+
+void DesktopPluginService::stop() {
+    if (stopping.exchange(true))
+        return;
+    if (listen_fd >= 0) {
+        // wakes up accept().
+        shutdown(listen_fd, SHUT_RDWR);
+        close(listen_fd);
+        listen_fd = -1;
+        unlink(socket_path.c_str());
+    }
+}
+
+void DesktopPluginService::serveClient(int32_t clientFD) {
+    DesktopPluginServiceSession session{};
+    while (!stopping.load()) {
+        desktop::DesktopIpcRequestHeader req{};
+        int32_t fd = -1;
+        std::string payload{};
+        if (!desktop::readHeader(clientFD, &req, sizeof(req), &fd) ||
+            !desktop::readPayload(clientFD, payload, req.payload_size)) {
+            if (fd >= 0)
+                close(fd);
+            break;
+        }
+        desktop::DesktopIpcReplyHeader reply{};
+        std::string error{};
+        session.handle(req, payload, fd, reply, error);
+        if (!error.empty())
+            aap::a_log_f(AAP_LOG_LEVEL_ERROR, LOG_TAG, "request %d failed: %s", req.opcode, error.c_str());
+        reply.error_size = (uint32_t) error.size();
+        if (!desktop::writeMessage(clientFD, &reply, sizeof(reply), error))
+            break;
+    }
+    close(clientFD);
+}
+
+} // namespace aap
+
+#endif
@@ -0,0 +1,105 @@
+#if !ANDROID
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include "desktop-ipc.h"
+
+namespace aap::desktop {
+
+bool writeMessage(int32_t socketFD, const void* header, size_t headerSize, const std::string& payload, int32_t fd) {
+    iovec iov[2]{{(void*) header, headerSize}, {(void*) payload.data(), payload.size()}};
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = payload.empty() ? 1 : 2;
+
+    char control[CMSG_SPACE(sizeof(int))]{};
+    if (fd >= 0) {
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        auto cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+
+    size_t total = headerSize + payload.size();
+    auto sent = sendmsg(socketFD, &msg, MSG_NOSIGNAL);
+    while (sent < 0 && errno == EINTR)
+        sent = sendmsg(socketFD, &msg, MSG_NOSIGNAL);
+    if (sent < 0)
+        return false;
+    // SOCK_STREAM may send partially; the ancillary data went out with the first chunk anyway.
+    std::string all{(const char*) header, headerSize};
+    all += payload;
+    while ((size_t) sent < total) {
+        auto n = send(socketFD, all.data() + sent, total - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+bool readHeader(int32_t socketFD, void* header, size_t headerSize, int32_t* receivedFD) {
+    if (receivedFD)
+        *receivedFD = -1;
+    iovec iov{header, headerSize};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    char control[CMSG_SPACE(sizeof(int))]{};
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    auto n = recvmsg(socketFD, &msg, MSG_CMSG_CLOEXEC);
+    while (n < 0 && errno == EINTR)
+        n = recvmsg(socketFD, &msg, MSG_CMSG_CLOEXEC);
+    if (n <= 0)
+        return false;
+
+    for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+            if (receivedFD)
+                *receivedFD = fd;
+            else
+                close(fd);
+        }
+    }
+
+    size_t received = (size_t) n;
+    while (received < headerSize) {
+        auto r = recv(socketFD, (char*) header + received, headerSize - received, 0);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        received += (size_t) r;
+    }
+    return true;
+}
+
+bool readPayload(int32_t socketFD, std::string& payload, uint32_t size) {
+    payload.resize(size);
+    size_t received = 0;
+    while (received < size) {
+        auto r = recv(socketFD, payload.data() + received, size - received, 0);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        received += (size_t) r;
+    }
+    return true;
+}
+
+} // namespace aap::desktop
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef AAP_CORE_DESKTOP_IPC_H
+#define AAP_CORE_DESKTOP_IPC_H
+
+#include <cstdint>
+#include <string>
+
+// Wire protocol between desktop plugin clients and DesktopPluginService.
+// It mirrors IAudioPluginInterface.aidl one request at a time; every request gets exactly one reply.
+
+namespace aap::desktop {
+
+enum DesktopIpcOpcode : int32_t {
+    DESKTOP_IPC_BEGIN_CREATE = 1,   // payload: pluginId, reply value: instanceId
+    DESKTOP_IPC_ADD_EXTENSION,      // payload: uri, arg0: size, fd: shm
+    DESKTOP_IPC_END_CREATE,
+    DESKTOP_IPC_IS_PLUGIN_ALIVE,    // reply value: 1 if alive
+    DESKTOP_IPC_PREPARE_MEMORY,     // arg0: shm FD index, fd: shm
+    DESKTOP_IPC_BEGIN_PREPARE,
+    DESKTOP_IPC_END_PREPARE,        // arg0: frameCount, arg1: sampleRate
+    DESKTOP_IPC_ACTIVATE,
+    DESKTOP_IPC_PROCESS,            // arg0: frameCount, arg2: timeoutInNanoseconds
+    DESKTOP_IPC_DEACTIVATE,
+    DESKTOP_IPC_EXTENSION,          // payload: uri, arg0: opcode, arg1: requestId
+    DESKTOP_IPC_DESTROY
+};
+
+struct DesktopIpcRequestHeader {
+    int32_t opcode;
+    int32_t instance_id;
+    int32_t arg0;
+    int32_t arg1;
+    int64_t arg2;
+    uint32_t payload_size;
+};
+
+struct DesktopIpcReplyHeader {
+    int32_t status; // 0 for success
+    int32_t value;
+    uint32_t error_size;
+};
+
+// Sends `header` + `payload` in one message, attaching `fd` as SCM_RIGHTS if it is non-negative.
+bool writeMessage(int32_t socketFD, const void* header, size_t headerSize, const std::string& payload, int32_t fd = -1);
+// Receives the fixed-size header (and an attached FD, if any; -1 otherwise).
+bool readHeader(int32_t socketFD, void* header, size_t headerSize, int32_t* receivedFD = nullptr);
+bool readPayload(int32_t socketFD, std::string& payload, uint32_t size);
+
+} // namespace aap::desktop
+
+#endif //AAP_CORE_DESKTOP_IPC_H
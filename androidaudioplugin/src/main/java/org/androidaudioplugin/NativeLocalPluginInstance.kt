@@ -20,6 +20,13 @@ class NativeLocalPluginInstance(private val service: NativePluginService, privat
     fun getPresetName(index: Int) = getPresetName(service.native, instanceId, index)
     fun setPresetIndex(index: Int) = setPresetIndex(service.native, instanceId, index)
 
+    // process() tracing (service side); `flags` is a combination of the
+    // NativeRemotePluginInstance.PROCESS_TRACE_* flags, 0 to disable.
+    fun setProcessTraceFlags(flags: Int) = setProcessTraceFlags(service.native, instanceId, flags)
+    fun resetProcessTraceHistograms() = resetProcessTraceHistograms(service.native, instanceId)
+    fun dumpProcessTraceHistograms() = dumpProcessTraceHistograms(service.native, instanceId)
+    fun dumpProcessTraceEventsAsJson() = dumpProcessTraceEventsAsJson(service.native, instanceId)
+
     companion object {
         @JvmStatic
         private external fun getPluginId(nativeService: Long, instanceId: Int): String
@@ -45,5 +52,14 @@ class NativeLocalPluginInstance(private val service: NativePluginService, privat
         private external fun getPresetName(nativeService: Long, instanceId: Int, index: Int) : String
         @JvmStatic
         private external fun setPresetIndex(nativeService: Long, instanceId: Int, index: Int)
+
+        @JvmStatic
+        private external fun setProcessTraceFlags(nativeService: Long, instanceId: Int, flags: Int)
+        @JvmStatic
+        private external fun resetProcessTraceHistograms(nativeService: Long, instanceId: Int)
+        @JvmStatic
+        private external fun dumpProcessTraceHistograms(nativeService: Long, instanceId: Int) : String
+        @JvmStatic
+        private external fun dumpProcessTraceEventsAsJson(nativeService: Long, instanceId: Int) : String
     }
 }
@@ -148,7 +148,17 @@ class NativeRemotePluginInstance(val instanceId: Int, // aap::RemotePluginInstan
         sendExtensionRequest(client, instanceId, uri, opcode, buffer, offset, length)
     }
 
+    // process() tracing (client side); `flags` is a combination of PROCESS_TRACE_* flags, 0 to disable.
+    fun setProcessTraceFlags(flags: Int) = setProcessTraceFlags(client, instanceId, flags)
+    fun resetProcessTraceHistograms() = resetProcessTraceHistograms(client, instanceId)
+    fun dumpProcessTraceHistograms() = dumpProcessTraceHistograms(client, instanceId)
+    fun dumpProcessTraceEventsAsJson() = dumpProcessTraceEventsAsJson(client, instanceId)
+
     companion object {
+        // aap::ProcessTraceFlags
+        const val PROCESS_TRACE_HISTOGRAMS = 1
+        const val PROCESS_TRACE_EVENTS = 2
+
         fun create(pluginId: String, nativeClient: Long) =
             NativeRemotePluginInstance(createRemotePluginInstance(pluginId, nativeClient), nativeClient)
 
@@ -229,5 +239,15 @@ class NativeRemotePluginInstance(val instanceId: Int, // aap::RemotePluginInstan
 
         @JvmStatic
         external fun addEventUmpInput(nativeClient: Long, instanceId: Int, data: ByteBuffer, length: Int)
+
+        // process trace
+        @JvmStatic
+        external fun setProcessTraceFlags(nativeClient: Long, instanceId: Int, flags: Int)
+        @JvmStatic
+        external fun resetProcessTraceHistograms(nativeClient: Long, instanceId: Int)
+        @JvmStatic
+        external fun dumpProcessTraceHistograms(nativeClient: Long, instanceId: Int) : String
+        @JvmStatic
+        external fun dumpProcessTraceEventsAsJson(nativeClient: Long, instanceId: Int) : String
     }
 }
@@ -16,6 +16,14 @@
 namespace aap {
     class AAPXSMidi2InitiatorSession;
     const size_t MAX_PENDING_CALLBACKS = UINT8_MAX;
+    // Pending callbacks take a slot from a free list, and are looked up through the bucket for
+    // the lower 8 bits of the request ID (request IDs are mostly sequential, so it rarely chains).
+    const size_t AAPXS_PENDING_CALLBACK_SLOTS = MAX_PENDING_CALLBACKS + 1;
+    static_assert((AAPXS_PENDING_CALLBACK_SLOTS & (AAPXS_PENDING_CALLBACK_SLOTS - 1)) == 0,
+                  "AAPXS_PENDING_CALLBACK_SLOTS must be a power of two");
+    // Request timeouts are tracked in a hashed timer wheel whose tick is this many frames.
+    const int32_t AAPXS_TIMER_WHEEL_TICK_FRAMES = 256;
+    const size_t AAPXS_TIMER_WHEEL_SIZE = 256;
 
     typedef void (*add_midi2_event_func) (AAPXSMidi2InitiatorSession* session, void* userData, int32_t messageSize);
 
@@ -27,24 +35,49 @@ namespace aap {
             void* data;
             // failure delivery + deadline for the request/response timeout (MIDI-CI style).
             aapxs_error_callback error_func;
-            std::chrono::steady_clock::time_point deadline;
+            uint64_t deadline_tick;
+            // links within the timer wheel bucket (slot indices, -1 for none)
+            int16_t wheel_prev;
+            int16_t wheel_next;
+            // the next slot in the request ID bucket, or in the free list if not in use (-1 for none)
+            int16_t bucket_next;
+            bool in_use;
         };
 
         int32_t midi_buffer_size;
         int32_t request_timeout_ms{AAPXS_REQUEST_TIMEOUT_DEFAULT_MS};
+        int32_t sample_rate{48000};
         aap_midi2_aapxs_parse_context aapxs_parse_context{};
         std::function<void(aap_midi2_aapxs_parse_context*)> handle_reply;
-        CallbackUnit pending_callbacks[MAX_PENDING_CALLBACKS];
-
-        // Fires "timeout" for any in-flight request whose deadline has passed. Called from
-        // completeSession() (i.e. once per process() cycle).
-        void sweepTimeouts(void* pluginOrHost);
+        CallbackUnit pending_callbacks[AAPXS_PENDING_CALLBACK_SLOTS];
+        // head slot index of each bucket, -1 if empty
+        int16_t timer_wheel[AAPXS_TIMER_WHEEL_SIZE];
+        // head slot index of each request ID bucket, -1 if empty
+        int16_t request_buckets[AAPXS_PENDING_CALLBACK_SLOTS];
+        int16_t free_slots{-1};
+        // frames processed so far; the timer wheel clock.
+        uint64_t current_frame{0};
+        // whether the recipient accepts compact (URID-only) AAPXS SysEx8. Negotiated at URID mapping.
+        bool compact_frames{false};
+
+        void linkTimer(int16_t slot);
+        void unlinkTimer(int16_t slot);
+        // Both return -1 if there is no such slot.
+        int16_t acquireSlot(uint32_t requestId);
+        int16_t findPendingSlot(uint32_t requestId);
+        // unlinks the slot from its request ID bucket and returns it to the free list.
+        void releaseSlot(int16_t slot);
 
     public:
         AAPXSMidi2InitiatorSession(int32_t midiBufferSize);
         ~AAPXSMidi2InitiatorSession();
 
         void setRequestTimeoutMs(int32_t ms) { request_timeout_ms = ms; }
+        // Timeouts are measured in processed frames, so the session needs to know the sample rate.
+        void setSampleRate(int32_t sampleRate) { sample_rate = sampleRate; }
+
+        // When enabled, requests for extensions with a mapped URID omit the URI on the wire.
+        void setCompactFramesEnabled(bool enabled) { compact_frames = enabled; }
 
         uint8_t *aapxs_rt_midi_buffer{nullptr};
         uint8_t *aapxs_rt_conversion_helper_buffer{nullptr};
@@ -63,9 +96,16 @@ namespace aap {
                         int32_t dataSize,
                         int32_t opcode);
 
-        void addSession(add_midi2_event_func addMidi2Event, void* addMidi2EventUserData, AAPXSRequestContext* request);
+        // Returns false without sending anything if the request has a callback and every pending
+        // callback slot is taken.
+        bool addSession(add_midi2_event_func addMidi2Event, void* addMidi2EventUserData, AAPXSRequestContext* request);
 
+        // Dispatches the replies in `buffer` to their pending callbacks.
         void completeSession(void* buffer, void* pluginOrHost);
+
+        // Advances the timer wheel by `frameCount` and fires "timeout" for any in-flight request
+        // whose deadline has passed. It should be called once per process() cycle.
+        void processTimeouts(int32_t frameCount, void* pluginOrHost);
     };
 }
 
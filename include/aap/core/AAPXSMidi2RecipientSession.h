@@ -10,6 +10,8 @@ namespace aap {
         aap_midi2_aapxs_parse_context aapxs_parse_context{};
 
         std::function<void(aap_midi2_aapxs_parse_context*)> call_extension;
+        // set once the initiator has sent a compact (URID-only) frame; replies follow the same format.
+        bool compact_frames{false};
     public:
         AAPXSMidi2RecipientSession();
         virtual ~AAPXSMidi2RecipientSession();
@@ -49,6 +49,30 @@ size_t aap_midi2_generate_aapxs_sysex8(uint32_t *dst,
                                               const uint8_t *data,
                                               size_t dataSize);
 
+/**
+ * Compact variant of `aap_midi2_generate_aapxs_sysex8()` that omits the extension URI.
+ * Its AAPXS code is `00 02` instead of `00 01`:
+ *
+ *   `7E  7F 00-02 urid]  [reqId]  [opcode]  [value-size]  [..value..]`
+ *
+ * It can be used only when `urid` is mapped (non-zero) and the recipient is known to understand it
+ * (see `AAP_URID_MAP_REPLY_COMPACT_AAPXS_SYSEX8` in urid-aapxs.h).
+ * Parameters are the same as `aap_midi2_generate_aapxs_sysex8()`.
+ *
+ * @return size of generated bytes (0 if failed)
+ */
+AAP_PUBLIC_API
+size_t aap_midi2_generate_aapxs_sysex8_compact(uint32_t *dst,
+                                               size_t dstSizeInInt,
+                                               uint8_t *conversionHelperBuffer,
+                                               size_t conversionHelperBufferSize,
+                                               uint8_t group,
+                                               uint32_t requestId,
+                                               uint8_t urid,
+                                               int32_t opcode,
+                                               const uint8_t *data,
+                                               size_t dataSize);
+
 struct aap_midi2_aapxs_parse_context {
     uint8_t group;
     uint32_t request_id;
@@ -59,6 +83,8 @@ struct aap_midi2_aapxs_parse_context {
     uint32_t dataSize; // parsed result
     uint8_t *conversionHelperBuffer;
     size_t conversionHelperBufferSize;
+    // true if the message was in the compact format. `uri` is then empty and has to be resolved from `urid`.
+    bool compact;
 };
 
 AAP_PUBLIC_API
@@ -74,9 +100,10 @@ static inline void aap_midi2_aapxs_parse_context_prepare(
     context->dataSize = 0;
     context->conversionHelperBuffer = conversionHelperBuffer;
     context->conversionHelperBufferSize = conversionHelperBufferSize;
+    context->compact = false;
 }
 
-// Reads AAPXS SysEx8 UMP into `aap_midi2_aapxs_parse_context`.
+// Reads AAPXS SysEx8 UMP (either full or compact format) into `aap_midi2_aapxs_parse_context`.
 // Returns true if it is successfully parsed and it turned out to be AAPXS SysEx8.
 // In any other case, return false.
 AAP_PUBLIC_API
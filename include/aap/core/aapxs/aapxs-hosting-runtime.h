@@ -3,7 +3,11 @@
 
 // AAPXS v2 runtime - strongly typed.
 
+#include <array>
 #include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
 #include <vector>
 #include <map>
 #include <future>
@@ -20,16 +24,86 @@ namespace aap::xs {
      * The integer `0` is reserved as UNMAPPED (used when the mapped URID is not found).
      */
     class UridMapping {
+        // Open-addressing (linear probing) indices from URI to URID; 0 is an empty slot.
+        // They have twice as many slots as the URID range, so that probing stays short.
+        // `pointer_index` lets the registered `const char*` itself resolve without touching the string.
+        static const size_t INDEX_SIZE = 512;
+
         std::vector<uint8_t> urids{};
-        std::vector<std::string> string_pool{};
+        std::deque<std::string> string_pool{};
         std::vector<const char*> uris{};
+        std::vector<uint32_t> hashes{};
+        std::array<uint8_t, INDEX_SIZE> uri_index{};
+        std::array<uint8_t, INDEX_SIZE> pointer_index{};
+
+        static size_t hashPointer(const char* uri) {
+            auto v = (uint64_t) (uintptr_t) uri;
+            v ^= v >> 33;
+            v *= 0xff51afd7ed558ccdULL;
+            return (size_t) (v ^ (v >> 33));
+        }
+
+        // rebuilt whenever a mapping is added (which never happens on the realtime path).
+        void rebuildIndex() {
+            uri_index.fill(0);
+            pointer_index.fill(0);
+            for (size_t i = 1, n = uris.size(); i < n; i++) {
+                if (urids[i] == UNMAPPED_URID || !uris[i])
+                    continue;
+                hashes[i] = hashUri(uris[i]);
+                if (lookupByPointer(uris[i]) == UNMAPPED_URID) {
+                    size_t slot = hashPointer(uris[i]) & (INDEX_SIZE - 1);
+                    while (pointer_index[slot] != 0)
+                        slot = (slot + 1) & (INDEX_SIZE - 1);
+                    pointer_index[slot] = urids[i];
+                }
+                // keep the first registration for duplicate URIs, like the former linear search did.
+                if (lookupByString(uris[i], hashes[i]) == UNMAPPED_URID) {
+                    size_t slot = hashes[i] & (INDEX_SIZE - 1);
+                    while (uri_index[slot] != 0)
+                        slot = (slot + 1) & (INDEX_SIZE - 1);
+                    uri_index[slot] = urids[i];
+                }
+            }
+        }
+
+        uint8_t lookupByPointer(const char* uri) {
+            for (size_t slot = hashPointer(uri) & (INDEX_SIZE - 1); pointer_index[slot] != 0; slot = (slot + 1) & (INDEX_SIZE - 1))
+                if (uris[pointer_index[slot]] == uri)
+                    return pointer_index[slot];
+            return UNMAPPED_URID;
+        }
+
+        uint8_t lookupByString(const char* uri, uint32_t uriHash) {
+            for (size_t slot = uriHash & (INDEX_SIZE - 1); uri_index[slot] != 0; slot = (slot + 1) & (INDEX_SIZE - 1)) {
+                auto urid = uri_index[slot];
+                if (hashes[urid] == uriHash && !strcmp(uri, uris[urid]))
+                    return urid;
+            }
+            return UNMAPPED_URID;
+        }
 
     public:
         static const uint8_t UNMAPPED_URID = 0;
 
+        /**
+         * FNV-1a hash of the URI length and its last (up to) 24 bytes; extension URIs tend to
+         * share long prefixes and differ at the end. It is `constexpr` so that the hashes of
+         * well-known URIs (e.g. `constexpr auto hash = UridMapping::hashUri(AAP_PRESETS_EXTENSION_URI);`)
+         * can be computed at compile time and passed to `getUrid(uri, hash)`.
+         */
+        static constexpr uint32_t hashUri(const char* uri) {
+            size_t length = std::char_traits<char>::length(uri);
+            uint32_t hash = (2166136261u ^ (uint32_t) length) * 16777619u;
+            for (size_t i = length > 24 ? length - 24 : 0; i < length; i++)
+                hash = (hash ^ (uint8_t) uri[i]) * 16777619u;
+            return hash;
+        }
+
         UridMapping() {
             uris.emplace_back("");
             urids.emplace_back(0);
+            hashes.emplace_back(0);
         }
 
         uint8_t tryAdd(const char* uri) {
@@ -43,26 +117,29 @@ namespace aap::xs {
             uint8_t urid = uris.size();
             uris.emplace_back(uri);
             urids.emplace_back(urid);
+            hashes.emplace_back(0);
+            rebuildIndex();
             return urid;
         }
 
         uint8_t getUrid(const char* uri) {
-            // starts from 1, as 0 is "unmapped"
-            for (size_t i = 1, n = uris.size(); i < n; i++)
-                if (uri == uris[i])
-                    return urids[i];
-            for (size_t i = 1, n = uris.size(); i < n; i++)
-                if (uris[i] && !strcmp(uri, uris[i]))
-                    return urids[i];
-            return UNMAPPED_URID;
+            if (!uri)
+                return UNMAPPED_URID;
+            auto urid = lookupByPointer(uri);
+            return urid != UNMAPPED_URID ? urid : lookupByString(uri, hashUri(uri));
+        }
+
+        // `uriHash` must be `hashUri(uri)`.
+        uint8_t getUrid(const char* uri, uint32_t uriHash) {
+            if (!uri)
+                return UNMAPPED_URID;
+            auto urid = lookupByPointer(uri);
+            return urid != UNMAPPED_URID ? urid : lookupByString(uri, uriHash);
         }
 
         const char* getUri(uint8_t urid) {
-            // starts from 1, as 0 is "unmapped"
-            for (size_t i = 1, n = urids.size(); i < n; i++)
-                if (urid == urids[i])
-                    return uris[i];
-            return nullptr;
+            // the URID is also the index (0 is "unmapped")
+            return urid != UNMAPPED_URID && urid < urids.size() && urids[urid] == urid ? uris[urid] : nullptr;
         }
 
         using container=std::vector<uint8_t>;
@@ -85,13 +162,15 @@ namespace aap::xs {
             }
 
             string_pool.emplace_back(uri);
-            while (urids.size() < urid)
+            while (urids.size() <= urid) {
                 urids.emplace_back(0);
-            while (uris.size() < urid)
                 uris.emplace_back("");
-            urids.emplace_back(urid);
-            // add the underlying buffer as the const char*.
-            uris.emplace_back(string_pool[string_pool.size() - 1].data());
+                hashes.emplace_back(0);
+            }
+            urids[urid] = urid;
+            // add the underlying buffer as the const char* (std::deque does not move existing elements).
+            uris[urid] = string_pool.back().data();
+            rebuildIndex();
         }
     };
 
@@ -120,6 +199,11 @@ namespace aap::xs {
             uint8_t urid = urid_mapping->getUrid(uri);
             return &items[urid];
         }
+        // `uriHash` must be `UridMapping::hashUri(uri)`, typically computed at compile time.
+        T* getByUri(const char* uri, uint32_t uriHash) {
+            uint8_t urid = urid_mapping->getUrid(uri, uriHash);
+            return &items[urid];
+        }
         T* getByUrid(uint8_t urid) {
             return &items[urid];
         }
@@ -181,6 +265,7 @@ namespace aap::xs {
         AAPXSClientDispatcher(AAPXSDefinitionRegistry* registry);
 
         inline AAPXSInitiatorInstance* getPluginAAPXSByUri(const char* uri) { if (already_setup) return initiators.getByUri(uri); AAP_ASSERT_FALSE; return nullptr; }
+        inline AAPXSInitiatorInstance* getPluginAAPXSByUri(const char* uri, uint32_t uriHash) { if (already_setup) return initiators.getByUri(uri, uriHash); AAP_ASSERT_FALSE; return nullptr; }
         inline AAPXSInitiatorInstance* getPluginAAPXSByUrid(uint8_t urid) { if (already_setup) return initiators.getByUrid(urid); AAP_ASSERT_FALSE; return nullptr; }
         inline AAPXSRecipientInstance* getHostAAPXSByUri(const char* uri) { if (already_setup) return recipients.getByUri(uri); AAP_ASSERT_FALSE; return nullptr; }
         inline AAPXSRecipientInstance* getHostAAPXSByUrid(uint8_t urid) { if (already_setup) return recipients.getByUrid(urid); AAP_ASSERT_FALSE; return nullptr; }
@@ -230,6 +315,8 @@ namespace aap::xs {
                        aapxs_recipient_send_func sendAapxsReply,
                        aapxs_initiator_send_func sendAAPXSRequest,
                        initiator_get_new_request_id_func initiatorGetNewRequestId);
+
+        AAPXSSerializationContext *getSerialization(const char *uri);
     };
 
     class AAPXSDefinitionClientRegistry {
@@ -13,13 +13,37 @@ const int32_t OPCODE_PARAMETERS_GET_PARAMETER = 2;
 const int32_t OPCODE_PARAMETERS_GET_PROPERTY = 3;
 const int32_t OPCODE_PARAMETERS_GET_ENUMERATION_COUNT = 4;
 const int32_t OPCODE_PARAMETERS_GET_ENUMERATION = 5;
+const int32_t OPCODE_PARAMETERS_GET_PARAMETER_DESCRIPTORS = 6;
 
 // host extension opcodes
 const int32_t OPCODE_NOTIFY_PARAMETERS_CHANGED = -1;
 
-const int32_t PARAMETERS_SHARED_MEMORY_SIZE = sizeof(aap_parameter_info_t); // it is the expected max size in v2.1 extension.
+// Written by the service host right after the parameter count in the OPCODE_PARAMETERS_GET_PARAMETER_COUNT
+// reply data, to tell the client host that it accepts OPCODE_PARAMETERS_GET_PARAMETER_DESCRIPTORS.
+// Older services leave the slot untouched, so the client keeps issuing the per-item requests.
+const int32_t AAP_PARAMETERS_COUNT_REPLY_DESCRIPTOR_PAGES = 0x41415044; // 'AAPD'
+
+// OPCODE_PARAMETERS_GET_PARAMETER_DESCRIPTORS takes the start index (int32_t) and replies with
+// as many parameters as fit into the shared memory: aap::xs::ParameterDescriptorPageHeader, then
+// for each parameter, aap_parameter_info_t, the number of enumerations (int32_t) and the
+// enumerations (aap_parameter_enum_t). The number of enumerations is -1 if they do not fit into
+// a page at all; the client retrieves them per item then.
+const int32_t PARAMETERS_DESCRIPTOR_PAGE_SIZE = 32768;
+
+// It used to be sizeof(aap_parameter_info_t) (the expected max size in v2.1 extension); now it is large enough for a descriptor page.
+const int32_t PARAMETERS_SHARED_MEMORY_SIZE = PARAMETERS_DESCRIPTOR_PAGE_SIZE;
 
 namespace aap::xs {
+    struct ParameterDescriptorPageHeader {
+        int32_t num_parameters;
+        // including this header
+        int32_t size_in_bytes;
+    };
+
+    typedef std::function<void(const aap_parameter_info_t& parameter,
+                               const aap_parameter_enum_t* enumerations,
+                               int32_t numEnumerations)> ParameterDescriptorCallback;
+
     class ParametersClientAAPXS : public TypedAAPXS {
         // extension proxy support
         static int32_t staticGetParameterCount(aap_parameters_extension_t* ext, AndroidAudioPlugin* plugin) {
@@ -56,6 +80,13 @@ namespace aap::xs {
         };
 
         CallbackData pending_calls[UINT8_MAX];
+        struct ParameterCountReply {
+            int32_t count;
+            int32_t flags;
+        };
+        // set by the service reply to getParameterCount().
+        bool descriptor_pages_supported{false};
+
         static void completeWithParameterCallback(void *callbackData, void *pluginOrHost);
         static void completeWithEnumCallback(void *callbackData, void *pluginOrHost);
 
@@ -71,6 +102,17 @@ namespace aap::xs {
         int32_t getEnumerationCount(int32_t index);
         aap_parameter_enum_t getEnumeration(int32_t index, int32_t enumIndex);
 
+        // Bulk retrieval (OPCODE_PARAMETERS_GET_PARAMETER_DESCRIPTORS). It is available if the
+        // service reported it in the reply to the last getParameterCount() call.
+        bool supportsParameterDescriptorPages() { return descriptor_pages_supported; }
+        // Copies the descriptor page that starts at `startIndex` into `buffer`. Returns the size
+        // of the page, or -1 if it failed.
+        int32_t getParameterDescriptorPage(int32_t startIndex, uint8_t* buffer, int32_t bufferSize);
+        // Retrieves the descriptors of all the `parameterCount` parameters, a page at a time
+        // through `pageBuffer`. Returns false if it could not (use the per-item functions then).
+        bool getParameterDescriptors(int32_t parameterCount, uint8_t* pageBuffer, int32_t pageBufferSize,
+                                     ParameterDescriptorCallback onParameter);
+
         // returns request ID
         int32_t getParameterAsync(int32_t index, aapxs_async_get_parameter_callback* callback);
         // returns request ID
@@ -147,7 +189,8 @@ namespace aap::xs {
 
         // Per-opcode RT-safety, matching the RT_SAFE/RT_UNSAFE annotations in ext/parameters.h.
         // - get_parameter_count is RT_SAFE.
-        // - get_parameter / get_parameter_property / get_enumeration_count / get_enumeration are
+        // - get_parameter / get_parameter_property / get_enumeration_count / get_enumeration (and
+        //   the descriptor pages that batch them) are
         //   RT_UNSAFE: they can be issued hundreds/thousands at a time over one shared serialization
         //   buffer, so they stay on the synchronous Binder path.
         // Host callbacks are always treated as RT-unsafe by the runtime, so they are not handled here.
@@ -9,6 +9,8 @@
 #include "midi-aapxs.h"
 #include "gui-aapxs.h"
 #include "urid-aapxs.h"
+#include "tail-aapxs.h"
+#include <algorithm>
 #include <functional>
 
 namespace aap::xs {
@@ -32,6 +34,9 @@ namespace aap::xs {
         virtual int32_t getEnumerationCount(int32_t index) = 0;
         virtual aap_parameter_enum_t getEnumeration(int32_t index, int32_t enumIndex) = 0;
         virtual aap_parameters_extension_t* asParametersExtension() { return nullptr; }
+        // Enumerates all the parameters with their enumerations in fewer calls than the per-item
+        // functions, where the implementation supports it. Returns false if it does not (or failed).
+        virtual bool getParameterDescriptors(int32_t parameterCount, ParameterDescriptorCallback onParameter) { return false; }
 
         // Presets
         virtual int32_t getPresetCount() = 0;
@@ -59,6 +64,34 @@ namespace aap::xs {
             memcpy(tmp_state.data, stateToLoad, dataSize);
             return setState(tmp_state);
         }
+        // Streaming variants without the size limit of the shared memory. The default implementations
+        // go through getState() and setState().
+        virtual std::string readState(StateChunkReader onChunk) {
+            auto result = getState();
+            if (result.isOk() && result.value.data_size > 0)
+                onChunk((const uint8_t*) result.value.data, result.value.data_size, result.value.data_size);
+            return result.error;
+        }
+        virtual std::string writeState(size_t totalSize, StateChunkWriter nextChunk) {
+            std::vector<uint8_t> buffer(totalSize);
+            if (totalSize > 0 && !nextChunk(buffer.data(), 0, totalSize))
+                return "cancelled";
+            aap_state_t stateToLoad{buffer.data(), totalSize};
+            return setState(stateToLoad).error;
+        }
+        // Brings `snapshot` up to date with the current state. The default implementation reads it all.
+        virtual std::string updateStateSnapshot(StateSnapshot& snapshot) {
+            snapshot.clear();
+            auto error = readState([&snapshot](const uint8_t* data, size_t size, size_t totalSize) {
+                snapshot.data.reserve(totalSize);
+                snapshot.data.insert(snapshot.data.end(), data, data + size);
+                return true;
+            });
+            snapshot.last_transferred_size = snapshot.data.size();
+            if (!error.empty())
+                snapshot.clear();
+            return error;
+        }
 
         // Gui
         virtual aap_gui_instance_id createGui(std::string pluginId, int32_t instanceId, void* audioPluginView) = 0;
@@ -66,6 +99,9 @@ namespace aap::xs {
         virtual int32_t hideGui(aap_gui_instance_id guiInstanceId) = 0;
         virtual int32_t resizeGui(aap_gui_instance_id guiInstanceId, int32_t width, int32_t height) = 0;
         virtual int32_t destroyGui(aap_gui_instance_id guiInstanceId) = 0;
+
+        // Tail
+        virtual int32_t getTailTimeInMilliseconds() = 0;
     };
 
     class ClientStandardExtensions : public StandardExtensions {
@@ -76,6 +112,7 @@ namespace aap::xs {
         std::unique_ptr<StateClientAAPXS> state{nullptr};
         std::unique_ptr<GuiClientAAPXS> gui{nullptr};
         std::unique_ptr<UridClientAAPXS> urid{nullptr};
+        std::unique_ptr<TailClientAAPXS> tail{nullptr};
 
     public:
         void initialize(AAPXSClientDispatcher* dispatcher) {
@@ -87,6 +124,7 @@ namespace aap::xs {
             state = std::make_unique<StateClientAAPXS>(dispatcher->getPluginAAPXSByUri(AAP_STATE_EXTENSION_URI), dispatcher->getSerialization(AAP_STATE_EXTENSION_URI));
             gui = std::make_unique<GuiClientAAPXS>(dispatcher->getPluginAAPXSByUri(AAP_GUI_EXTENSION_URI), dispatcher->getSerialization(AAP_GUI_EXTENSION_URI));
             urid = std::make_unique<UridClientAAPXS>(dispatcher->getPluginAAPXSByUri(AAP_URID_EXTENSION_URI), dispatcher->getSerialization(AAP_URID_EXTENSION_URI));
+            tail = std::make_unique<TailClientAAPXS>(dispatcher->getPluginAAPXSByUri(AAP_TAIL_EXTENSION_URI), dispatcher->getSerialization(AAP_TAIL_EXTENSION_URI));
             initialized = true;
         }
 
@@ -103,6 +141,12 @@ namespace aap::xs {
         int32_t getEnumerationCount(int32_t index) override { return parameters->getEnumerationCount(index); }
         aap_parameter_enum_t getEnumeration(int32_t index, int32_t enumIndex) override { return parameters->getEnumeration(index, enumIndex); }
         aap_parameters_extension_t* asParametersExtension() override { return parameters ? parameters->asPluginExtension() : nullptr; }
+        bool getParameterDescriptors(int32_t parameterCount, ParameterDescriptorCallback onParameter) override {
+            if (!parameters->supportsParameterDescriptorPages())
+                return false;
+            std::vector<uint8_t> page(PARAMETERS_DESCRIPTOR_PAGE_SIZE);
+            return parameters->getParameterDescriptors(parameterCount, page.data(), (int32_t) page.size(), std::move(onParameter));
+        }
 
         // Presets
         int32_t getPresetCount() override { return presets->getPresetCount(); }
@@ -133,14 +177,17 @@ namespace aap::xs {
         int32_t getStateSize() override { return state->getStateSize(); }
         // OBSOLETE: use requestStateAsync() instead.
         Result<aap_state_t> getState() override {
-            if (tmp_state_capacity < static_cast<size_t>(STATE_SHARED_MEMORY_SIZE)) {
+            // the state may be larger than the shared memory (it is transferred in chunks then).
+            auto size = std::max(state->getStateSize(), static_cast<size_t>(1));
+            if (tmp_state_capacity < size) {
                 if (tmp_state.data)
                     free(tmp_state.data);
-                tmp_state.data = calloc(1, STATE_SHARED_MEMORY_SIZE);
-                tmp_state_capacity = STATE_SHARED_MEMORY_SIZE;
+                tmp_state.data = calloc(1, size);
+                tmp_state_capacity = size;
             }
             tmp_state.data_size = tmp_state_capacity;
             auto error = state->getState(tmp_state);
+            tmp_state.data_size = std::min(tmp_state.data_size, tmp_state_capacity);
             return Result<aap_state_t>{tmp_state, error};
         }
         // OBSOLETE: use setStateAsync() instead.
@@ -154,6 +201,9 @@ namespace aap::xs {
         int32_t setStateAsync(aap_state_t& stateToLoad, std::function<void(Result<bool>)> callback) override {
             return state->setStateAsync(stateToLoad, std::move(callback));
         }
+        std::string readState(StateChunkReader onChunk) override { return state->readState(std::move(onChunk)); }
+        std::string writeState(size_t totalSize, StateChunkWriter nextChunk) override { return state->writeState(totalSize, std::move(nextChunk)); }
+        std::string updateStateSnapshot(StateSnapshot& snapshot) override { return state->updateStateSnapshot(snapshot); }
 
         // Gui
         aap_gui_instance_id createGui(std::string pluginId, int32_t instanceId, void* audioPluginView) override { return gui->createGui(pluginId, instanceId, audioPluginView); }
@@ -161,6 +211,9 @@ namespace aap::xs {
         int32_t hideGui(aap_gui_instance_id guiInstanceId) override { return gui->hideGui(guiInstanceId); }
         int32_t resizeGui(aap_gui_instance_id guiInstanceId, int32_t width, int32_t height) override { return gui->resizeGui(guiInstanceId, width, height); }
         int32_t destroyGui(aap_gui_instance_id guiInstanceId) override { return gui->destroyGui(guiInstanceId); }
+
+        // Tail
+        int32_t getTailTimeInMilliseconds() override { return tail->getTailTimeInMilliseconds(); }
     };
 
     class ServiceStandardExtensions : public StandardExtensions {
@@ -170,6 +223,7 @@ namespace aap::xs {
         aap_presets_extension_t* presets;
         aap_state_extension_t* state;
         aap_gui_extension_t* gui;
+        aap_tail_extension_t* tail;
 
     public:
         ServiceStandardExtensions(AndroidAudioPlugin* plugin) : plugin(plugin) {
@@ -177,6 +231,7 @@ namespace aap::xs {
             parameters = (aap_parameters_extension_t*) plugin->get_extension(plugin, AAP_PARAMETERS_EXTENSION_URI);
             presets = (aap_presets_extension_t*) plugin->get_extension(plugin, AAP_PRESETS_EXTENSION_URI);
             state = (aap_state_extension_t*) plugin->get_extension(plugin, AAP_STATE_EXTENSION_URI);
+            tail = (aap_tail_extension_t*) plugin->get_extension(plugin, AAP_TAIL_EXTENSION_URI);
         }
 
         // MIDI
@@ -282,6 +337,9 @@ namespace aap::xs {
                 return AAP_GUI_ERROR_NO_GUI_DEFINED;
             return 0;
         }
+
+        // Tail
+        int32_t getTailTimeInMilliseconds() override { return tail && tail->get_tail_time_in_milliseconds ? tail->get_tail_time_in_milliseconds(tail, plugin) : AAP_TAIL_TIME_INFINITE; }
     };
 
     class StandardHostExtensions {
@@ -5,7 +5,9 @@
 #include <cstring>
 #include <functional>
 #include <future>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include "aap/aapxs.h"
 #include "../../ext/state.h"
@@ -15,13 +17,94 @@
 const int32_t OPCODE_GET_STATE_SIZE = 1;
 const int32_t OPCODE_GET_STATE = 2;
 const int32_t OPCODE_SET_STATE = 3;
+const int32_t OPCODE_GET_STATE_CHUNK = 4;
+const int32_t OPCODE_SET_STATE_CHUNK = 5;
+const int32_t OPCODE_GET_STATE_DELTA = 6;
 
 // host extension opcodes
 // ... nothing?
 
 const int32_t STATE_SHARED_MEMORY_SIZE = 0x100000; // 1M
 
+// Written by the service host after the (int32_t) state size in the OPCODE_GET_STATE_SIZE reply, to
+// tell the client host that it accepts OPCODE_GET_STATE_CHUNK and OPCODE_SET_STATE_CHUNK. The full
+// (int64_t) size follows it. Older services leave it untouched (the client clears it beforehand).
+const int32_t AAP_STATE_SIZE_REPLY_CHUNKED = 0x41415343; // 'AASC'
+
+// The chunked state transfer is not limited by the shared memory size. The service still has to
+// hold the whole state while it is transferred, as the plugin API takes it at once.
+// - OPCODE_GET_STATE_CHUNK takes the (int64_t) offset. The service captures the state from the
+//   plugin at offset 0, and replies with a StateChunkHeader and the chunk.
+// - OPCODE_SET_STATE_CHUNK takes a StateChunkHeader and the chunk. The service passes the state to
+//   the plugin when it received the last chunk, and replies with the status (int32_t, 0 = success).
+//   A total size above STATE_CHUNKED_TRANSFER_MAX_SIZE (or one that cannot be allocated) is rejected.
+const int64_t STATE_CHUNKED_TRANSFER_MAX_SIZE = 0x40000000; // 1G
+
+// Written by the service host after the full size in the OPCODE_GET_STATE_SIZE reply, to tell that
+// it accepts OPCODE_GET_STATE_DELTA as well.
+const int32_t AAP_STATE_SIZE_REPLY_DELTA = 0x41415344; // 'AASD'
+
+// OPCODE_GET_STATE_DELTA returns only the blocks of the state that differ from the client host's
+// snapshot, so that frequent autosaves do not transfer the whole state every time. The state is
+// split into fixed-size blocks, and the client sends the hashes of the blocks it has; the service
+// keeps nothing between snapshots.
+// - The first request is a StateDeltaRequestHeader (cursor 0) followed by the block hashes
+//   (uint64_t each). The service captures the state and compares the block hashes.
+// - The reply is a StateDeltaReplyHeader followed by the changed blocks (each one is a
+//   StateDeltaBlockHeader and the block data) as many as fit. While `next_cursor` is not the
+//   number of the changed blocks, the client sends another request with that cursor (and no hashes).
+// - A negative cursor cancels the transfer.
+const int32_t STATE_DELTA_DEFAULT_BLOCK_SIZE = 0x4000; // 16K
+
 namespace aap::xs {
+    struct StateChunkHeader {
+        int64_t total_size;
+        int64_t offset;
+        int32_t chunk_size;
+        int32_t reserved;
+    };
+
+    struct StateDeltaRequestHeader {
+        int64_t cursor;
+        int32_t block_size;
+        int32_t num_hashes;
+    };
+
+    struct StateDeltaReplyHeader {
+        int64_t total_size;
+        int32_t num_changed_blocks;
+        int32_t num_blocks_in_reply;
+        int32_t next_cursor;
+        int32_t block_size;
+    };
+
+    struct StateDeltaBlockHeader {
+        uint64_t hash;
+        int32_t index;
+        int32_t size;
+    };
+
+    // The host side copy of a plugin state that StateClientAAPXS::updateStateSnapshot() brings up
+    // to date. Keep the same instance between the calls to transfer only the changes.
+    struct StateSnapshot {
+        std::vector<uint8_t> data{};
+        std::vector<uint64_t> block_hashes{};
+        int32_t block_size{0};
+        // the state bytes that the last update actually transferred
+        size_t last_transferred_size{0};
+
+        void clear() {
+            data.clear();
+            block_hashes.clear();
+            block_size = 0;
+        }
+    };
+
+    // Receives the state chunks in order. Return false to stop the transfer.
+    typedef std::function<bool(const uint8_t* data, size_t size, size_t totalSize)> StateChunkReader;
+    // Fills `destination` with `size` bytes of the state starting at `offset`. Return false to stop the transfer.
+    typedef std::function<bool(uint8_t* destination, size_t offset, size_t size)> StateChunkWriter;
+
     class StateClientAAPXS : public TypedAAPXS {
         // extension proxy support
         static size_t staticGetStateSize(aap_state_extension_t* ext, AndroidAudioPlugin* plugin) {
@@ -38,6 +121,18 @@ namespace aap::xs {
                                                   staticGetState,
                                                   staticSetState};
 
+        struct StateSizeReply {
+            int32_t size;
+            int32_t flags;
+            int64_t full_size;
+            int32_t delta_flags;
+            int32_t reserved;
+        };
+        // set by the service reply to getStateSize().
+        bool chunks_supported{false};
+        bool delta_supported{false};
+        bool chunks_probed{false};
+
     public:
         StateClientAAPXS(AAPXSInitiatorInstance* initiatorInstance, AAPXSSerializationContext* serialization)
                 : TypedAAPXS(AAP_STATE_EXTENSION_URI, initiatorInstance, serialization) {
@@ -51,7 +146,23 @@ namespace aap::xs {
         int32_t requestStateAsync(std::function<void(Result<aap_state_t>)> callback);
         int32_t setStateAsync(aap_state_t& stateToLoad, std::function<void(Result<bool>)> callback);
 
+        // Streaming transfer in chunks of the shared memory size, without the size limit that
+        // getState() and setState() have (they use it too if the state does not fit). Returns an
+        // error description; empty == success.
+        std::string readState(StateChunkReader onChunk);
+        std::string writeState(size_t totalSize, StateChunkWriter nextChunk);
+        // Updates `snapshot` to the current plugin state, transferring only the blocks that changed
+        // since it was last updated (everything if the service does not support it). Returns an
+        // error description; empty == success. The snapshot is cleared on failure.
+        std::string updateStateSnapshot(StateSnapshot& snapshot);
+
         aap_state_extension_t * asPluginExtension() { return &as_plugin_extension; }
+
+    private:
+        // the single-request transfer (limited to the shared memory size)
+        std::string getStateAtOnce(aap_state_t& stateToSave);
+        std::string setStateAtOnce(aap_state_t& stateToLoad);
+        void discardStateChunks(int32_t opcode);
     };
 
     class StateServiceAAPXS : public TypedAAPXS {
@@ -64,6 +175,19 @@ namespace aap::xs {
     };
 
     class AAPXSDefinition_State : public AAPXSDefinitionWrapper {
+        // the whole state being transferred in chunks, per service instance (keyed by its serialization).
+        struct StagedState {
+            std::unique_ptr<uint8_t[]> data{};
+            size_t size{0};
+            // OPCODE_GET_STATE_DELTA only
+            int32_t block_size{0};
+            std::vector<int32_t> changed_blocks{};
+            std::vector<uint64_t> changed_block_hashes{};
+        };
+        std::mutex staging_mutex{};
+        std::map<AAPXSSerializationContext*, StagedState> staging{};
+        static void captureState(aap_state_extension_t* ext, AndroidAudioPlugin* plugin, StagedState& staged);
+        StagedState& getStagedState(AAPXSSerializationContext* serialization);
 
         static void aapxs_state_process_incoming_plugin_aapxs_request(
                 struct AAPXSDefinition* feature,
@@ -111,6 +235,10 @@ namespace aap::xs {
         AAPXSDefinition& asPublic() override {
             return aapxs_state;
         }
+
+        // Drops the state that a chunked transfer holds for the service instance. The service host
+        // calls it when the instance goes away, as an abandoned transfer is never completed.
+        void releaseStagedState(AAPXSSerializationContext* serialization);
     };
 }
 
@@ -0,0 +1,90 @@
+#ifndef AAP_CORE_TAIL_AAPXS_H
+#define AAP_CORE_TAIL_AAPXS_H
+
+#include <functional>
+#include <future>
+#include "aap/aapxs.h"
+#include "../../ext/tail.h"
+#include "typed-aapxs.h"
+
+// plugin extension opcodes
+const int32_t OPCODE_GET_TAIL_TIME = 1;
+
+// host extension opcodes
+// ... nothing?
+
+const int32_t TAIL_SHARED_MEMORY_SIZE = sizeof(int32_t);
+
+namespace aap::xs {
+    class TailClientAAPXS : public TypedAAPXS {
+        static int32_t staticGetTailTimeInMilliseconds(aap_tail_extension_t* ext, AndroidAudioPlugin*) {
+            return ((TailClientAAPXS*) ext->aapxs_context)->getTailTimeInMilliseconds();
+        }
+        aap_tail_extension_t as_public_extension{this, staticGetTailTimeInMilliseconds};
+    public:
+        TailClientAAPXS(AAPXSInitiatorInstance* initiatorInstance, AAPXSSerializationContext* serialization)
+                : TypedAAPXS(AAP_TAIL_EXTENSION_URI, initiatorInstance, serialization) {
+        }
+
+        // Returns AAP_TAIL_TIME_INFINITE if the plugin does not implement the extension, or the
+        // service did not reply in time (e.g. it predates the extension).
+        int32_t getTailTimeInMilliseconds();
+
+        aap_tail_extension_t* asPluginExtension() { return &as_public_extension; }
+    };
+
+    class AAPXSDefinition_Tail : public AAPXSDefinitionWrapper {
+
+        static void aapxs_tail_process_incoming_plugin_aapxs_request(
+                struct AAPXSDefinition* feature,
+                AAPXSRecipientInstance* aapxsInstance,
+                AndroidAudioPlugin* plugin,
+                AAPXSRequestContext* request);
+        static void aapxs_tail_process_incoming_host_aapxs_request(
+                struct AAPXSDefinition* feature,
+                AAPXSRecipientInstance* aapxsInstance,
+                AndroidAudioPluginHost* host,
+                AAPXSRequestContext* request);
+        static void aapxs_tail_process_incoming_plugin_aapxs_reply(
+                struct AAPXSDefinition* feature,
+                AAPXSInitiatorInstance* aapxsInstance,
+                AndroidAudioPlugin* plugin,
+                AAPXSRequestContext* request);
+        static void aapxs_tail_process_incoming_host_aapxs_reply(
+                struct AAPXSDefinition* feature,
+                AAPXSInitiatorInstance* aapxsInstance,
+                AndroidAudioPluginHost* host,
+                AAPXSRequestContext* request);
+
+        // It is used in synchronous context such as `get_extension()` in `binder-client-as-plugin.cpp` etc.
+        static AAPXSExtensionClientProxy aapxs_tail_get_plugin_proxy(
+                struct AAPXSDefinition* feature,
+                AAPXSInitiatorInstance* aapxsInstance,
+                AAPXSSerializationContext* serialization);
+
+        static void* aapxs_tail_as_plugin_extension(AAPXSExtensionClientProxy* proxy) {
+            return ((TailClientAAPXS*) proxy->aapxs_context)->asPluginExtension();
+        }
+
+        AAPXSDefinition aapxs_tail{this,
+                                   AAP_TAIL_EXTENSION_URI,
+                                   TAIL_SHARED_MEMORY_SIZE,
+                                   aapxs_tail_process_incoming_plugin_aapxs_request,
+                                   aapxs_tail_process_incoming_host_aapxs_request,
+                                   aapxs_tail_process_incoming_plugin_aapxs_reply,
+                                   aapxs_tail_process_incoming_host_aapxs_reply,
+                                   aapxs_tail_get_plugin_proxy,
+                                   nullptr, // no host extension
+                                   // the host queries it at prepare() (before ACTIVE state), so
+                                   // is_command_rt_safe is left null -> always Binder.
+                                   nullptr
+        };
+
+    public:
+        AAPXSDefinition& asPublic() override {
+            return aapxs_tail;
+        }
+    };
+}
+
+#endif //AAP_CORE_TAIL_AAPXS_H
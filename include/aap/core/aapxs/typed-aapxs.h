@@ -3,6 +3,7 @@
 
 #include <future>
 #include <functional>
+#include <array>
 #include <map>
 #include <deque>
 #include <vector>
@@ -23,6 +24,13 @@
 #define AAPXS_REQUEST_TIMEOUT_DEFAULT_MS 1000
 #endif
 
+// Number of preallocated completion slots per TypedAAPXS for synchronous calls. More than one is
+// needed only for concurrent synchronous calls on the same extension, or while a timed-out call
+// still waits for its (late) reply.
+#ifndef AAPXS_SYNC_COMPLETION_SLOTS
+#define AAPXS_SYNC_COMPLETION_SLOTS 4
+#endif
+
 namespace aap { class PluginInstance; }
 
 namespace aap::xs {
@@ -34,6 +42,74 @@ namespace aap::xs {
 
     class TypedAAPXS;
 
+    // Preallocated completion slot for synchronous AAPXS calls. The reply callback flips its
+    // atomic state, and the caller spins briefly and then sleeps on a futex (a short nanosleep
+    // where futex is unavailable), so that a synchronous call involves neither heap allocation
+    // nor std::promise. A slot whose wait timed out stays reserved until the late reply (or the
+    // transport failure) arrives, so that it never completes a newer call.
+    class SyncCompletionSlot {
+        std::atomic<uint32_t> state{IDLE};
+        // the TypedAAPXS whose serialization block the call holds; told when a late reply frees it.
+        std::atomic<TypedAAPXS*> owner{nullptr};
+
+    public:
+        enum State : uint32_t {
+            IDLE,
+            PENDING,
+            // PENDING, and the caller is sleeping on the futex
+            WAITING,
+            COMPLETED,
+            FAILED,
+            // the caller gave up waiting; the late reply will make it IDLE again.
+            ABANDONED
+        };
+
+        bool tryAcquire(TypedAAPXS* owner) {
+            uint32_t expected = IDLE;
+            if (!state.compare_exchange_strong(expected, PENDING, std::memory_order_acquire))
+                return false;
+            this->owner.store(owner, std::memory_order_release);
+            return true;
+        }
+        bool isAbandoned() { return state.load(std::memory_order_acquire) == ABANDONED; }
+        uint32_t getState() { return state.load(std::memory_order_acquire); }
+
+        // Invoked by the reply or error callback.
+        void complete(bool succeeded);
+        // Returns COMPLETED, FAILED, or ABANDONED if it timed out (negative `timeoutMs` waits forever).
+        // The slot must be released by the caller unless it returned ABANDONED.
+        uint32_t wait(int32_t timeoutMs);
+        // Returns whether the call still counted against its owner's serialization block (i.e.
+        // `TypedAAPXS::failAllPending()` did not take it over meanwhile).
+        bool release() {
+            bool owned = owner.exchange(nullptr, std::memory_order_acq_rel) != nullptr;
+            state.store(IDLE, std::memory_order_release);
+            return owned;
+        }
+        // the owner is going away; a late reply must not reach it.
+        void detach() { owner.store(nullptr, std::memory_order_release); }
+        // Takes over the call from `owner`; returns false if the caller or a late reply already released it.
+        bool disown(TypedAAPXS* owner) {
+            return this->owner.compare_exchange_strong(owner, nullptr, std::memory_order_acq_rel);
+        }
+        // Makes an abandoned slot reusable when its reply can no longer arrive.
+        void reclaim() {
+            uint32_t expected = ABANDONED;
+            state.compare_exchange_strong(expected, IDLE, std::memory_order_acq_rel);
+        }
+
+        static void onReply(void* callbackContext, void* pluginOrHost) {
+            ((SyncCompletionSlot*) callbackContext)->complete(true);
+        }
+        static void onError(void* callbackContext, void* pluginOrHost, const char* error) {
+            ((SyncCompletionSlot*) callbackContext)->complete(false);
+        }
+    };
+
+    struct SyncCompletionSlots {
+        std::array<SyncCompletionSlot, AAPXS_SYNC_COMPLETION_SLOTS> slots{};
+    };
+
     // Shared-owned registry of a plugin instance's async-capable AAPXS clients. Held by *both* the
     // owning PluginInstance and every TypedAAPXS (via shared_ptr), so abort iteration and teardown
     // are independent of member-destruction order. (An earlier version stored the mutex directly on
@@ -45,6 +121,8 @@ namespace aap::xs {
     };
 
     class TypedAAPXS {
+        friend class SyncCompletionSlot;
+
         const char* uri;
     protected:
         AAPXSInitiatorInstance *aapxs_instance;
@@ -90,35 +168,68 @@ namespace aap::xs {
         }
 
         // This must be visible to consuming code i.e. defined in this header file.
-        // FIXME: use spinlock instead of promise<T> for RT-safe extension functions,
-        //  which means there should be another RT-safe version of this function.
+        // It waits on a preallocated completion slot (no allocation, no std::promise), without timeout.
+        // Like the other synchronous calls, it goes through the deferral queue (see `beginSyncCall()`)
+        // while another call holds the serialization block.
         template<typename T>
         T callTypedFunctionSynchronously(int32_t opcode) {
-            std::promise<T> promise{};
+            auto slot = beginSyncCall();
+            if (!slot)
+                return callAndWait<T>(opcode, [](AAPXSSerializationContext* s) { return getTypedResult<T>(s); }, -1).value;
             uint32_t requestId = aapxs_instance->get_new_request_id(aapxs_instance);
-            auto future = promise.get_future();
-            WithPromise<void, T> callbackData{serialization->data, &promise};
-            AAPXSRequestContext request{getTypedCallback<T>, &callbackData, serialization, aapxs_instance->urid, uri, requestId, opcode};
-
-            if (aapxs_instance->send_aapxs_request(aapxs_instance, &request)) {
-                future.wait();
-                return future.get();
-            }
-            else
-                return getTypedResult<T>(serialization);
+            AAPXSRequestContext request{SyncCompletionSlot::onReply, slot, serialization, aapxs_instance->urid, uri, requestId, opcode,
+                                        SyncCompletionSlot::onError};
+            if (aapxs_instance->send_aapxs_request(aapxs_instance, &request))
+                slot->wait(-1);
+            auto result = getTypedResult<T>(serialization);
+            endSyncCall(slot);
+            return result;
         }
 
-        // FIXME: use spinlock instead of promise<T> for RT-safe extension functions,
-        //  which means there should be another RT-safe version of this function.
         void callVoidFunctionSynchronously(int32_t opcode) {
-            std::promise<int32_t> promise{};
+            auto slot = beginSyncCall();
+            if (!slot) {
+                callAndWait<bool>(opcode, [](AAPXSSerializationContext*) { return true; }, -1);
+                return;
+            }
             uint32_t requestId = aapxs_instance->get_new_request_id(aapxs_instance);
-            WithPromise<void, int32_t> callbackData{serialization->data, &promise};
-            auto future = promise.get_future();
-            AAPXSRequestContext request{getVoidCallback, &callbackData, serialization, aapxs_instance->urid, uri, requestId, opcode};
-
+            AAPXSRequestContext request{SyncCompletionSlot::onReply, slot, serialization, aapxs_instance->urid, uri, requestId, opcode,
+                                        SyncCompletionSlot::onError};
             if (aapxs_instance->send_aapxs_request(aapxs_instance, &request))
-                future.wait();
+                slot->wait(-1);
+            endSyncCall(slot);
+        }
+
+        // Synchronous call that waits up to `request_timeout_ms` and reports failures, like
+        // `callAndWait()`, but on a preallocated completion slot. While another call on this
+        // extension holds the serialization block, it falls back to `callAndWait()` so that the
+        // request is deferred instead of overwriting the block.
+        template<typename T>
+        Result<T> callTypedFunctionAndWait(int32_t opcode) {
+            auto slot = beginSyncCall();
+            if (!slot)
+                return callAndWait<T>(opcode, [](AAPXSSerializationContext* s) { return getTypedResult<T>(s); });
+            uint32_t requestId = aapxs_instance->get_new_request_id(aapxs_instance);
+            AAPXSRequestContext request{SyncCompletionSlot::onReply, slot, serialization, aapxs_instance->urid, uri, requestId, opcode,
+                                        SyncCompletionSlot::onError};
+            if (!aapxs_instance->send_aapxs_request(aapxs_instance, &request)) {
+                endSyncCall(slot);
+                return Result<T>{T{}, "request could not be sent"};
+            }
+            switch (slot->wait(request_timeout_ms)) {
+                case SyncCompletionSlot::COMPLETED: {
+                    auto result = Result<T>{getTypedResult<T>(serialization), ""};
+                    endSyncCall(slot);
+                    return result;
+                }
+                case SyncCompletionSlot::FAILED:
+                    endSyncCall(slot);
+                    return Result<T>{T{}, "error"};
+                default:
+                    // the slot (and the serialization block) is released when the late reply or
+                    // transport failure arrives, and the deferred calls are sent after that.
+                    return Result<T>{T{}, "timeout"};
+            }
         }
 
         // "Fire and forget" invocation: sends a request with no completion callback (the
@@ -146,6 +257,46 @@ namespace aap::xs {
     protected:
         int32_t request_timeout_ms{AAPXS_REQUEST_TIMEOUT_DEFAULT_MS};
 
+        // Allocated once at construction. It is deliberately leaked at destruction if a timed-out
+        // call is still waiting for its reply, as the transport still holds a pointer to its slot.
+        std::unique_ptr<SyncCompletionSlots> sync_slots{std::make_unique<SyncCompletionSlots>()};
+
+        // the number of calls on completion slots that hold the serialization block, including
+        // the ones whose wait timed out and whose reply has not arrived yet. Guarded by `calls_mutex`.
+        int32_t sync_in_flight_count{0};
+
+        // Reserves the serialization block and a completion slot for a synchronous call. Returns
+        // nullptr if another call holds the block (or is deferred), or every slot is taken; the
+        // caller should then go through `callAndWait()`, which defers the request.
+        SyncCompletionSlot* beginSyncCall() {
+            if (!sync_slots)
+                return nullptr;
+            std::lock_guard<std::mutex> lock(calls_mutex);
+            if (!in_flight.empty() || !deferred.empty() || sync_in_flight_count > 0)
+                return nullptr;
+            for (auto& slot : sync_slots->slots) {
+                if (slot.tryAcquire(this)) {
+                    sync_in_flight_count++;
+                    return &slot;
+                }
+            }
+            return nullptr;
+        }
+
+        // Releases the slot and the serialization block after `wait()` returned COMPLETED or
+        // FAILED (or the request was not sent at all).
+        void endSyncCall(SyncCompletionSlot* slot) {
+            if (slot->release())
+                onSyncCallEnded();
+        }
+
+        // Also invoked by SyncCompletionSlot when a late reply completes an abandoned call.
+        void onSyncCallEnded() {
+            std::unique_lock<std::mutex> lock(calls_mutex);
+            sync_in_flight_count--;
+            sendNextDeferredLocked(lock);
+        }
+
         struct AsyncCall {
             std::atomic<TypedAAPXS*> owner{nullptr};
             uint32_t request_id{0};
@@ -208,14 +359,19 @@ namespace aap::xs {
                 call->deliver(error);
             std::unique_lock<std::mutex> lock(calls_mutex);
             in_flight.erase(call->request_id); // deletes the AsyncCall; do not touch `call` afterwards
-            if (!deferred.empty() && in_flight.empty()) {
-                DeferredCall d = std::move(deferred.front());
-                deferred.pop_front();
-                if (!d.payload.empty())
-                    memcpy(serialization->data, d.payload.data(), d.payload.size());
-                serialization->data_size = d.payload.size();
-                sendLocked(d.opcode, std::move(d.call), lock);
-            }
+            sendNextDeferredLocked(lock);
+        }
+
+        // assumes `calls_mutex` is held on entry; sends the first deferred call if the block is free.
+        void sendNextDeferredLocked(std::unique_lock<std::mutex>& lock) {
+            if (deferred.empty() || !in_flight.empty() || sync_in_flight_count > 0)
+                return;
+            DeferredCall d = std::move(deferred.front());
+            deferred.pop_front();
+            if (!d.payload.empty())
+                memcpy(serialization->data, d.payload.data(), d.payload.size());
+            serialization->data_size = d.payload.size();
+            sendLocked(d.opcode, std::move(d.call), lock);
         }
 
         void detachAllPending(const std::string& error) {
@@ -262,9 +418,12 @@ namespace aap::xs {
         // Fail every in-flight and not-yet-sent request with `error`. Used on hard transport
         // failure (e.g. Binder service death) where no reply will ever arrive. Safe because the
         // death handler then becomes the sole completer (Binder `completed()` cannot fire again).
+        // Synchronous calls on completion slots fail as well, and abandoned slots are reclaimed,
+        // so that the serialization block is free for the next call.
         void failAllPending(const std::string& error) {
             std::vector<AsyncCall*> pending;
             std::deque<DeferredCall> abortedDeferred;
+            std::vector<SyncCompletionSlot*> interrupted;
             {
                 std::unique_lock<std::mutex> lock(calls_mutex);
                 pending.reserve(in_flight.size());
@@ -273,7 +432,29 @@ namespace aap::xs {
                 // Clear deferred first so finish()'s pump does not replay onto a dead service.
                 abortedDeferred = std::move(deferred);
                 deferred.clear();
+                // Slots are acquired only under `calls_mutex`, so none can be added meanwhile.
+                if (sync_slots) {
+                    for (auto& slot : sync_slots->slots) {
+                        if (!slot.disown(this))
+                            continue;
+                        switch (slot.getState()) {
+                            case SyncCompletionSlot::ABANDONED:
+                                slot.reclaim();
+                                break;
+                            case SyncCompletionSlot::PENDING:
+                            case SyncCompletionSlot::WAITING:
+                                interrupted.emplace_back(&slot);
+                                break;
+                            default:
+                                break; // the caller is releasing it.
+                        }
+                    }
+                }
+                sync_in_flight_count = 0;
             }
+            // the callers see FAILED and release their slots; they do not count anymore.
+            for (auto* slot : interrupted)
+                slot->complete(false);
             for (auto* call : pending)
                 finish(call, error);
             for (auto& d : abortedDeferred)
@@ -296,7 +477,7 @@ namespace aap::xs {
             std::unique_lock<std::mutex> lock(calls_mutex);
             uint32_t requestId = aapxs_instance->get_new_request_id(aapxs_instance);
             call->request_id = requestId;
-            if (!in_flight.empty()) {
+            if (!in_flight.empty() || sync_in_flight_count > 0) {
                 // block busy: defer with a snapshot of the current request payload.
                 DeferredCall d;
                 d.opcode = opcode;
@@ -313,6 +494,12 @@ namespace aap::xs {
         // runs inside the completion (safe window) and produces the success value.
         template<typename R>
         Result<R> callAndWait(int32_t opcode, std::function<R(AAPXSSerializationContext*)> deserialize) {
+            return callAndWait<R>(opcode, std::move(deserialize), request_timeout_ms);
+        }
+
+        // Same as above, with an explicit timeout (negative waits until the call completes).
+        template<typename R>
+        Result<R> callAndWait(int32_t opcode, std::function<R(AAPXSSerializationContext*)> deserialize, int32_t timeoutMs) {
             auto promise = std::make_shared<std::promise<Result<R>>>();
             auto future = promise->get_future();
             callFunctionAsync(opcode, [promise, deserialize = std::move(deserialize)](
@@ -322,7 +509,11 @@ namespace aap::xs {
                 else
                     promise->set_value(Result<R>{deserialize(s), ""});
             });
-            if (future.wait_for(std::chrono::milliseconds(request_timeout_ms)) == std::future_status::ready)
+            if (timeoutMs < 0) {
+                future.wait();
+                return future.get();
+            }
+            if (future.wait_for(std::chrono::milliseconds(timeoutMs)) == std::future_status::ready)
                 return future.get();
             // Leave the request registered: the transport timeout sweep / death handler will
             // release it (and the shared promise keeps the late set_value harmless).
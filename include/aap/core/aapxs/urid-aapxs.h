@@ -15,6 +15,11 @@ const int32_t OPCODE_MAP = 1;
 // host extension opcodes
 // ... nothing?
 
+// Written by the service host right after the URI in the OPCODE_MAP reply data, to tell the client
+// host that it accepts compact (URID-only) AAPXS SysEx8 (see `aap_midi2_generate_aapxs_sysex8_compact()`).
+// Older services leave the slot untouched, so the client keeps sending full frames.
+const int32_t AAP_URID_MAP_REPLY_COMPACT_AAPXS_SYSEX8 = 0x41415843; // 'AAXC'
+
 const int32_t URID_SHARED_MEMORY_SIZE = AAP_MAX_PLUGIN_ID_SIZE + sizeof(int32_t) * 2 + AAP_MAX_EXTENSION_URI_SIZE + 1;
 
 namespace aap::xs {
@@ -2,12 +2,98 @@
 #define ANDROIDAUDIOPLUGINFRAMEWORK_ANDROID_AUDIO_PLUGIN_HOST_DESKTOP_H
 #if !ANDROID
 
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 #include "../audio-plugin-host.h"
+#include "../plugin-client-system.h"
+
+// Environment variable that lists plugin directories (separated by ':') to look up aap_metadata.xml.
+#define AAP_DESKTOP_PLUGIN_PATH_ENV "AAP_PLUGIN_PATH"
+// Environment variable to override the directory where plugin services create their sockets.
+#define AAP_DESKTOP_SERVICE_SOCKET_DIR_ENV "AAP_SERVICE_SOCKET_DIR"
+// Environment variable to override the path to the binary plugin metadata index (empty to disable it).
+#define AAP_DESKTOP_METADATA_INDEX_PATH_ENV "AAP_METADATA_INDEX_PATH"
+// On desktop there is no Service class; every plugin package (directory) is served by one service process.
+#define AAP_DESKTOP_SERVICE_CLASS_NAME "AudioPluginService"
 
 namespace aap {
 
+/*
+ * On desktop, a "plugin package" is a directory that contains `aap_metadata.xml` and the plugin
+ * shared libraries. The package name is the directory name, and the plugin service for the
+ * package listens on a Unix domain socket (see `getDesktopServiceSocketPath()`).
+ */
+class DesktopPluginClientSystem : public PluginClientSystem {
+public:
+    virtual ~DesktopPluginClientSystem() {}
+
+    // memfd-based, so that the FD can be passed to the service process via SCM_RIGHTS.
+    int32_t createSharedMemory(size_t size) override;
+
+    void ensurePluginServiceConnected(aap::PluginClientConnectionList* connections, std::string serviceName, std::function<void(std::string&)> callback) override;
+
+    std::vector<std::string> getPluginPaths() override;
+
+    void getAAPMetadataPaths(std::string path, std::vector<std::string>& results) override;
+
+    std::vector<PluginInformation*> getPluginsFromMetadataPaths(std::vector<std::string>& aapMetadataPaths) override;
+
+    // mtime and size of aap_metadata.xml.
+    bool getMetadataStamp(const std::string& aapMetadataPath, PluginMetadataStamp& stamp) override;
+
+    // `${XDG_CACHE_HOME:-~/.cache}/androidaudioplugin/plugin-metadata.idx` unless overridden by the environment variable.
+    std::string getMetadataIndexPath() override;
+};
+
+std::string getDesktopServiceSocketPath(const std::string& packageName);
+
+// Parses one aap_metadata.xml file. Returns an empty list if the file could not be parsed.
+std::vector<PluginInformation*> parseAAPMetadata(const std::string& metadataFullPath, const std::string& packageName, bool isOutProcess);
+
+/*
+ * Client side of a desktop plugin service connection (counterpart of AndroidPluginClientConnectionData).
+ * Each call is a synchronous request/reply over the socket, serialized by a mutex.
+ */
+class DesktopPluginClientConnectionData {
+    int32_t socket_fd;
+    std::mutex call_mutex{};
+
+public:
+    explicit DesktopPluginClientConnectionData(int32_t socketFD) : socket_fd(socketFD) {}
+    ~DesktopPluginClientConnectionData();
+
+    // Returns false on transport failure. Service errors are reported as non-zero `status` with `error`.
+    bool call(int32_t opcode, int32_t instanceId, int32_t arg0, int32_t arg1, int64_t arg2,
+              const std::string& payload, int32_t fdToSend,
+              int32_t& status, int32_t& value, std::string& error);
+};
+
+/*
+ * Out-of-process plugin service for desktop: it serves the plugins in one plugin package
+ * to clients that connect to the package socket. Each client connection gets its own
+ * PluginService, just like each Binder connection gets its own AudioPluginInterfaceImpl.
+ */
+class DesktopPluginService {
+    std::string socket_path;
+    int32_t listen_fd{-1};
+    std::atomic<bool> stopping{false};
+    std::vector<std::thread> client_threads{};
+
+    void serveClient(int32_t clientFD);
+
+public:
+    explicit DesktopPluginService(std::string packageName);
+    ~DesktopPluginService();
+
+    // Blocks until stop() is called. Returns false if the socket could not be set up.
+    bool run();
+    void stop();
+};
+
 } // namespace aap
 
 #endif // ANDROID
 #endif // ANDROIDAUDIOPLUGINFRAMEWORK_ANDROID_AUDIO_PLUGIN_HOST_DESKTOP_H
-
@@ -0,0 +1,54 @@
+#ifndef AAP_CORE_GUI_LISTENER_MIDI_BUFFER_H
+#define AAP_CORE_GUI_LISTENER_MIDI_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include "aap/unstable/utility.h"
+
+namespace aap {
+
+    /**
+     * Wait-free single-producer single-consumer byte ring that carries the MIDI2 (UMP) outputs of
+     * a LocalPluginInstance to its GUI listeners (parameter change notifications etc.).
+     *
+     * The producer is the audio thread (`write()` in process()); it never blocks or allocates.
+     * When the ring is full, the UMPs that do not fit are dropped and counted (see
+     * `getDroppedBytes()`). The consumer (`read()`) only returns whole UMP packets so that every
+     * read can be parsed on its own. Readers that run at the same time do not block each other
+     * either; all but one of them just get nothing.
+     */
+    class GuiListenerMidiBuffer {
+        uint8_t* buffer{nullptr};
+        uint32_t capacity{0};
+        uint32_t mask{0};
+        // monotonically increasing byte positions (wrapping around at 2^32), masked on access.
+        alignas(64) std::atomic<uint32_t> write_position{0};
+        alignas(64) std::atomic<uint32_t> read_position{0};
+        // producer-only writes
+        std::atomic<uint64_t> dropped_bytes{0};
+        std::atomic<uint64_t> dropped_writes{0};
+        // consumer-only state
+        NanoSleepLock read_mutex{};
+        uint64_t reported_dropped_writes{0};
+        int64_t last_report_time_ns{0};
+
+        void copyIn(uint32_t position, const uint8_t* src, uint32_t size);
+        void copyOut(uint32_t position, uint8_t* dst, uint32_t size);
+
+    public:
+        explicit GuiListenerMidiBuffer(int32_t capacityInBytes);
+        ~GuiListenerMidiBuffer();
+
+        // audio thread. `ump` must consist of whole UMP packets.
+        void write(const void* ump, int32_t size);
+
+        // Copies as many whole UMP packets as fit into `output`, and returns the number of bytes.
+        int32_t read(void* output, int32_t size);
+
+        uint64_t getDroppedBytes() const { return dropped_bytes.load(std::memory_order_relaxed); }
+        uint64_t getDroppedWrites() const { return dropped_writes.load(std::memory_order_relaxed); }
+    };
+}
+
+#endif //AAP_CORE_GUI_LISTENER_MIDI_BUFFER_H
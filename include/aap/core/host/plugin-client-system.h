@@ -3,14 +3,41 @@
 
 #include <sys/stat.h>
 #include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
 #include <vector>
 #include "../plugin-information.h"
 #include "plugin-connections.h"
 
 namespace aap {
 
+/**
+ * Identifies the state of one metadata source (e.g. an `aap_metadata.xml` file).
+ * Cached plugin information for the source is reused only while the stamp is unchanged.
+ */
+struct PluginMetadataStamp {
+    int64_t modified_time_nanoseconds{0};
+    int64_t size{0};
+};
+
 class PluginClientSystem
 {
+    struct MetadataEntry {
+        PluginMetadataStamp stamp{};
+        std::vector<PluginInformation*> plugins{};
+    };
+
+    std::mutex installed_plugins_mutex{};
+    bool installed_plugins_cached{false};
+    std::vector<PluginInformation*> installed_plugins{};
+    bool metadata_index_loaded{false};
+    // keyed by metadata path. Only the sources that have a stamp are stored.
+    std::map<std::string, MetadataEntry> metadata_entries{};
+
+    void loadMetadataIndex();
+    void saveMetadataIndex();
+
 public:
     static PluginClientSystem* getInstance();
 
@@ -22,7 +49,29 @@ public:
     virtual void getAAPMetadataPaths(std::string path, std::vector<std::string>& results) = 0;
     virtual std::vector<PluginInformation*> getPluginsFromMetadataPaths(std::vector<std::string>& aapMetadataPaths) = 0;
 
+    /**
+     * Returns the stamp of the metadata at `aapMetadataPath`, or false if it cannot be determined,
+     * in which case the metadata is always parsed. The default implementation returns false.
+     */
+    virtual bool getMetadataStamp(const std::string& aapMetadataPath, PluginMetadataStamp& stamp) { return false; }
+    /**
+     * Returns the file path to store the binary plugin metadata index at, or an empty string
+     * if the index should not be persisted. The default implementation returns an empty string.
+     */
+    virtual std::string getMetadataIndexPath() { return ""; }
+
+    /**
+     * Returns the list of the installed plugins.
+     *
+     * If `returnCacheIfExists` is true and the list has been retrieved before, the cached list is
+     * returned without scanning. Otherwise the plugin paths (or `searchPaths` if specified) are
+     * scanned, and only the metadata sources whose stamps have changed since the last scan
+     * (or since the index was saved) are parsed.
+     */
     std::vector<PluginInformation*> getInstalledPlugins(bool returnCacheIfExists = true, std::vector<std::string>* searchPaths = nullptr);
+
+    /** Discards the cached plugin list so that the next `getInstalledPlugins()` call rescans. */
+    void invalidateInstalledPluginsCache();
 };
 
 } // namespace aap
@@ -20,6 +20,7 @@
 #include "aap/plugin-meta-info.h"
 #include "plugin-connections.h"
 #include "plugin-instance.h"
+#include "process-transport.h"
 #include "../aapxs/extension-service.h"
 #include "../aapxs/standard-extensions.h"
 #include "../aapxs/aapxs-hosting-runtime.h"
@@ -106,6 +107,7 @@ namespace aap {
 
     class PluginClient : public PluginHost {
         PluginClientConnectionList* connections;
+        ProcessTransportType process_transport_type{PROCESS_TRANSPORT_IPC};
 
         // Result<T> is the shared aap::Result<T> (include/aap/core/aapxs/result.h);
         // kept as a member alias so existing `PluginClient::Result<...>` references stay valid.
@@ -124,6 +126,10 @@ namespace aap {
 
         inline PluginClientConnectionList* getConnections() { return connections; }
 
+        // Applies to instances that are created afterwards.
+        inline ProcessTransportType getProcessTransportType() { return process_transport_type; }
+        inline void setProcessTransportType(ProcessTransportType type) { process_transport_type = type; }
+
         // Synchronous version that does not expect service connection on the fly (fails immediately).
         // It is probably better suited for Kotlin client to avoid complicated JNI interop.
         Result<int32_t> createInstance(std::string identifier, bool isRemoteExplicit);
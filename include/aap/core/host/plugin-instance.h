@@ -2,6 +2,7 @@
 #define AAP_CORE_AUDIO_PLUGIN_INSTANCE_H
 //-------------------------------------------------------
 
+#include <functional>
 #include <mutex>
 #include "aap/core/aapxs/standard-extensions.h"
 #include "aap/unstable/utility.h"
@@ -12,6 +13,9 @@
 #include "aap/core/AAPXSMidi2InitiatorSession.h"
 #include "aap/aapxs.h"
 #include "aap/core/aapxs/aapxs-hosting-runtime.h"
+#include "process-trace.h"
+#include "gui-listener-midi-buffer.h"
+#include "silence-bypass.h"
 
 #define AAP_CORE_REMOTE_NATIVE_UI_PREFERRED_SIZE 1
 
@@ -24,6 +28,39 @@ namespace aap {
     class PluginSharedMemoryStore;
     class PluginHost;
     class PluginClient;
+    namespace internal { class ParameterValueTable; }
+
+    // A UMP sequence that the offline renderer delivers at `frame` (counted from the beginning of the render).
+    struct OfflineRenderEvent {
+        int64_t frame;
+        const void* ump;
+        int32_t size;
+    };
+
+    // Fills (or reads) one audio port buffer for the block that starts at `framePosition`.
+    // `audioPortIndex` counts only the audio input (or output) ports.
+    typedef std::function<void(int64_t framePosition, int32_t audioPortIndex, float* buffer, int32_t frameCount)> OfflineRenderInputSource;
+    typedef std::function<void(int64_t framePosition, int32_t audioPortIndex, const float* buffer, int32_t frameCount)> OfflineRenderOutputSink;
+
+    struct OfflineRenderRequest {
+        int64_t total_frames{0};
+        // if it is null, the audio inputs are silent.
+        OfflineRenderInputSource input_source{};
+        // must be sorted by `frame`.
+        const OfflineRenderEvent* events{nullptr};
+        int32_t num_events{0};
+        // optional.
+        OfflineRenderOutputSink output_sink{};
+        int64_t timeout_in_nanoseconds{1000000000};
+    };
+
+    struct OfflineRenderResult {
+        int64_t frames_rendered{0};
+        int32_t num_blocks{0};
+        // events that did not fit into the MIDI2 input buffer of their block.
+        int32_t num_dropped_events{0};
+        int64_t elapsed_nanoseconds{0};
+    };
 
 /**
  * The common basis for client RemotePluginInstance and service LocalPluginInstance.
@@ -37,6 +74,11 @@ namespace aap {
         int sample_rate{48000};
 
         NanoSleepLock ump_sequence_merger_mutex{};
+
+        // measures the stages of process(); see ProcessTrace.
+        ProcessTrace process_trace{};
+        // skips process() while the plugin has nothing to render; see SilenceBypass.
+        SilenceBypass silence_bypass{};
         void merge_ump_sequences(aap_port_direction portDirection, void *mergeTmp, int32_t mergeBufSize, void* sequence, int32_t sequenceSize, aap_buffer_t *buffer, PluginInstance* instance);
 
         aap_host_plugin_info_extension_t host_plugin_info{};
@@ -51,6 +93,8 @@ namespace aap {
         const PluginInformation *pluginInfo;
         std::unique_ptr <std::vector<PortInformation>> configured_ports{nullptr};
         std::unique_ptr <std::vector<ParameterInformation>> cached_parameters{nullptr};
+        // parameter values reported by the plugin, updated lock-free at process().
+        std::unique_ptr<internal::ParameterValueTable> parameter_values;
         // for client, it collects event inputs and AAPXS SysEx8 UMPs
         // for service, it collects AAPXS SysEx8 UMPs (can be put multiple async results)
         void* event_midi2_buffer{nullptr};
@@ -81,6 +125,8 @@ namespace aap {
 
         const PluginInformation *getPluginInformation() { return pluginInfo; }
 
+        internal::ParameterValueTable *getParameterValueTable() { return parameter_values.get(); }
+
         void completeInstantiation();
 
         // common to both service and client.
@@ -124,12 +170,30 @@ namespace aap {
 
         aap::PluginInstantiationState getInstanceState() { return instantiation_state; }
 
+        int32_t getSampleRate() { return sample_rate; }
+
         void activate();
 
         void deactivate();
 
         virtual void process(int32_t frameCount, int32_t timeoutInNanoseconds) = 0;
 
+        /**
+         * Renders `request.total_frames` frames in one native loop, block by block (the block size is
+         * the one that the instance was prepared with), instead of the caller driving process() for
+         * every block. The instance must be prepared and activated. The audio inputs and outputs are
+         * accessed in place in the plugin buffer, and nothing is allocated in the loop.
+         */
+        OfflineRenderResult renderOffline(const OfflineRenderRequest& request);
+
+        // Per-stage latency histograms and trace events of process(). Disabled by default
+        // (use `setFlags()`); while ATrace is enabled, the stages are emitted as ATrace sections anyway.
+        ProcessTrace& getProcessTrace() { return process_trace; }
+
+        // Skipping process() while the inputs are silent longer than the plugin's tail time.
+        // Enabled by default on RemotePluginInstance; the tail time is queried at activate().
+        SilenceBypass& getSilenceBypass() { return silence_bypass; }
+
         virtual void setupAAPXS() = 0;
         virtual xs::StandardExtensions &getStandardExtensions() = 0;
 
@@ -140,9 +204,9 @@ namespace aap {
         virtual std::shared_ptr<xs::AsyncAbortRegistry> getAsyncAbortRegistry() { return nullptr; }
         virtual void abortAllPendingAAPXS(const std::string& error) {}
 
-        uint32_t getTailTimeInMilliseconds() {
-            // TODO: FUTURE - most likely just a matter of plugin property
-            return 0;
+        // non-RT. AAP_TAIL_TIME_INFINITE if the plugin does not support the tail extension.
+        int32_t getTailTimeInMilliseconds() {
+            return getStandardExtensions().getTailTimeInMilliseconds();
         }
 
         // It is used by both local and remote plugin instance
@@ -161,6 +225,10 @@ namespace aap {
         static void
         aapxsSessionAddEventUmpInput(AAPXSMidi2InitiatorSession *client, void *context,
                                      int32_t messageSize);
+
+        // Compact AAPXS SysEx8 carries only URID; fills in `context->uri` from the registry.
+        // Returns false if the URID is not mapped to any extension.
+        static bool resolveCompactAAPXSUri(xs::AAPXSDefinitionRegistry* registry, aap_midi2_aapxs_parse_context* context);
     };
 
     typedef void(*aapxs_host_ipc_sender)(void* context,
@@ -191,6 +259,8 @@ namespace aap {
         void* aapxs_out_midi2_buffer{nullptr};
         void* aapxs_out_merge_buffer{nullptr};
         int32_t aapxs_out_midi2_buffer_offset{0};
+        // MIDI2 outputs for the GUI listeners (written at process(), read by the UI thread)
+        GuiListenerMidiBuffer gui_listener_midi_buffer;
 
         static void* internalGetHostExtension(AndroidAudioPluginHost *host, const char *uri) {
             return ((LocalPluginInstance*) host->context)->getHostExtension(0, uri);
@@ -222,6 +292,8 @@ namespace aap {
 
         inline AndroidAudioPlugin *getPlugin() { return plugin; }
 
+        GuiListenerMidiBuffer& getGuiListenerMidiBuffer() { return gui_listener_midi_buffer; }
+
         std::unique_ptr<aap::xs::ServiceStandardExtensions> standards{nullptr};
         xs::ServiceStandardExtensions &getStandardExtensions() override { return *standards; }
         void setupAAPXS() override;
@@ -280,7 +352,7 @@ namespace aap {
     class RemotePluginInstance : public PluginInstance {
         // holds AudioPluginSurfaceControlClient for plugin instance lifetime.
         class RemotePluginNativeUIController {
-            void* handle;
+            void* handle{nullptr};
         public:
             RemotePluginNativeUIController(RemotePluginInstance* owner);
             virtual ~RemotePluginNativeUIController();
@@ -0,0 +1,161 @@
+#ifndef AAP_CORE_PROCESS_TRACE_H
+#define AAP_CORE_PROCESS_TRACE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace aap {
+
+    // The stages of `PluginInstance::process()` that are measured.
+    enum ProcessTraceStage : uint8_t {
+        // the whole process() call
+        PROCESS_TRACE_STAGE_TOTAL,
+        // merging the queued event inputs and AAPXS SysEx8 requests into the MIDI2 input
+        PROCESS_TRACE_STAGE_AAPXS_INPUT_MERGE,
+        // plugin->process(); the transport call on the client, the plugin itself on the service
+        PROCESS_TRACE_STAGE_PLUGIN_PROCESS,
+        // AAPXSMidi2InitiatorSession::completeSession() (client)
+        PROCESS_TRACE_STAGE_COMPLETE_SESSION,
+        // removing AAPXS SysEx8 replies from the MIDI2 output (client)
+        PROCESS_TRACE_STAGE_FILTER_AAPXS_REPLIES,
+        // updating the parameter value cache from the MIDI2 output
+        PROCESS_TRACE_STAGE_PARAMETER_CACHE_UPDATE,
+        PROCESS_TRACE_STAGE_COUNT
+    };
+
+    enum ProcessTraceFlags : uint32_t {
+        // record the stage latencies into the histograms
+        PROCESS_TRACE_HISTOGRAMS = 1,
+        // record every stage as an event, for dumpEventsAsJson()
+        PROCESS_TRACE_EVENTS = 2
+    };
+
+    const char* getProcessTraceStageName(ProcessTraceStage stage);
+
+    /**
+     * Latency histogram with log-linear buckets (8 per power of two, i.e. within 12.5%), from
+     * nanoseconds up to about 18 minutes. It has a single writer (the audio thread) that never
+     * blocks or allocates; any other thread can read it at any time (the result may lag behind
+     * by the samples that are being recorded).
+     */
+    class LatencyHistogram {
+    public:
+        static const int32_t SUB_BUCKET_BITS = 3;
+        static const int32_t NUM_BUCKETS = 40 << SUB_BUCKET_BITS;
+
+    private:
+        std::array<std::atomic<uint32_t>, NUM_BUCKETS> buckets{};
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> total{0};
+        std::atomic<uint64_t> max{0};
+
+        static int32_t bucketOf(uint64_t nanoseconds) {
+            if (nanoseconds < (1u << SUB_BUCKET_BITS))
+                return (int32_t) nanoseconds;
+            int32_t exponent = 63 - __builtin_clzll(nanoseconds);
+            int32_t index = ((exponent - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) +
+                            (int32_t) ((nanoseconds >> (exponent - SUB_BUCKET_BITS)) & ((1u << SUB_BUCKET_BITS) - 1));
+            return index < NUM_BUCKETS ? index : NUM_BUCKETS - 1;
+        }
+
+    public:
+        static uint64_t getBucketUpperBound(int32_t index);
+
+        // audio thread only
+        void record(uint64_t nanoseconds) {
+            auto& bucket = buckets[bucketOf(nanoseconds)];
+            // single writer: no read-modify-write instructions needed.
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            total.store(total.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+            if (nanoseconds > max.load(std::memory_order_relaxed))
+                max.store(nanoseconds, std::memory_order_relaxed);
+            count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        uint64_t getCount() const { return count.load(std::memory_order_acquire); }
+        uint64_t getMax() const { return max.load(std::memory_order_relaxed); }
+        uint64_t getMean() const;
+        // Returns the upper bound of the bucket that contains the percentile (0.0 - 100.0).
+        uint64_t getPercentile(double percentile) const;
+        // Samples that are being recorded at the same time may be lost.
+        void reset();
+    };
+
+    struct ProcessTraceEvent {
+        int64_t begin_ns;
+        int64_t duration_ns;
+        int32_t thread_id;
+        ProcessTraceStage stage;
+    };
+
+    /**
+     * Per-instance tracing of the process() stages. When it is enabled (`setFlags()`), the
+     * stages are measured with the monotonic clock and recorded into the histograms and/or the
+     * event buffer. Regardless of the flags, the stages are also emitted as ATrace sections while
+     * ATrace is enabled (Android only).
+     *
+     * Nothing on the audio thread blocks or allocates. The event buffer is a ring that is
+     * allocated when PROCESS_TRACE_EVENTS is first enabled, and keeps the latest events.
+     */
+    class ProcessTrace {
+        std::atomic<uint32_t> flags{0};
+        std::array<LatencyHistogram, PROCESS_TRACE_STAGE_COUNT> histograms{};
+        std::unique_ptr<ProcessTraceEvent[]> events{};
+        uint32_t event_capacity{0};
+        std::atomic<uint64_t> event_write_position{0};
+        char section_names[PROCESS_TRACE_STAGE_COUNT][64]{};
+
+        // audio thread state, updated by beginCycle().
+        bool active{false};
+        bool atrace{false};
+        uint32_t cycle_flags{0};
+
+    public:
+        ProcessTrace() { setSectionNamePrefix("AAP::process"); }
+
+        // The ATrace section names are "(prefix)" for the total and "(prefix)::(stage)" for the others.
+        void setSectionNamePrefix(const char* prefix);
+
+        // Enables or disables the recording (see ProcessTraceFlags). It is not for the audio thread.
+        void setFlags(uint32_t flags, uint32_t eventCapacity = 0x10000);
+        uint32_t getFlags() const { return flags.load(std::memory_order_relaxed); }
+
+        // audio thread: call at the beginning of every process() before any ProcessTraceScope.
+        void beginCycle();
+        bool isActive() const { return active; }
+        void beginStage(ProcessTraceStage stage, int64_t& beginNanoseconds);
+        void endStage(ProcessTraceStage stage, int64_t beginNanoseconds);
+
+        const LatencyHistogram& getHistogram(ProcessTraceStage stage) const { return histograms[stage]; }
+        void resetHistograms();
+
+        // "stage count p50 p99 max mean" per line, in microseconds.
+        std::string dumpHistograms() const;
+        // Chrome JSON trace event format (complete events), that Perfetto UI and chrome://tracing can load.
+        std::string dumpEventsAsJson() const;
+
+        static int64_t nowNanoseconds();
+    };
+
+    // Measures the stage while it is alive.
+    class ProcessTraceScope {
+        ProcessTrace& trace;
+        ProcessTraceStage stage;
+        int64_t begin_ns{0};
+
+    public:
+        ProcessTraceScope(ProcessTrace& trace, ProcessTraceStage stage) : trace(trace), stage(stage) {
+            if (trace.isActive())
+                trace.beginStage(stage, begin_ns);
+        }
+        ~ProcessTraceScope() {
+            if (trace.isActive())
+                trace.endStage(stage, begin_ns);
+        }
+    };
+}
+
+#endif //AAP_CORE_PROCESS_TRACE_H
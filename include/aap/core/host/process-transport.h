@@ -0,0 +1,110 @@
+#ifndef AAP_CORE_PROCESS_TRANSPORT_H
+#define AAP_CORE_PROCESS_TRANSPORT_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <pthread.h>
+#include <thread>
+
+// Reserved pseudo extension URI that is used to hand the process control block shm FD over to
+// the plugin service (via `addExtension()`), so that no new IPC method is needed for negotiation.
+#define AAP_PROCESS_TRANSPORT_FUTEX_URI "urn://androidaudioplugin.org/internal/process-transport/futex/v1"
+
+namespace aap {
+
+    enum ProcessTransportType {
+        // A synchronous IPC transaction (e.g. Binder `process()`) for every audio block.
+        PROCESS_TRANSPORT_IPC,
+        // A control block in shared memory and futex wake/wait (Linux only).
+        // Falls back to PROCESS_TRANSPORT_IPC if the service or the platform does not support it.
+        PROCESS_TRANSPORT_SHARED_MEMORY_FUTEX
+    };
+
+    /**
+     * Client-side transport that asks the plugin service to process one audio block whose
+     * buffers are already in the shared memory.
+     */
+    class ProcessTransport {
+    public:
+        virtual ~ProcessTransport() {}
+
+        virtual ProcessTransportType getType() = 0;
+
+        // Returns false if the service did not complete the block (IPC failure or timeout).
+        virtual bool process(int32_t frameCount, int64_t timeoutInNanoseconds) = 0;
+    };
+
+    /**
+     * The shared memory layout for PROCESS_TRANSPORT_SHARED_MEMORY_FUTEX.
+     *
+     * The client writes the block parameters and increments `request_sequence`; the service
+     * render thread processes the block and then stores the same value to `reply_sequence`.
+     * Both sides wait on the counters via (non-private) futex, as they live in MAP_SHARED memory.
+     * The client also publishes the scheduling of its calling (audio) thread, which the render
+     * thread follows.
+     */
+    struct ProcessControlBlock {
+        static const uint32_t SERVICE_READY_MAGIC = 0x41415054; // "AAPT"
+
+        std::atomic<uint32_t> service_ready;
+        std::atomic<uint32_t> request_sequence;
+        std::atomic<uint32_t> reply_sequence;
+        std::atomic<uint32_t> terminated;
+        int32_t frame_count;
+        int64_t timeout_in_nanoseconds;
+        std::atomic<int32_t> caller_sched_policy;
+        std::atomic<int32_t> caller_sched_priority;
+    };
+
+    class FutexProcessTransport : public ProcessTransport {
+        int32_t fd;
+        ProcessControlBlock* block{nullptr};
+        uint32_t sequence{0};
+        // the thread whose scheduling was published last.
+        pthread_t last_caller{};
+        bool has_last_caller{false};
+
+    public:
+        // `fd` is the shared memory FD (at least sizeof(ProcessControlBlock)); it is owned by this object.
+        explicit FutexProcessTransport(int32_t fd);
+        ~FutexProcessTransport() override;
+
+        // Returns true if the futex transport is available on this platform.
+        static bool isSupported();
+
+        bool isMapped() { return block != nullptr; }
+        // Returns true once the service acknowledged the control block.
+        bool isServiceReady();
+        int32_t getFD() { return fd; }
+
+        ProcessTransportType getType() override { return PROCESS_TRANSPORT_SHARED_MEMORY_FUTEX; }
+        bool process(int32_t frameCount, int64_t timeoutInNanoseconds) override;
+    };
+
+    /**
+     * Service-side render thread for PROCESS_TRANSPORT_SHARED_MEMORY_FUTEX.
+     * It waits for the client's ring and invokes `processFunc` for each block.
+     */
+    class FutexProcessTransportService {
+        int32_t fd;
+        ProcessControlBlock* block{nullptr};
+        std::function<void(int32_t frameCount, int64_t timeoutInNanoseconds)> process_func;
+        std::thread render_thread{};
+        std::atomic<bool> stopping{false};
+
+        void run();
+
+    public:
+        // `fd` is an already-duplicated FD; it is owned by this object.
+        FutexProcessTransportService(int32_t fd, std::function<void(int32_t frameCount, int64_t timeoutInNanoseconds)> processFunc);
+        ~FutexProcessTransportService();
+
+        // Starts the render thread and marks the control block as ready. Returns false on failure.
+        bool start();
+        void stop();
+    };
+}
+
+#endif //AAP_CORE_PROCESS_TRANSPORT_H
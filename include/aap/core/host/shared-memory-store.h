@@ -2,9 +2,50 @@
 #define AAP_CORE_SHARED_MEMORY_EXTENSION_H
 
 #include <sys/mman.h>
+#include <unistd.h>
+#include <atomic>
 #include "plugin-instance.h"
 
 namespace aap {
+    /*
+     * All port buffers of a plugin instance live in one shared memory arena.
+     * It starts with this header and the offset table (`int32_t offsets[num_ports]`, then
+     * `int32_t sizes[num_ports]`), so that the service maps the buffers as the client laid them out.
+     * Every port buffer is aligned to the cache line size.
+     */
+    struct PortBufferArenaHeader {
+        static const uint32_t MAGIC = 0x41415042; // "AAPB"
+        uint32_t magic;
+        int32_t num_ports;
+    };
+    // passed as the shm FD index to prepareMemory() to indicate the port buffer arena.
+    static constexpr int32_t PORT_BUFFER_ARENA_FD_INDEX = -1;
+    static constexpr size_t PORT_BUFFER_ALIGNMENT = 64;
+
+    /*
+     * Services that predate the arena only accept one FD per port, so the client asks first.
+     * It passes a PortBufferArenaNegotiation block to addExtension() with this URI (between
+     * beginCreate() and endCreate()). Services that support the arena set `service_ready`;
+     * older ones just store the block as an extension buffer and never acknowledge it.
+     */
+#define AAP_PORT_BUFFER_ARENA_URI "urn://androidaudioplugin.org/internal/port-buffer-arena/v1"
+    struct PortBufferArenaNegotiation {
+        static const uint32_t SERVICE_READY_MAGIC = 0x41415041; // "AAPA"
+        std::atomic<uint32_t> service_ready;
+    };
+
+    // service side of the negotiation. `fd` is not closed.
+    inline bool acknowledgePortBufferArena(int32_t fd, int32_t size) {
+        if (fd < 0 || size < (int32_t) sizeof(PortBufferArenaNegotiation))
+            return false;
+        auto mapped = mmap(nullptr, sizeof(PortBufferArenaNegotiation), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED)
+            return false;
+        ((PortBufferArenaNegotiation*) mapped)->service_ready.store(PortBufferArenaNegotiation::SERVICE_READY_MAGIC, std::memory_order_release);
+        munmap(mapped, sizeof(PortBufferArenaNegotiation));
+        return true;
+    }
+
     class AbstractPluginBuffer
     {
         aap_buffer_t pub;
@@ -80,9 +121,18 @@ namespace aap {
         int32_t getPortContentType(int32_t portIndex) override { return instance->getPort(portIndex)->getContentType(); }
         int32_t getPortDirection(int32_t portIndex) override { return instance->getPort(portIndex)->getPortDirection(); }
 
+        // non-null if the buffers are mapped as one arena (see PortBufferArenaHeader).
+        void* arena{nullptr};
+        size_t arena_size{0};
+
         inline void setBuffer(size_t index, void* buffer) { buffers[index] = buffer; }
 
         void unmapSharedMemory() {
+            if (arena) {
+                munmap(arena, arena_size);
+                arena = nullptr;
+                return;
+            }
             for (size_t i = 0; i < numPorts(); i++) {
                 auto buffer = buffers[i];
                 if (buffer)
@@ -114,6 +164,9 @@ namespace aap {
         // first store those FDs somewhere.
         // Within the AIDL, we first receive unknown number of shm FDs.
         std::unique_ptr<std::vector<int32_t>> cached_shm_fds_for_prepare{nullptr};
+        // The port buffer arena FD, passed as PORT_BUFFER_ARENA_FD_INDEX. Clients that predate
+        // the arena send one FD per port instead (cached_shm_fds_for_prepare).
+        int32_t cached_arena_fd_for_prepare{-1};
 
         // ex-PluginSharedMemoryBuffer members
         std::unique_ptr<std::vector<int32_t>> port_buffer_fds{nullptr};
@@ -185,6 +238,10 @@ namespace aap {
                     close(fd);
             }
             port_buffer_fds->clear();
+            if (cached_arena_fd_for_prepare >= 0) {
+                close(cached_arena_fd_for_prepare);
+                cached_arena_fd_for_prepare = -1;
+            }
         }
 
         // Stores clone of port buffer FDs passed from client via Binder.
@@ -195,10 +252,24 @@ namespace aap {
         // used by AudioPluginInterfaceImpl.
         inline int32_t getPortBufferFD(size_t index) { return port_buffer_fds->at(index); }
 
+        // The FD of the arena that contains all port buffers, sent as PORT_BUFFER_ARENA_FD_INDEX.
+        // Valid only when the buffers are allocated as an arena.
+        inline int32_t getPortBufferArenaFD() { return port_buffer_fds->empty() ? -1 : port_buffer_fds->at(0); }
+
         // called by AudioPluginInterfaceImpl::prepareMemory().
         // `fd` is an already-duplicated FD.`
-        inline void setPortBufferFD(size_t index, int32_t fd) {
-            cached_shm_fds_for_prepare->at(index) = fd;
+        inline void setPortBufferFD(int32_t index, int32_t fd) {
+            if (index == PORT_BUFFER_ARENA_FD_INDEX) {
+                if (cached_arena_fd_for_prepare >= 0)
+                    close(cached_arena_fd_for_prepare);
+                cached_arena_fd_for_prepare = fd;
+            }
+            else if (0 <= index && (size_t) index < cached_shm_fds_for_prepare->size())
+                cached_shm_fds_for_prepare->at(index) = fd;
+            else {
+                AAP_ASSERT_FALSE;
+                close(fd);
+            }
         }
 
         void* addExtensionFD(int fd, int dataSize) {
@@ -231,16 +302,33 @@ namespace aap {
     };
 
     class ClientPluginSharedMemoryStore : public PluginSharedMemoryStore {
+        // set once the service acknowledged AAP_PORT_BUFFER_ARENA_URI. Otherwise one shm per port.
+        bool port_buffer_arena_enabled{false};
+
+        int32_t allocateClientArena(size_t numPorts, size_t numFrames, aap::PluginInstance& instance, size_t defaultControllBytesPerBlock);
+        int32_t allocateClientPortBuffers(size_t numPorts, size_t numFrames, aap::PluginInstance& instance, size_t defaultControllBytesPerBlock);
+
     public:
+        // must be called before allocateClientBuffer().
+        void setPortBufferArenaEnabled(bool enabled) { port_buffer_arena_enabled = enabled; }
+        bool isPortBufferArenaEnabled() const { return port_buffer_arena_enabled; }
+
         [[nodiscard]] int32_t allocateClientBuffer(size_t numPorts, size_t numFrames, aap::PluginInstance& instance, size_t defaultControllBytesPerBlock);
     };
 
     class ServicePluginSharedMemoryStore : public PluginSharedMemoryStore {
     public:
         [[nodiscard]] int32_t allocateServiceBuffer(std::vector<int32_t>& clientFDs, size_t numFrames, aap::PluginInstance& instance, size_t defaultControllBytesPerBlock);
+        [[nodiscard]] int32_t mapServiceArena(int32_t arenaFD, size_t numFrames, aap::PluginInstance& instance);
 
         [[nodiscard]] bool completeServiceInitialization(size_t numFrames, aap::PluginInstance& instance, size_t defaultControllBytesPerBlock) {
-            auto ret = allocateServiceBuffer(*cached_shm_fds_for_prepare, numFrames, instance, defaultControllBytesPerBlock) == PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_SUCCESS;
+            bool ret;
+            if (cached_arena_fd_for_prepare >= 0) {
+                ret = mapServiceArena(cached_arena_fd_for_prepare, numFrames, instance) == PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_SUCCESS;
+                cached_arena_fd_for_prepare = -1; // now owned by port_buffer_fds
+            }
+            else
+                ret = allocateServiceBuffer(*cached_shm_fds_for_prepare, numFrames, instance, defaultControllBytesPerBlock) == PluginMemoryAllocatorResult::PLUGIN_MEMORY_ALLOCATOR_SUCCESS;
             cached_shm_fds_for_prepare->clear();
             return ret;
         }
@@ -0,0 +1,72 @@
+#ifndef AAP_CORE_SILENCE_BYPASS_H
+#define AAP_CORE_SILENCE_BYPASS_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "aap/android-audio-plugin.h"
+
+namespace aap {
+
+    class PluginInstance;
+
+    /**
+     * Decides whether a plugin instance can skip process() because it has nothing to render.
+     *
+     * It watches the input and output ports: once every audio input has been silent and no MIDI
+     * input event has arrived for longer than the tail time that the plugin reported (see the tail
+     * extension), and the last outputs were silent too, `beginBlock()` tells the caller to skip the
+     * plugin and zero-fills its outputs instead. The first block that comes with non-silent audio or
+     * any event is processed as usual, so the plugin resumes at the exact sample.
+     *
+     * Plugins that report an infinite tail (or do not support the tail extension) are never skipped.
+     * The port layout and the tail time are cached at `configure()` (at prepare()), so the audio
+     * thread does not query anything. The host should call `beginBlock()` and `endBlock()` only while
+     * the instance is ACTIVE.
+     */
+    class SilenceBypass {
+        bool enabled{false};
+        // in frames. Negative if the instance must never be skipped. `configure()` writes it last,
+        // so the audio thread never sees a valid tail with half-built port lists.
+        std::atomic<int64_t> tail_frames{-1};
+        // the number of frames that the inputs have been silent in a row.
+        int64_t silent_input_frames{0};
+        bool input_silent_in_block{false};
+        bool bypassing{false};
+        bool outputs_cleared{false};
+        uint64_t skipped_blocks{0};
+        std::vector<int32_t> audio_in_ports{};
+        std::vector<int32_t> audio_out_ports{};
+        std::vector<int32_t> midi_in_ports{};
+        std::vector<int32_t> midi_out_ports{};
+
+        bool areInputsSilent(aap_buffer_t* buffer, int32_t frameCount);
+        bool areOutputsSilent(aap_buffer_t* buffer, int32_t frameCount);
+
+    public:
+        // samples whose magnitude is at or below this (-100dBFS) are regarded as silent.
+        static constexpr float silence_threshold = 1.0e-5f;
+
+        // Enabling takes effect at the next `configure()`; disabling takes effect immediately.
+        void setEnabled(bool enabled);
+        bool isEnabled() const { return enabled; }
+
+        // non-RT. Caches the ports of `instance` and converts the tail time (AAP_TAIL_TIME_INFINITE
+        // if negative) to frames at its sample rate.
+        void configure(PluginInstance* instance, int32_t tailTimeInMilliseconds);
+
+        // audio thread, before process(). Returns true if process() should be skipped for this
+        // block; the outputs are silent then.
+        bool beginBlock(aap_buffer_t* buffer, int32_t frameCount);
+        // audio thread, after process() (only when it was not skipped).
+        void endBlock(aap_buffer_t* buffer, int32_t frameCount);
+
+        bool isBypassing() const { return bypassing; }
+        uint64_t getSkippedBlockCount() const { return skipped_blocks; }
+
+        // the silence detector. Exposed for hosts that check their own buffers.
+        static bool isSilent(const float* data, int32_t numFrames);
+    };
+}
+
+#endif //AAP_CORE_SILENCE_BYPASS_H
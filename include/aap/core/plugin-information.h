@@ -48,6 +48,7 @@ public:
     std::string getPropertyAsString(std::string propertyId) const {
         return hasProperty(propertyId) ? properties.find(propertyId)->second : "";
     }
+    const std::map<std::string, std::string>& getProperties() const { return properties; }
 };
 
 class PortInformation : public PropertyContainer {
@@ -79,9 +80,9 @@ public:
                 : index(index), value(value), name(name) {
         }
 
-        int32_t getIndex() { return index; }
-        double getValue() { return value; }
-        std::string getName() { return name; };
+        int32_t getIndex() const { return index; }
+        double getValue() const { return value; }
+        std::string getName() const { return name; };
     };
 
 private:
@@ -111,6 +112,7 @@ public:
     int32_t getEnumCount() const { return enums.size(); }
     // returns reference to internal copy
     const Enumeration& getEnumeration(int32_t index) const { return enums.at(index); }
+    const std::map<int32_t, Enumeration>& getEnumerations() const { return enums; }
 };
 
 class PluginExtensionInformation
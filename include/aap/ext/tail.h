@@ -0,0 +1,49 @@
+#ifndef AAP_TAIL_H_INCLUDED
+#define AAP_TAIL_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../android-audio-plugin.h"
+#include "stdint.h"
+
+/*
+ * Tail extension lets the host know how long the plugin keeps producing outputs after its inputs
+ * became silent (e.g. reverb or delay tails, or the release of an instrument).
+ *
+ * Hosts use it to skip `process()` of plugins that have nothing to render: once the inputs have
+ * been silent (and no events arrived) for longer than the tail time, and the outputs are silent too,
+ * the host may stop calling `process()` and fill the outputs with zeros instead, until non-silent
+ * inputs or events arrive. The plugin receives that block as the next `process()` as usual.
+ *
+ * A plugin that does not implement this extension is never skipped. A plugin that may produce
+ * outputs without any inputs (e.g. a generator) should return `AAP_TAIL_TIME_INFINITE`.
+ *
+ * The host queries it at preparation. If the tail time changes (e.g. by parameter changes), the plugin
+ * should report the longest possible one.
+ */
+
+#define AAP_TAIL_EXTENSION_URI "urn://androidaudioplugin.org/extensions/tail/v1"
+
+// The plugin may keep producing outputs forever; the host should never skip it.
+#define AAP_TAIL_TIME_INFINITE -1
+
+typedef struct aap_tail_extension_t {
+    /*
+     * `aapxs_context` is an opaque pointer assigned and used by AAPXS hosting implementation (libandroidaudioplugin).
+     * Neither of plugin developer (extension user) or extension developers is supposed to touch it.
+     */
+    void *aapxs_context;
+
+    /*
+     * Returns the tail time in milliseconds, or AAP_TAIL_TIME_INFINITE.
+     */
+    RT_SAFE int32_t (*get_tail_time_in_milliseconds) (aap_tail_extension_t* ext, AndroidAudioPlugin* plugin);
+} aap_tail_extension_t;
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // AAP_TAIL_H_INCLUDED
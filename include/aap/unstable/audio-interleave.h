@@ -0,0 +1,29 @@
+#ifndef AAP_CORE_UNSTABLE_AUDIO_INTERLEAVE_H
+#define AAP_CORE_UNSTABLE_AUDIO_INTERLEAVE_H
+
+#include <cstdint>
+
+namespace aap {
+
+    /**
+     * Converts planar audio (one buffer per channel) into interleaved audio:
+     * `dst[frame * numChannels + ch] = src[ch][frame]`.
+     *
+     * The kernel for the channel count is selected at startup from what the CPU supports
+     * (SSE2/AVX2 on x86-64, NEON on ARM). 1 to 8 channels have dedicated kernels; more channels
+     * fall back to a generic loop. It does not allocate and is safe to call on the audio thread.
+     */
+    void interleaveAudio(float* dst, const float* const* src, int32_t numChannels, int32_t numFrames);
+
+    /**
+     * Converts interleaved audio into planar audio (one buffer per channel):
+     * `dst[ch][frame] = src[frame * numChannels + ch]`. See `interleaveAudio()` for the kernels.
+     */
+    void deinterleaveAudio(float* const* dst, const float* src, int32_t numChannels, int32_t numFrames);
+
+    /** Returns the name of the instruction set the kernels were selected for ("scalar", "sse2", "avx2" or "neon"). */
+    const char* getAudioInterleaveKernelName();
+
+}
+
+#endif//AAP_CORE_UNSTABLE_AUDIO_INTERLEAVE_H
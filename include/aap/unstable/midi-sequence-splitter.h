@@ -0,0 +1,124 @@
+#ifndef AAP_CORE_UNSTABLE_MIDI_SEQUENCE_SPLITTER_H
+#define AAP_CORE_UNSTABLE_MIDI_SEQUENCE_SPLITTER_H
+
+#include <cstdint>
+#include "aap/ext/midi.h"
+
+namespace aap {
+
+    /**
+     * Splits the MIDI2 (UMP) sequence of an `AAPMidiBufferHeader` into sample-accurate sub-blocks,
+     * so that a plugin can render the audio between two events in one go:
+     *
+     * ```
+     * aap::MidiSequenceSplitter splitter{midiIn, frameCount, sampleRate};
+     * aap::MidiSequenceSplitter::Segment segment;
+     * while (splitter.next(segment)) {
+     *     CMIDI2_UMP_SEQUENCE_FOREACH(segment.events, segment.events_size, ev)
+     *         handleEvent((cmidi2_ump*) ev);
+     *     render(segment.frame_offset, segment.num_frames);
+     * }
+     * ```
+     *
+     * Event timing is given as JR Timestamp UMPs (in 1/31250 seconds, relative to the previous
+     * timestamp) in front of the events, which is how AAP hosts send them. The splitter consumes
+     * them; `events` may only contain a JR Timestamp between events that fall onto the same frame.
+     * Events beyond the block are delivered at its last frame. The segments cover the whole block,
+     * and the first one starts at frame 0 (without events if the first event comes later).
+     *
+     * It is header-only, does not allocate, and is safe to use on the audio thread.
+     */
+    class MidiSequenceSplitter {
+        static constexpr int32_t jr_timestamp_ticks_per_second = 31250;
+
+        const uint32_t* words;
+        uint32_t num_words;
+        uint32_t position{0};
+        int32_t frame_count;
+        int64_t sample_rate;
+        int64_t ticks{0};
+        // frameAt(ticks), updated only when a JR timestamp advances `ticks`.
+        int32_t ticks_frame{0};
+        int32_t current_frame{0};
+        bool done{false};
+
+        // UMP packet size in 32-bit words, by the message type (the top 4 bits of the first word).
+        static uint32_t umpWords(uint32_t word0) {
+            static constexpr uint8_t sizes[16] {1, 1, 1, 2, 2, 4, 1, 1, 2, 2, 2, 3, 3, 4, 4, 4};
+            return sizes[word0 >> 28];
+        }
+
+        // message type 0 (utility), status 0x20
+        static bool isJRTimestamp(uint32_t word0) { return (word0 & 0xF0F00000) == 0x00200000; }
+
+        int32_t frameAt(int64_t t) const {
+            auto frame = t * sample_rate / jr_timestamp_ticks_per_second;
+            auto last = frame_count > 0 ? frame_count - 1 : 0;
+            return frame < last ? (int32_t) frame : last;
+        }
+
+    public:
+        struct Segment {
+            // the frame where the events take place and the sub-block starts
+            int32_t frame_offset;
+            // the number of frames until the next event (or the end of the block); can be 0 only if frameCount is 0
+            int32_t num_frames;
+            // the UMPs at `frame_offset`, or null if there is none
+            const uint32_t* events;
+            // in bytes
+            uint32_t events_size;
+        };
+
+        MidiSequenceSplitter(const AAPMidiBufferHeader* sequence, int32_t frameCount, int32_t sampleRate)
+            : words(sequence ? (const uint32_t*) (sequence + 1) : nullptr),
+              num_words(sequence ? sequence->length / sizeof(uint32_t) : 0),
+              frame_count(frameCount),
+              sample_rate(sampleRate) {
+        }
+
+        // Returns false when the whole block has been covered.
+        bool next(Segment& segment) {
+            if (done)
+                return false;
+            uint32_t start = position;
+            uint32_t end = position;
+            bool hasEvents = false;
+            int32_t nextFrame = frame_count;
+            while (position < num_words) {
+                auto word0 = words[position];
+                auto size = umpWords(word0);
+                if (position + size > num_words) {
+                    // truncated packet; ignore the rest.
+                    position = num_words;
+                    break;
+                }
+                if (isJRTimestamp(word0)) {
+                    ticks += word0 & 0xFFFF;
+                    ticks_frame = frameAt(ticks);
+                    position++;
+                    continue;
+                }
+                if (ticks_frame > current_frame) {
+                    nextFrame = ticks_frame;
+                    break;
+                }
+                if (!hasEvents) {
+                    start = position;
+                    hasEvents = true;
+                }
+                position += size;
+                end = position;
+            }
+
+            segment.frame_offset = current_frame;
+            segment.num_frames = nextFrame > current_frame ? nextFrame - current_frame : 0;
+            segment.events = hasEvents ? words + start : nullptr;
+            segment.events_size = hasEvents ? (end - start) * (uint32_t) sizeof(uint32_t) : 0;
+            current_frame = nextFrame;
+            done = current_frame >= frame_count;
+            return true;
+        }
+    };
+}
+
+#endif//AAP_CORE_UNSTABLE_MIDI_SEQUENCE_SPLITTER_H
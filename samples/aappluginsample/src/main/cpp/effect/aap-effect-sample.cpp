@@ -5,6 +5,7 @@
 #include <aap/ext/midi.h>
 #include <aap/ext/parameters.h>
 #include <aap/unstable/logging.h>
+#include <aap/unstable/midi-sequence-splitter.h>
 #include <cassert>
 #include <cstring>
 #include "cmidi2.h"
@@ -34,6 +35,7 @@ typedef struct SamplePluginSpecific {
     int32_t audioInPortR{-1};
     int32_t audioOutPortL{-1};
     int32_t audioOutPortR{-1};
+    int32_t sample_rate{48000};
 
     SamplePluginSpecific(AndroidAudioPluginHost *host) {
         this->host = *host;
@@ -63,6 +65,7 @@ void sample_plugin_delete(
 
 void sample_plugin_prepare(AndroidAudioPlugin *plugin, int32_t sampleRate, aap_buffer_t *buffer) {
     auto ctx = (SamplePluginSpecific*) plugin->plugin_specific;
+    ctx->sample_rate = sampleRate;
     auto ext = (aap_host_plugin_info_extension_t*) ctx->host.get_extension(&ctx->host, AAP_PLUGIN_INFO_EXTENSION_URI);
     assert(ext);
     auto pluginInfo = ext->get(ext, &ctx->host, PLUGIN_URI);
@@ -161,11 +164,12 @@ void sample_plugin_process(AndroidAudioPlugin *plugin,
     auto fOL = (float *) buffer->get_buffer(buffer, ctx->audioOutPortL);
     auto fOR = (float *) buffer->get_buffer(buffer, ctx->audioOutPortR);
 
-    // update parameters via MIDI2 messages
+    // update parameters via MIDI2 messages, at the frames they are timestamped at.
     auto midiSeq = (AAPMidiBufferHeader*) buffer->get_buffer(buffer, ctx->midiInPort);
-    auto midiSeqData = midiSeq + 1;
-    if (midiSeq->length > 0) {
-        CMIDI2_UMP_SEQUENCE_FOREACH(midiSeqData, midiSeq->length, iter) {
+    aap::MidiSequenceSplitter splitter{midiSeq, (int32_t) (size / sizeof(float)), ctx->sample_rate};
+    aap::MidiSequenceSplitter::Segment segment;
+    while (splitter.next(segment)) {
+        CMIDI2_UMP_SEQUENCE_FOREACH(segment.events, segment.events_size, iter) {
             auto ump = (cmidi2_ump*) iter;
             uint8_t paramGroup, paramChannel, paramKey{0}, paramExtra{0};
             uint16_t paramIndex;
@@ -174,10 +178,7 @@ void sample_plugin_process(AndroidAudioPlugin *plugin,
             bool relative{false};
             switch (cmidi2_ump_get_message_type(ump)) {
                 case CMIDI2_MESSAGE_TYPE_UTILITY:
-                    if (cmidi2_ump_get_status_code(ump) == CMIDI2_UTILITY_STATUS_JR_TIMESTAMP) {
-                        // FIXME: ideally there should be timestamp-based sample accuracy adjustment here
-                        //  and the audio processing code later should take care of it, but we're lazy here...
-                    }
+                    // JR timestamps are taken care of by the splitter.
                     continue;
                 case CMIDI2_MESSAGE_TYPE_SYSEX8_MDS: {
                     if (!readMidi2Parameter(&paramGroup, &paramChannel, &paramKey, &paramExtra,
@@ -233,13 +234,13 @@ process_acc:
                     continue; // invalid parameter index FIXME: log it
             }
         }
-    }
 
-    for (int i = 0; i < size / sizeof(float); i++) {
-        if (i >= ctx->delayL)
-            fOL[i] = (float) (fIL[i - ctx->delayL] * ctx->modL);
-        if (i >= ctx->delayR)
-            fOR[i] = (float) (fIR[i - ctx->delayR] * ctx->modR);
+        for (int i = segment.frame_offset, end = i + segment.num_frames; i < end; i++) {
+            if (i >= ctx->delayL)
+                fOL[i] = (float) (fIL[i - ctx->delayL] * ctx->modL);
+            if (i >= ctx->delayR)
+                fOR[i] = (float) (fIR[i - ctx->delayR] * ctx->modR);
+        }
     }
 
     /* FIXME: This is for testing minBufferSize, but now it's gone because we don't use port for it.
@@ -4,6 +4,7 @@
 #include <string>
 #include <math.h>
 #include <aap/unstable/logging.h>
+#include <aap/unstable/midi-sequence-splitter.h>
 #include <aap/ext/presets.h>
 #include <aap/ext/state.h>
 #include <aap/ext/midi.h>
@@ -357,125 +358,118 @@ void sample_plugin_process(AndroidAudioPlugin *plugin,
 
     flush_parameter_outputs(context, buffer);
 
-    volatile auto aapmb = (AAPMidiBufferHeader*) buffer->get_buffer(buffer, context->midi2_in_port);
-
-    uint32_t currentTicks = 0;
+    auto midiIn = (AAPMidiBufferHeader*) buffer->get_buffer(buffer, context->midi2_in_port);
 
     auto outL = (float*) buffer->get_buffer(buffer, context->audio_out_l_port);
     auto outR = (float*) buffer->get_buffer(buffer, context->audio_out_r_port);
 
-    auto midi2ptr = ((uint32_t*) (void*) aapmb) + 8;
-    CMIDI2_UMP_SEQUENCE_FOREACH(midi2ptr, aapmb->length, ev) {
-        auto ump = (cmidi2_ump *) ev;
-        uint8_t paramGroup, paramChannel, paramKey{0}, paramExtra{0};
-        uint16_t paramIndex;
-        double paramValue;
-        uint32_t intValue;
-        bool relative{false};
-        if (cmidi2_ump_get_message_type(ump) == CMIDI2_MESSAGE_TYPE_UTILITY &&
-            cmidi2_ump_get_status_code(ump) == CMIDI2_UTILITY_STATUS_JR_TIMESTAMP) {
-            uint32_t max = currentTicks + (uint32_t) (cmidi2_ump_get_jr_timestamp_timestamp(ump) / 31250.0 * context->sample_rate);
-            auto numFrames = buffer->num_frames(buffer);
-            max = max < numFrames ? max : numFrames;
-            for (uint32_t i = currentTicks; i < max; i++) {
-                ayumi_process(context->impl);
-                ayumi_remove_dc(context->impl);
-                outL[i] = (float) context->impl->left;
-                outR[i] = (float) context->impl->right;
+    auto numFrames = buffer->num_frames(buffer);
+    if (frameCount > numFrames) {
+        aap::a_log_f(AAP_LOG_LEVEL_ERROR, AAP_APP_LOG_TAG, "frameCount passed at process() is bigger than aap_buffer_t num_frames().");
+        numFrames = frameCount;
+    }
+
+    // render the frames between the events, and the events at their timestamped frames.
+    aap::MidiSequenceSplitter splitter{midiIn, numFrames, (int32_t) context->sample_rate};
+    aap::MidiSequenceSplitter::Segment segment;
+    while (splitter.next(segment)) {
+        CMIDI2_UMP_SEQUENCE_FOREACH(segment.events, segment.events_size, ev) {
+            auto ump = (cmidi2_ump *) ev;
+            uint8_t paramGroup, paramChannel, paramKey{0}, paramExtra{0};
+            uint16_t paramIndex;
+            double paramValue;
+            uint32_t intValue;
+            bool relative{false};
+            if (cmidi2_ump_get_message_type(ump) == CMIDI2_MESSAGE_TYPE_UTILITY) {
+                // JR timestamps are taken care of by the splitter.
+                continue;
+            } else if (readMidi2Parameter(&paramGroup, &paramChannel, &paramKey, &paramExtra, &paramIndex, &paramValue, ump)) {
+                intValue = static_cast<int32_t>(paramValue);
+            } else if (cmidi2_ump_get_message_type(ump) == CMIDI2_MESSAGE_TYPE_MIDI_2_CHANNEL) {
+                switch (cmidi2_ump_get_status_code(ump)) {
+                    // enable this if it supports per-note parameters.
+                    case CMIDI2_STATUS_PER_NOTE_ACC:
+                        paramKey = cmidi2_ump_get_midi2_pnacc_note(ump); // FIXME: implement it maybe?
+                        break;
+                    case CMIDI2_STATUS_RELATIVE_NRPN:
+                        relative = true; // FIXME: implement it maybe?
+                        break;
+                    case CMIDI2_STATUS_NRPN:
+                        break;
+                    default:
+                        // FIXME: fully down-convert to MIDI1 and process it (sysex can be lengthier)
+                        uint8_t midi1Bytes[16];
+                        if (cmidi2_convert_single_ump_to_midi1(midi1Bytes, 16, ump) > 0)
+                            ayumi_aap_process_midi_event(context, midi1Bytes);
+                        continue;
+                }
+                paramGroup = cmidi2_ump_get_group(ump);
+                paramChannel = cmidi2_ump_get_channel(ump);
+                paramIndex = cmidi2_ump_get_midi2_nrpn_msb(ump) * 0x80 + cmidi2_ump_get_midi2_nrpn_lsb(ump);
+                intValue = (uint32_t) aapParameterTransportUint32ToPlain(ayumi_parameter_min(paramIndex), ayumi_parameter_max(paramIndex), cmidi2_ump_get_midi2_nrpn_data(ump));
+            } else {
+                // FIXME: fully down-convert to MIDI1 and process it (sysex can be lengthier)
+                uint8_t midi1Bytes[16];
+                if (cmidi2_convert_single_ump_to_midi1(midi1Bytes, 16, ump) > 0)
+                    ayumi_aap_process_midi_event(context, midi1Bytes);
+                continue;
             }
-            currentTicks = max;
-            continue;
-        } else if (readMidi2Parameter(&paramGroup, &paramChannel, &paramKey, &paramExtra, &paramIndex, &paramValue, ump)) {
-            intValue = static_cast<int32_t>(paramValue);
-        } else if (cmidi2_ump_get_message_type(ump) == CMIDI2_MESSAGE_TYPE_MIDI_2_CHANNEL) {
-            switch (cmidi2_ump_get_status_code(ump)) {
-                // enable this if it supports per-note parameters.
-                case CMIDI2_STATUS_PER_NOTE_ACC:
-                    paramKey = cmidi2_ump_get_midi2_pnacc_note(ump); // FIXME: implement it maybe?
+
+            // process parameter changes
+            switch (paramIndex & 0xFF) {
+                case CMIDI2_CC_BANK_SELECT: {
+                    auto mixer = intValue & 0xFF;
+                    auto tone_switch = mixer & 1;
+                    auto noise_switch = (mixer >> 1) & 1;
+                    auto env_switch = (mixer >> 2) & 1;
+                    context->mixer[paramChannel] = mixer << 5;
+                    ayumi_set_mixer(context->impl, paramChannel, tone_switch, noise_switch,
+                                    env_switch);
+                    context->state_parameter_outputs_pending.store(true, std::memory_order_release);
                     break;
-                case CMIDI2_STATUS_RELATIVE_NRPN:
-                    relative = true; // FIXME: implement it maybe?
+                }
+                case CMIDI2_CC_PAN: {
+                    float pan = static_cast<float>(paramValue);
+                    context->pan = pan;
+                    ayumi_set_pan(context->impl, paramChannel, pan, 0);
+                    context->state_parameter_outputs_pending.store(true, std::memory_order_release);
                     break;
-                case CMIDI2_STATUS_NRPN:
+                }
+                case CMIDI2_CC_VOLUME: {
+                    auto volume = static_cast<int32_t>(paramValue);
+                    context->volume = volume;
+                    ayumi_set_volume(context->impl, paramChannel, volume);
+                    context->state_parameter_outputs_pending.store(true, std::memory_order_release);
+                    break;
+                }
+                case AYUMI_AAP_PARAM_ENVELOPE: {
+                    auto env = static_cast<int32_t>(paramValue) & 0xFFFF;
+                    context->envelope = env;
+                    ayumi_set_envelope(context->impl, context->envelope);
+                    context->state_parameter_outputs_pending.store(true, std::memory_order_release);
+                    break;
+                }
+                case AYUMI_AAP_MIDI_CC_ENVELOPE_SHAPE: {
+                    auto shape = static_cast<int32_t>(paramValue);
+                    context->envelope_shape = shape;
+                    ayumi_set_envelope_shape(context->impl, shape);
+                    context->state_parameter_outputs_pending.store(true, std::memory_order_release);
+                    break;
+                }
+                case AYUMI_AAP_MIDI_CC_ENVELOPE_SHAPE + 1:
+                    context->extra_enums = static_cast<int32_t>(paramValue);
+                    context->state_parameter_outputs_pending.store(true, std::memory_order_release);
                     break;
-                default:
-                    // FIXME: fully down-convert to MIDI1 and process it (sysex can be lengthier)
-                    uint8_t midi1Bytes[16];
-                    if (cmidi2_convert_single_ump_to_midi1(midi1Bytes, 16, ump) > 0)
-                        ayumi_aap_process_midi_event(context, midi1Bytes);
-                    continue;
             }
-            paramGroup = cmidi2_ump_get_group(ump);
-            paramChannel = cmidi2_ump_get_channel(ump);
-            paramIndex = cmidi2_ump_get_midi2_nrpn_msb(ump) * 0x80 + cmidi2_ump_get_midi2_nrpn_lsb(ump);
-            intValue = (uint32_t) aapParameterTransportUint32ToPlain(ayumi_parameter_min(paramIndex), ayumi_parameter_max(paramIndex), cmidi2_ump_get_midi2_nrpn_data(ump));
-        } else {
-            // FIXME: fully down-convert to MIDI1 and process it (sysex can be lengthier)
-            uint8_t midi1Bytes[16];
-            if (cmidi2_convert_single_ump_to_midi1(midi1Bytes, 16, ump) > 0)
-                ayumi_aap_process_midi_event(context, midi1Bytes);
-            continue;
         }
 
-        // process parameter changes
-        switch (paramIndex & 0xFF) {
-            case CMIDI2_CC_BANK_SELECT: {
-                auto mixer = intValue & 0xFF;
-                auto tone_switch = mixer & 1;
-                auto noise_switch = (mixer >> 1) & 1;
-                auto env_switch = (mixer >> 2) & 1;
-                context->mixer[paramChannel] = mixer << 5;
-                ayumi_set_mixer(context->impl, paramChannel, tone_switch, noise_switch,
-                                env_switch);
-                context->state_parameter_outputs_pending.store(true, std::memory_order_release);
-                break;
-            }
-            case CMIDI2_CC_PAN: {
-                float pan = static_cast<float>(paramValue);
-                context->pan = pan;
-                ayumi_set_pan(context->impl, paramChannel, pan, 0);
-                context->state_parameter_outputs_pending.store(true, std::memory_order_release);
-                break;
-            }
-            case CMIDI2_CC_VOLUME: {
-                auto volume = static_cast<int32_t>(paramValue);
-                context->volume = volume;
-                ayumi_set_volume(context->impl, paramChannel, volume);
-                context->state_parameter_outputs_pending.store(true, std::memory_order_release);
-                break;
-            }
-            case AYUMI_AAP_PARAM_ENVELOPE: {
-                auto env = static_cast<int32_t>(paramValue) & 0xFFFF;
-                context->envelope = env;
-                ayumi_set_envelope(context->impl, context->envelope);
-                context->state_parameter_outputs_pending.store(true, std::memory_order_release);
-                break;
-            }
-            case AYUMI_AAP_MIDI_CC_ENVELOPE_SHAPE: {
-                auto shape = static_cast<int32_t>(paramValue);
-                context->envelope_shape = shape;
-                ayumi_set_envelope_shape(context->impl, shape);
-                context->state_parameter_outputs_pending.store(true, std::memory_order_release);
-                break;
-            }
-            case AYUMI_AAP_MIDI_CC_ENVELOPE_SHAPE + 1:
-                context->extra_enums = static_cast<int32_t>(paramValue);
-                context->state_parameter_outputs_pending.store(true, std::memory_order_release);
-                break;
+        for (int32_t i = segment.frame_offset, end = i + segment.num_frames; i < end; i++) {
+            ayumi_process(context->impl);
+            ayumi_remove_dc(context->impl);
+            outL[i] = (float) context->impl->left;
+            outR[i] = (float) context->impl->right;
         }
     }
-
-    auto numFrames = buffer->num_frames(buffer);
-    if (frameCount > numFrames) {
-        aap::a_log_f(AAP_LOG_LEVEL_ERROR, AAP_APP_LOG_TAG, "frameCount passed at process() is bigger than aap_buffer_t num_frames().");
-        numFrames = frameCount;
-    }
-    for (int32_t i = currentTicks; i < numFrames; i++) {
-        ayumi_process(context->impl);
-        ayumi_remove_dc(context->impl);
-        outL[i] = (float) context->impl->left;
-        outR[i] = (float) context->impl->right;
-    }
 }
 
 void sample_plugin_deactivate(AndroidAudioPlugin *plugin) {